@@ -1,5 +1,17 @@
 #include "base.h"
 
+#if defined(ON_PLATFORM_LINUX)
+  #include <errno.h>
+  #include <linux/io_uring.h>
+  #include <sys/syscall.h>
+#endif
+
+/*****************************************************************************/
+
+/* these are initialized at runtime in `initialize_base` */
+bit supports_ssse3;
+bit supports_avx2;
+
 /*****************************************************************************/
 
 uintb clz(uintl value)
@@ -10,7 +22,8 @@ uintb clz(uintl value)
     return sizeof(value) * byte_width;
   return sizeof(value) * byte_width - index - 1;
 #elif defined(ON_PLATFORM_LINUX)
-  return __builtin_clz(value);
+  if (!value) return sizeof(value) * byte_width;
+  return __builtin_clzll(value);
 #endif
 }
 
@@ -22,88 +35,130 @@ uintb ctz(uintl value)
     return sizeof(value) * byte_width;
   return index;
 #elif defined(ON_PLATFORM_LINUX)
-  return __builtin_ctz(value);
+  if (!value) return sizeof(value) * byte_width;
+  return __builtin_ctzll(value);
 #endif
 }
 
-/*
-ALGORITHM
+#if defined(ON_ARCHITECTURE_X64)
 
-  twice the byte granularity of bits are buffered as a bitmask that's
-  iteratively compared to the input bitset by shifting the bitmask.
+TARGETING("avx2")
+static uint skip_bit_words_avx2(const uintl *words, uint words_count, uint index, uintl skipped)
+{
+  __m256i skipped_words = _mm256_set1_epi64x((long long)skipped);
+  for (; index + 4 <= words_count; index += 4)
+  {
+    __m256i block = _mm256_loadu_si256((const __m256i *)(words + index));
+    uint equals = (uint)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(block, skipped_words)));
+    if (equals != 0xf) return index + ctz(~equals);
+  }
+  for (; index < words_count && words[index] == skipped; ++index);
+  return index;
+}
 
-  the amount of shifts for the bitmask is calculated by:
-  1) the amount of trailing zeros in the bitset; and
-  2) the amount of leading zeros in the bitmask.
-  in other words, we skip ranges of zeros, and try to skip to a leading range
-  of ones in the bitmask. (we "try" since there may not be any leading range of
-  ones in the bitmask, at which case the bitmask is completely skipped).
+#endif
 
-  when the total amount of shifts is clamped and reset at the the byte
-  granularity, we extract the next byte from the bitset into the bitmask.
-*/
-sintl index_bit_range(uintb range_size, bit of_zeros, const uint *bytes, uint bytes_count)
+/* returns the index of the first word from `index` that isn't `skipped`, or
+   `words_count` */
+static uint skip_bit_words(const uintl *words, uint words_count, uint index, uintl skipped)
 {
-  sintl range_index = -1;
-  uintb byte_granularity = sizeof(*bytes) * byte_width; 
-
-  /* i know... it's not ideal to limit the range */
-  assert(range_size <= byte_granularity * 2);
+#if defined(ON_ARCHITECTURE_X64)
+  if (supports_avx2) return skip_bit_words_avx2(words, words_count, index, skipped);
+#endif
+  for (; index < words_count && words[index] == skipped; ++index);
+  return index;
+}
 
-  uintl mask = (1 << range_size) - 1;
-  uintb shift_count = 0;
-  uint byte_index = 0;
-  for (;;)
+/* the bits that begin ranges of ones of `range_size` within the word */
+static uintl get_bit_range_beginnings(uintl word, uint range_size)
+{
+  /* each bit is and-ed with those after it, doubling the ranges it stands
+     for until they're of the size */
+  for (uint size = 1; size < range_size;)
   {
-    if (byte_index == bytes_count) break;
+    uint shift = get_minimum(size, range_size - size);
+    word &= word >> shift;
+    size += shift;
+  }
+  return word;
+}
 
-    /* buffer bits as a bitmask */
-    uintl buffer = (uintl)0 | (uintl)bytes[byte_index];
-    if (byte_index != bytes_count - 1) buffer |= ((uintl)bytes[byte_index + 1] << byte_granularity);
+/*
+ALGORITHM
 
-    /* flip the bits because the user wants to search for a range of zeros
-       instead of a range of ones */
-    if (of_zeros) buffer = ~buffer;
+  the words are scanned for a range of ones, which is either within a word,
+  or runs from the leading ones of a word over full words into the trailing
+  ones of another. the range running into a word is compared first, since it
+  begins before any within it; then those within are found at once by
+  `get_bit_range_beginnings`; then the leading ones run into the next word.
 
-    /* skip the trailing zeros */
-    shift_count += ctz(buffer >> shift_count);
+  while no range runs, the words without ones are skipped, 4 at a time in
+  AVX2. a range of zeros is searched as one of ones in the flipped words.
+*/
+sintl index_bit_range(uint range_size, bit of_zeros, const uintl *words, uint words_count)
+{
+  assert(range_size);
+  uintl flipping = of_zeros ? ~(uintl)0 : 0;
+  uintl range_index = 0, running_size = 0;
+  for (uint i = 0; i < words_count; ++i)
+  {
+    if (!running_size)
+    {
+      i = skip_bit_words(words, words_count, i, flipping);
+      if (i == words_count) break;
+    }
+    uintl word = words[i] ^ flipping;
+    uintl word_index = (uintl)i * bitmap_word_width;
+    if (!running_size) range_index = word_index;
 
-    /* try to extract the next byte */
-    if (shift_count >= byte_granularity)
+    if (!~word)
     {
-      ++byte_index;
-      shift_count = 0;
+      running_size += bitmap_word_width;
+      if (running_size >= range_size) return (sintl)range_index;
       continue;
     }
+    if (running_size + ctz(~word) >= range_size) return (sintl)range_index;
 
-    /* skip the compare the bitmask */
-    uintl shifted_mask = mask << shift_count;
-    uintl masked = buffer & shifted_mask;
-    if (masked == shifted_mask)
+    if (range_size <= bitmap_word_width)
     {
-      range_index = byte_index * byte_granularity + shift_count;
-      break;
+      uintl beginnings = get_bit_range_beginnings(word, range_size);
+      if (beginnings) return (sintl)(word_index + ctz(beginnings));
     }
+    running_size = clz(~word);
+    range_index = word_index + bitmap_word_width - running_size;
+  }
+  return -1;
+}
 
-    /* try to skip to the leading range of ones */
-    uintb leading_zeros_count = clz(~masked << (byte_granularity * 2 - range_size));
-    shift_count += range_size - leading_zeros_count;
+void toggle_bits(uintl index, uint count, uintl *words)
+{
+  uintl *word = words + index / bitmap_word_width;
+  uint shift = (uint)(index % bitmap_word_width);
+  while (count)
+  {
+    uint size = get_minimum(count, bitmap_word_width - shift);
+    uintl mask = size == bitmap_word_width ? ~(uintl)0 : (((uintl)1 << size) - 1) << shift;
+    *word++ ^= mask;
+    count -= size;
+    shift = 0;
   }
-  return range_index;
 }
 
-sintl toggle_bit_range(uintb range_size, bit of_zero, uint *bytes, uint bytes_count)
+sintl toggle_bit_range(uint range_size, bit of_zeros, uintl *words, uint words_count)
 {
-  sintl index = index_bit_range(range_size, of_zero, bytes, bytes_count);
+  sintl index = index_bit_range(range_size, of_zeros, words, words_count);
   if (index < 0) return -1;
-  uint byte_granularity = sizeof(uint) * byte_width;
-  uint *byte = bytes + index / byte_granularity;
-  *byte ^= ((1 << range_size) - 1) << (index % byte_granularity);
+  toggle_bits((uintl)index, range_size, words);
   return index;
 }
 
 /*****************************************************************************/
 
+inline uint get_minimum(uint a, uint b)
+{
+  return a <= b ? a : b;
+}
+
 inline uint get_maximum(uint a, uint b)
 {
   return a >= b ? a : b;
@@ -126,6 +181,18 @@ inline sintl compare_sized_string(const utf8 *left, const utf8 *right, uint size
   return strncmp(left, right, size);
 }
 
+/* FNV-1a */
+uint hash_string(const utf8 *string, uint size)
+{
+  uint hash = 0x811c9dc5;
+  for (uint i = 0; i < size; ++i)
+  {
+    hash ^= (byte)string[i];
+    hash *= 0x01000193;
+  }
+  return hash;
+}
+
 static const byte utf8_classes[32] =
 {
   1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
@@ -228,6 +295,283 @@ byte encode_utf8(utf8 string[4], utf32 rune)
   return increment;
 }
 
+/*
+ALGORITHM
+
+  the string is validated in blocks with the lookup algorithm of Keiser and
+  Lemire ("Validating UTF-8 In Less Than One Instruction Per Byte").
+
+  every byte is classified against the byte before it by three 16-entry
+  lookups (the high nibble of the prior byte, the low nibble of the prior
+  byte, and the high nibble of the current byte). the AND of the three is
+  nonzero exactly where the pair is an error, with the exception of a
+  continuation after a continuation, which is only an error if the byte two
+  or three places before wasn't a leading byte of a 3 or 4 byte sequence.
+
+  blocks of only ASCII are skipped after checking that the prior block didn't
+  end in an incomplete sequence.
+
+  because the vectorized check only tells us that a block is erroneous, the
+  exact offset is found by rescanning from the last rune boundary before the
+  block.
+*/
+
+#define utf8_too_short      ((byte)bit1) /* 11______ 0_______ or 11______ 11______ */
+#define utf8_too_long       ((byte)bit2) /* 0_______ 10______ */
+#define utf8_overlong_3     ((byte)bit3) /* 11100000 100_____ */
+#define utf8_too_large      ((byte)bit4) /* 11110100 1001____ or above */
+#define utf8_surrogate      ((byte)bit5) /* 11101101 101_____ */
+#define utf8_overlong_2     ((byte)bit6) /* 1100000_ 10______ */
+#define utf8_too_large_1000 ((byte)bit7) /* 11110101 1000____ or above */
+#define utf8_overlong_4     ((byte)bit7) /* 11110000 1000____ */
+#define utf8_two_continues  ((byte)bit8) /* 10______ 10______ */
+#define utf8_carry          (utf8_too_short | utf8_too_long | utf8_two_continues)
+
+static const byte utf8_first_high_errors[16] =
+{
+  /* 0_______ ________ */
+  utf8_too_long, utf8_too_long, utf8_too_long, utf8_too_long,
+  utf8_too_long, utf8_too_long, utf8_too_long, utf8_too_long,
+  /* 10______ ________ */
+  utf8_two_continues, utf8_two_continues, utf8_two_continues, utf8_two_continues,
+  /* 1100____ ________ */
+  utf8_too_short | utf8_overlong_2,
+  /* 1101____ ________ */
+  utf8_too_short,
+  /* 1110____ ________ */
+  utf8_too_short | utf8_overlong_3 | utf8_surrogate,
+  /* 1111____ ________ */
+  utf8_too_short | utf8_too_large | utf8_too_large_1000 | utf8_overlong_4,
+};
+
+static const byte utf8_first_low_errors[16] =
+{
+  /* ____0000 ________ */
+  utf8_carry | utf8_overlong_3 | utf8_overlong_2 | utf8_overlong_4,
+  /* ____0001 ________ */
+  utf8_carry | utf8_overlong_2,
+  /* ____001_ ________ */
+  utf8_carry,
+  utf8_carry,
+  /* ____0100 ________ */
+  utf8_carry | utf8_too_large,
+  /* ____0101 ________ */
+  utf8_carry | utf8_too_large | utf8_too_large_1000,
+  /* ____011_ ________ */
+  utf8_carry | utf8_too_large | utf8_too_large_1000,
+  utf8_carry | utf8_too_large | utf8_too_large_1000,
+  /* ____1___ ________ */
+  utf8_carry | utf8_too_large | utf8_too_large_1000,
+  utf8_carry | utf8_too_large | utf8_too_large_1000,
+  utf8_carry | utf8_too_large | utf8_too_large_1000,
+  utf8_carry | utf8_too_large | utf8_too_large_1000,
+  utf8_carry | utf8_too_large | utf8_too_large_1000,
+  /* ____1101 ________ */
+  utf8_carry | utf8_too_large | utf8_too_large_1000 | utf8_surrogate,
+  utf8_carry | utf8_too_large | utf8_too_large_1000,
+  utf8_carry | utf8_too_large | utf8_too_large_1000,
+};
+
+static const byte utf8_second_high_errors[16] =
+{
+  /* ________ 0_______ */
+  utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short,
+  utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short,
+  /* ________ 1000____ */
+  utf8_too_long | utf8_overlong_2 | utf8_two_continues | utf8_overlong_3 | utf8_too_large_1000 | utf8_overlong_4,
+  /* ________ 1001____ */
+  utf8_too_long | utf8_overlong_2 | utf8_two_continues | utf8_overlong_3 | utf8_too_large,
+  /* ________ 101_____ */
+  utf8_too_long | utf8_overlong_2 | utf8_two_continues | utf8_surrogate | utf8_too_large,
+  utf8_too_long | utf8_overlong_2 | utf8_two_continues | utf8_surrogate | utf8_too_large,
+  /* ________ 11______ */
+  utf8_too_short, utf8_too_short, utf8_too_short, utf8_too_short,
+};
+
+/* the maximum values of the last bytes of a block that don't begin an
+   incomplete sequence */
+static const byte utf8_incomplete_maximums[32] =
+{
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+  0xff, 0xff, 0xff, 0xff, 0xff, 0xef, 0xdf, 0xbf,
+};
+
+static sintl validate_utf8_scalar(const utf8 *string, uint size)
+{
+  const byte *bytes = (const byte *)string;
+  uint offset = 0;
+  while (offset < size)
+  {
+    byte first = bytes[offset];
+    if (first < 0x80)
+    {
+      offset += 1;
+      continue;
+    }
+
+    /* the valid range of the second byte depends on the first to exclude
+       overlong encodings, surrogates and runes above U+10FFFF */
+    uint continues_count;
+    byte second_minimum = 0x80, second_maximum = 0xbf;
+    if      (first >= 0xc2 && first <= 0xdf) continues_count = 1;
+    else if (first == 0xe0)                  continues_count = 2, second_minimum = 0xa0;
+    else if (first == 0xed)                  continues_count = 2, second_maximum = 0x9f;
+    else if (first >= 0xe1 && first <= 0xef) continues_count = 2;
+    else if (first == 0xf0)                  continues_count = 3, second_minimum = 0x90;
+    else if (first == 0xf4)                  continues_count = 3, second_maximum = 0x8f;
+    else if (first >= 0xf1 && first <= 0xf3) continues_count = 3;
+    else return offset;
+
+    if (size - offset <= continues_count) return offset;
+    if (bytes[offset + 1] < second_minimum || bytes[offset + 1] > second_maximum) return offset;
+    for (uint i = 2; i <= continues_count; ++i)
+      if ((bytes[offset + i] & 0xc0) != 0x80) return offset;
+    offset += continues_count + 1;
+  }
+  return -1;
+}
+
+/* rescans an erroneous block from the last rune boundary before it */
+static sintl locate_invalid_utf8(const utf8 *string, uint size, uint block_offset)
+{
+  /* a sequence is at most 4 bytes, so a boundary is within 3 bytes before */
+  uint offset = block_offset >= 3 ? block_offset - 3 : 0;
+  while (offset < block_offset && ((byte)string[offset] & 0xc0) == 0x80) ++offset;
+  sintl invalid_offset = validate_utf8_scalar(string + offset, size - offset);
+  ASSERT(invalid_offset >= 0);
+  return offset + invalid_offset;
+}
+
+#if defined(ON_ARCHITECTURE_X64)
+
+TARGETING("ssse3")
+static sintl validate_utf8_ssse3(const utf8 *string, uint size)
+{
+  const __m128i first_high_errors  = _mm_loadu_si128((const __m128i *)utf8_first_high_errors);
+  const __m128i first_low_errors   = _mm_loadu_si128((const __m128i *)utf8_first_low_errors);
+  const __m128i second_high_errors = _mm_loadu_si128((const __m128i *)utf8_second_high_errors);
+  const __m128i incomplete_maximum = _mm_loadu_si128((const __m128i *)(utf8_incomplete_maximums + 16));
+  const __m128i low_nibbles        = _mm_set1_epi8(0x0f);
+
+  __m128i prior_block = _mm_setzero_si128();
+  __m128i prior_incomplete = _mm_setzero_si128();
+  alignas(16) byte tail[16];
+
+  for (uint offset = 0; offset < size; offset += 16)
+  {
+    __m128i block;
+    if (size - offset >= 16) block = _mm_loadu_si128((const __m128i *)(string + offset));
+    else
+    {
+      /* the tail is padded with ASCII, so a truncated sequence fails as "too short" */
+      zero(tail, sizeof(tail));
+      copy(tail, string + offset, size - offset);
+      block = _mm_load_si128((const __m128i *)tail);
+    }
+
+    __m128i errors;
+    if (!_mm_movemask_epi8(block)) errors = prior_incomplete;
+    else
+    {
+      __m128i prior1 = _mm_alignr_epi8(block, prior_block, 15);
+      __m128i prior2 = _mm_alignr_epi8(block, prior_block, 14);
+      __m128i prior3 = _mm_alignr_epi8(block, prior_block, 13);
+
+      __m128i first_high  = _mm_shuffle_epi8(first_high_errors,  _mm_and_si128(_mm_srli_epi16(prior1, 4), low_nibbles));
+      __m128i first_low   = _mm_shuffle_epi8(first_low_errors,   _mm_and_si128(prior1, low_nibbles));
+      __m128i second_high = _mm_shuffle_epi8(second_high_errors, _mm_and_si128(_mm_srli_epi16(block, 4), low_nibbles));
+      __m128i special_cases = _mm_and_si128(_mm_and_si128(first_high, first_low), second_high);
+
+      /* only 111_____ two bytes before, or 1111____ three bytes before, saturate to >= 0x80 */
+      __m128i is_third  = _mm_subs_epu8(prior2, _mm_set1_epi8((char)(0xe0 - 0x80)));
+      __m128i is_fourth = _mm_subs_epu8(prior3, _mm_set1_epi8((char)(0xf0 - 0x80)));
+      __m128i must_continue = _mm_and_si128(_mm_or_si128(is_third, is_fourth), _mm_set1_epi8((char)0x80));
+
+      errors = _mm_xor_si128(must_continue, special_cases);
+      prior_incomplete = _mm_subs_epu8(block, incomplete_maximum);
+    }
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(errors, _mm_setzero_si128())) != 0xffff)
+      return locate_invalid_utf8(string, size, offset);
+    prior_block = block;
+  }
+
+  /* the last block may end in an incomplete sequence */
+  if (_mm_movemask_epi8(_mm_cmpeq_epi8(prior_incomplete, _mm_setzero_si128())) != 0xffff)
+    return locate_invalid_utf8(string, size, size & ~(uint)15);
+  return -1;
+}
+
+TARGETING("avx2")
+static sintl validate_utf8_avx2(const utf8 *string, uint size)
+{
+  /* `vpshufb` looks up within each 128-bit lane, so the tables are repeated */
+  const __m256i first_high_errors  = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)utf8_first_high_errors));
+  const __m256i first_low_errors   = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)utf8_first_low_errors));
+  const __m256i second_high_errors = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *)utf8_second_high_errors));
+  const __m256i incomplete_maximum = _mm256_loadu_si256((const __m256i *)utf8_incomplete_maximums);
+  const __m256i low_nibbles        = _mm256_set1_epi8(0x0f);
+
+  __m256i prior_block = _mm256_setzero_si256();
+  __m256i prior_incomplete = _mm256_setzero_si256();
+  alignas(32) byte tail[32];
+
+  for (uint offset = 0; offset < size; offset += 32)
+  {
+    __m256i block;
+    if (size - offset >= 32) block = _mm256_loadu_si256((const __m256i *)(string + offset));
+    else
+    {
+      zero(tail, sizeof(tail));
+      copy(tail, string + offset, size - offset);
+      block = _mm256_load_si256((const __m256i *)tail);
+    }
+
+    __m256i errors;
+    if (!_mm256_movemask_epi8(block)) errors = prior_incomplete;
+    else
+    {
+      /* the upper lane of the prior block followed by the lower lane of this block */
+      __m256i straddle = _mm256_permute2x128_si256(prior_block, block, 0x21);
+      __m256i prior1 = _mm256_alignr_epi8(block, straddle, 15);
+      __m256i prior2 = _mm256_alignr_epi8(block, straddle, 14);
+      __m256i prior3 = _mm256_alignr_epi8(block, straddle, 13);
+
+      __m256i first_high  = _mm256_shuffle_epi8(first_high_errors,  _mm256_and_si256(_mm256_srli_epi16(prior1, 4), low_nibbles));
+      __m256i first_low   = _mm256_shuffle_epi8(first_low_errors,   _mm256_and_si256(prior1, low_nibbles));
+      __m256i second_high = _mm256_shuffle_epi8(second_high_errors, _mm256_and_si256(_mm256_srli_epi16(block, 4), low_nibbles));
+      __m256i special_cases = _mm256_and_si256(_mm256_and_si256(first_high, first_low), second_high);
+
+      __m256i is_third  = _mm256_subs_epu8(prior2, _mm256_set1_epi8((char)(0xe0 - 0x80)));
+      __m256i is_fourth = _mm256_subs_epu8(prior3, _mm256_set1_epi8((char)(0xf0 - 0x80)));
+      __m256i must_continue = _mm256_and_si256(_mm256_or_si256(is_third, is_fourth), _mm256_set1_epi8((char)0x80));
+
+      errors = _mm256_xor_si256(must_continue, special_cases);
+      prior_incomplete = _mm256_subs_epu8(block, incomplete_maximum);
+    }
+
+    if (!_mm256_testz_si256(errors, errors)) return locate_invalid_utf8(string, size, offset);
+    prior_block = block;
+  }
+
+  if (!_mm256_testz_si256(prior_incomplete, prior_incomplete))
+    return locate_invalid_utf8(string, size, size & ~(uint)31);
+  return -1;
+}
+
+#endif
+
+sintl validate_utf8(const utf8 *string, uint size)
+{
+#if defined(ON_ARCHITECTURE_X64)
+  if (supports_avx2)  return validate_utf8_avx2(string, size);
+  if (supports_ssse3) return validate_utf8_ssse3(string, size);
+#endif
+  return validate_utf8_scalar(string, size);
+}
+
 /*****************************************************************************/
 
 inline uint get_backward_alignment(address x, uint a)
@@ -268,13 +612,44 @@ inline void move(void *destination, const void *source, uint size)
   memmove(destination, source, size);
 }
 
+#if defined(ON_PLATFORM_LINUX)
+/* the reservation is a huge page longer than the allocation, and its ends
+   before and after the aligned allocation are unmapped, so `deallocate`
+   unmaps all that's left */
+static void *allocate_huge_pages(uint size)
+{
+#if defined(RESERVING_HUGE_PAGES) && defined(MAP_HUGETLB)
+  /* the reserved pages run out, or were never reserved */
+  if (!(size % huge_page_size))
+  {
+    void *memory = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (memory != MAP_FAILED) return memory;
+  }
+#endif
+  uintl mapped_size = align_forwards(size, memory_page_size);
+  uintl slack_size = huge_page_size - memory_page_size;
+  byte *reservation = mmap(0, mapped_size + slack_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (reservation == MAP_FAILED) return 0;
+  byte *memory = (byte *)align_forwards((address)reservation, huge_page_size);
+  uintl head_size = (uintl)(memory - reservation);
+  if (head_size) (void)munmap(reservation, head_size);
+  if (slack_size - head_size) (void)munmap(memory + mapped_size, slack_size - head_size);
+#if defined(MADV_HUGEPAGE)
+  /* which fails where transparent huge pages are disabled, leaving small ones */
+  (void)madvise(memory, mapped_size, MADV_HUGEPAGE);
+#endif
+  return memory;
+}
+#endif
+
 inline void *allocate(uint size)
 {
 #if defined(ON_PLATFORM_WIN32)
   void *memory = VirtualAlloc(0, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
   if (!memory) goto failed;
 #elif defined(ON_PLATFORM_LINUX)
-  void *memory = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  void *memory = size >= huge_page_size ? allocate_huge_pages(size) : 0;
+  if (!memory) memory = mmap(0, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
   if (memory == MAP_FAILED) goto failed;
 #endif
   return memory;
@@ -292,8 +667,25 @@ inline void deallocate(void *memory, uint size)
 #endif
 }
 
+bit protect_executable(void *memory, uint size)
+{
+#if defined(ON_PLATFORM_WIN32)
+  DWORD old_protection;
+  return VirtualProtect(memory, size, PAGE_EXECUTE_READ, &old_protection) != 0;
+#elif defined(ON_PLATFORM_LINUX)
+  return mprotect(memory, size, PROT_READ | PROT_EXEC) == 0;
+#endif
+}
+
 inline void *reallocate(uint size, void *old_memory, uint old_size)
 {
+  if (!old_memory) return allocate(size);
+#if defined(ON_PLATFORM_LINUX)
+  /* the pages are moved rather than copied, unless the kernel can't, like
+     those of the reserved huge pages of older ones */
+  void *remapped = mremap(old_memory, old_size, size, MREMAP_MAYMOVE);
+  if (remapped != MAP_FAILED) return remapped;
+#endif
   void *memory = allocate(size);
   copy(memory, old_memory, old_size);
   deallocate(old_memory, old_size);
@@ -324,6 +716,15 @@ void *push(uint size, uint alignment, allocator *allocator)
     if (!allocator->minimum_buffer_size) allocator->minimum_buffer_size = default_allocator_minimum_buffer_size;
     uint buffer_size = get_maximum(size, allocator->minimum_buffer_size);
     uint allocation_size = sizeof(buffer) + buffer_size;
+    if (allocator->is_huge && allocator->active_buffer)
+    {
+      /* the buffers of a huge arena double until they're huge pages, and the
+         memory the pages are rounded up to is the buffer's */
+      uint prior_allocation_size = sizeof(buffer) + allocator->active_buffer->size;
+      allocation_size = get_maximum(allocation_size, get_minimum(2 * prior_allocation_size, maximum_huge_buffer_size));
+      if (!allocator->allocator && allocation_size >= huge_page_size) allocation_size = (uint)align_forwards(allocation_size, huge_page_size);
+      buffer_size = allocation_size - sizeof(buffer);
+    }
     buffer *new_buffer = allocator->allocator ? push(allocation_size, alignof(buffer), allocator->allocator) : allocate(allocation_size);
     new_buffer->prior = allocator->active_buffer;
     if (allocator->active_buffer) allocator->active_buffer->next = new_buffer;
@@ -351,19 +752,37 @@ void get_scratch(scratch *scratch, allocator *allocator)
 
 void end_scratch(scratch *scratch)
 {
-  buffer *current_buffer = scratch->allocator->active_buffer;
-  for (
-    buffer *prior_buffer;
-    current_buffer && current_buffer != scratch->buffer;
-    current_buffer = prior_buffer)
+  /* the buffers past the point are emptied and kept for what's pushed next,
+     like those of `reset_allocator`; those a reset kept may follow the active
+     one, so none are cut from the chain */
+  allocator *allocator = scratch->allocator;
+  for (buffer *current_buffer = scratch->buffer ? scratch->buffer->next : allocator->first_buffer; current_buffer; current_buffer = current_buffer->next)
+    current_buffer->mass = 0;
+  if (scratch->buffer) scratch->buffer->mass = scratch->mass;
+  allocator->active_buffer = scratch->buffer;
+}
+
+void reset_allocator(allocator *allocator)
+{
+  for (buffer *current_buffer = allocator->first_buffer; current_buffer; current_buffer = current_buffer->next) current_buffer->mass = 0;
+  allocator->active_buffer = allocator->first_buffer;
+}
+
+void release_allocator(allocator *allocator)
+{
+  /* the buffers of a nested allocator are its parent's */
+  if (allocator->allocator)
   {
-    prior_buffer = current_buffer->prior;
-    if (!scratch->allocator->allocator) deallocate(current_buffer, sizeof(buffer) + current_buffer->size);
-    else current_buffer->mass = 0;
+    reset_allocator(allocator);
+    return;
   }
-  ASSERT(current_buffer == scratch->buffer);
-  if (current_buffer) current_buffer->mass = scratch->mass;
-  scratch->allocator->active_buffer = current_buffer;
+  for (buffer *current_buffer = allocator->first_buffer, *next_buffer; current_buffer; current_buffer = next_buffer)
+  {
+    next_buffer = current_buffer->next;
+    deallocate(current_buffer, sizeof(buffer) + current_buffer->size);
+  }
+  allocator->first_buffer = 0;
+  allocator->active_buffer = 0;
 }
 
 /*****************************************************************************/
@@ -379,6 +798,175 @@ static void initialize_context(void)
 
 /*****************************************************************************/
 
+void *grow_array(void *elements, uint *capacity, uint count, uint element_size)
+{
+  if (count <= *capacity) return elements;
+  uint grown_capacity = *capacity ? *capacity : get_maximum(memory_page_size / element_size, 1);
+  while (grown_capacity < count) grown_capacity *= 2;
+  elements = reallocate(grown_capacity * element_size, elements, *capacity * element_size);
+  *capacity = grown_capacity;
+  return elements;
+}
+
+DEFINE_ARRAY(uint_array, uint)
+
+/*****************************************************************************/
+
+uint match_map_group(const byte *controls, byte control)
+{
+#if defined(ON_ARCHITECTURE_X64)
+  __m128i group = _mm_loadu_si128((const __m128i *)controls);
+  return (uint)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8((char)control)));
+#else
+  uint matches = 0;
+  for (uint i = 0; i < map_group_size; ++i) matches |= (uint)(controls[i] == control) << i;
+  return matches;
+#endif
+}
+
+uint get_map_slots_count(uint entries_count)
+{
+  uint slots_count = map_group_size;
+  while (slots_count / 8 * 7 < entries_count) slots_count *= 2;
+  return slots_count;
+}
+
+uint find_empty_map_slot(const byte *controls, uint slots_count, uint hash)
+{
+  uint groups_mask = slots_count / map_group_size - 1;
+  for (uint group = hash & groups_mask, step = 0;; group = (group + ++step) & groups_mask)
+  {
+    uint empty_slots = match_map_group(controls + group * map_group_size, empty_map_control);
+    if (empty_slots) return group * map_group_size + ctz(empty_slots);
+  }
+}
+
+/*****************************************************************************/
+
+struct slot_chunk
+{
+  uint  index;       /* among the chunks of its pool */
+  uint  slots_count; /* a multiple of a word of the bitmap */
+  uint  free_word;   /* before which every slot is in use */
+  byte *slots;
+  uintl used[];      /* a bit of each slot */
+};
+
+DEFINE_ARRAY(slot_chunk_array, slot_chunk *)
+
+static slot_chunk *add_slot_chunk(slot_pool *pool)
+{
+  /* every slot costs a bit besides its bytes, and the words of the bitmap
+     are full; a word is given up to the alignment of the slots */
+  uint slots_count = (uint)(((uintl)slot_chunk_size - sizeof(slot_chunk)) * byte_width / (pool->slot_size * byte_width + 1));
+  slots_count = slots_count / bitmap_word_width * bitmap_word_width - bitmap_word_width;
+
+  /* big allocations are aligned to huge pages, so chunks of their size are
+     aligned to it */
+  slot_chunk *chunk = allocate(slot_chunk_size);
+  if (get_backward_alignment((address)chunk, slot_chunk_size)) pool->has_unaligned_chunks = 1;
+  chunk->index = pool->chunks.count;
+  chunk->slots_count = slots_count;
+  chunk->free_word = 0;
+  chunk->slots = (byte *)align_forwards((address)(chunk->used + slots_count / bitmap_word_width), pool->slot_size);
+  zero(chunk->used, slots_count / byte_width);
+
+  *add_to_slot_chunk_array(1, &pool->chunks) = chunk;
+  *add_to_uint_array(1, &pool->failed_sizes) = slots_count + 1;
+
+  /* chunks are added seldom, so they're inserted in order */
+  slot_chunk **ordered = add_to_slot_chunk_array(1, &pool->ordered_chunks);
+  while (ordered > pool->ordered_chunks.elements && ordered[-1] > chunk)
+  {
+    *ordered = ordered[-1];
+    --ordered;
+  }
+  *ordered = chunk;
+  return chunk;
+}
+
+void *take_slots(uint size, slot_pool *pool)
+{
+  uint count = (uint)align_forwards(size, pool->slot_size) / pool->slot_size;
+  if (!pool->least_count || count < pool->least_count)
+  {
+    pool->least_count = count;
+    pool->full_chunks_count = 0;
+  }
+  for (uint i = pool->full_chunks_count;; ++i)
+  {
+    /* the chunks filled up are passed without touching them */
+    if (i < pool->chunks.count && count >= pool->failed_sizes.elements[i]) continue;
+    slot_chunk *chunk = i < pool->chunks.count ? pool->chunks.elements[i] : add_slot_chunk(pool);
+    assert(count <= chunk->slots_count);
+
+    uint words_count = chunk->slots_count / bitmap_word_width;
+    sintl index = toggle_bit_range(count, 1, chunk->used + chunk->free_word, words_count - chunk->free_word);
+    if (index < 0)
+    {
+      pool->failed_sizes.elements[i] = count;
+      if (i == pool->full_chunks_count && count == pool->least_count) ++pool->full_chunks_count;
+      continue;
+    }
+    index += (sintl)chunk->free_word * bitmap_word_width;
+    chunk->free_word = skip_bit_words(chunk->used, words_count, chunk->free_word, ~(uintl)0);
+    if (chunk->free_word == words_count) pool->failed_sizes.elements[i] = 1;
+    while (pool->full_chunks_count < pool->chunks.count && pool->failed_sizes.elements[pool->full_chunks_count] <= pool->least_count) ++pool->full_chunks_count;
+
+    byte *memory = chunk->slots + (uintl)index * pool->slot_size;
+    zero(memory, count * pool->slot_size);
+    return memory;
+  }
+}
+
+/* the chunk whose slots the memory is of, or 0 */
+static slot_chunk *find_slot_chunk(const void *memory, slot_pool *pool)
+{
+  /* the last chunk beginning at or before the memory */
+  slot_chunk **chunks = pool->ordered_chunks.elements;
+  uint low = 0, high = pool->ordered_chunks.count;
+  while (low < high)
+  {
+    uint middle = low + (high - low) / 2;
+    if ((const void *)chunks[middle] <= memory) low = middle + 1;
+    else high = middle;
+  }
+  if (!low) return 0;
+  slot_chunk *chunk = chunks[low - 1];
+  if ((const byte *)memory >= chunk->slots && (const byte *)memory < chunk->slots + (uintl)chunk->slots_count * pool->slot_size) return chunk;
+  return 0;
+}
+
+bit has_slots(const void *memory, slot_pool *pool)
+{
+  return find_slot_chunk(memory, pool) != 0;
+}
+
+void give_slots(void *memory, uint size, slot_pool *pool)
+{
+  uint count = (uint)align_forwards(size, pool->slot_size) / pool->slot_size;
+  slot_chunk *chunk = pool->has_unaligned_chunks ? find_slot_chunk(memory, pool)
+                                                 : (slot_chunk *)((address)memory - get_backward_alignment((address)memory, slot_chunk_size));
+  uintl index = (uintl)((byte *)memory - chunk->slots) / pool->slot_size;
+  toggle_bits(index, count, chunk->used);
+  chunk->free_word = get_minimum(chunk->free_word, (uint)(index / bitmap_word_width));
+  pool->failed_sizes.elements[chunk->index] = chunk->slots_count + 1;
+  pool->full_chunks_count = get_minimum(pool->full_chunks_count, chunk->index);
+}
+
+void release_slot_pool(slot_pool *pool)
+{
+  for (uint i = 0; i < pool->chunks.count; ++i) deallocate(pool->chunks.elements[i], slot_chunk_size);
+  release_slot_chunk_array(&pool->chunks);
+  release_slot_chunk_array(&pool->ordered_chunks);
+  release_uint_array(&pool->failed_sizes);
+  pool->least_count = 0;
+  pool->full_chunks_count = 0;
+  pool->has_unaligned_chunks = 0;
+}
+
+/*****************************************************************************/
+
 handle open_file(const char *file_path)
 {
   handle file_handle;
@@ -387,7 +975,7 @@ handle open_file(const char *file_path)
   if (win32_file_handle == INVALID_HANDLE_VALUE) goto failed;
   file_handle = win32_file_handle;
 #elif defined(ON_PLATFORM_LINUX)
-  int linux_file_handle = open(file_path, O_RDWR);
+  int linux_file_handle = open(file_path, O_RDONLY | O_CLOEXEC);
   if (linux_file_handle == -1) goto failed;
   file_handle = linux_file_handle;
 #endif
@@ -397,6 +985,24 @@ failed:
   jump(*context.failure_jump_point, 1);
 }
 
+handle create_file(const char *file_path)
+{
+  handle file_handle;
+#if defined(ON_PLATFORM_WIN32)
+  HANDLE win32_file_handle = CreateFileA(file_path, GENERIC_WRITE, 0, 0, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+  if (win32_file_handle == INVALID_HANDLE_VALUE) goto failed;
+  file_handle = win32_file_handle;
+#elif defined(ON_PLATFORM_LINUX)
+  int linux_file_handle = open(file_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (linux_file_handle == -1) goto failed;
+  file_handle = linux_file_handle;
+#endif
+  return file_handle;
+failed:
+  print_failure("Failed to create file.\n");
+  jump(*context.failure_jump_point, 1);
+}
+
 uintl get_file_size(handle file_handle)
 {
   uintl file_size;
@@ -421,10 +1027,11 @@ uint read_from_file(void *buffer, uint buffer_size, handle file_handle)
 #if defined(ON_PLATFORM_WIN32)
   DWORD win32_read_size;
   if (!ReadFile(file_handle, buffer, buffer_size, &win32_read_size, 0)) goto failed;
+  read_size = win32_read_size;
 #elif defined(ON_PLATFORM_LINUX)
   ssize_t linux_read_size = read(file_handle, buffer, buffer_size);
-  if (read_size == -1) goto failed;
-  read_size = linux_read_size; 
+  if (linux_read_size == -1) goto failed;
+  read_size = linux_read_size;
 #endif
   return read_size;
 failed:
@@ -432,6 +1039,42 @@ failed:
   jump(*context.failure_jump_point, 1);
 }
 
+uint write_to_file(const void *buffer, uint buffer_size, handle file_handle)
+{
+  uint written_size;
+#if defined(ON_PLATFORM_WIN32)
+  DWORD win32_written_size;
+  if (!WriteFile(file_handle, buffer, buffer_size, &win32_written_size, 0)) goto failed;
+  written_size = win32_written_size;
+#elif defined(ON_PLATFORM_LINUX)
+  ssize_t linux_written_size = write(file_handle, buffer, buffer_size);
+  if (linux_written_size == -1) goto failed;
+  written_size = linux_written_size;
+#endif
+  return written_size;
+failed:
+  print_failure("Failed to write file.\n");
+  jump(*context.failure_jump_point, 1);
+}
+
+handle get_standard_input(void)
+{
+#if defined(ON_PLATFORM_WIN32)
+  return GetStdHandle(STD_INPUT_HANDLE);
+#elif defined(ON_PLATFORM_LINUX)
+  return STDIN_FILENO;
+#endif
+}
+
+handle get_standard_error(void)
+{
+#if defined(ON_PLATFORM_WIN32)
+  return GetStdHandle(STD_ERROR_HANDLE);
+#elif defined(ON_PLATFORM_LINUX)
+  return STDERR_FILENO;
+#endif
+}
+
 void close_file(handle file_handle)
 {
   (void)close(file_handle);
@@ -439,24 +1082,384 @@ void close_file(handle file_handle)
 
 /*****************************************************************************/
 
-/* this is initialized at runtime in `initialize_base` */
+typedef enum
+{
+  batched_file_state_unopened,
+  batched_file_state_opening, /* and being sized */
+  batched_file_state_reading,
+  batched_file_state_read,
+  batched_file_state_failed,
+} batched_file_state;
+
+typedef struct
+{
+  const char *path;
+  uint8       state;
+  uint8       pending_count; /* of its operations that are submitted */
+  bit         is_sized : 1;
+  sint        descriptor;    /* -1 until it's opened */
+  byte       *memory;
+  uint        memory_size;   /* which a file that shrank keeps */
+  uint        size;
+  uint        read_size;
+#if defined(ON_PLATFORM_LINUX)
+  struct statx status;
+#endif
+} batched_file;
+
+struct file_batch
+{
+  batched_file *files;
+  uint          files_count;
+  uint          next_file;   /* the first that's unopened */
+  uint          waited_file; /* whose memory is released by the next wait, or `files_count` */
+#if defined(ON_PLATFORM_LINUX)
+  int  ring;                 /* -1 where io_uring isn't available */
+  bit  is_ending : 1;        /* so that completions don't submit more */
+  uint entries_count;
+  uint in_flight_count;      /* which never exceeds the entries, so completions never overflow */
+  uint unsubmitted_count;
+  uint held_size;            /* of the files read, but not yet released */
+
+  byte                *submission_ring;
+  uint                 submission_ring_size;
+  byte                *completion_ring;
+  uint                 completion_ring_size;
+  struct io_uring_sqe *entries;
+  uint                 entries_size;
+  uint                *submission_tail;
+  uint                *submission_mask;
+  uint                *submission_array;
+  uint                *completion_head;
+  uint                *completion_tail;
+  uint                *completion_mask;
+  struct io_uring_cqe *completions;
+#endif
+};
+
+#if defined(ON_PLATFORM_LINUX)
+
+#define file_batch_entries_count ((uint)64)
+#define file_batch_ahead_count   ((uint)8)            /* of the files opened ahead of the one waited for */
+#define file_batch_held_size     ((uint)8 * mebibyte) /* beyond which no more files are opened ahead */
+
+typedef enum
+{
+  file_operation_open,
+  file_operation_size,
+  file_operation_read,
+} file_operation;
+
+static bit set_up_ring(file_batch *batch)
+{
+  struct io_uring_params parameters = {0};
+  int ring = (int)syscall(__NR_io_uring_setup, file_batch_entries_count, &parameters);
+  if (ring < 0) return 0;
+
+  uint submission_ring_size = parameters.sq_off.array + parameters.sq_entries * sizeof(uint);
+  uint completion_ring_size = parameters.cq_off.cqes + parameters.cq_entries * sizeof(struct io_uring_cqe);
+  uint entries_size = parameters.sq_entries * sizeof(struct io_uring_sqe);
+  byte *submission_ring = mmap(0, submission_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+  byte *completion_ring = mmap(0, completion_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+  void *entries = mmap(0, entries_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+  if (submission_ring == MAP_FAILED || completion_ring == MAP_FAILED || entries == MAP_FAILED)
+  {
+    if (submission_ring != MAP_FAILED) munmap(submission_ring, submission_ring_size);
+    if (completion_ring != MAP_FAILED) munmap(completion_ring, completion_ring_size);
+    if (entries != MAP_FAILED) munmap(entries, entries_size);
+    close(ring);
+    return 0;
+  }
+
+  batch->ring                 = ring;
+  batch->entries_count        = parameters.sq_entries;
+  batch->submission_ring      = submission_ring;
+  batch->submission_ring_size = submission_ring_size;
+  batch->completion_ring      = completion_ring;
+  batch->completion_ring_size = completion_ring_size;
+  batch->entries              = entries;
+  batch->entries_size         = entries_size;
+  batch->submission_tail      = (uint *)(submission_ring + parameters.sq_off.tail);
+  batch->submission_mask      = (uint *)(submission_ring + parameters.sq_off.ring_mask);
+  batch->submission_array     = (uint *)(submission_ring + parameters.sq_off.array);
+  batch->completion_head      = (uint *)(completion_ring + parameters.cq_off.head);
+  batch->completion_tail      = (uint *)(completion_ring + parameters.cq_off.tail);
+  batch->completion_mask      = (uint *)(completion_ring + parameters.cq_off.ring_mask);
+  batch->completions          = (struct io_uring_cqe *)(completion_ring + parameters.cq_off.cqes);
+  return 1;
+}
+
+static void tear_down_ring(file_batch *batch)
+{
+  munmap(batch->submission_ring, batch->submission_ring_size);
+  munmap(batch->completion_ring, batch->completion_ring_size);
+  munmap(batch->entries, batch->entries_size);
+  close(batch->ring);
+  batch->ring = -1;
+}
+
+/* the operation is submitted upon the next entering of the ring */
+static void queue_operation(uint index, file_operation operation, uint8 opcode, int descriptor, const void *memory, uint size, uintl offset, uint flags,
+                            file_batch *batch)
+{
+  uint tail = *batch->submission_tail;
+  uint slot = tail & *batch->submission_mask;
+  struct io_uring_sqe *entry = &batch->entries[slot];
+  zero(entry, sizeof(*entry));
+  entry->opcode    = opcode;
+  entry->fd        = descriptor;
+  entry->addr      = (uintl)(address)memory;
+  entry->len       = size;
+  entry->off       = offset;
+  entry->rw_flags  = (int)flags; /* which shares `open_flags` and `statx_flags` */
+  entry->user_data = (uintl)index << 2 | operation;
+  batch->submission_array[slot] = slot;
+  __atomic_store_n(batch->submission_tail, tail + 1, __ATOMIC_RELEASE);
+
+  batch->unsubmitted_count += 1;
+  batch->in_flight_count += 1;
+  batch->files[index].pending_count += 1;
+}
+
+static void queue_read(uint index, file_batch *batch)
+{
+  batched_file *file = &batch->files[index];
+  queue_operation(index, file_operation_read, IORING_OP_READ, file->descriptor, file->memory + file->read_size, file->size - file->read_size,
+                  file->read_size, 0, batch);
+}
+
+static void hold_file_memory(batched_file *file, file_batch *batch)
+{
+  file->memory_size = file->size + 1;
+  file->memory = allocate(file->memory_size);
+  batch->held_size += file->memory_size;
+}
+
+/* the opens and sizes of the next files, as many as there's room for; the
+   sizes are only known once they complete, so the files read ahead are
+   bounded by count as well as by size, and the waited file is opened
+   regardless */
+static void queue_openings(uint waited_index, file_batch *batch)
+{
+  for (; batch->next_file < batch->files_count && batch->in_flight_count + 2 <= batch->entries_count
+         && (batch->next_file <= waited_index
+             || (batch->next_file <= waited_index + file_batch_ahead_count && batch->held_size < file_batch_held_size));
+       ++batch->next_file)
+  {
+    batched_file *file = &batch->files[batch->next_file];
+    file->state = batched_file_state_opening;
+    queue_operation(batch->next_file, file_operation_open, IORING_OP_OPENAT, AT_FDCWD, file->path, 0, 0, O_RDONLY | O_CLOEXEC, batch);
+    queue_operation(batch->next_file, file_operation_size, IORING_OP_STATX, AT_FDCWD, file->path, STATX_SIZE, (uintl)(address)&file->status, 0, batch);
+  }
+}
+
+static void release_file_memory(batched_file *file, file_batch *batch)
+{
+  if (!file->memory) return;
+  deallocate(file->memory, file->memory_size);
+  batch->held_size -= file->memory_size;
+  file->memory = 0;
+}
+
+static void finish_file(batched_file *file, batched_file_state state, file_batch *batch)
+{
+  file->state = state;
+  if (file->descriptor >= 0) close(file->descriptor);
+  file->descriptor = -1;
+  if (state == batched_file_state_failed) release_file_memory(file, batch);
+}
+
+/* a completion frees the entry of its operation, so the next one of its file
+   always has room */
+static void complete_operation(uintl user_data, sint result, file_batch *batch)
+{
+  uint index = (uint)(user_data >> 2);
+  batched_file *file = &batch->files[index];
+  file->pending_count -= 1;
+  batch->in_flight_count -= 1;
+
+  if (result < 0 && file->state != batched_file_state_failed)
+  {
+    if ((file_operation)(user_data & 3) == file_operation_open || !file->pending_count) finish_file(file, batched_file_state_failed, batch);
+    else file->state = batched_file_state_failed;
+    return;
+  }
+  switch ((file_operation)(user_data & 3))
+  {
+  case file_operation_open:
+    file->descriptor = result;
+    break;
+  case file_operation_size:
+    file->is_sized = 1;
+    file->size = (uint)file->status.stx_size;
+    break;
+  case file_operation_read:
+    file->read_size += (uint)result;
+    /* a file that shrank ends early */
+    if (!result) file->size = file->read_size;
+    break;
+  }
+  if (file->pending_count) return;
+
+  if (file->state == batched_file_state_failed) finish_file(file, batched_file_state_failed, batch);
+  else if (file->state == batched_file_state_opening)
+  {
+    hold_file_memory(file, batch);
+    file->state = batched_file_state_reading;
+  }
+  if (file->state != batched_file_state_reading) return;
+  if (file->read_size == file->size) finish_file(file, batched_file_state_read, batch);
+  else if (batch->is_ending) finish_file(file, batched_file_state_failed, batch);
+  else queue_read(index, batch);
+}
+
+/* submits the queued operations, and completes those that are done */
+static bit enter_ring(uint waited_count, file_batch *batch)
+{
+  for (;;)
+  {
+    long result = syscall(__NR_io_uring_enter, batch->ring, batch->unsubmitted_count, waited_count, waited_count ? IORING_ENTER_GETEVENTS : 0, 0, 0);
+    if (result >= 0)
+    {
+      batch->unsubmitted_count -= (uint)result;
+      break;
+    }
+    if (errno != EINTR) return 0;
+  }
+
+  uint head = *batch->completion_head;
+  uint tail = __atomic_load_n(batch->completion_tail, __ATOMIC_ACQUIRE);
+  for (; head != tail; ++head)
+  {
+    struct io_uring_cqe *completion = &batch->completions[head & *batch->completion_mask];
+    complete_operation(completion->user_data, completion->res, batch);
+  }
+  __atomic_store_n(batch->completion_head, head, __ATOMIC_RELEASE);
+  return 1;
+}
+
+static bit read_whole_file(batched_file *file, file_batch *batch)
+{
+  int descriptor = open(file->path, O_RDONLY | O_CLOEXEC);
+  if (descriptor < 0) return 0;
+  struct stat status;
+  if (fstat(descriptor, &status) < 0)
+  {
+    close(descriptor);
+    return 0;
+  }
+  file->size = (uint)status.st_size;
+  hold_file_memory(file, batch);
+  file->descriptor = descriptor;
+  for (file->read_size = 0; file->read_size < file->size;)
+  {
+    ssize_t read_size = pread(descriptor, file->memory + file->read_size, file->size - file->read_size, file->read_size);
+    if (read_size < 0 && errno == EINTR) continue;
+    if (read_size < 0)
+    {
+      finish_file(file, batched_file_state_failed, batch);
+      return 0;
+    }
+    if (!read_size) file->size = file->read_size;
+    file->read_size += (uint)read_size;
+  }
+  finish_file(file, batched_file_state_read, batch);
+  return 1;
+}
+
+#endif
+
+file_batch *begin_reading_files(const char *file_paths[], uint files_count)
+{
+  file_batch *batch = allocate(sizeof(file_batch));
+  batch->files = allocate(files_count * sizeof(batched_file) + 1);
+  batch->files_count = files_count;
+  batch->waited_file = files_count;
+  for (uint i = 0; i < files_count; ++i)
+  {
+    batch->files[i].path = file_paths[i];
+    batch->files[i].descriptor = -1;
+  }
+#if defined(ON_PLATFORM_LINUX)
+  batch->ring = -1;
+  if (set_up_ring(batch))
+  {
+    queue_openings(0, batch);
+    if (!enter_ring(0, batch)) tear_down_ring(batch);
+  }
+#endif
+  return batch;
+}
+
+const byte *wait_for_file(uint *file_size, uint index, file_batch *batch)
+{
+  if (batch->waited_file < batch->files_count)
+  {
+#if defined(ON_PLATFORM_LINUX)
+    release_file_memory(&batch->files[batch->waited_file], batch);
+#endif
+  }
+  batch->waited_file = index;
+
+  batched_file *file = &batch->files[index];
+#if defined(ON_PLATFORM_LINUX)
+  while (batch->ring >= 0 && file->state != batched_file_state_read && file->state != batched_file_state_failed)
+  {
+    queue_openings(index, batch);
+    if (!enter_ring(1, batch)) break;
+  }
+  /* the ring can fail an operation it doesn't support, so a file it failed
+     is read again plainly */
+  if (file->state != batched_file_state_read && !file->pending_count && !read_whole_file(file, batch)) return 0;
+  if (file->state != batched_file_state_read) return 0;
+  *file_size = file->size;
+  return file->memory;
+#else
+  (void)file;
+  *file_size = 0;
+  return 0;
+#endif
+}
+
+void end_reading_files(file_batch *batch)
+{
+#if defined(ON_PLATFORM_LINUX)
+  /* the kernel may still write to the files being read */
+  batch->is_ending = 1;
+  while (batch->ring >= 0 && batch->in_flight_count && enter_ring(1, batch));
+  if (batch->ring >= 0) tear_down_ring(batch);
+#endif
+  for (uint i = 0; i < batch->files_count; ++i)
+  {
+    batched_file *file = &batch->files[i];
+    if (file->descriptor >= 0) close(file->descriptor);
+    if (file->memory) deallocate(file->memory, file->memory_size);
+  }
+  deallocate(batch->files, batch->files_count * sizeof(batched_file) + 1);
+  deallocate(batch, sizeof(file_batch));
+}
+
+/*****************************************************************************/
+
+/* this is initialized at runtime in `initialize_base`, on Win32 */
 uintl clock_frequency;
 
 thread_local uintl clock_beginning_time;
 
 inline uintl get_time(void)
 {
-  uintl time;
 #if defined(ON_PLATFORM_WIN32)
   LARGE_INTEGER win32_time;
   QueryPerformanceCounter(&win32_time);
-  time = win32_time.QuadPart;
+  uintl ticks = win32_time.QuadPart;
+  /* the seconds and the ticks within one are scaled apart, so they don't
+     overflow */
+  return ticks / clock_frequency * 1000000000 + ticks % clock_frequency * 1000000000 / clock_frequency;
 #elif defined(ON_PLATFORM_LINUX)
   struct timespec ts;
-  clock_gettime(CLOCK_REALTIME, &ts);
-  time = ts.tv_nsec;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uintl)ts.tv_sec * 1000000000 + (uintl)ts.tv_nsec;
 #endif
-  return time / clock_frequency;
 }
 
 inline void begin_clock(void)
@@ -478,13 +1481,15 @@ bit initialize_base(void)
     LARGE_INTEGER frequency;
     QueryPerformanceFrequency(&frequency);
     clock_frequency = frequency.QuadPart;
-#elif defined(ON_PLATFORM_LINUX)
-    struct timespec ts;
-    clock_getres(CLOCK_REALTIME, &ts);
-    clock_frequency = ts.tv_nsec;
 #endif
   }
 
+#if defined(ON_ARCHITECTURE_X64)
+  __builtin_cpu_init();
+  supports_ssse3 = __builtin_cpu_supports("ssse3") != 0;
+  supports_avx2  = __builtin_cpu_supports("avx2") != 0;
+#endif
+
   if (set_jump_point(context.default_failure_jump_point))
   {
     print_comment("Failed to %s.", __FUNCTION__);
@@ -7,10 +7,17 @@
   #define ON_PLATFORM_LINUX 1
 #endif
 
+#if defined(__x86_64__) || defined(_M_X64)
+  #define ON_ARCHITECTURE_X64 1
+#endif
+
 #if defined(_DEBUG) || !defined(NDEBUG)
   #define DEBUGGING 1
 #endif
 
+/* `-DRESERVING_HUGE_PAGES` takes the allocations of huge pages from those
+   the system reserved, by `MAP_HUGETLB`, before transparent ones */
+
 /* platform dependencies */
 #if defined(ON_PLATFORM_WIN32)
   #include <tchar.h>
@@ -18,7 +25,9 @@
 
   #pragma comment(lib, "User32.lib")
 #elif defined(ON_PLATFORM_LINUX)
-  #define _POSIX_C_SOURCE 199309L
+  #if !defined(_GNU_SOURCE)
+    #define _GNU_SOURCE /* for `MAP_ANONYMOUS`, sockets and inotify */
+  #endif
 
   #include <unistd.h>
   #include <fcntl.h>
@@ -43,6 +52,11 @@
 #include <wctype.h>
 #include <time.h>
 
+/* architecture dependencies */
+#if defined(ON_ARCHITECTURE_X64)
+  #include <immintrin.h>
+#endif
+
 /*****************************************************************************/
 
 /* macros */
@@ -56,6 +70,14 @@
 
 #define UNIMPLEMENTED() do { ASSERT(!"unimplemented"); UNREACHABLE(); } while (0);
 
+/* enables instruction set extensions for a single function; callers must
+   check for the extension at runtime */
+#if defined(ON_ARCHITECTURE_X64)
+  #define TARGETING(...) __attribute__((target(__VA_ARGS__)))
+#else
+  #define TARGETING(...)
+#endif
+
 #if !defined(__FUNCTION__)
   #if defined(__func__)
     #define __FUNCTION__ __func__
@@ -119,9 +141,16 @@ uintb clz(uintl value);
 
 uintb ctz(uintl value);
 
-sintl index_bit_range(uintb range_size, bit of_zeros, const uint *bytes, uint bytes_count);
+/* the bits of a bitmap are indexed from the lowest of its first word */
+#define bitmap_word_width ((uint)(sizeof(uintl) * byte_width))
+
+/* returns the index of the first range of `range_size` ones, or zeros, or -1 */
+sintl index_bit_range(uint range_size, bit of_zeros, const uintl *words, uint words_count);
 
-sintl toggle_bit_range(uintb range_size, bit of_zeros, uint *bytes, uint bytes_count);
+void toggle_bits(uintl index, uint count, uintl *words);
+
+/* toggles the first range of `index_bit_range`, returning its index */
+sintl toggle_bit_range(uint range_size, bit of_zeros, uintl *words, uint words_count);
 
 #define lmask1  ((uint)0x00000001)
 #define lmask2  ((uint)0x00000003)
@@ -268,11 +297,14 @@ extern jump_point default_failure_jump_point;
 
 typedef va_list vargs;
 
-#define get_vargs(...) va_start(__VA_ARGS__)
-#define end_vargs(...) va_end(__VA_ARGS__)
+#define get_vargs(...)  va_start(__VA_ARGS__)
+#define copy_vargs(...) va_copy(__VA_ARGS__)
+#define end_vargs(...)  va_end(__VA_ARGS__)
 
 /*****************************************************************************/
 
+uint get_minimum(uint a, uint b);
+
 uint get_maximum(uint a, uint b);
 
 /*****************************************************************************/
@@ -290,10 +322,16 @@ sintl compare_sized_string(const utf8 *left, const utf8 *right, uint size);
 
 #define compare_literal_string(left, right) compare_sized_string(left, right, sizeof(left) - 1)
 
+uint hash_string(const utf8 *string, uint size);
+
 byte decode_utf8(utf32 *rune, const utf8 string[4]);
 
 byte encode_utf8(utf8 string[4], utf32 rune);
 
+/* returns the offset of the first byte of the first invalid sequence, or -1
+   if the whole string is valid. */
+sintl validate_utf8(const utf8 *string, uint size);
+
 /*****************************************************************************/
 
 typedef uintptr_t   address;
@@ -312,7 +350,7 @@ address align_forwards(address x, uint a);
 
 void copy(void *destination, const void *source, uint size);
 
-#define copy_typed(type, destination, source, count) copy(destination, source, count * sizeof(type))
+#define copy_typed(type, destination, source, count) copy(destination, source, (count) * sizeof(type))
 
 void fill(void *destination, uint size, byte value);
 
@@ -320,15 +358,21 @@ void zero(void *destination, uint size);
 
 void move(void *destination, const void *source, uint size);
 
+/* an allocation of at least a huge page is aligned to one, and advised to be
+   backed by them where the system allows */
 void *allocate(uint size);
 
 void deallocate(void *memory, uint size);
 
 void *reallocate(uint size, void *memory, uint old_size);
 
+/* makes allocated memory executable and no longer writable */
+bit protect_executable(void *memory, uint size);
+
 #define kibibyte ((uint)1024)
 #define mebibyte ((uint)kibibyte * kibibyte)
 #define memory_page_size ((uint)4 * kibibyte)
+#define huge_page_size   ((uint)2 * mebibyte)
 
 typedef struct buffer buffer;
 struct buffer
@@ -346,16 +390,18 @@ struct allocator
 {
   allocator *allocator;           /* if 0, `allocate_memory` is implicitly used */
   uint       minimum_buffer_size; /* if 0, `default_allocator_minimum_buffer_size` is implicitly used */
+  bit        is_huge : 1;         /* its buffers double up to `maximum_huge_buffer_size`, so a big arena is a few reservations of huge pages */
 
   buffer *active_buffer;
   buffer *first_buffer;
 };
 
 #define default_allocator_minimum_buffer_size (memory_page_size - sizeof(buffer))
+#define maximum_huge_buffer_size              ((uint)64 * mebibyte)
 
 void *push(uint size, uint alignment, allocator *allocator);
 
-#define push_type(type, count, allocator) (type *)push(count * sizeof(type), alignof(type), allocator)
+#define push_type(type, count, allocator) (type *)push((count) * sizeof(type), alignof(type), allocator)
 
 #define push_train(type, extra, allocator) (type *)push(sizeof(type) + extra, alignof(type), allocator)
 #define push_typed_train(first_type, second_type, allocator) push_train(first_type, sizeof(second_type), allocator)
@@ -371,6 +417,12 @@ void get_scratch(scratch *scratch, allocator *allocator);
 
 void end_scratch(scratch *scratch);
 
+/* empties the allocator, keeping its buffers for what's pushed next */
+void reset_allocator(allocator *allocator);
+
+/* empties the allocator, releasing its buffers */
+void release_allocator(allocator *allocator);
+
 /*****************************************************************************/
 
 typedef struct
@@ -386,6 +438,197 @@ extern thread_local context_data context;
 
 /*****************************************************************************/
 
+/* the elements of an array grown to hold at least `count`, whose capacity
+   doubles; an array's first elements fill a page, since they're allocated */
+void *grow_array(void *elements, uint *capacity, uint count, uint element_size);
+
+/* declares a growable array of `type`, whose elements are allocated and
+   grown by `reallocate`, which remaps rather than copies them where it can.
+   like the X-macros, it's expanded twice, by `DECLARE_ARRAY` where the type
+   is declared and by `DEFINE_ARRAY` where its functions are:
+
+     `add_to_name(count, array)`, the appended elements, which are zeroed
+     `release_name(array)` */
+#define DECLARE_ARRAY(name, type)                  \
+  typedef struct                                   \
+  {                                                \
+    type *elements;                                \
+    uint  count;                                   \
+    uint  capacity;                                \
+  } name;                                          \
+                                                   \
+  type *add_to_##name(uint count, name *array);    \
+                                                   \
+  void release_##name(name *array);
+
+#define DEFINE_ARRAY(name, type)                                                                    \
+  type *add_to_##name(uint count, name *array)                                                      \
+  {                                                                                                 \
+    array->elements = grow_array(array->elements, &array->capacity, array->count + count, sizeof(type)); \
+    type *result = array->elements + array->count;                                                 \
+    zero(result, count * sizeof(type));                                                             \
+    array->count += count;                                                                          \
+    return result;                                                                                  \
+  }                                                                                                 \
+                                                                                                    \
+  void release_##name(name *array)                                                                  \
+  {                                                                                                 \
+    if (array->elements) deallocate(array->elements, array->capacity * sizeof(type));               \
+    zero(array, sizeof(*array));                                                                    \
+  }
+
+DECLARE_ARRAY(uint_array, uint)
+
+/*****************************************************************************/
+
+/* the slots of a map are probed a group at a time, each of which has a
+   control byte: empty, or the 7 bits of the hash of its entry that didn't
+   choose the group, which are compared all at once */
+#define map_group_size    ((uint)16)
+#define empty_map_control ((byte)0x80)
+
+#define get_map_control(hash) ((byte)((hash) >> 25))
+
+/* the bits of the slots of a group whose controls are `control` */
+uint match_map_group(const byte *controls, byte control);
+
+/* the slots are at least a group, and at most 7/8 full, so a probe always
+   ends upon an empty slot */
+uint get_map_slots_count(uint entries_count);
+
+/* the groups are probed triangularly, which visits each once */
+uint find_empty_map_slot(const byte *controls, uint slots_count, uint hash);
+
+/* declares an open-addressing hash map of `entry_type`, found by `key_type`;
+   entries aren't removed. like `DECLARE_ARRAY`, it's expanded twice, and
+   `DEFINE_MAP` takes two functions of entries, `is_entry_of(entry, key)` and
+   `get_entry_hash(entry)`, which rehashes them as the map grows:
+
+     `find_in_name(hash, key, map)`, the entry of the key, or 0
+     `add_to_name(hash, key, &is_new, map)`, the entry of the key, which is
+       added and zeroed if it's new
+     `reserve_name(count, map)`, room for `count` entries
+     `release_name(map)` */
+#define DECLARE_MAP(name, entry_type, key_type)                                    \
+  typedef struct                                                                   \
+  {                                                                                \
+    entry_type *entries;                                                           \
+    byte       *controls;      /* of each slot */                                  \
+    uint        slots_count;   /* a power of two, and a multiple of a group */     \
+    uint        entries_count;                                                     \
+    allocator  *allocator;     /* of the slots, which are allocated if 0 */        \
+  } name;                                                                          \
+                                                                                   \
+  entry_type *find_in_##name(uint hash, key_type key, name *map);                  \
+                                                                                   \
+  entry_type *add_to_##name(uint hash, key_type key, bit *is_new, name *map);      \
+                                                                                   \
+  void reserve_##name(uint count, name *map);                                      \
+                                                                                   \
+  void release_##name(name *map);
+
+#define DEFINE_MAP(name, entry_type, key_type, is_entry_of, get_entry_hash)                           \
+  entry_type *find_in_##name(uint hash, key_type key, name *map)                                      \
+  {                                                                                                   \
+    if (!map->slots_count) return 0;                                                                  \
+    byte control = get_map_control(hash);                                                             \
+    uint groups_mask = map->slots_count / map_group_size - 1;                                         \
+    for (uint group = hash & groups_mask, step = 0;; group = (group + ++step) & groups_mask)          \
+    {                                                                                                 \
+      const byte *controls = map->controls + group * map_group_size;                                  \
+      for (uint matches = match_map_group(controls, control); matches; matches &= matches - 1)       \
+      {                                                                                               \
+        entry_type *entry = &map->entries[group * map_group_size + ctz(matches)];                     \
+        if (is_entry_of(entry, key)) return entry;                                                    \
+      }                                                                                               \
+      if (match_map_group(controls, empty_map_control)) return 0;                                     \
+    }                                                                                                 \
+  }                                                                                                   \
+                                                                                                      \
+  static uint get_##name##_size(uint slots_count)                                                     \
+  {                                                                                                   \
+    return slots_count * (uint)sizeof(entry_type) + slots_count;                                      \
+  }                                                                                                   \
+                                                                                                      \
+  void reserve_##name(uint count, name *map)                                                          \
+  {                                                                                                   \
+    uint slots_count = get_map_slots_count(count);                                                    \
+    if (slots_count <= map->slots_count) return;                                                      \
+    name grown = { .slots_count = slots_count, .entries_count = map->entries_count, .allocator = map->allocator }; \
+    grown.entries  = map->allocator ? push(get_##name##_size(slots_count), alignof(entry_type), map->allocator) \
+                                    : allocate(get_##name##_size(slots_count));                       \
+    grown.controls = (byte *)(grown.entries + slots_count);                                           \
+    fill(grown.controls, slots_count, empty_map_control);                                             \
+    for (uint i = 0; i < map->slots_count; ++i)                                                       \
+    {                                                                                                 \
+      if (map->controls[i] == empty_map_control) continue;                                            \
+      uint hash = get_entry_hash(&map->entries[i]);                                                   \
+      uint slot = find_empty_map_slot(grown.controls, slots_count, hash);                             \
+      grown.controls[slot] = get_map_control(hash);                                                   \
+      grown.entries[slot]  = map->entries[i];                                                         \
+    }                                                                                                 \
+    /* the slots of an arena are left to it */                                                        \
+    if (map->slots_count && !map->allocator) deallocate(map->entries, get_##name##_size(map->slots_count)); \
+    *map = grown;                                                                                     \
+  }                                                                                                   \
+                                                                                                      \
+  entry_type *add_to_##name(uint hash, key_type key, bit *is_new, name *map)                          \
+  {                                                                                                   \
+    entry_type *entry = find_in_##name(hash, key, map);                                               \
+    *is_new = !entry;                                                                                 \
+    if (entry) return entry;                                                                          \
+    reserve_##name(map->entries_count + 1, map);                                                      \
+    uint slot = find_empty_map_slot(map->controls, map->slots_count, hash);                           \
+    map->controls[slot] = get_map_control(hash);                                                      \
+    map->entries_count += 1;                                                                          \
+    entry = &map->entries[slot];                                                                      \
+    zero(entry, sizeof(entry_type));                                                                  \
+    return entry;                                                                                     \
+  }                                                                                                   \
+                                                                                                      \
+  void release_##name(name *map)                                                                      \
+  {                                                                                                   \
+    if (map->slots_count && !map->allocator) deallocate(map->entries, get_##name##_size(map->slots_count)); \
+    allocator *allocator = map->allocator;                                                            \
+    zero(map, sizeof(*map));                                                                          \
+    map->allocator = allocator;                                                                       \
+  }
+
+/*****************************************************************************/
+
+typedef struct slot_chunk slot_chunk;
+
+DECLARE_ARRAY(slot_chunk_array, slot_chunk *)
+
+/* a pool of fixed-size slots, like those of nodes, whose runs are taken
+   first-fit and given back singly, unlike the pushes of an arena; each of its
+   chunks marks the slots in use in a bitmap */
+typedef struct
+{
+  uint             slot_size; /* a power of two */
+  bit              has_unaligned_chunks : 1; /* whose slots aren't found by their addresses */
+  uint             least_count;       /* of the slots taken together, or 0 */
+  uint             full_chunks_count; /* before which no chunk has a range of the least count left */
+  slot_chunk_array chunks;
+  slot_chunk_array ordered_chunks; /* by their addresses */
+  uint_array       failed_sizes; /* of each chunk, the size of a range of slots that wasn't found since one was given */
+} slot_pool;
+
+#define slot_chunk_size huge_page_size
+
+/* takes zeroed slots of at least `size` bytes together */
+void *take_slots(uint size, slot_pool *pool);
+
+/* gives back the slots of `size` bytes taken together, or the first of them */
+void give_slots(void *memory, uint size, slot_pool *pool);
+
+/* whether the memory was taken from the pool, rather than pushed */
+bit has_slots(const void *memory, slot_pool *pool);
+
+void release_slot_pool(slot_pool *pool);
+
+/*****************************************************************************/
+
 #if defined(ON_PLATFORM_WIN32)
 typedef HANDLE handle;
 #elif defined(ON_PLATFORM_LINUX)
@@ -396,14 +639,38 @@ typedef sintl handle;
 
 handle open_file(const char *file_path);
 
+/* creates the file, or truncates it, for writing */
+handle create_file(const char *file_path);
+
 uintl get_file_size(handle file_handle);
 
 uint read_from_file(void *buffer, uint buffer_size, handle file_handle);
 
+uint write_to_file(const void *buffer, uint buffer_size, handle file_handle);
+
+handle get_standard_input(void);
+
+handle get_standard_error(void);
+
 void close_file(handle file_handle);
 
+/* reads several files together, so that the earlier ones are used while the
+   later ones are still being read. where io_uring is available, the opens,
+   sizes and reads of a window of files are submitted at once; otherwise each
+   file is read when it's waited for */
+typedef struct file_batch file_batch;
+
+file_batch *begin_reading_files(const char *file_paths[], uint files_count);
+
+/* the contents of the file, or 0 if it couldn't be read; they're valid until
+   another file is waited for */
+const byte *wait_for_file(uint *file_size, uint index, file_batch *batch);
+
+void end_reading_files(file_batch *batch);
+
 /*****************************************************************************/
 
+/* in nanoseconds, since an arbitrary time */
 uintl get_time(void);
 
 void begin_clock(void);
@@ -11,38 +11,134 @@ const utf8 reporting_type_representation[][8] =
   [reporting_type_failure] = "failure",
 };
 
+reporting_settings reporting =
+{
+  .minimum_type = reporting_type_caution,
+};
+
+#define reports_buffer_size ((uint)16 * kibibyte)
+
+static thread_local struct
+{
+  uint mass;
+  utf8 memory[reports_buffer_size];
+} reports;
+
+static void capture_reports(const utf8 *memory, uint size, report_capture *capture)
+{
+  if (capture->size + size > capture->capacity)
+  {
+    uint capacity = capture->capacity ? capture->capacity : reports_buffer_size;
+    while (capacity < capture->size + size) capacity *= 2;
+    capture->text = capture->text ? reallocate(capacity, capture->text, capture->capacity) : allocate(capacity);
+    capture->capacity = capacity;
+  }
+  copy(capture->text + capture->size, memory, size);
+  capture->size += size;
+}
+
+void flush_reports(void)
+{
+  if (!reports.mass) return;
+  if (reporting.capture) capture_reports(reports.memory, reports.mass, reporting.capture);
+  else write_to_file(reports.memory, reports.mass, get_standard_error());
+  reports.mass = 0;
+}
+
+static void write_report(const utf8 *string, uint size)
+{
+  while (size)
+  {
+    if (reports.mass == reports_buffer_size) flush_reports();
+    uint available_size = reports_buffer_size - reports.mass;
+    uint written_size = size < available_size ? size : available_size;
+    copy(reports.memory + reports.mass, string, written_size);
+    reports.mass += written_size;
+    string += written_size;
+    size -= written_size;
+  }
+}
+
+static void v_format_report(const utf8 *format, vargs format_vargs)
+{
+  for (bit flushed = 0;; flushed = 1)
+  {
+    vargs copied_vargs;
+    copy_vargs(copied_vargs, format_vargs);
+    uint available_size = reports_buffer_size - reports.mass;
+    int formatted_size = vsnprintf(reports.memory + reports.mass, available_size, format, copied_vargs);
+    end_vargs(copied_vargs);
+    if (formatted_size < 0) return;
+
+    /* a report larger than the whole buffer is truncated */
+    if ((uint)formatted_size < available_size || flushed)
+    {
+      reports.mass += (uint)formatted_size < available_size ? (uint)formatted_size : available_size - 1;
+      return;
+    }
+    flush_reports();
+  }
+}
+
+static void format_report(const utf8 *format, ...)
+{
+  vargs vargs;
+  get_vargs(vargs, format);
+  v_format_report(format, vargs);
+  end_vargs(vargs);
+}
+
 void v_report(reporting_type type, const utf8 *source, const utf8 *path, uint beginning, uint ending, uint row, uint column, const utf8 *message, vargs vargs)
 {
+  if (type < reporting.minimum_type) return;
+
   const utf8 *type_representation = reporting_type_representation[type];
-  fprintf(stderr, "%s(%u, %u): %s: ", path, row, column, type_representation);
-  vfprintf(stderr, message, vargs);
-  fputc('\n', stderr);
+  if (reporting.is_compact)
+    format_report("%s:%u:%u:%u:%u:%s:", path, row, column, beginning, ending, type_representation);
+  else
+    format_report("%s(%u, %u): %s: ", path, row, column, type_representation);
+  v_format_report(message, vargs);
+  write_report("\n", 1);
+  /* a streamed source isn't kept, so it isn't quoted */
+  if (reporting.is_compact || beginning == ending || !source) goto finished;
 
-  if (beginning == ending) return;
-  const utf8 *caret = source + beginning - column + 1;
+  /* the column counts runes, so the line is found by its bytes */
+  const utf8 *line = source + beginning;
+  while (line != source && line[-1] != '\n') --line;
 
-  fprintf(stderr, "\t%u | ", row++);
-  while (caret != source + beginning) fputc(*caret++, stderr);
+  format_report("\t%u | ", row++);
+  write_report(line, (uint)(source + beginning - line));
 
-  fprintf(stderr, "\x1b[1;31m");
-  while (caret != source + ending)
+  write_report("\x1b[1;31m", 7);
+  for (const utf8 *span = source + beginning, *caret = span;; ++caret)
   {
+    if (caret == source + ending)
+    {
+      write_report(span, (uint)(caret - span));
+      break;
+    }
     if (*caret == '\n')
     {
-      // TODO: align the row number
-      fprintf(stderr, "\t%u | ", row);
-      ++row;
+      write_report(span, (uint)(caret - span));
+      format_report("\x1b[0m\n\t%u | \x1b[1;31m", row++);
+      span = caret + 1;
     }
-    fputc(*caret++, stderr);
   }
-  fprintf(stderr, "\x1b[0m");
+  write_report("\x1b[0m", 4);
 
-  while (*caret != '\n' && *caret != '\0') fputc(*caret++, stderr);
-  fputc('\n', stderr);
+  const utf8 *rest = source + ending;
+  while (*rest != '\n' && *rest != '\0') ++rest;
+  write_report(source + ending, (uint)(rest - (source + ending)));
+  write_report("\n", 1);
 
-  fflush(stderr);
+finished:
+  /* failures are written immediately, since they usually precede a jump */
+  if (type == reporting_type_failure) flush_reports();
 }
 
+/* emits the external definition of the inline `report` */
+extern inline void report(reporting_type type, const utf8 *source, const utf8 *path, uint beginning, uint ending, uint row, uint column, const utf8 *message, ...);
+
 /*****************************************************************************/
 
 const utf8 token_tag_representations[][16] =
@@ -54,7 +150,8 @@ const utf8 token_tag_representations[][16] =
 
 inline void v_report_token(reporting_type type, parser *parser, const utf8 *message, vargs vargs)
 {
-  v_report(type, parser->source, parser->source_path, parser->token.beginning, parser->token.ending, parser->token.row, parser->token.column, message, vargs);
+  if (type == reporting_type_failure) parser->program->failures_count += 1;
+  v_report(type, parser->is_streaming ? 0 : parser->source, parser->source_path, parser->token.beginning, parser->token.ending, parser->token.row, parser->token.column, message, vargs);
 }
 
 inline void report_token(reporting_type type, parser *parser, const utf8 *message, ...)
@@ -65,6 +162,12 @@ inline void report_token(reporting_type type, parser *parser, const utf8 *messag
   end_vargs(vargs);
 }
 
+/* a streamed source is read into a window, of which the runes past the
+   current one are peeked */
+#define stream_window_size ((uint)64 * kibibyte)
+#define stream_margin      ((uint)8)
+#define no_kept_offset     ((uint)-1)
+
 static utf32 peek(uints *increment, parser *parser)
 {
   uint peek_offset = parser->offset + parser->increment;
@@ -73,13 +176,35 @@ static utf32 peek(uints *increment, parser *parser)
     *increment = 0;
     return token_tag_etx;
   }
+
+  /* the source was validated upon loading, so ASCII needs no decoding */
+  byte first = (byte)parser->source[peek_offset - parser->source_base];
+  if (first < 0x80)
+  {
+    *increment = 1;
+    return first;
+  }
+
   utf32 rune;
-  *increment = decode_utf8(&rune, parser->source + peek_offset);
+  *increment = decode_utf8(&rune, parser->source + peek_offset - parser->source_base);
   return rune;
 }
 
+static bit on_etx(parser *parser)
+{
+  return parser->offset >= parser->source_size;
+}
+
+static void refill_source(uint ending, parser *parser);
+
+static void record_line(parser *parser);
+
 static utf32 advance(parser *parser)
 {
+  if (parser->is_streaming && parser->offset + parser->increment + stream_margin > parser->source_size)
+    refill_source(parser->offset + parser->increment + stream_margin, parser);
+  if (on_etx(parser)) return parser->rune = token_tag_etx;
+
   uints increment;
   utf32 rune = peek(&increment, parser);
 
@@ -88,12 +213,11 @@ static utf32 advance(parser *parser)
   {
     parser->row   += 1;
     parser->column = 0;
+    if (parser->is_streaming) record_line(parser);
   }
   parser->column++;
   parser->rune      = rune;
   parser->increment = increment;
-  if (parser->rune == (utf32)token_tag_etx)
-    jump(parser->etx_jump_point, 1);
   return rune;
 }
 
@@ -102,35 +226,223 @@ static bit on(utf32 rune, parser *parser)
   return rune == parser->rune;
 }
 
+/* classes of runes within Latin-1; runes above it are classified by the
+   XID_Start and XID_Continue properties in `xid_blocks` */
+typedef enum
+{
+  rune_class_space        = bit1,
+  rune_class_letter       = bit2, /* an identifier's onset, including `_` */
+  rune_class_number       = bit3,
+  rune_class_hexadecimal  = bit4,
+  rune_class_continuation = bit5, /* the rest of an identifier */
+} rune_class;
+
+#include "proglosa_runes.inc"
+
+static bit has_xid_property(utf32 rune, uint property)
+{
+  if (rune >= countof(xid_block_indices) * 256) return 0;
+  const uint *bits = xid_blocks[xid_block_indices[rune >> 8]][property];
+  return (bits[(rune & 0xff) / uint_bits_count] >> (rune % uint_bits_count)) & 1;
+}
+
+static bit on_class(rune_class class, parser *parser)
+{
+  if (parser->rune < countof(rune_classes)) return (rune_classes[parser->rune] & class) != 0;
+  switch (class)
+  {
+  case rune_class_letter:       return has_xid_property(parser->rune, 0);
+  case rune_class_continuation: return has_xid_property(parser->rune, 1);
+  case rune_class_space:
+    return parser->rune == 0x1680
+           || (parser->rune >= 0x2000 && parser->rune <= 0x200a)
+           || parser->rune == 0x2028
+           || parser->rune == 0x2029
+           || parser->rune == 0x202f
+           || parser->rune == 0x205f
+           || parser->rune == 0x3000;
+  default: return 0;
+  }
+}
+
 static bit on_space(parser *parser)
 {
-  /* TODO: complete this */
-  return (parser->rune >= '\t' && parser->rune <= '\r')
-         || (parser->rune == ' ');
+  return on_class(rune_class_space, parser);
 }
 
 static bit on_letter(parser *parser)
 {
-  return (parser->rune >= 'A' && parser->rune <= 'Z')
-         || (parser->rune >= 'a' && parser->rune <= 'z');
+  return on_class(rune_class_letter, parser);
 }
 
 static bit on_number(parser *parser)
 {
-  return (parser->rune >= '0' && parser->rune <= '9');
+  return on_class(rune_class_number, parser);
 }
 
+/* skips the ASCII identifier runes following the current rune with one load
+   per byte, leaving the last of them as the current rune. */
+static void skip_identifier_runes(parser *parser)
+{
+  uint run_beginning = parser->offset + parser->increment;
+  uint run_ending = run_beginning;
+  while (run_ending < parser->source_size)
+  {
+    byte b = (byte)parser->source[run_ending - parser->source_base];
+    if (b >= 0x80 || !(rune_classes[b] & rune_class_continuation)) break;
+    ++run_ending;
+  }
+  if (run_ending == run_beginning) return;
+
+  parser->column   += run_ending - parser->offset - parser->increment;
+  parser->offset    = run_ending - 1;
+  parser->rune      = (byte)parser->source[parser->offset - parser->source_base];
+  parser->increment = 1;
+}
+
+/* validates the loaded source, and reads its first rune */
+static void begin_source(parser *parser);
+
 static void load_into_parser(const utf8 *path, parser *parser)
 {
-  print_comment("Loading source: %s\n", path);
+  if (reporting.minimum_type <= reporting_type_comment) print_comment("Loading source: %s\n", path);
 
   begin_clock();
   parser->source_path = path;
   handle source_handle = open_file(parser->source_path);
   parser->source_size = (uint)get_file_size(source_handle);
-  parser->source = (utf8 *)push((uint)align_forwards(parser->source_size, 4), universal_alignment, &parser->general_allocator);
+  /* the zeroed padding terminates the source, and keeps `decode_utf8` from
+     reading past it */
+  parser->source = (utf8 *)push((uint)align_forwards(parser->source_size + 4, 4), universal_alignment, &parser->program->allocator);
   read_from_file(parser->source, parser->source_size, source_handle);
   close_file(source_handle);
+  begin_source(parser);
+}
+
+/* like `load_into_parser`, of a source that's already in memory */
+static void copy_into_parser(const utf8 *path, const utf8 *text, uint text_size, parser *parser)
+{
+  parser->source_path = path;
+  parser->source_size = text_size;
+  parser->source = (utf8 *)push((uint)align_forwards(parser->source_size + 4, 4), universal_alignment, &parser->program->allocator);
+  copy(parser->source, text, text_size);
+  begin_source(parser);
+}
+
+/* the source is valid before the invalid offset, so the column is the count
+   of runes since the current one */
+static void report_invalid_rune(uint invalid_offset, parser *parser)
+{
+  uint row = parser->row ? parser->row : 1, column = parser->row ? parser->column : 1;
+  for (uint offset = parser->offset; offset < invalid_offset; ++offset)
+  {
+    byte b = (byte)parser->source[offset - parser->source_base];
+    if (b == '\n') row += 1, column = 1;
+    else if ((b & 0xc0) != 0x80) column += 1;
+  }
+  report_failure(parser->is_streaming ? 0 : parser->source, parser->source_path, invalid_offset, invalid_offset + 1, row, column, "Invalid UTF-8 sequence.");
+  parser->program->failures_count += 1;
+  /* a streamed source is validated while parsing, which isn't recovered */
+  jump(*context.failure_jump_point, 1);
+}
+
+static void stream_into_parser(const utf8 *path, handle stream, parser *parser)
+{
+  if (reporting.minimum_type <= reporting_type_comment) print_comment("Streaming source: %s\n", path);
+
+  parser->source_path  = path;
+  parser->is_streaming = 1;
+  parser->stream       = stream;
+  parser->kept_offset  = no_kept_offset;
+  /* like a loaded source's, the zeroed padding keeps `decode_utf8` from
+     reading past the window */
+  parser->source = allocate(stream_window_size + 4);
+  begin_source(parser);
+}
+
+/* validates the runes read since the last refill, except one that's only
+   partly read */
+static void validate_streamed_runes(parser *parser)
+{
+  uint ending = parser->streamed_size;
+  for (uint i = 1; !parser->has_stream_ended && i <= 3 && i <= ending - parser->source_size; ++i)
+  {
+    /* a rune's leading byte tells its size */
+    byte b = (byte)parser->source[ending - i - parser->source_base];
+    if ((b & 0xc0) == 0x80) continue;
+    uint rune_size = b < 0x80 ? 1 : b < 0xe0 ? 2 : b < 0xf0 ? 3 : 4;
+    if (rune_size > i) ending -= i;
+    break;
+  }
+  sintl invalid_offset = validate_utf8(parser->source + parser->source_size - parser->source_base, ending - parser->source_size);
+  if (invalid_offset >= 0) report_invalid_rune(parser->source_size + (uint)invalid_offset, parser);
+  parser->source_size = ending;
+}
+
+/* reads the streamed source until the runes before the ending are available;
+   once the window is mostly used, the runes that are still needed are moved
+   to its beginning */
+void refill_source(uint ending, parser *parser)
+{
+  uint kept_offset = parser->kept_offset < parser->offset ? parser->kept_offset : parser->offset;
+  while (!parser->has_stream_ended && parser->source_size < ending)
+  {
+    uint held_size = parser->streamed_size - parser->source_base;
+    if (held_size > stream_window_size / 4 * 3)
+    {
+      uint dropped_size = kept_offset - parser->source_base;
+      held_size -= dropped_size;
+      if (held_size + stream_margin >= stream_window_size)
+      {
+        bit is_within_token = parser->kept_offset != no_kept_offset;
+        report_failure(0, parser->source_path, kept_offset, parser->offset, is_within_token ? parser->token.row : parser->row,
+                       is_within_token ? parser->token.column : parser->column, "A token of a streamed source is longer than %u bytes.",
+                       stream_window_size - stream_margin);
+        parser->program->failures_count += 1;
+        jump(*context.failure_jump_point, 1);
+      }
+      move(parser->source, parser->source + dropped_size, held_size);
+      parser->source_base = kept_offset;
+    }
+
+    uint read_size = read_from_file(parser->source + held_size, stream_window_size - held_size, parser->stream);
+    zero(parser->source + held_size + read_size, 4);
+    parser->has_stream_ended = !read_size;
+    parser->streamed_size += read_size;
+    validate_streamed_runes(parser);
+  }
+}
+
+void record_line(parser *parser)
+{
+  *add_to_uint_array(1, &parser->line_offsets) = parser->offset;
+
+  /* the lines locate the reports of expressions while parsing */
+  parser->program->line_offsets = parser->line_offsets.elements;
+  parser->program->lines_count = parser->line_offsets.count;
+}
+
+/* the program keeps the lines of a streamed source, but not its runes */
+static void end_stream(program *program, parser *parser)
+{
+  program->source_size = parser->source_size;
+  program->lines_count = parser->line_offsets.count ? parser->line_offsets.count : 1;
+  program->line_offsets = push_type(uint, program->lines_count, &program->allocator);
+  copy(program->line_offsets, parser->line_offsets.elements, parser->line_offsets.count * sizeof(uint));
+
+  release_uint_array(&parser->line_offsets);
+  deallocate(parser->source, stream_window_size + 4);
+  parser->source = 0;
+}
+
+void begin_source(parser *parser)
+{
+  /* a streamed source is validated as it's read */
+  if (!parser->is_streaming)
+  {
+    sintl invalid_offset = validate_utf8(parser->source, parser->source_size);
+    if (invalid_offset >= 0) report_invalid_rune((uint)invalid_offset, parser);
+  }
 
   parser->offset    = 0;
   parser->row       = 0;
@@ -144,13 +456,24 @@ static token_tag get_token(parser *parser)
   const utf8 *failure_message = 0;
 
   token *token = &parser->token;
-  while (on_space(parser)) advance(parser);
+  parser->last_ending = token->ending;
 
 repeat:
+  parser->kept_offset = no_kept_offset;
+  while (on_space(parser)) advance(parser);
+
   token->beginning = parser->offset;
+  parser->kept_offset = token->beginning;
   token->row       = parser->row;
   token->column    = parser->column;
 
+  if (on_etx(parser))
+  {
+    token->tag    = token_tag_etx;
+    token->ending = parser->offset;
+    return token->tag;
+  }
+
   uints peeked_increment;
   utf32 peeked_rune;
   switch (parser->rune)
@@ -159,51 +482,77 @@ repeat:
     for(;;)
     { 
       advance(parser);           
+      if (on_etx(parser))
+      {
+        failure_message = "Unterminated string.";
+        goto failed_no_skip;
+      }
       if (parser->rune == '"')
         break;
       if (parser->rune == '\\')
-      {
-        switch(advance(parser))
-        {
-        default:
-          advance(parser);
-          break;
-        }
-      }
+        advance(parser); /* the escaped rune is skipped by the next iteration */
     }
     advance(parser);
     token->tag = token_tag_string;
     break;
   case '=':
+  case '!':
+  case '+':
+  case '*':
+  case '/':
+  case '%':
+  case '^':
+    /* `a=`, `==` and `!=` */
     peeked_rune = peek(&peeked_increment, parser);
-    if (peeked_rune == '=')
+    if (peeked_rune != '=') goto set_single_rune;
+    switch (parser->rune)
     {
-      token->tag = token_tag_equality2;
-      goto double_rune;
+    case '=': token->tag = token_tag_equality2;            break;
+    case '!': token->tag = token_tag_exclamation_equality; break;
+    case '+': token->tag = token_tag_plus_equality;        break;
+    case '*': token->tag = token_tag_asterisk_equality;    break;
+    case '/': token->tag = token_tag_slash_equality;       break;
+    case '%': token->tag = token_tag_percent_equality;     break;
+    case '^': token->tag = token_tag_caret_equality;       break;
     }
-    goto set_single_rune;
+    goto double_rune;
+  case '&':
+  case '|':
+    /* `aa` and `a=` */
+    peeked_rune = peek(&peeked_increment, parser);
+    if (peeked_rune == parser->rune)
+      token->tag = parser->rune == '&' ? token_tag_and2 : token_tag_bar2;
+    else if (peeked_rune == '=')
+      token->tag = parser->rune == '&' ? token_tag_and_equality : token_tag_bar_equality;
+    else goto set_single_rune;
+    goto double_rune;
   case '<':
+  case '>':
+    /* `a=`, `aa` and `aa=` */
     peeked_rune = peek(&peeked_increment, parser);
-    if (peeked_rune == '<')
+    if (peeked_rune == '=')
     {
-      token->tag = token_tag_left_angle2;
+      token->tag = parser->rune == '<' ? token_tag_left_angle_equality : token_tag_right_angle_equality;
       goto double_rune;
     }
-    goto set_single_rune;
-  case '>':
+    if (peeked_rune != parser->rune) goto set_single_rune;
+    advance(parser);
     peeked_rune = peek(&peeked_increment, parser);
-    if (peeked_rune == '>')
+    if (peeked_rune == '=')
     {
-      token->tag = token_tag_right_angle2;
+      token->tag = parser->rune == '<' ? token_tag_left_angle2_equality : token_tag_right_angle2_equality;
       goto double_rune;
     }
-    goto set_single_rune;
+    token->tag = parser->rune == '<' ? token_tag_left_angle2 : token_tag_right_angle2;
+    goto single_rune;
       
   case '-':
     peeked_rune = peek(&peeked_increment, parser);
     if (peeked_rune == '-')
     {
-      while (advance(parser) != '\n');
+      parser->kept_offset = no_kept_offset;
+      do advance(parser);
+      while (!on('\n', parser) && !on_etx(parser));
       goto repeat;
     }
     else if (peeked_rune == '>')
@@ -211,29 +560,26 @@ repeat:
       token->tag = token_tag_arrow;
       goto double_rune;
     }
+    else if (peeked_rune == '=')
+    {
+      token->tag = token_tag_minus_equality;
+      goto double_rune;
+    }
     goto set_single_rune;
 
-  case '!':
   case '#':
   case '$':
-  case '%':
-  case '&':
   case '(':
   case ')':
-  case '*':
-  case '+':
   case ',':
   case '.':
-  case '/':
   case ':':
   case ';':
   case '?':
   case '@':
   case '[':
   case ']':
-  case '^':
   case '{':
-  case '|':
   case '}':
   case '~':
   set_single_rune:
@@ -247,10 +593,14 @@ repeat:
       break;
       
   default:
-    if (on_letter(parser) || on('_', parser))
+    if (on_letter(parser))
     {
-      do advance(parser);
-      while(on_letter(parser) || on('_', parser) || on_number(parser));
+      do
+      {
+        skip_identifier_runes(parser);
+        advance(parser);
+      }
+      while (on_class(rune_class_continuation, parser));
       token->tag = token_tag_identifier;
     }
     else if (on_number(parser))
@@ -265,10 +615,17 @@ repeat:
         case 'x': token->tag = token_tag_hexadecimal; break;
         default: break;
         }
-        advance(parser);
+        if (token->tag != token_tag_digital)
+        {
+          advance(parser); /* skip `0` */
+          advance(parser); /* skip the prefix */
+        }
       }
 
-      do
+      while (on_number(parser)
+             || on('_', parser)
+             || on('.', parser)
+             || (token->tag == token_tag_hexadecimal && on_class(rune_class_hexadecimal, parser)))
       {
         if (on('.', parser))
         {
@@ -276,17 +633,16 @@ repeat:
           {
           case token_tag_binary:
           case token_tag_hexadecimal:
+          case token_tag_decimal:
             failure_message = "Weird ass number.";
             goto failed;
           default:
             break;
           }
           token->tag = token_tag_decimal;
-          advance(parser);
         }
         advance(parser);
       }
-      while(on_number(parser) || on('_', parser) || on('.', parser));
     }
     else
     {
@@ -302,7 +658,7 @@ repeat:
   return token->tag;
 
 failed:
-  while (!on_space(parser)) advance(parser);
+  while (!on_space(parser) && !on_etx(parser)) advance(parser);
 
 failed_no_skip:
   token->ending = parser->offset;
@@ -340,7 +696,399 @@ const utf8 *node_tag_representations[] =
 #undef XPASTE
 };
 
-/*****************************************************************************/
+static const uint node_sizes[] =
+{
+#define XPASTE(identifier, body) [node_tag_##identifier] = sizeof(identifier##_node),
+  #include "proglosa_nodes.inc"
+#undef XPASTE
+};
+
+/* the layout of a node's children; unlisted nodes have none */
+typedef enum
+{
+  node_family_leaf,
+  node_family_unary,   /* `data->unary`   */
+  node_family_binary,  /* `data->binary`  */
+  node_family_ternary, /* `data->ternary` */
+  node_family_scoped,  /* declarations, structures, procedures and their types */
+} node_family;
+
+static const node_family node_families[countof(node_sizes)] =
+{
+  [node_tag_procedure_type]                           = node_family_scoped,
+  [node_tag_declaration]                              = node_family_scoped,
+  [node_tag_structure]                                = node_family_scoped,
+  [node_tag_procedure]                                = node_family_scoped,
+
+  [node_tag_unary]                                    = node_family_unary,
+  [node_tag_negation]                                 = node_family_unary,
+  [node_tag_positive]                                 = node_family_unary,
+  [node_tag_negative]                                 = node_family_unary,
+  [node_tag_bitwise_negation]                         = node_family_unary,
+  [node_tag_reference]                                = node_family_unary,
+
+  [node_tag_binary]                                   = node_family_binary,
+  [node_tag_conjunction]                              = node_family_binary,
+  [node_tag_disjunction]                              = node_family_binary,
+  [node_tag_equality]                                 = node_family_binary,
+  [node_tag_inequality]                               = node_family_binary,
+  [node_tag_greater]                                  = node_family_binary,
+  [node_tag_lesser]                                   = node_family_binary,
+  [node_tag_inclusive_greater]                        = node_family_binary,
+  [node_tag_inclusive_lesser]                         = node_family_binary,
+  [node_tag_addition]                                 = node_family_binary,
+  [node_tag_subtraction]                              = node_family_binary,
+  [node_tag_multiplication]                           = node_family_binary,
+  [node_tag_division]                                 = node_family_binary,
+  [node_tag_modulo]                                   = node_family_binary,
+  [node_tag_bitwise_conjunction]                      = node_family_binary,
+  [node_tag_bitwise_disjunction]                      = node_family_binary,
+  [node_tag_bitwise_exclusive_disjunction]            = node_family_binary,
+  [node_tag_bitwise_left_shift]                       = node_family_binary,
+  [node_tag_bitwise_right_shift]                      = node_family_binary,
+  [node_tag_assignment]                               = node_family_binary,
+  [node_tag_addition_assignment]                      = node_family_binary,
+  [node_tag_subtraction_assignment]                   = node_family_binary,
+  [node_tag_multiplication_assignment]                = node_family_binary,
+  [node_tag_division_assignment]                      = node_family_binary,
+  [node_tag_modulo_assignment]                        = node_family_binary,
+  [node_tag_bitwise_conjunction_assignment]           = node_family_binary,
+  [node_tag_bitwise_disjunction_assignment]           = node_family_binary,
+  [node_tag_bitwise_exclusive_disjunction_assignment] = node_family_binary,
+  [node_tag_bitwise_left_shift_assignment]            = node_family_binary,
+  [node_tag_bitwise_right_shift_assignment]           = node_family_binary,
+  [node_tag_resolution]                               = node_family_binary,
+  [node_tag_cast]                                     = node_family_binary,
+  [node_tag_invocation]                               = node_family_binary,
+  [node_tag_list]                                     = node_family_binary,
+
+  [node_tag_ternary]                                  = node_family_ternary,
+  [node_tag_condition]                                = node_family_ternary,
+};
+
+static expression *clone_expression(expression *expression, allocator *allocator);
+
+/* the clone of a list of statements, or of declarations */
+static statement *clone_statements(statement *statements, allocator *allocator);
+
+/* the parameters' names and types are those within the arguments and the
+   results, so the copies' are too */
+static void alias_parameters(statement **parameter, expression *parameters)
+{
+  if (!parameters || !*parameter) return;
+  if (parameters->tag == node_tag_list)
+  {
+    alias_parameters(parameter, parameters->data->list.left);
+    alias_parameters(parameter, parameters->data->list.right);
+    return;
+  }
+  (*parameter)->expression.data->declaration.identifier.runes = parameters->data->cast.left->data->identifier.runes;
+  (*parameter)->expression.data->declaration.type_definition = parameters->data->cast.right;
+  *parameter = (*parameter)->next;
+}
+
+/* clones the children of a copied node, as they were before resolution */
+static void clone_children(expression *expression, allocator *allocator)
+{
+  expression->type = none_type;
+  switch (node_families[expression->tag])
+  {
+  case node_family_leaf:
+    if (expression->tag == node_tag_identifier) expression->data->identifier.declaration = 0;
+    break;
+  case node_family_unary:
+    expression->data->unary.expression = clone_expression(expression->data->unary.expression, allocator);
+    break;
+  case node_family_binary:
+    expression->data->binary.left  = clone_expression(expression->data->binary.left, allocator);
+    expression->data->binary.right = clone_expression(expression->data->binary.right, allocator);
+    break;
+  case node_family_ternary:
+    expression->data->ternary.left  = clone_expression(expression->data->ternary.left, allocator);
+    expression->data->ternary.right = clone_expression(expression->data->ternary.right, allocator);
+    expression->data->ternary.other = clone_expression(expression->data->ternary.other, allocator);
+    break;
+  case node_family_scoped:
+    switch (expression->tag)
+    {
+    case node_tag_procedure_type:
+      expression->data->procedure_type.arguments = clone_expression(expression->data->procedure_type.arguments, allocator);
+      expression->data->procedure_type.results   = clone_expression(expression->data->procedure_type.results, allocator);
+      break;
+    case node_tag_declaration:
+      {
+        declaration_node *declaration = &expression->data->declaration;
+        declaration->identifier.declaration = 0;
+        declaration->type_definition = clone_expression(declaration->type_definition, allocator);
+        declaration->assignment      = clone_expression(declaration->assignment, allocator);
+        declaration->is_folded       = 0;
+        declaration->checking_state  = 0;
+        declaration->type            = none_type;
+        declaration->denoted_type    = none_type;
+        declaration->slot            = 0;
+        break;
+      }
+    case node_tag_structure:
+      expression->data->structure.declarations = clone_statements(expression->data->structure.declarations, allocator);
+      expression->data->structure.scope = 0;
+      break;
+    case node_tag_procedure:
+      {
+        procedure_node *procedure = &expression->data->procedure;
+        procedure->arguments = clone_expression(procedure->arguments, allocator);
+        procedure->results   = clone_expression(procedure->results, allocator);
+        procedure->structure.declarations = clone_statements(procedure->structure.declarations, allocator);
+        procedure->structure.scope = 0;
+        statement *parameter = procedure->structure.declarations;
+        alias_parameters(&parameter, procedure->arguments);
+        alias_parameters(&parameter, procedure->results);
+        procedure->statements      = clone_statements(procedure->statements, allocator);
+        procedure->type_parameters = clone_statements(procedure->type_parameters, allocator);
+        break;
+      }
+    default:
+      UNREACHABLE();
+    }
+    break;
+  }
+}
+
+expression *clone_expression(expression *expression, allocator *allocator)
+{
+  if (!expression) return 0;
+  uint size = node_sizes[expression->tag];
+  struct expression *result = push_train(struct expression, size, allocator);
+  copy(result, expression, sizeof(struct expression) + size);
+  clone_children(result, allocator);
+  return result;
+}
+
+statement *clone_statements(statement *statements, allocator *allocator)
+{
+  statement *result = 0;
+  for (statement *original = statements, *prior = 0; original; original = original->next)
+  {
+    uint size = node_sizes[original->expression.tag];
+    statement *clone = push_train(statement, size, allocator);
+    copy(&clone->expression, &original->expression, sizeof(expression) + size);
+    clone_children(&clone->expression, allocator);
+
+    clone->prior = prior;
+    clone->next  = 0;
+    if (prior) prior = prior->next = clone;
+    else result = prior = clone;
+  }
+  return result;
+}
+
+/*****************************************************************************/
+
+/* the parsed nodes are interleaved with their runes, and with the nodes that
+   were discarded, in the order they were pushed; compacting copies them into
+   one block of the program's arena in preorder, every node before its
+   children and all the runes after all the nodes; the parser's arena is
+   then emptied for its next source.
+
+   it's only done upon `--compact-nodes`, since the parsed nodes are already
+   nearly in preorder, so copying them mostly costs more than walking them
+   forwards saves */
+typedef struct
+{
+  bit   is_measuring : 1; /* the sizes of the block, rather than copying into it */
+  uint  nodes_size;
+  uint  runes_size;
+  byte *nodes;            /* where the next node is copied */
+  utf8 *runes;            /* where the next runes are copied */
+} compactor;
+
+/* while measuring, the nodes are their own copies */
+static void *compact_node(void *node, uint size, compactor *compactor)
+{
+  uint aligned_size = (uint)align_forwards(size, alignof(statement));
+  if (compactor->is_measuring)
+  {
+    compactor->nodes_size += aligned_size;
+    return node;
+  }
+  void *result = compactor->nodes;
+  copy(result, node, size);
+  compactor->nodes += aligned_size;
+  return result;
+}
+
+static utf8 *compact_runes(utf8 *runes, uint runes_count, compactor *compactor)
+{
+  if (!runes) return 0;
+  if (compactor->is_measuring)
+  {
+    compactor->runes_size += runes_count + 1;
+    return runes;
+  }
+  utf8 *result = compactor->runes;
+  copy(result, runes, runes_count + 1);
+  compactor->runes += runes_count + 1;
+  return result;
+}
+
+static expression *compact_expression(expression *expression, compactor *compactor);
+
+/* the names and types of parameters are aliased afterwards, see `alias_parameters` */
+static statement *compact_statements(statement *statements, bit is_parameters, compactor *compactor);
+
+static void compact_identifier(identifier_node *identifier, compactor *compactor)
+{
+  identifier->runes = compact_runes(identifier->runes, identifier->runes_count, compactor);
+}
+
+static void compact_children(expression *expression, compactor *compactor)
+{
+  switch (node_families[expression->tag])
+  {
+  case node_family_leaf:
+    if (expression->tag == node_tag_identifier) compact_identifier(&expression->data->identifier, compactor);
+    else if (expression->tag == node_tag_type_parameter) compact_identifier(&expression->data->type_parameter.identifier, compactor);
+    else if (expression->tag == node_tag_string)
+      expression->data->string.runes = compact_runes(expression->data->string.runes, expression->data->string.runes_count, compactor);
+    break;
+  case node_family_unary:
+    expression->data->unary.expression = compact_expression(expression->data->unary.expression, compactor);
+    break;
+  case node_family_binary:
+    expression->data->binary.left  = compact_expression(expression->data->binary.left, compactor);
+    expression->data->binary.right = compact_expression(expression->data->binary.right, compactor);
+    break;
+  case node_family_ternary:
+    expression->data->ternary.left  = compact_expression(expression->data->ternary.left, compactor);
+    expression->data->ternary.right = compact_expression(expression->data->ternary.right, compactor);
+    expression->data->ternary.other = compact_expression(expression->data->ternary.other, compactor);
+    break;
+  case node_family_scoped:
+    switch (expression->tag)
+    {
+    case node_tag_procedure_type:
+      expression->data->procedure_type.arguments = compact_expression(expression->data->procedure_type.arguments, compactor);
+      expression->data->procedure_type.results   = compact_expression(expression->data->procedure_type.results, compactor);
+      break;
+    case node_tag_declaration:
+      {
+        declaration_node *declaration = &expression->data->declaration;
+        compact_identifier(&declaration->identifier, compactor);
+        declaration->type_definition = compact_expression(declaration->type_definition, compactor);
+        declaration->assignment      = compact_expression(declaration->assignment, compactor);
+        break;
+      }
+    case node_tag_structure:
+      expression->data->structure.declarations = compact_statements(expression->data->structure.declarations, 0, compactor);
+      break;
+    case node_tag_procedure:
+      {
+        procedure_node *procedure = &expression->data->procedure;
+        procedure->arguments = compact_expression(procedure->arguments, compactor);
+        procedure->results   = compact_expression(procedure->results, compactor);
+        procedure->structure.declarations = compact_statements(procedure->structure.declarations, 1, compactor);
+        if (!compactor->is_measuring)
+        {
+          statement *parameter = procedure->structure.declarations;
+          alias_parameters(&parameter, procedure->arguments);
+          alias_parameters(&parameter, procedure->results);
+        }
+        procedure->statements      = compact_statements(procedure->statements, 0, compactor);
+        procedure->type_parameters = compact_statements(procedure->type_parameters, 0, compactor);
+        break;
+      }
+    default:
+      UNREACHABLE();
+    }
+    break;
+  }
+}
+
+expression *compact_expression(expression *expression, compactor *compactor)
+{
+  if (!expression) return 0;
+  struct expression *result = compact_node(expression, sizeof(struct expression) + node_sizes[expression->tag], compactor);
+  compact_children(result, compactor);
+  return result;
+}
+
+statement *compact_statements(statement *statements, bit is_parameters, compactor *compactor)
+{
+  statement *result = compactor->is_measuring ? statements : 0;
+  for (statement *original = statements, *prior = 0, *next; original; original = next)
+  {
+    next = original->next;
+    statement *compacted = compact_node(original, sizeof(statement) + node_sizes[original->expression.tag], compactor);
+    if (!is_parameters) compact_children(&compacted->expression, compactor);
+    if (compactor->is_measuring) continue;
+
+    compacted->prior = prior;
+    compacted->next  = 0;
+    if (prior) prior = prior->next = compacted;
+    else result = prior = compacted;
+  }
+  return result;
+}
+
+static void compact_program(program *program)
+{
+  compactor compactor = {.is_measuring = 1};
+  compact_statements(program->global_scope.declarations, 0, &compactor);
+  if (!compactor.nodes_size) return;
+
+  compactor.is_measuring = 0;
+  compactor.nodes = push(compactor.nodes_size + compactor.runes_size, alignof(statement), &program->allocator);
+  compactor.runes = (utf8 *)compactor.nodes + compactor.nodes_size;
+  program->global_scope.declarations = compact_statements(program->global_scope.declarations, 0, &compactor);
+}
+
+/*****************************************************************************/
+
+static void locate_offset(uint *row, uint *column, uint offset, program *program)
+{
+  if (!program->line_offsets)
+  {
+    uint lines_count = 1;
+    for (uint i = 0; i < program->source_size; ++i) lines_count += program->source[i] == '\n';
+    program->line_offsets = push_type(uint, lines_count, &program->allocator);
+    program->lines_count = 0;
+    program->line_offsets[program->lines_count++] = 0;
+    for (uint i = 0; i < program->source_size; ++i)
+      if (program->source[i] == '\n') program->line_offsets[program->lines_count++] = i + 1;
+  }
+
+  /* the last line beginning at or before the offset */
+  uint low = 0, high = program->lines_count;
+  while (high - low > 1)
+  {
+    uint middle = low + (high - low) / 2;
+    if (program->line_offsets[middle] <= offset) low = middle;
+    else high = middle;
+  }
+
+  /* like the lexer, the column counts runes, or bytes of a streamed source,
+     which isn't kept */
+  *row = low + 1;
+  *column = 1;
+  if (!program->source) *column += offset - program->line_offsets[low];
+  else for (uint i = program->line_offsets[low]; i < offset; ++i)
+    *column += ((byte)program->source[i] & 0xc0) != 0x80;
+}
+
+void v_report_expression(reporting_type type, program *program, expression *expression, const utf8 *message, vargs vargs)
+{
+  if (type == reporting_type_failure) program->failures_count += 1;
+  uint row, column;
+  locate_offset(&row, &column, expression->beginning, program);
+  v_report(type, program->source, program->source_path, expression->beginning, expression->ending, row, column, message, vargs);
+}
+
+void report_expression(reporting_type type, program *program, expression *expression, const utf8 *message, ...)
+{
+  vargs vargs;
+  get_vargs(vargs, message);
+  v_report_expression(type, program, expression, message, vargs);
+  end_vargs(vargs);
+}
 
 static uint get_token_size(parser *parser)
 {
@@ -349,7 +1097,7 @@ static uint get_token_size(parser *parser)
 
 static utf8 *get_token_pointer(parser *parser)
 {
-  return parser->source + parser->token.beginning;
+  return parser->source + parser->token.beginning - parser->source_base;
 }
 
 /* the same as C's */
@@ -425,6 +1173,17 @@ static void parse_procedure  (procedure_node        *result, parser *parser);
 static expression *parse_expression(precedence precedence, parser *parser);
 static statement  *parse_statement (                       parser *parser);
 
+/* a node is pushed onto the general arena, or taken from the program's pool
+   when nodes are pooled, so that folding can give it back */
+static void *push_node(uint size, uint alignment, parser *parser)
+{
+  if (parser->is_pooling) return take_slots(size, &parser->program->nodes);
+  return push(size, alignment, parser->general_allocator);
+}
+
+#define push_node_train(type, extra, parser)                   (type *)push_node(sizeof(type) + (extra), alignof(type), parser)
+#define push_typed_node_train(first_type, second_type, parser) push_node_train(first_type, sizeof(second_type), parser)
+
 void parse_declaration(declaration_node *result, parser *parser)
 {
   /*  */
@@ -451,6 +1210,11 @@ void parse_declaration(declaration_node *result, parser *parser)
   case token_tag_equality:
     get_token(parser);
     result->assignment = parse_expression(0, parser);
+    if (!result->assignment)
+    {
+      report_token_failure(parser, "Expected an expression.");
+      jump(*parser->failure_jump_point, 1);
+    }
     break;
   default:
     if (!result->type_definition)
@@ -471,9 +1235,10 @@ void parse_identifier(identifier_node *result, parser *parser)
   ASSERT(parser->token.tag == token_tag_identifier);
 
   result->runes_count = get_token_size(parser);
-  result->runes = push_type(utf8, result->runes_count + 1, &parser->general_allocator);
+  result->runes = push_type(utf8, result->runes_count + 1, parser->general_allocator);
   result->runes[result->runes_count] = 0;
   copy_typed(utf8, result->runes, get_token_pointer(parser), result->runes_count);
+  result->hash = hash_string(result->runes, result->runes_count);
   get_token(parser);
 }
 
@@ -482,7 +1247,7 @@ void parse_string(string_node *result, parser *parser)
   ASSERT(parser->token.tag == token_tag_string);
 
   result->runes_count = get_token_size(parser);
-  result->runes = push_type(utf8, result->runes_count + 1, &parser->general_allocator);
+  result->runes = push_type(utf8, result->runes_count + 1, parser->general_allocator);
   result->runes[result->runes_count] = 0;
   copy_typed(utf8, result->runes, get_token_pointer(parser), result->runes_count);
   get_token(parser);
@@ -507,8 +1272,13 @@ void parse_number(expression *result, parser *parser)
     report_token_failure(parser, "number is too long.");
     jump(*parser->failure_jump_point, 1);
   }
-  copy_typed(utf8, string, get_token_pointer(parser), string_size);
-  string[string_size] = 0;
+  /* `_` separates digits, and `strtoull` doesn't know binary prefixes */
+  const utf8 *token_pointer = get_token_pointer(parser);
+  uint digits_offset = parser->token.tag == token_tag_binary ? 2 : 0;
+  uint digits_count = 0;
+  for (uint i = digits_offset; i < string_size; ++i)
+    if (token_pointer[i] != '_') string[digits_count++] = token_pointer[i];
+  string[digits_count] = 0;
   utf8 *string_ending;
 
   uintb base;
@@ -535,44 +1305,124 @@ void parse_number(expression *result, parser *parser)
   get_token(parser); /* skip number */
 }
 
+/* the offset past the ASCII spaces from the offset */
+static uint skip_spaces_from(uint offset, parser *parser)
+{
+  for (;;)
+  {
+    while (offset < parser->source_size && (byte)parser->source[offset - parser->source_base] < 0x80
+           && (rune_classes[(byte)parser->source[offset - parser->source_base]] & rune_class_space))
+      ++offset;
+    if (offset < parser->source_size || !parser->is_streaming || parser->has_stream_ended) return offset;
+    refill_source(offset + 1, parser);
+  }
+}
+
+static bit on_empty_parentheses(parser *parser)
+{
+  if (parser->token.tag != token_tag_left_parenthesis) return 0;
+  uint offset = skip_spaces_from(parser->token.ending, parser);
+  return offset < parser->source_size && parser->source[offset - parser->source_base] == ')';
+}
+
+/* a statement is a declaration if its identifier is followed by `:` */
+static bit on_declaration(parser *parser)
+{
+  if (parser->token.tag != token_tag_identifier) return 0;
+  uint offset = skip_spaces_from(parser->token.ending, parser);
+  return offset < parser->source_size && parser->source[offset - parser->source_base] == ':';
+}
+
+/* skips to the onset after a failure; that is, past the next `;`, or up to
+   the `}` closing the current scope, skipping nested groupings. */
+static void skip_to_onset(parser *parser)
+{
+  for (uint depth = 0;; get_token(parser))
+  {
+    switch (parser->token.tag)
+    {
+    case token_tag_etx:
+      return;
+    case token_tag_left_parenthesis:
+    case token_tag_left_bracket:
+    case token_tag_left_brace:
+      depth += 1;
+      break;
+    case token_tag_right_parenthesis:
+    case token_tag_right_bracket:
+      if (depth) depth -= 1;
+      break;
+    case token_tag_right_brace:
+      if (!depth) return;
+      depth -= 1;
+      break;
+    case token_tag_semicolon:
+      if (depth) break;
+      get_token(parser);
+      return;
+    default:
+      break;
+    }
+  }
+}
+
 void parse_structure(structure_node *result, parser *parser)
 {
-  get_token(parser); /* get the first onset */
+  structure_node *prior_scope = parser->current_scope;
+  jump_point *prior_failure_jump_point = parser->failure_jump_point;
+  parser->current_scope = result;
 
-  /* TODO: upon the failure of an iteration, deallocate the allocated memory
-           from the iteration, and skip to a valid onset. */
+  /* because a file scope is implicitely a structure, encountering `}` is
+     erroneous if we're at the global scope. */
+  bit is_global = result == &parser->program->global_scope;
+
+  get_token(parser); /* get the first onset */
 
   result->declarations_count = 0;
 
   for (statement *prior_declaration = 0;;)
   {
+    /* upon the failure of an iteration, the memory allocated by it is
+       deallocated, and parsing resumes from the next onset. */
+    scratch iteration_scratch;
+    get_scratch(&iteration_scratch, parser->general_allocator);
+    jump_point recovery_jump_point;
+    if (set_jump_point(recovery_jump_point))
+    {
+      end_scratch(&iteration_scratch);
+      parser->current_scope = result;
+      skip_to_onset(parser);
+      continue;
+    }
+    parser->failure_jump_point = &recovery_jump_point;
+
     statement *next_declaration = 0;
 
     switch (parser->token.tag)
     {
     case token_tag_identifier:
       /* encountered a declaration */
-      next_declaration = push_typed_train(statement, declaration_node, &parser->general_allocator);
+      next_declaration = push_typed_node_train(statement, declaration_node, parser);
       next_declaration->expression.tag = node_tag_declaration;
+      next_declaration->expression.beginning = parser->token.beginning;
       parse_declaration(&next_declaration->expression.data->declaration, parser);
+      next_declaration->expression.ending = parser->last_ending;
       break;
     case token_tag_semicolon:
       get_token(parser); /* ignore */
       break;
     case token_tag_right_brace:
-      /* because a file scope is implicitely a structure, encountering `{` is
-         erroneous if we're at the global scope.
-      */
-      if (parser->current_scope == &parser->program->global_scope)
+      if (is_global)
       {
         report_token_failure(parser, "Encountered extraneous %s.", token_tag_representations[token_tag_right_brace]);
+        get_token(parser); /* skip it, so it isn't the onset again */
         goto failed;
       }
-      else
-      {
-        get_token(parser);
-        break;
-      }
+      get_token(parser);
+      goto finished;
+    case token_tag_etx:
+      if (!is_global) report_token_failure(parser, "Expected %s.", token_tag_representations[token_tag_right_brace]);
+      goto finished;
     default:
       report_token_failure(parser, "Expected %s, %s, or %s.",
                            token_tag_representations[token_tag_identifier],
@@ -584,6 +1434,7 @@ void parse_structure(structure_node *result, parser *parser)
     /* link the next declaration */
     if (next_declaration)
     {
+      next_declaration->prior = prior_declaration;
       if (prior_declaration) prior_declaration = prior_declaration->next = next_declaration;
       else result->declarations = prior_declaration = next_declaration;
       result->declarations_count += 1;
@@ -595,29 +1446,232 @@ void parse_structure(structure_node *result, parser *parser)
   failed:
     jump(*parser->failure_jump_point, 1);
   }
+
+finished:
+  parser->current_scope = prior_scope;
+  parser->failure_jump_point = prior_failure_jump_point;
+}
+
+statement *parse_statement(parser *parser)
+{
+  statement *result;
+  if (on_declaration(parser))
+  {
+    result = push_typed_node_train(statement, declaration_node, parser);
+    result->expression.tag = node_tag_declaration;
+    result->expression.beginning = parser->token.beginning;
+    parse_declaration(&result->expression.data->declaration, parser);
+    result->expression.ending = parser->last_ending;
+  }
+  else
+  {
+    parser->is_parsing_statement = 1;
+    expression *parsed_expression = parse_expression(0, parser);
+    if (!parsed_expression)
+    {
+      report_token_failure(parser, "Expected a statement.");
+      jump(*parser->failure_jump_point, 1);
+    }
+    result = parser->parsed_statement;
+    if (!result)
+    {
+      /* a parenthesized expression was pushed by an inner parse */
+      uint size = node_sizes[parsed_expression->tag];
+      result = push_node_train(statement, size, parser);
+      copy(&result->expression, parsed_expression, sizeof(expression) + size);
+    }
+  }
+  return result;
 }
 
 void parse_procedure(procedure_node *result, parser *parser)
 {
-  get_token(parser);
-  for (;;)
+  structure_node *scope = parser->current_scope;
+  jump_point *prior_failure_jump_point = parser->failure_jump_point;
+
+  get_token(parser); /* skip `{` */
+
+  result->statements_count = 0;
+
+  for (statement *prior_statement = 0;;)
   {
-    parse_expression(0, parser);
+    scratch iteration_scratch;
+    get_scratch(&iteration_scratch, parser->general_allocator);
+    jump_point recovery_jump_point;
+    if (set_jump_point(recovery_jump_point))
+    {
+      end_scratch(&iteration_scratch);
+      parser->current_scope = scope;
+      skip_to_onset(parser);
+      continue;
+    }
+    parser->failure_jump_point = &recovery_jump_point;
+
     switch (parser->token.tag)
     {
     case token_tag_semicolon:
+      get_token(parser); /* ignore */
+      continue;
+    case token_tag_right_brace:
       get_token(parser);
+      goto finished;
+    case token_tag_etx:
+      report_token_failure(parser, "Expected %s.", token_tag_representations[token_tag_right_brace]);
+      goto finished;
+    default:
       break;
+    }
+
+    statement *next_statement = parse_statement(parser);
+    switch (parser->token.tag)
+    {
+    case token_tag_semicolon:
     case token_tag_right_brace:
-      goto finished;
+      break;
+    default:
+      report_token_failure(parser, "Expected %s or %s.",
+                           token_tag_representations[token_tag_semicolon],
+                           token_tag_representations[token_tag_right_brace]);
+      jump(*parser->failure_jump_point, 1);
     }
+
+    /* link the next statement */
+    next_statement->prior = prior_statement;
+    if (prior_statement) prior_statement = prior_statement->next = next_statement;
+    else result->statements = prior_statement = next_statement;
+    result->statements_count += 1;
   }
+
 finished:
-  get_token(parser);
+  parser->failure_jump_point = prior_failure_jump_point;
+}
+
+/* declares the named parameters, `name: type`, of a parameter list */
+static void parse_parameters(structure_node *result, expression *parameters, parser *parser)
+{
+  if (!parameters) return;
+  if (parameters->tag == node_tag_list)
+  {
+    parse_parameters(result, parameters->data->list.left, parser);
+    parse_parameters(result, parameters->data->list.right, parser);
+    return;
+  }
+
+  if (parameters->tag != node_tag_cast || parameters->data->cast.left->tag != node_tag_identifier)
+  {
+    report_expression_failure(parser->program, parameters, "Expected a named parameter.");
+    jump(*parser->failure_jump_point, 1);
+  }
+
+  statement *parameter = push_typed_node_train(statement, declaration_node, parser);
+  parameter->expression.tag       = node_tag_declaration;
+  parameter->expression.beginning = parameters->beginning;
+  parameter->expression.ending    = parameters->ending;
+  declaration_node *declaration = &parameter->expression.data->declaration;
+  declaration->identifier      = parameters->data->cast.left->data->identifier;
+  declaration->type_definition = parameters->data->cast.right;
+
+  /* the declarations are prepended, and reversed after all are declared */
+  parameter->next = result->declarations;
+  result->declarations = parameter;
+  result->declarations_count += 1;
+}
+
+/* declares the fields selected by `a.{b, c}`, whose types are those of the
+   fields of `a` */
+static void parse_selection(structure_node *result, parser *parser)
+{
+  get_token(parser); /* skip `{` */
+  for (statement *prior_field = 0;;)
+  {
+    ensure_token(token_tag_identifier, parser);
+    statement *field = push_typed_node_train(statement, declaration_node, parser);
+    field->expression.tag       = node_tag_declaration;
+    field->expression.beginning = parser->token.beginning;
+    parse_identifier(&field->expression.data->declaration.identifier, parser);
+    field->expression.ending = parser->last_ending;
+
+    field->prior = prior_field;
+    if (prior_field) prior_field = prior_field->next = field;
+    else result->declarations = prior_field = field;
+    result->declarations_count += 1;
+
+    if (parser->token.tag != token_tag_comma) break;
+    get_token(parser); /* skip `,` */
+  }
+  ensure_get_token(token_tag_right_brace, parser);
+}
+
+/* declares the type parameters, `$T`, within the types of the arguments,
+   after which they're uses of `T` like any other */
+static void parse_type_parameters(procedure_node *result, expression *types, parser *parser)
+{
+  if (!types) return;
+  switch (node_families[types->tag])
+  {
+  case node_family_leaf:
+    if (types->tag != node_tag_type_parameter) break;
+    {
+      statement *type_parameter = push_typed_node_train(statement, declaration_node, parser);
+      type_parameter->expression.tag       = node_tag_declaration;
+      type_parameter->expression.beginning = types->beginning;
+      type_parameter->expression.ending    = types->ending;
+      type_parameter->expression.data->declaration.identifier  = types->data->type_parameter.identifier;
+      type_parameter->expression.data->declaration.is_constant = 1;
+
+      type_parameter->next = result->type_parameters;
+      if (result->type_parameters) result->type_parameters->prior = type_parameter;
+      result->type_parameters = type_parameter;
+      result->type_parameters_count += 1;
+      types->tag = node_tag_identifier;
+    }
+    break;
+  case node_family_unary:
+    parse_type_parameters(result, types->data->unary.expression, parser);
+    break;
+  case node_family_binary:
+    parse_type_parameters(result, types->data->binary.left, parser);
+    parse_type_parameters(result, types->data->binary.right, parser);
+    break;
+  default:
+    break;
+  }
+}
+
+static void reverse_declarations(structure_node *structure)
+{
+  statement *prior = 0;
+  for (statement *current = structure->declarations, *next; current; current = next)
+  {
+    next = current->next;
+    current->next  = prior;
+    current->prior = next;
+    prior = current;
+  }
+  structure->declarations = prior;
+}
+
+/* a node that may be the expression of a statement is pushed within one, so
+   it isn't copied into it */
+static expression *push_expression(uint size, bit is_statement, statement **statement_node, parser *parser)
+{
+  if (!is_statement) return push_node_train(expression, size, parser);
+  *statement_node = push_node_train(statement, size, parser);
+  return &(*statement_node)->expression;
 }
 
+#define push_typed_expression(node_type, is_statement, statement_node, parser) push_expression(sizeof(node_type), is_statement, statement_node, parser)
+
 expression *parse_expression(precedence left_precedence, parser *parser)
 {
+  uint beginning = parser->token.beginning;
+
+  /* only the nodes of this parse, and not of its operands', may be a
+     statement's expression */
+  bit is_statement = parser->is_parsing_statement;
+  parser->is_parsing_statement = 0;
+  statement *statement_node = 0;
+
   /* parse left */
   expression *left = 0;
   {
@@ -625,25 +1679,72 @@ expression *parse_expression(precedence left_precedence, parser *parser)
     {
       /* structure */
     case token_tag_left_brace:
-      left = push_typed_train(expression, structure_node, &parser->general_allocator);
-      parse_structure(&left->data->structure, parser);
+      left = push_typed_expression(structure_node, is_statement, &statement_node, parser);
+      left->tag = node_tag_structure;
+      {
+        bit was_parsing_consequent = parser->is_parsing_consequent;
+        parser->is_parsing_consequent = 0;
+        parse_structure(&left->data->structure, parser);
+        parser->is_parsing_consequent = was_parsing_consequent;
+      }
+      left->beginning = beginning;
+      left->ending    = parser->last_ending;
       goto finished;
 
     case token_tag_left_parenthesis:
-      get_token(parser); /* skip `(` */
-      left = parse_expression(0, parser);
-      ensure_get_token(token_tag_right_parenthesis, parser);
-      break;
+      {
+        get_token(parser); /* skip `(` */
+        bit was_parsing_consequent = parser->is_parsing_consequent;
+        parser->is_parsing_consequent = 0;
+        left = parse_expression(0, parser);
+        parser->is_parsing_consequent = was_parsing_consequent;
+        ensure_get_token(token_tag_right_parenthesis, parser);
+        break;
+      }
+
+      /* prefixed */
+    case token_tag_exclamation:
+    case token_tag_plus:
+    case token_tag_dash:
+    case token_tag_tilde:
+      {
+        node_tag tag;
+        switch (parser->token.tag)
+        {
+        case token_tag_exclamation: tag = node_tag_negation;         break;
+        case token_tag_plus:        tag = node_tag_positive;         break;
+        case token_tag_dash:        tag = node_tag_negative;         break;
+        default:                    tag = node_tag_bitwise_negation; break;
+        }
+        get_token(parser); /* skip the operator */
+        left = push_typed_expression(unary_node, is_statement, &statement_node, parser);
+        left->tag = tag;
+        left->data->unary.expression = parse_expression(precedences[tag], parser);
+        if (!left->data->unary.expression)
+        {
+          report_token_failure(parser, "Expected an expression.");
+          jump(*parser->failure_jump_point, 1);
+        }
+        break;
+      }
 
     case token_tag_identifier:
-      left = push_typed_train(expression, identifier_node, &parser->general_allocator);
+      left = push_typed_expression(identifier_node, is_statement, &statement_node, parser);
       left->tag = node_tag_identifier;
       parse_identifier(&left->data->identifier, parser);
       break;
 
+    case token_tag_dollar:
+      get_token(parser); /* skip `$` */
+      ensure_token(token_tag_identifier, parser);
+      left = push_typed_expression(type_parameter_node, is_statement, &statement_node, parser);
+      left->tag = node_tag_type_parameter;
+      parse_identifier(&left->data->type_parameter.identifier, parser);
+      break;
+
     case token_tag_at:
       get_token(parser); /* skip `@` */
-      left = push_typed_train(expression, unary_node, &parser->general_allocator);
+      left = push_typed_expression(unary_node, is_statement, &statement_node, parser);
       left->tag = node_tag_reference;
       left->data->unary.expression = parse_expression(0, parser);
       break;
@@ -652,18 +1753,32 @@ expression *parse_expression(precedence left_precedence, parser *parser)
     case token_tag_digital:
     case token_tag_hexadecimal:
     case token_tag_decimal:
-      left = push_typed_train(expression, digital_node, &parser->general_allocator);
+      left = push_typed_expression(digital_node, is_statement, &statement_node, parser);
       parse_number(left, parser);
       break;
 
+    case token_tag_string:
+      left = push_typed_expression(string_node, is_statement, &statement_node, parser);
+      left->tag = node_tag_string;
+      parse_string(&left->data->string, parser);
+      break;
+
     case token_tag_right_parenthesis:
+    case token_tag_right_bracket:
     case token_tag_right_brace:
+    case token_tag_semicolon:
+    case token_tag_etx:
       goto finished;
 
     default:
-      report_token_comment(parser, "unknklsdf");
-      UNIMPLEMENTED();
-      break;
+      report_token_failure(parser, "Expected an expression.");
+      jump(*parser->failure_jump_point, 1);
+    }
+
+    if (left)
+    {
+      left->beginning = beginning;
+      left->ending    = parser->last_ending;
     }
   }
 
@@ -679,10 +1794,12 @@ expression *parse_expression(precedence left_precedence, parser *parser)
         get_token(parser); /* skip `->` */
 
         expression *arguments = left;
-        left = push_typed_train(expression, procedure_node, &parser->general_allocator);
+        left = push_typed_expression(procedure_node, is_statement, &statement_node, parser);
         left->tag = node_tag_procedure_type;
         left->data->procedure_type.arguments = arguments;
         left->data->procedure_type.results = parse_expression(0, parser);
+        left->beginning = beginning;
+        left->ending    = parser->last_ending;
 
         /* procedure type */
         if (parser->token.tag != token_tag_left_brace)
@@ -693,9 +1810,19 @@ expression *parse_expression(precedence left_precedence, parser *parser)
 
         /* procedure */
     case token_tag_left_brace:
-        if (left->tag != node_tag_procedure_type) goto finished;
+        if (!left || left->tag != node_tag_procedure_type) goto finished;
         left->tag = node_tag_procedure;
-        parse_procedure(&left->data->procedure, parser);
+        procedure_node *procedure = &left->data->procedure;
+        parse_parameters(&procedure->structure, procedure->arguments, parser);
+        procedure->arguments_count = procedure->structure.declarations_count;
+        parse_parameters(&procedure->structure, procedure->results, parser);
+        reverse_declarations(&procedure->structure);
+        parse_type_parameters(procedure, procedure->arguments, parser);
+        bit was_parsing_consequent = parser->is_parsing_consequent;
+        parser->is_parsing_consequent = 0;
+        parse_procedure(procedure, parser);
+        parser->is_parsing_consequent = was_parsing_consequent;
+        left->ending = parser->last_ending;
         goto finished;
       }
       
@@ -740,11 +1867,17 @@ expression *parse_expression(precedence left_precedence, parser *parser)
     case token_tag_dot: right_tag = node_tag_resolution; break;
       
       /* other */
-    case token_tag_colon:     right_tag = node_tag_cast;       break;
+    case token_tag_colon:
+      if (parser->is_parsing_consequent) goto finished;
+      right_tag = node_tag_cast;
+      break;
     case token_tag_comma:     right_tag = node_tag_list;       break;
     case token_tag_question:  right_tag = node_tag_condition;  break;
     case token_tag_semicolon:
     case token_tag_right_parenthesis:
+    case token_tag_right_bracket:
+    case token_tag_right_brace:
+    case token_tag_etx:
       goto finished;
     default:                  right_tag = node_tag_invocation; break;
     }
@@ -765,18 +1898,45 @@ expression *parse_expression(precedence left_precedence, parser *parser)
     if (right_tag != node_tag_invocation) get_token(parser);
 
     expression *right = right_tag != node_tag_condition
-                      ? push_typed_train(expression, binary_node, &parser->general_allocator)
-                      : push_typed_train(expression, ternary_node, &parser->general_allocator);
+                      ? push_typed_expression(binary_node, is_statement, &statement_node, parser)
+                      : push_typed_expression(ternary_node, is_statement, &statement_node, parser);
     right->tag = right_tag;
+    right->beginning = left->beginning;
     right->data->binary.left = left;
-    if (right_tag != node_tag_condition)
+    if (right_tag == node_tag_resolution && parser->token.tag == token_tag_left_brace)
+    {
+      /* `a.{b, c}` selects several fields */
+      uint selection_beginning = parser->token.beginning;
+      expression *selection = push_typed_node_train(expression, structure_node, parser);
+      selection->tag = node_tag_structure;
+      parse_selection(&selection->data->structure, parser);
+      selection->beginning = selection_beginning;
+      selection->ending    = parser->last_ending;
+      right->data->resolution.right = selection;
+    }
+    else if (right_tag == node_tag_invocation && on_empty_parentheses(parser))
+    {
+      /* `a ()` invokes without arguments */
+      get_token(parser); /* skip `(` */
+      get_token(parser); /* skip `)` */
+      right->data->binary.right = 0;
+    }
+    else if (right_tag != node_tag_condition)
     {
       right->data->binary.right = parse_expression(right_precedence, parser);
+      if (!right->data->binary.right)
+      {
+        report_token_failure(parser, "Expected an expression.");
+        jump(*parser->failure_jump_point, 1);
+      }
     }
     else /* the expression is ternary */
     {
       /* parse the right expression as a parenthesized expression */
+      bit was_parsing_consequent = parser->is_parsing_consequent;
+      parser->is_parsing_consequent = 1;
       right->data->ternary.right = parse_expression(0, parser);
+      parser->is_parsing_consequent = was_parsing_consequent;
 
       /* parse a possible other expression */
       if (parser->token.tag == token_tag_colon)
@@ -786,18 +1946,37 @@ expression *parse_expression(precedence left_precedence, parser *parser)
       }
     }
 
+    right->ending = parser->last_ending;
     left = right;
   }
   
 finished:
+  if (is_statement) parser->parsed_statement = statement_node && left == &statement_node->expression ? statement_node : 0;
   return left;
 }
 
-void parse(const utf8 *path, program *program, parser *parser)
+/* parses the source at the path, or the text or the stream if any */
+static void parse_source(const utf8 *path, const utf8 *text, uint text_size, const handle *stream, program *program, parser *parser)
 {
+  /* the parser keeps nothing of a prior source but its arena, so it's reused */
+  bit is_compacting = parser->is_compacting;
+  bit is_pooling = parser->is_pooling;
+  allocator parsing_allocator = parser->parsing_allocator;
   fill(parser, sizeof(*parser), 0);
-
+  parser->is_compacting = is_compacting;
+  parser->parsing_allocator = parsing_allocator;
+
+  /* compacted nodes are copied out of the parsing arena anyway */
+  parser->is_pooling = is_pooling && !is_compacting;
+  if (parser->is_pooling) program->nodes.slot_size = node_slot_size;
+
+  /* a big source's nodes take far fewer pages, and page table entries, in
+     the huge buffers of these */
+  program->allocator.is_huge = 1;
+  parser->parsing_allocator.is_huge = 1;
+  parser->general_allocator = is_compacting ? &parser->parsing_allocator : &program->allocator;
   parser->program = program;
+  program->source_path = path;
 
   /* initialize failure system */
   jump_point failure_jump_point;
@@ -806,44 +1985,354 @@ void parse(const utf8 *path, program *program, parser *parser)
   context.failure_jump_point = parser->failure_jump_point;
   if (set_jump_point(failure_jump_point))
   {
-    print_comment("Failed to %s.\n", __FUNCTION__);
-    /* TODO: handle failure here */
+    if (reporting.minimum_type <= reporting_type_comment) print_comment("Failed to %s.\n", __FUNCTION__);
+    /* a failure without a report, like failing to read the source, still
+       fails the program */
+    if (!program->failures_count) program->failures_count = 1;
     goto defer;
   }
 
   /* load the source */
-  load_into_parser(path, parser);
-
-  /* initialize closure */
-  if (set_jump_point(parser->etx_jump_point))
-    goto done_parsing;
+  if (text) copy_into_parser(path, text, text_size, parser);
+  else if (stream) stream_into_parser(path, *stream, parser);
+  else if (!compare_string(path, "-")) stream_into_parser(path, get_standard_input(), parser);
+  else load_into_parser(path, parser);
+  program->source      = parser->is_streaming ? 0 : parser->source;
+  program->source_size = parser->source_size;
 
   /* parse */
   parse_structure(&parser->program->global_scope, parser);
 
-done_parsing:
-
 defer:
+  if (parser->is_streaming) end_stream(program, parser);
+  /* even a partial tree is compacted, since the parsing arena is emptied */
+  if (is_compacting)
+  {
+    compact_program(program);
+    reset_allocator(&parser->parsing_allocator);
+  }
+  flush_reports();
   context.failure_jump_point = prior_context_failure_jump_point;
 }
 
+void parse(const utf8 *path, program *program, parser *parser)
+{
+  parse_source(path, 0, 0, 0, program, parser);
+}
+
+void parse_text(const utf8 *path, const utf8 *text, uint text_size, program *program, parser *parser)
+{
+  parse_source(path, text, text_size, 0, program, parser);
+}
+
+void parse_stream(const utf8 *path, handle stream, program *program, parser *parser)
+{
+  parse_source(path, 0, 0, &stream, program, parser);
+}
+
+void release_parser(parser *parser)
+{
+  release_allocator(&parser->parsing_allocator);
+}
+
+/*****************************************************************************/
+
+#include "proglosa_resolution.c"
+#include "proglosa_typing.c"
+#include "proglosa_layout.c"
+#include "proglosa_folding.c"
+#include "proglosa_bytecode.c"
+#include "proglosa_ir.c"
+#include "proglosa_jit.c"
+#include "proglosa_c.c"
+#include "proglosa_elf.c"
+#include "proglosa_server.c"
+#include "proglosa_lsp.c"
+#include "proglosa_stress.c"
+
 /*****************************************************************************/
 
+/* runs a procedure with arguments parsed by its parameters' types, and
+   prints its results; in machine code if it's jitted */
+static int run_procedure(bytecode *bytecode, jit *jit, const utf8 *name, char *arguments[], uint arguments_count)
+{
+  sintl procedure_index = find_bytecode_procedure(name, bytecode);
+  if (procedure_index < 0)
+  {
+    print_failure("No procedure is named %s.\n", name);
+    return -1;
+  }
+  bytecode_procedure *procedure = &bytecode->procedures[procedure_index];
+  if (arguments_count != procedure->arguments_count)
+  {
+    print_failure("%s takes %u argument%s, but %u were given.\n", name, procedure->arguments_count, procedure->arguments_count == 1 ? "" : "s", arguments_count);
+    return -1;
+  }
+
+  type *procedure_type = get_type(procedure->type);
+  value procedure_arguments[maximum_parameters_count];
+  value procedure_results[maximum_parameters_count];
+  for (uint i = 0; i < arguments_count; ++i)
+  {
+    type *argument_type = get_type(procedure_type->components[i]);
+    utf8 *argument_ending;
+    switch (argument_type->kind)
+    {
+    case type_kind_float:
+      procedure_arguments[i].decimal = strtod(arguments[i], &argument_ending);
+      if (argument_type->size == sizeof(float32)) procedure_arguments[i].decimal = (float32)procedure_arguments[i].decimal;
+      break;
+    case type_kind_signed:
+    case type_kind_unsigned:
+    case type_kind_bit:
+      procedure_arguments[i].unsigned_integer = normalize_integer(strtoull(arguments[i], &argument_ending, 0), procedure_type->components[i]);
+      break;
+    default:
+      print_failure("The argument %u of %s can't be given.\n", i + 1, name);
+      return -1;
+    }
+    if (*argument_ending)
+    {
+      print_failure("The argument %u of %s isn't a number: %s\n", i + 1, name, arguments[i]);
+      return -1;
+    }
+  }
+
+  if (!run_bytecode(0, 0, 0, bytecode)) return 1;
+  if (jit && jit->entries[procedure_index] != no_jit_entry)
+  {
+    if (!run_jitted(procedure_index, procedure_arguments, procedure_results, jit)) return 1;
+  }
+  else
+  {
+    if (jit) print_comment("%s isn't compiled to machine code, so it's interpreted.\n", name);
+    if (!run_bytecode(procedure_index, procedure_arguments, procedure_results, bytecode)) return 1;
+  }
+
+  for (uint i = 0; i < procedure->results_count; ++i)
+  {
+    type_id result_type = procedure_type->components[procedure->arguments_count + i];
+    switch (get_type(result_type)->kind)
+    {
+    case type_kind_float:  printf("%g\n", procedure_results[i].decimal); break;
+    case type_kind_signed: printf("%lld\n", (long long)procedure_results[i].signed_integer); break;
+    default:               printf("%llu\n", (unsigned long long)procedure_results[i].unsigned_integer); break;
+    }
+  }
+  return 0;
+}
+
+void reset_program(program *program)
+{
+  forget_program(program);
+  release_slot_pool(&program->nodes);
+  allocator allocator = program->allocator;
+  reset_allocator(&allocator);
+  zero(program, sizeof(*program));
+  program->allocator = allocator;
+}
+
+void release_program(program *program)
+{
+  forget_program(program);
+  release_slot_pool(&program->nodes);
+  release_allocator(&program->allocator);
+  zero(program, sizeof(*program));
+}
+
+/* checks several programs, whose sources are read together so that each is
+   parsed while the later ones are still being read */
+static int check_programs(char *paths[], uint paths_count, const layout_options *layout_options, bit is_compacting_nodes, bit is_pooling_nodes)
+{
+  uint failures_count = 0;
+  file_batch *batch = begin_reading_files((const char **)paths, paths_count);
+  /* one arena serves every program, which is reset after each */
+  program program = {0};
+  parser parser = { .is_compacting = is_compacting_nodes, .is_pooling = is_pooling_nodes };
+  for (uint i = 0; i < paths_count; ++i)
+  {
+    uint source_size;
+    const byte *source = compare_string(paths[i], "-") ? wait_for_file(&source_size, i, batch) : 0;
+    /* the standard input is streamed, and a source that couldn't be read
+       is read again by the parser, which reports why */
+    if (source) parse_text(paths[i], (const utf8 *)source, source_size, &program, &parser);
+    else parse(paths[i], &program, &parser);
+    if (!program.failures_count) resolve(&program);
+    if (!program.failures_count) check_types(&program);
+    if (!program.failures_count) lay_out_types(&program, layout_options);
+    if (!program.failures_count) fold_constants(&program);
+    flush_reports();
+    failures_count += program.failures_count;
+    reset_program(&program);
+  }
+  release_program(&program);
+  release_parser(&parser);
+  end_reading_files(batch);
+
+  if (!failures_count) return 0;
+  print_failure("%u failure%s.\n", failures_count, failures_count == 1 ? "" : "s");
+  return 1;
+}
+
 int start(int arguments_count, char *arguments[])
 {
   if (!initialize_base())
     UNIMPLEMENTED();
 
-  if (arguments_count <= 1)
+  /* `proglosa [options] path...` checks programs, and `proglosa run [options]
+     path [procedure [arguments]]` runs one of its procedures, `main` by
+     default; `--jit` runs it in machine code. `--emit-ir` prints the
+     optimized intermediate representation, and `--emit-unoptimized-ir` the
+     one lowered from the program. `--emit-c` prints the program translated
+     to C, and `--emit-object path` writes it to an object. `--emit-layout`
+     prints the layouts of the structures, whose fields `--reorder-fields`
+     orders to minimize padding; `--struct-of-arrays Name` lays out the
+     arrays of a structure as arrays of its fields. `--compact-nodes`
+     copies the parsed nodes into preorder before they're checked, and
+     `--pool-nodes` takes them from a slot pool that folding gives the
+     replaced ones back to. The path `-` streams the standard input.
+
+     `proglosa serve [options] socket` checks programs upon the requests of
+     `proglosa ask socket request`, like `check path` or `declarations path`,
+     and keeps them until their sources change; `stop` stops it.
+
+     `proglosa lsp` speaks the language server protocol upon the standard
+     input and output, answering definitions, hovers and document symbols.
+
+     `proglosa stress [shape [size [steps]]]` parses and resolves generated
+     programs of sizes halved from the greatest, failing if their time grows
+     faster than linearly or their memory outgrows their sources; its shapes
+     are a million declarations, an expression nested ten thousand deep, a
+     string of 100 MiB, a scope of a million declarations, a failing
+     source reparsed into a reset program, whose memory mustn't grow, and a
+     million folded constants whose nodes are pushed, or pooled. */
+  if (arguments_count > 2 && !compare_string(arguments[1], "ask"))
+    return ask(arguments[2], arguments + 3, (uint)(arguments_count - 3));
+  if (arguments_count == 2 && !compare_string(arguments[1], "lsp"))
+    return serve_language();
+  if (arguments_count > 1 && !compare_string(arguments[1], "stress"))
+    return stress(arguments + 2, (uint)(arguments_count - 2));
+
+  int i = 1;
+  bit is_running = i < arguments_count && !compare_string(arguments[i], "run");
+  bit is_serving = !is_running && i < arguments_count && !compare_string(arguments[i], "serve");
+  if (is_running || is_serving) ++i;
+
+  const utf8 *source_path = 0;
+  bit is_jitting = 0;
+  bit is_emitting_ir = 0, is_optimizing_ir = 1;
+  bit is_emitting_c = 0;
+  const utf8 *object_path = 0;
+  bit is_emitting_layout = 0;
+  bit is_compacting_nodes = 0;
+  bit is_pooling_nodes = 0;
+  layout_options layout_options = {0};
+  layout_options.struct_of_arrays = allocate(arguments_count * sizeof(const utf8 *));
+  for (; i < arguments_count && !source_path; ++i)
+  {
+    if (!compare_string(arguments[i], "--verbose"))
+      reporting.minimum_type = reporting_type_comment;
+    else if (!compare_string(arguments[i], "--quiet"))
+      reporting.minimum_type = reporting_type_failure;
+    else if (!compare_string(arguments[i], "--compact"))
+      reporting.is_compact = 1;
+    else if (is_running && !compare_string(arguments[i], "--jit"))
+      is_jitting = 1;
+    else if (!compare_string(arguments[i], "--emit-ir"))
+      is_emitting_ir = 1;
+    else if (!compare_string(arguments[i], "--emit-unoptimized-ir"))
+      is_emitting_ir = 1, is_optimizing_ir = 0;
+    else if (!compare_string(arguments[i], "--emit-c"))
+      is_emitting_c = 1;
+    else if (!compare_string(arguments[i], "--emit-object") && i + 1 < arguments_count)
+      object_path = arguments[++i];
+    else if (!compare_string(arguments[i], "--emit-layout"))
+      is_emitting_layout = 1;
+    else if (!compare_string(arguments[i], "--reorder-fields"))
+      layout_options.is_reordering_fields = 1;
+    else if (!compare_string(arguments[i], "--struct-of-arrays") && i + 1 < arguments_count)
+      layout_options.struct_of_arrays[layout_options.struct_of_arrays_count++] = arguments[++i];
+    else if (!compare_string(arguments[i], "--compact-nodes"))
+      is_compacting_nodes = 1;
+    else if (!compare_string(arguments[i], "--pool-nodes"))
+      is_pooling_nodes = 1;
+    else if (arguments[i][0] == '-' && arguments[i][1])
+    {
+      print_failure("Unknown option: %s\n", arguments[i]);
+      return -1;
+    }
+    else source_path = arguments[i];
+  }
+
+  if (!source_path)
   {
     print_failure("A source path wasn't given.\n");
     return -1;
   }
 
-  program program;
+  if (is_serving)
+  {
+    if (i < arguments_count || is_emitting_ir || is_emitting_c || object_path || is_emitting_layout)
+    {
+      print_failure("Only checks are served.\n");
+      return -1;
+    }
+    return serve(source_path, &layout_options, is_compacting_nodes, is_pooling_nodes);
+  }
+
+  const utf8 *procedure_name = "main";
+  if (is_running && i < arguments_count) procedure_name = arguments[i++];
+  else if (!is_running && i < arguments_count)
+  {
+    if (is_emitting_ir || is_emitting_c || object_path || is_emitting_layout)
+    {
+      print_failure("Only one program is emitted.\n");
+      return -1;
+    }
+    return check_programs(arguments + i - 1, (uint)(arguments_count - i + 1), &layout_options, is_compacting_nodes, is_pooling_nodes);
+  }
+
+  program program = {0};
 
-  parser parser;
-  parse(arguments[1], &program, &parser);
+  parser parser = { .is_compacting = is_compacting_nodes, .is_pooling = is_pooling_nodes };
+  parse(source_path, &program, &parser);
+  if (!program.failures_count) resolve(&program);
+  if (!program.failures_count) check_types(&program);
+  if (!program.failures_count) lay_out_types(&program, &layout_options);
+  if (!program.failures_count) fold_constants(&program);
 
-  return 0;
+  ir ir;
+  if (!program.failures_count && is_emitting_ir) compile_ir(&program, &ir);
+  c_unit c_unit;
+  if (!program.failures_count && is_emitting_c) translate_to_c(&program, &c_unit);
+  bytecode bytecode;
+  if (!program.failures_count && (is_running || object_path)) compile_bytecode(&program, &bytecode);
+  flush_reports();
+
+  if (program.failures_count)
+  {
+    print_failure("%u failure%s.\n", program.failures_count, program.failures_count == 1 ? "" : "s");
+    return 1;
+  }
+
+  if (is_emitting_layout) print_layouts();
+  if (is_emitting_ir)
+  {
+    if (is_optimizing_ir) optimize_ir(&ir);
+    print_ir(&ir);
+    release_ir(&ir);
+  }
+  if (is_emitting_c)
+  {
+    print_c(&c_unit);
+    release_c(&c_unit);
+  }
+  if (object_path && !write_object(&program, &bytecode, object_path)) return 1;
+  if (!is_running) return 0;
+
+  jit jit;
+  if (is_jitting) compile_jit(&bytecode, &jit);
+  int status = run_procedure(&bytecode, is_jitting ? &jit : 0, procedure_name, arguments + i, (uint)(arguments_count - i));
+  if (is_jitting) release_jit(&jit);
+  return status;
 }
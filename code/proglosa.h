@@ -13,8 +13,36 @@ typedef enum
   reporting_type_failure,
 } reporting_type;
 
+/* reports below this type are compiled out */
+#if !defined(REPORTING_THRESHOLD)
+  #if defined(DEBUGGING)
+    #define REPORTING_THRESHOLD reporting_type_comment
+  #else
+    #define REPORTING_THRESHOLD reporting_type_caution
+  #endif
+#endif
+
+/* reports that are kept rather than written */
+typedef struct
+{
+  utf8 *text;
+  uint  size;
+  uint  capacity;
+} report_capture;
+
+typedef struct
+{
+  reporting_type  minimum_type; /* reports below this are ignored at runtime */
+  bit             is_compact : 1; /* `path:row:column:beginning:ending:type:message` without excerpts */
+  report_capture *capture;      /* if any, reports are flushed into it rather than the standard error */
+} reporting_settings;
+
+extern reporting_settings reporting;
+
 extern const utf8 reporting_type_representation[][8];
 
+/* reports are buffered per thread, and written upon a failure, upon filling
+   the buffer, or upon `flush_reports`. */
 void v_report(reporting_type type, const utf8 *source, const utf8 *path, uint beginning, uint ending, uint row, uint column, const utf8 *message, vargs vargs);
 
 inline void report(reporting_type type, const utf8 *source, const utf8 *path, uint beginning, uint ending, uint row, uint column, const utf8 *message, ...)
@@ -25,9 +53,13 @@ inline void report(reporting_type type, const utf8 *source, const utf8 *path, ui
   end_vargs(vargs);
 }
 
-#define report_comment(...) report(reporting_type_comment, __VA_ARGS__)
-#define report_caution(...) report(reporting_type_caution, __VA_ARGS__)
-#define report_failure(...) report(reporting_type_failure, __VA_ARGS__)
+void flush_reports(void);
+
+#define REPORT_ABOVE_THRESHOLD(type, reporter, ...) do { if ((type) >= REPORTING_THRESHOLD) reporter(type, __VA_ARGS__); } while (0)
+
+#define report_comment(...) REPORT_ABOVE_THRESHOLD(reporting_type_comment, report, __VA_ARGS__)
+#define report_caution(...) REPORT_ABOVE_THRESHOLD(reporting_type_caution, report, __VA_ARGS__)
+#define report_failure(...) REPORT_ABOVE_THRESHOLD(reporting_type_failure, report, __VA_ARGS__)
 
 /*****************************************************************************/
 
@@ -55,9 +87,9 @@ void v_report_token(reporting_type type, parser *parser, const utf8 *message, va
 
 void report_token(reporting_type type, parser *parser, const utf8 *message, ...);
 
-#define report_token_comment(...) report_token(reporting_type_comment, __VA_ARGS__)
-#define report_token_caution(...) report_token(reporting_type_caution, __VA_ARGS__)
-#define report_token_failure(...) report_token(reporting_type_failure, __VA_ARGS__)
+#define report_token_comment(...) REPORT_ABOVE_THRESHOLD(reporting_type_comment, report_token, __VA_ARGS__)
+#define report_token_caution(...) REPORT_ABOVE_THRESHOLD(reporting_type_caution, report_token, __VA_ARGS__)
+#define report_token_failure(...) REPORT_ABOVE_THRESHOLD(reporting_type_failure, report_token, __VA_ARGS__)
 
 /*****************************************************************************/
 
@@ -72,6 +104,9 @@ extern const utf8 *node_tag_representations[];
 
 typedef struct expression expression;
 typedef struct statement  statement;
+typedef struct scope      scope;
+
+typedef uint type_id; /* see `type` */
 
 #define XPASTE(identifier, body) typedef struct identifier##_node identifier##_node;
   #include "proglosa_nodes.inc"
@@ -84,6 +119,9 @@ typedef struct statement  statement;
 struct expression
 {
   node_tag tag;
+  uint     beginning; /* the source span */
+  uint     ending;
+  type_id  type;      /* assigned by `check_types` */
   union
   {
 #define XPASTE(identifier, body) identifier##_node identifier;
@@ -99,39 +137,446 @@ struct statement
   expression expression;
 };
 
+#define node_slot_size ((uint)8) /* of the pool of a program's nodes, which are aligned to it */
+
 #define identifier_allocator_chunk_size (8)
 #define maximum_identifier_size         (uint_bits_count * identifier_allocator_chunk_size)
 
 typedef struct
 {
+  /* which owns the source, the nodes and their scopes, and the instances of
+     the generic procedures */
+  allocator allocator;
+  slot_pool nodes; /* which the nodes are taken from instead when they're pooled; see `parser.is_pooling` */
+
   structure_node global_scope;
+
+  const utf8 *source_path;
+  utf8       *source;
+  uint        source_size;
+
+  uint *line_offsets; /* the offset of every line, built upon the first report */
+  uint  lines_count;
+
+  uint failures_count;
 } program;
 
+/* forgets the program's types and instances, and empties its arena while
+   keeping the buffers, so it can be parsed again without faulting pages */
+void reset_program(program *program);
+
+/* like `reset_program`, but the arena's buffers are released */
+void release_program(program *program);
+
+void v_report_expression(reporting_type type, program *program, expression *expression, const utf8 *message, vargs vargs);
+
+void report_expression(reporting_type type, program *program, expression *expression, const utf8 *message, ...);
+
+#define report_expression_comment(...) REPORT_ABOVE_THRESHOLD(reporting_type_comment, report_expression, __VA_ARGS__)
+#define report_expression_caution(...) REPORT_ABOVE_THRESHOLD(reporting_type_caution, report_expression, __VA_ARGS__)
+#define report_expression_failure(...) REPORT_ABOVE_THRESHOLD(reporting_type_failure, report_expression, __VA_ARGS__)
+
 /*****************************************************************************/
 
 struct parser
 {
-  allocator general_allocator;
-  
+  allocator *general_allocator; /* of the program, or the parsing arena when compacting */
+
+  /* a compacting parser parses into its own arena, which it keeps across
+     sources, and compacts the nodes into the program's; see `compact_program` */
+  bit       is_compacting : 1;
+  allocator parsing_allocator;
+
+  /* a pooling parser takes the nodes from the program's slot pool, which
+     folding gives the operands it replaces back to; the nodes of a failed
+     declaration are kept until the program is reset, unlike those pushed */
+  bit is_pooling : 1;
+
   const utf8 *source_path;
-  utf8 *source;
-  uint  source_size;
+  utf8 *source;      /* from `source_base` */
+  uint  source_base; /* which is nonzero only within a streamed source */
+  uint  source_size; /* the offset past the last rune that's available */
+
+  /* a streamed source, like a pipe, is read into a window that keeps the
+     runes from the earliest one that's still needed */
+  bit    is_streaming     : 1;
+  bit    has_stream_ended : 1;
+  handle stream;
+  uint   streamed_size;  /* which may end within a rune */
+  uint   kept_offset;    /* of the current token, or `no_kept_offset` between tokens */
+  uint_array line_offsets; /* since the lines aren't kept, they're recorded while streaming */
 
   uint offset;
   uint row;
   uint column;
+  uint last_ending; /* the ending of the prior token */
 
   utf32 rune;
   uints increment;
 
-  bit finished_parsing : 1;
-
-  jump_point  etx_jump_point;
   jump_point *failure_jump_point;
   
   token           token;
   program        *program;
   structure_node *current_scope;
+  bit             is_parsing_consequent : 1; /* so `:` ends `a ? b : c`'s `b` rather than casting it */
+  bit             is_parsing_statement : 1;  /* so the next expression is pushed within a statement */
+  statement      *parsed_statement;          /* which the last expression parsed as a statement is within, if any */
 };
 
 void parse(const utf8 *path, program *program, parser *parser);
+
+/* parses a source that's in memory, like an unsaved one of an editor; the
+   path is only reported */
+void parse_text(const utf8 *path, const utf8 *text, uint text_size, program *program, parser *parser);
+
+/* parses a source as it's read from the handle, like a pipe, keeping only a
+   window of it; the path `-` of `parse` streams the standard input */
+void parse_stream(const utf8 *path, handle stream, program *program, parser *parser);
+
+/* releases the parsing arena of a compacting parser */
+void release_parser(parser *parser);
+
+/*****************************************************************************/
+
+typedef struct
+{
+  uint              hash;
+  declaration_node *declaration;
+} scope_slot;
+
+DECLARE_MAP(scope_map, scope_slot, const identifier_node *)
+
+/* the declarations of a structure or a procedure, chained to the scope
+   enclosing it. */
+struct scope
+{
+  scope    *parent;
+  scope_map slots;
+};
+
+declaration_node *find_declaration(const utf8 *runes, uint runes_count, uint hash, scope *scope);
+
+/* binds every identifier to its declaration */
+void resolve(program *program);
+
+/*****************************************************************************/
+
+typedef enum
+{
+  type_kind_none,      /* of failed and valueless expressions */
+  type_kind_type,      /* of expressions denoting types */
+  type_kind_integer,   /* of untyped integer constants */
+  type_kind_decimal,   /* of untyped decimal constants */
+  type_kind_unsigned,
+  type_kind_signed,
+  type_kind_float,
+  type_kind_bit,
+  type_kind_pointer,
+  type_kind_procedure,
+  type_kind_structure,
+} type_kind;
+
+/* types are hash-consed: equal types are interned once, so they're compared
+   by their ids. structures named by a declaration are distinct from equal
+   structures, which lets them refer to themselves. */
+typedef struct
+{
+  type_kind kind;
+  uint      hash;
+  uint      size;             /* in bytes; of structures, it's assigned by `lay_out_types` */
+  type_id   pointee;          /* of pointers */
+  type_id  *components;       /* the arguments then results of procedures, or the fields of structures */
+  uint      components_count;
+  uint      arguments_count;  /* of procedures */
+
+  structure_node   *structure;   /* of structures; its declarations name the fields */
+  declaration_node *declaration; /* of named structures */
+  program          *program;     /* whose nodes it refers to, even through its components, if any */
+
+  /* of every type, assigned by `lay_out_types` */
+  uint  alignment;
+  uint *offsets;                    /* of the fields of structures, or `no_offset` if they aren't stored */
+  uint  padding_size;               /* of structures, in bytes */
+  bit   is_struct_of_arrays : 1;    /* of structures whose arrays are laid out as arrays of their fields */
+} type;
+
+#define none_type ((type_id)0)
+
+type *get_type(type_id id);
+
+type_id intern_type(const type *type);
+
+/* writes the representation of a type, and returns the string */
+const utf8 *represent_type(utf8 *string, uint string_size, type_id id);
+
+/* assigns a type to every expression and declaration, and checks that they
+   agree */
+void check_types(program *program);
+
+/*****************************************************************************/
+
+typedef struct
+{
+  bit          is_reordering_fields : 1; /* to minimize the padding of structures */
+  const utf8 **struct_of_arrays;         /* the names of structures whose arrays are laid out as arrays of their fields */
+  uint         struct_of_arrays_count;
+} layout_options;
+
+#define no_offset ((uint)-1)
+
+/* assigns the size and alignment of every type, and the offsets of the
+   fields of structures; constant fields aren't stored */
+void lay_out_types(program *program, const layout_options *options);
+
+/* writes the offsets of the arrays of each field of `count` structures, and
+   returns their size */
+uint lay_out_arrays(type_id id, uint count, uint *offsets);
+
+/* prints the layout of every structure */
+void print_layouts(void);
+
+/*****************************************************************************/
+
+/* replaces the constant subtrees of checked expressions with literals, in
+   place. each declaration is folded once, upon its first use. */
+void fold_constants(program *program);
+
+/*****************************************************************************/
+
+typedef enum
+{
+#define XPASTE(identifier) operation_##identifier,
+  #include "proglosa_operations.inc"
+#undef XPASTE
+  operations_count,
+} operation;
+
+extern const utf8 *operation_representations[];
+
+/* an operation of up to three registers, or an immediate word following
+   one */
+typedef union
+{
+  struct
+  {
+    uint8 operation;
+    uint8 a;
+    uint8 b;
+    uint8 c;
+  };
+  uint32 immediate;
+} instruction;
+
+#define maximum_registers_count ((uint)256)
+
+/* registers hold integers extended to 64 bits, and floats as `float64`s
+   rounded to their type */
+typedef union
+{
+  uint64  unsigned_integer;
+  sint64  signed_integer;
+  float64 decimal;
+} value;
+
+typedef struct
+{
+  declaration_node *declaration;     /* that names the procedure, if any */
+  expression       *procedure;
+  type_id           type;
+  instruction      *code;
+  uint              code_size;       /* in instructions */
+  uint              registers_count; /* that the procedure uses from its first */
+  uint              arguments_count;
+  uint              results_count;
+} bytecode_procedure;
+
+typedef struct
+{
+  bytecode_procedure *procedures; /* the first initializes the globals */
+  uint                procedures_count;
+  uint                globals_count;
+  value              *globals;
+  type_id            *global_types; /* so the globals of an object are stored as they're declared */
+} bytecode;
+
+/* compiles the global procedures, and those they invoke; a failure is
+   reported for every construct that can't be compiled yet */
+void compile_bytecode(program *program, bytecode *bytecode);
+
+/* returns the procedure declared with the name, or -1 */
+sintl find_bytecode_procedure(const utf8 *name, bytecode *bytecode);
+
+/* runs a procedure until it returns, and returns whether it did */
+bit run_bytecode(uint procedure_index, const value *arguments, value *results, bytecode *bytecode);
+
+/*****************************************************************************/
+
+typedef enum
+{
+  ir_kind_constant,
+  ir_kind_argument,   /* the `index`th */
+  ir_kind_phi,        /* of an operand per predecessor of its block, in their order */
+  ir_kind_operation,  /* `operation` of one or two operands, to `bits` if truncating */
+  ir_kind_get_global, /* of `declaration` */
+  ir_kind_set_global, /* of `declaration`, to the operand */
+  ir_kind_call,       /* of the `index`th procedure with the operands, valued by its result if it's the only one */
+} ir_kind;
+
+/* the intermediate representation is in static single assignment form:
+   every value is defined once, by a basic block, and refers to the values
+   it uses by their indices. the first value and block of a procedure are
+   null. */
+typedef struct
+{
+  uint8             kind;
+  uint8             operation;
+  uint8             bits;
+  bit               is_dead : 1;
+  type_id           type;
+  uint              block;
+  uint              next;           /* in the block */
+  uint              index;
+  declaration_node *declaration;
+  uint              operands;       /* the offset in `ir_procedure.operands` */
+  uint              operands_count;
+  value             constant;
+  uint              replacement;    /* of a value replaced by the passes */
+} ir_value;
+
+typedef enum
+{
+  ir_ending_jump,   /* to the first successor */
+  ir_ending_branch, /* to the first successor, or to the second if `condition` is 0 */
+  ir_ending_return, /* the results */
+} ir_ending;
+
+typedef struct
+{
+  uint  first_value;
+  uint  last_value;
+  uint  next;               /* in the layout, where blocks follow their predecessors */
+  uint8 ending;
+  bit   is_dead : 1;        /* if unreachable */
+  uint  condition;
+  uint  successors[2];
+  uint  predecessors;       /* the offset in `ir_procedure.operands` */
+  uint  predecessors_count;
+  uint  results;            /* the offset in `ir_procedure.operands` */
+  uint  results_count;
+  uint  dominator;          /* the immediate one, found by the passes */
+} ir_block;
+
+#define ir_entry_block ((uint)1)
+
+typedef struct
+{
+  declaration_node *declaration; /* that names the procedure, if any */
+  type_id           type;
+  uint              arguments_count;
+  uint              results_count;
+
+  ir_value *values;
+  uint      values_count;
+  uint      values_capacity;
+  ir_block *blocks;
+  uint      blocks_count;
+  uint      blocks_capacity;
+  uint     *operands;            /* of the values and blocks */
+  uint      operands_count;
+  uint      operands_capacity;
+} ir_procedure;
+
+typedef struct
+{
+  ir_procedure *procedures; /* the first initializes the globals */
+  uint          procedures_count;
+  uint          procedures_capacity;
+} ir;
+
+/* lowers the global procedures, and those they invoke, to the intermediate
+   representation; a failure is reported for every construct that can't be
+   lowered yet */
+void compile_ir(program *program, ir *ir);
+
+/* inlines small procedures, propagates constants, and eliminates common
+   subexpressions and dead code */
+void optimize_ir(ir *ir);
+
+void print_ir(ir *ir);
+
+void release_ir(ir *ir);
+
+/*****************************************************************************/
+
+/* a C translation unit */
+typedef struct
+{
+  utf8 *text;
+  uint  size;
+  uint  capacity;
+} c_unit;
+
+/* translates the program to a single C translation unit of its globals and
+   the procedures they refer to, which defines `main` if the program does; a
+   failure is reported for every construct that can't be translated yet */
+void translate_to_c(program *program, c_unit *unit);
+
+void print_c(c_unit *unit);
+
+void release_c(c_unit *unit);
+
+/*****************************************************************************/
+
+/* machine code of the procedures whose arguments and result are scalars,
+   which are called with the platform's convention */
+typedef struct
+{
+  bytecode *bytecode;
+  byte     *code;     /* executable */
+  uint      code_size;
+  uint     *entries;  /* of each procedure, or `no_jit_entry` */
+  uint     *thunks;   /* of each procedure, called as `void (const value *arguments, value *results)` */
+} jit;
+
+#define no_jit_entry ((uint)-1)
+
+/* compiles the procedures that can be, and returns how many were */
+uint compile_jit(bytecode *bytecode, jit *jit);
+
+void release_jit(jit *jit);
+
+/* returns the machine code of the procedure declared with the name, or 0 */
+void *find_jitted_procedure(const utf8 *name, jit *jit);
+
+/* runs compiled machine code like `run_bytecode` */
+bit run_jitted(uint procedure_index, const value *arguments, value *results, jit *jit);
+
+/*****************************************************************************/
+
+/* writes an ELF relocatable object of the procedures that can be compiled to
+   machine code, with a symbol of each, and of the globals, which are
+   initialized beforehand */
+bit write_object(program *program, bytecode *bytecode, const utf8 *path);
+
+/*****************************************************************************/
+
+/* serves requests upon a local socket until one stops it, keeping the checked
+   programs and the reports of their checks, which are redone only once their
+   sources change; returns the exit status */
+int serve(const utf8 *socket_path, const layout_options *layout_options, bit is_compacting_nodes, bit is_pooling_nodes);
+
+/* sends a request, like `check path`, to the server upon the socket, and
+   writes its response; returns the exit status */
+int ask(const utf8 *socket_path, char *words[], uint words_count);
+
+/* speaks the language server protocol upon the standard input and output,
+   until it's told to exit */
+int serve_language(void);
+
+/*****************************************************************************/
+
+/* parses and resolves generated programs of growing sizes, each in its own
+   process, and fails if their time grows faster than their sizes or their
+   peak memory outgrows a multiple of them; returns the exit status */
+int stress(char *words[], uint words_count);
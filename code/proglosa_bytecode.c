@@ -0,0 +1,938 @@
+#include "proglosa.h"
+
+/*****************************************************************************/
+
+#define no_register ((uint)-1)
+
+const utf8 *operation_representations[] =
+{
+#define XPASTE(identifier) [operation_##identifier] = #identifier,
+  #include "proglosa_operations.inc"
+#undef XPASTE
+};
+
+typedef struct
+{
+  program  *program;
+  bytecode *bytecode;
+
+  /* reused by every procedure, whose code is copied once compiled */
+  instruction *code;
+  uint         code_size;
+  uint         code_capacity;
+
+  uint procedures_capacity;
+
+  /* of the compiled procedure */
+  uint                procedure_index;
+  declaration_node  **locals;
+  uint                locals_count;
+  uint                locals_capacity;
+  uint                registers_count;
+  uint                first_result;
+} compiler;
+
+static uint emit(compiler *compiler, operation operation, uint a, uint b, uint c)
+{
+  if (compiler->code_size == compiler->code_capacity)
+  {
+    uint capacity = compiler->code_capacity ? compiler->code_capacity * 2 : 1024;
+    compiler->code = reallocate(capacity * sizeof(instruction), compiler->code, compiler->code_capacity * sizeof(instruction));
+    compiler->code_capacity = capacity;
+  }
+  uint position = compiler->code_size++;
+  compiler->code[position] = (instruction){ .operation = operation, .a = (uint8)a, .b = (uint8)b, .c = (uint8)c };
+  return position;
+}
+
+static uint emit_immediate(compiler *compiler, uint32 immediate)
+{
+  uint position = emit(compiler, 0, 0, 0, 0);
+  compiler->code[position].immediate = immediate;
+  return position;
+}
+
+static void emit_load(compiler *compiler, uint a, value value)
+{
+  emit(compiler, operation_load, a, 0, 0);
+  emit_immediate(compiler, (uint32)value.unsigned_integer);
+  emit_immediate(compiler, (uint32)(value.unsigned_integer >> 32));
+}
+
+/* returns the position of the offset, to be patched */
+static uint emit_jump(compiler *compiler, operation operation, uint a)
+{
+  emit(compiler, operation, a, 0, 0);
+  return emit_immediate(compiler, 0);
+}
+
+static void patch_jump(compiler *compiler, uint offset_position)
+{
+  compiler->code[offset_position].immediate = (uint32)(compiler->code_size - (offset_position + 1));
+}
+
+static void report_unsupported(expression *expression, compiler *compiler)
+{
+  report_expression_failure(compiler->program, expression, "Running %s isn't supported.", node_tag_representations[expression->tag]);
+}
+
+/* procedures move as more are referred to */
+static bytecode_procedure *get_compiled_procedure(compiler *compiler)
+{
+  return &compiler->bytecode->procedures[compiler->procedure_index];
+}
+
+static uint allocate_register(expression *expression, compiler *compiler)
+{
+  if (compiler->registers_count == maximum_registers_count)
+  {
+    report_expression_failure(compiler->program, expression, "The procedure needs too many registers.");
+    return 0;
+  }
+  uint result = compiler->registers_count++;
+  bytecode_procedure *procedure = get_compiled_procedure(compiler);
+  if (compiler->registers_count > procedure->registers_count) procedure->registers_count = compiler->registers_count;
+  return result;
+}
+
+static void declare_local(declaration_node *declaration, uint register_index, compiler *compiler)
+{
+  if (compiler->locals_count == compiler->locals_capacity)
+  {
+    uint capacity = compiler->locals_capacity ? compiler->locals_capacity * 2 : 64;
+    compiler->locals = reallocate(capacity * sizeof(declaration_node *), compiler->locals, compiler->locals_capacity * sizeof(declaration_node *));
+    compiler->locals_capacity = capacity;
+  }
+  compiler->locals[compiler->locals_count++] = declaration;
+  declaration->slot = register_index;
+}
+
+static bit is_local(declaration_node *declaration, compiler *compiler)
+{
+  for (uint i = compiler->locals_count; i--;)
+    if (compiler->locals[i] == declaration) return 1;
+  return 0;
+}
+
+/* generic procedures are compiled through their instances alone */
+static bit is_procedure_declaration(declaration_node *declaration)
+{
+  return declaration->is_constant && declaration->assignment && declaration->assignment->tag == node_tag_procedure && !is_generic_declaration(declaration);
+}
+
+static bit is_type_declaration(declaration_node *declaration)
+{
+  return declaration->denoted_type != none_type || declaration->type == types.type_type;
+}
+
+/* declarations without a value at runtime, which are skipped */
+static bit is_compile_time_declaration(declaration_node *declaration)
+{
+  return is_type_declaration(declaration) || is_generic_declaration(declaration);
+}
+
+/* procedures are compiled in the order they're first referred to */
+static uint get_procedure(declaration_node *declaration, compiler *compiler)
+{
+  if (declaration->slot) return declaration->slot - 1;
+
+  bytecode *bytecode = compiler->bytecode;
+  if (bytecode->procedures_count == compiler->procedures_capacity)
+  {
+    uint capacity = compiler->procedures_capacity * 2;
+    bytecode->procedures = reallocate(capacity * sizeof(bytecode_procedure), bytecode->procedures, compiler->procedures_capacity * sizeof(bytecode_procedure));
+    compiler->procedures_capacity = capacity;
+  }
+
+  uint index = bytecode->procedures_count++;
+  type *type = get_type(declaration->type);
+  bytecode->procedures[index] = (bytecode_procedure)
+  {
+    .declaration     = declaration,
+    .procedure       = declaration->assignment,
+    .type            = declaration->type,
+    .arguments_count = type->arguments_count,
+    .results_count   = type->components_count - type->arguments_count,
+  };
+  declaration->slot = index + 1;
+  return index;
+}
+
+/*****************************************************************************/
+
+typedef enum
+{
+  operand_class_signed,
+  operand_class_unsigned,
+  operand_class_float32,
+  operand_class_float64,
+  operand_class_unsupported,
+} operand_class;
+
+static operand_class classify_operand(type_id id)
+{
+  type *type = get_type(id);
+  switch (type->kind)
+  {
+  case type_kind_integer:  return operand_class_signed;
+  case type_kind_decimal:  return operand_class_float64;
+  case type_kind_signed:   return operand_class_signed;
+  case type_kind_unsigned:
+  case type_kind_bit:      return operand_class_unsigned;
+  case type_kind_float:    return type->size == sizeof(float32) ? operand_class_float32 : operand_class_float64;
+  default:                 return operand_class_unsupported;
+  }
+}
+
+static bit is_float_class(operand_class class)
+{
+  return class == operand_class_float32 || class == operand_class_float64;
+}
+
+/* keeps a register's value in the domain of its type */
+static void emit_normalization(uint a, type_id id, compiler *compiler)
+{
+  type *type = get_type(id);
+  switch (type->kind)
+  {
+  case type_kind_signed:
+    if (type->size < sizeof(uint64)) emit(compiler, operation_truncate_signed, a, a, type->size * 8);
+    break;
+  case type_kind_unsigned:
+    if (type->size < sizeof(uint64)) emit(compiler, operation_truncate_unsigned, a, a, type->size * 8);
+    break;
+  case type_kind_bit:
+    emit(compiler, operation_test, a, a, 0);
+    break;
+  case type_kind_float:
+    if (type->size == sizeof(float32)) emit(compiler, operation_round_float32, a, a, 0);
+    break;
+  default:
+    break;
+  }
+}
+
+static void emit_conversion(uint a, uint b, type_id from, type_id to, compiler *compiler)
+{
+  operand_class from_class = classify_operand(from), to_class = classify_operand(to);
+  if (is_float_class(from_class) && !is_float_class(to_class))
+  {
+    if (get_type(to)->kind == type_kind_bit) emit(compiler, operation_test_float, a, b, 0);
+    else emit(compiler, to_class == operand_class_signed ? operation_convert_float_to_signed : operation_convert_float_to_unsigned, a, b, 0);
+  }
+  else if (!is_float_class(from_class) && is_float_class(to_class))
+    emit(compiler, from_class == operand_class_signed ? operation_convert_signed_to_float : operation_convert_unsigned_to_float, a, b, 0);
+  else if (a != b) emit(compiler, operation_move, a, b, 0);
+  emit_normalization(a, to, compiler);
+}
+
+static uint compile_expression(expression *expression, compiler *compiler);
+
+/* returns a register of the expression's value converted to the type */
+static uint compile_converted(expression *expression, type_id to, compiler *compiler)
+{
+  if (expression->tag == node_tag_digital || expression->tag == node_tag_decimal)
+  {
+    value value;
+    if (is_float_class(classify_operand(to)))
+    {
+      value.decimal = get_literal_decimal(expression);
+      if (classify_operand(to) == operand_class_float32) value.decimal = (float32)value.decimal;
+    }
+    else value.unsigned_integer = normalize_integer(get_literal_integer(expression), to);
+    uint result = allocate_register(expression, compiler);
+    emit_load(compiler, result, value);
+    return result;
+  }
+
+  uint result = compile_expression(expression, compiler);
+  if (result == no_register || expression->type == to || to == none_type) return result;
+  if (classify_operand(expression->type) == operand_class_unsupported || classify_operand(to) == operand_class_unsupported)
+  {
+    report_unsupported(expression, compiler);
+    return result;
+  }
+  uint converted = allocate_register(expression, compiler);
+  emit_conversion(converted, result, expression->type, to, compiler);
+  return converted;
+}
+
+/* returns a register of 0 or 1 */
+static uint compile_truth(expression *expression, compiler *compiler)
+{
+  uint result = compile_expression(expression, compiler);
+  if (result == no_register) return allocate_register(expression, compiler);
+  if (get_type(expression->type)->kind == type_kind_bit) return result;
+  uint truth = allocate_register(expression, compiler);
+  emit(compiler, is_float_class(classify_operand(expression->type)) ? operation_test_float : operation_test, truth, result, 0);
+  return truth;
+}
+
+static operation get_arithmetic_operation(node_tag tag, operand_class class)
+{
+  bit is_float = is_float_class(class), is_signed = class == operand_class_signed;
+  switch (tag)
+  {
+  case node_tag_addition:                      return is_float ? operation_add_float      : operation_add;
+  case node_tag_subtraction:                   return is_float ? operation_subtract_float : operation_subtract;
+  case node_tag_multiplication:                return is_float ? operation_multiply_float : operation_multiply;
+  case node_tag_division:                      return is_float ? operation_divide_float   : is_signed ? operation_divide_signed : operation_divide_unsigned;
+  case node_tag_modulo:                        return is_signed ? operation_modulo_signed : operation_modulo_unsigned;
+  case node_tag_bitwise_conjunction:           return operation_and;
+  case node_tag_bitwise_disjunction:           return operation_or;
+  case node_tag_bitwise_exclusive_disjunction: return operation_exclusive_or;
+  case node_tag_bitwise_left_shift:            return operation_left_shift;
+  case node_tag_bitwise_right_shift:           return is_signed ? operation_right_shift_signed : operation_right_shift_unsigned;
+  default: UNREACHABLE();
+  }
+}
+
+static uint compile_arithmetic(node_tag tag, type_id type, expression *left, expression *right, expression *expression, compiler *compiler)
+{
+  operand_class class = classify_operand(type);
+  if (class == operand_class_unsupported)
+  {
+    report_unsupported(expression, compiler);
+    return allocate_register(expression, compiler);
+  }
+
+  /* the operands' temporaries are reused for the result */
+  uint top = compiler->registers_count;
+  bit is_shift = tag == node_tag_bitwise_left_shift || tag == node_tag_bitwise_right_shift;
+  uint b = compile_converted(left, type, compiler);
+  uint c = compile_converted(right, is_shift ? right->type : type, compiler);
+  compiler->registers_count = top;
+  uint a = allocate_register(expression, compiler);
+  emit(compiler, get_arithmetic_operation(tag, class), a, b, c);
+  emit_normalization(a, type, compiler);
+  return a;
+}
+
+static uint compile_comparison(expression *expression, compiler *compiler)
+{
+  struct expression *left = expression->data->binary.left, *right = expression->data->binary.right;
+  type_id type = get_type(left->type)->kind == type_kind_integer || get_type(left->type)->kind == type_kind_decimal ? right->type : left->type;
+  operand_class class = classify_operand(type);
+  if (class == operand_class_unsupported)
+  {
+    report_unsupported(expression, compiler);
+    return allocate_register(expression, compiler);
+  }
+
+  uint top = compiler->registers_count;
+  uint b = compile_converted(left, type, compiler);
+  uint c = compile_converted(right, type, compiler);
+  compiler->registers_count = top;
+  uint a = allocate_register(expression, compiler);
+
+  /* greater comparisons are lesser ones of swapped operands */
+  bit is_float = is_float_class(class), is_signed = class == operand_class_signed;
+  operation operation;
+  switch (expression->tag)
+  {
+  case node_tag_equality:   operation = is_float ? operation_equal_float   : operation_equal;   break;
+  case node_tag_inequality: operation = is_float ? operation_unequal_float : operation_unequal; break;
+  case node_tag_greater:
+    { uint swapped = b; b = c; c = swapped; }
+    /* fallthrough */
+  case node_tag_lesser:
+    operation = is_float ? operation_lesser_float : is_signed ? operation_lesser_signed : operation_lesser_unsigned;
+    break;
+  case node_tag_inclusive_greater:
+    { uint swapped = b; b = c; c = swapped; }
+    /* fallthrough */
+  case node_tag_inclusive_lesser:
+    operation = is_float ? operation_inclusive_lesser_float : is_signed ? operation_inclusive_lesser_signed : operation_inclusive_lesser_unsigned;
+    break;
+  default: UNREACHABLE();
+  }
+  emit(compiler, operation, a, b, c);
+  return a;
+}
+
+/* `a && b` and `a || b` evaluate `b` only if needed */
+static uint compile_logical(expression *expression, compiler *compiler)
+{
+  uint result = allocate_register(expression, compiler);
+  uint top = compiler->registers_count;
+  uint left = compile_truth(expression->data->binary.left, compiler);
+  emit(compiler, expression->tag == node_tag_conjunction ? operation_move : operation_logical_not, result, left, 0);
+  uint skip = emit_jump(compiler, operation_jump_if_zero, result);
+  compiler->registers_count = top;
+  uint right = compile_truth(expression->data->binary.right, compiler);
+  emit(compiler, operation_move, result, right, 0);
+  uint end = emit_jump(compiler, operation_jump, 0);
+  patch_jump(compiler, skip);
+  if (expression->tag == node_tag_disjunction) emit(compiler, operation_logical_not, result, result, 0);
+  patch_jump(compiler, end);
+  compiler->registers_count = top;
+  return result;
+}
+
+static uint compile_condition(expression *expression, compiler *compiler)
+{
+  bit has_value = expression->type != none_type;
+  uint result = has_value ? allocate_register(expression, compiler) : no_register;
+  uint top = compiler->registers_count;
+
+  uint condition = compile_truth(expression->data->condition.left, compiler);
+  uint alternative = emit_jump(compiler, operation_jump_if_zero, condition);
+  compiler->registers_count = top;
+
+  uint consequent = has_value
+                  ? compile_converted(expression->data->condition.right, expression->type, compiler)
+                  : compile_expression(expression->data->condition.right, compiler);
+  if (has_value) emit(compiler, operation_move, result, consequent, 0);
+  compiler->registers_count = top;
+
+  if (!expression->data->condition.other)
+  {
+    patch_jump(compiler, alternative);
+    return result;
+  }
+
+  uint end = emit_jump(compiler, operation_jump, 0);
+  patch_jump(compiler, alternative);
+  uint other = has_value
+             ? compile_converted(expression->data->condition.other, expression->type, compiler)
+             : compile_expression(expression->data->condition.other, compiler);
+  if (has_value) emit(compiler, operation_move, result, other, 0);
+  compiler->registers_count = top;
+  patch_jump(compiler, end);
+  return result;
+}
+
+static void compile_return(expression *expression, struct expression *results, compiler *compiler)
+{
+  bytecode_procedure *procedure = get_compiled_procedure(compiler);
+  struct expression *items[maximum_parameters_count];
+  uint items_count = 0;
+  flatten_list(items, &items_count, maximum_parameters_count, results);
+
+  /* a bare `return` returns the named results */
+  if (!items_count)
+  {
+    emit(compiler, operation_return, compiler->first_result, procedure->results_count, 0);
+    return;
+  }
+
+  uint top = compiler->registers_count;
+  uint first = compiler->registers_count;
+  for (uint i = 0; i < items_count; ++i) allocate_register(expression, compiler);
+  for (uint i = 0; i < items_count; ++i)
+  {
+    uint inner_top = compiler->registers_count;
+    type_id result_type = get_type(procedure->type)->components[procedure->arguments_count + i];
+    uint item = compile_converted(items[i], result_type, compiler);
+    if (item != first + i) emit(compiler, operation_move, first + i, item, 0);
+    compiler->registers_count = inner_top;
+  }
+  emit(compiler, operation_return, first, items_count, 0);
+  compiler->registers_count = top;
+}
+
+static uint compile_invocation(expression *expression, compiler *compiler)
+{
+  struct expression *callee = expression->data->invocation.left;
+  if (callee->tag == node_tag_identifier && callee->data->identifier.declaration == &builtin_declarations[builtin_return])
+  {
+    compile_return(expression, expression->data->invocation.right, compiler);
+    return no_register;
+  }
+
+  declaration_node *declaration = callee->tag == node_tag_identifier ? callee->data->identifier.declaration : 0;
+  if (!declaration || !is_procedure_declaration(declaration))
+  {
+    report_unsupported(callee, compiler);
+    return no_register;
+  }
+  uint procedure_index = get_procedure(declaration, compiler);
+  type_id procedure_type = declaration->type;
+
+  struct expression *arguments[maximum_parameters_count];
+  uint arguments_count = 0;
+  flatten_list(arguments, &arguments_count, maximum_parameters_count, expression->data->invocation.right);
+
+  /* the arguments are the first registers of the invoked procedure */
+  uint base = compiler->registers_count;
+  for (uint i = 0; i < arguments_count; ++i) allocate_register(expression, compiler);
+  for (uint i = 0; i < arguments_count; ++i)
+  {
+    uint top = compiler->registers_count;
+    uint argument = compile_converted(arguments[i], get_type(procedure_type)->components[i], compiler);
+    if (argument != base + i) emit(compiler, operation_move, base + i, argument, 0);
+    compiler->registers_count = top;
+  }
+  emit(compiler, operation_call, base, arguments_count, 0);
+  emit_immediate(compiler, procedure_index);
+
+  type *type = get_type(procedure_type);
+  if (type->components_count - type->arguments_count != 1)
+  {
+    compiler->registers_count = base;
+    return no_register;
+  }
+  compiler->registers_count = base;
+  return allocate_register(expression, compiler);
+}
+
+static uint compile_assignment(expression *expression, compiler *compiler)
+{
+  struct expression *left = expression->data->binary.left, *right = expression->data->binary.right;
+  if (left->tag != node_tag_identifier)
+  {
+    report_unsupported(left, compiler);
+    return no_register;
+  }
+  declaration_node *declaration = left->data->identifier.declaration;
+  bit is_global = !is_local(declaration, compiler);
+  type_id type = left->type;
+
+  uint assigned;
+  node_tag operation = get_assigned_operation(expression->tag);
+  if (operation == node_tag_assignment) assigned = compile_converted(right, type, compiler);
+  else assigned = compile_arithmetic(operation, type, left, right, expression, compiler);
+  if (assigned == no_register) return no_register;
+
+  if (is_global)
+  {
+    emit(compiler, operation_set_global, assigned, 0, 0);
+    emit_immediate(compiler, declaration->slot - 1);
+    return assigned;
+  }
+  if (assigned != declaration->slot) emit(compiler, operation_move, declaration->slot, assigned, 0);
+  return declaration->slot;
+}
+
+uint compile_expression(expression *expression, compiler *compiler)
+{
+  switch (expression->tag)
+  {
+  case node_tag_digital:
+  case node_tag_decimal:
+    return compile_converted(expression, expression->type, compiler);
+
+  case node_tag_identifier:
+    {
+      declaration_node *declaration = expression->data->identifier.declaration;
+      if (declaration == &builtin_declarations[builtin_return])
+      {
+        compile_return(expression, 0, compiler);
+        return no_register;
+      }
+      if (is_local(declaration, compiler)) return declaration->slot;
+      if (!declaration->slot || is_procedure_declaration(declaration) || get_builtin(declaration) >= 0)
+      {
+        report_unsupported(expression, compiler);
+        return no_register;
+      }
+      uint result = allocate_register(expression, compiler);
+      emit(compiler, operation_get_global, result, 0, 0);
+      emit_immediate(compiler, declaration->slot - 1);
+      return result;
+    }
+
+  case node_tag_positive:
+    return compile_expression(expression->data->unary.expression, compiler);
+  case node_tag_negative:
+  case node_tag_bitwise_negation:
+    {
+      operand_class class = classify_operand(expression->type);
+      if (class == operand_class_unsupported) break;
+      uint top = compiler->registers_count;
+      uint b = compile_converted(expression->data->unary.expression, expression->type, compiler);
+      compiler->registers_count = top;
+      uint a = allocate_register(expression, compiler);
+      operation operation = expression->tag == node_tag_bitwise_negation ? operation_not
+                          : is_float_class(class) ? operation_negate_float : operation_negate;
+      emit(compiler, operation, a, b, 0);
+      emit_normalization(a, expression->type, compiler);
+      return a;
+    }
+  case node_tag_negation:
+    {
+      uint top = compiler->registers_count;
+      uint b = compile_truth(expression->data->unary.expression, compiler);
+      compiler->registers_count = top;
+      uint a = allocate_register(expression, compiler);
+      emit(compiler, operation_logical_not, a, b, 0);
+      return a;
+    }
+
+  case node_tag_addition:
+  case node_tag_subtraction:
+  case node_tag_multiplication:
+  case node_tag_division:
+  case node_tag_modulo:
+  case node_tag_bitwise_conjunction:
+  case node_tag_bitwise_disjunction:
+  case node_tag_bitwise_exclusive_disjunction:
+  case node_tag_bitwise_left_shift:
+  case node_tag_bitwise_right_shift:
+    return compile_arithmetic(expression->tag, expression->type, expression->data->binary.left, expression->data->binary.right, expression, compiler);
+
+  case node_tag_equality:
+  case node_tag_inequality:
+  case node_tag_greater:
+  case node_tag_lesser:
+  case node_tag_inclusive_greater:
+  case node_tag_inclusive_lesser:
+    return compile_comparison(expression, compiler);
+
+  case node_tag_conjunction:
+  case node_tag_disjunction:
+    return compile_logical(expression, compiler);
+
+  case node_tag_assignment:
+  case node_tag_addition_assignment:
+  case node_tag_subtraction_assignment:
+  case node_tag_multiplication_assignment:
+  case node_tag_division_assignment:
+  case node_tag_modulo_assignment:
+  case node_tag_bitwise_conjunction_assignment:
+  case node_tag_bitwise_disjunction_assignment:
+  case node_tag_bitwise_exclusive_disjunction_assignment:
+  case node_tag_bitwise_left_shift_assignment:
+  case node_tag_bitwise_right_shift_assignment:
+    return compile_assignment(expression, compiler);
+
+  case node_tag_cast:
+    return compile_converted(expression->data->cast.left, expression->type, compiler);
+  case node_tag_invocation:
+    return compile_invocation(expression, compiler);
+  case node_tag_condition:
+  case node_tag_ternary:
+    return compile_condition(expression, compiler);
+
+  default:
+    break;
+  }
+  report_unsupported(expression, compiler);
+  return no_register;
+}
+
+static void compile_local_declaration(declaration_node *declaration, compiler *compiler)
+{
+  if (is_compile_time_declaration(declaration)) return;
+  if (is_procedure_declaration(declaration))
+  {
+    get_procedure(declaration, compiler);
+    return;
+  }
+
+  expression *expression = get_declaration_expression(declaration);
+  uint local = allocate_register(expression, compiler);
+  if (declaration->assignment)
+  {
+    uint assigned = compile_converted(declaration->assignment, declaration->type, compiler);
+    if (assigned != no_register && assigned != local) emit(compiler, operation_move, local, assigned, 0);
+  }
+  else emit_load(compiler, local, (value){0});
+  compiler->registers_count = local + 1;
+  declare_local(declaration, local, compiler);
+}
+
+static void compile_statement(expression *expression, compiler *compiler)
+{
+  if (expression->tag == node_tag_declaration)
+  {
+    compile_local_declaration(&expression->data->declaration, compiler);
+    return;
+  }
+  uint top = compiler->registers_count;
+  compile_expression(expression, compiler);
+  compiler->registers_count = top;
+}
+
+static void finish_procedure(compiler *compiler)
+{
+  bytecode_procedure *procedure = get_compiled_procedure(compiler);
+  procedure->code_size = compiler->code_size;
+  procedure->code = push_type(instruction, compiler->code_size, context.allocator);
+  copy_typed(instruction, procedure->code, compiler->code, compiler->code_size);
+}
+
+static void compile_procedure(uint procedure_index, compiler *compiler)
+{
+  procedure_node *node = &compiler->bytecode->procedures[procedure_index].procedure->data->procedure;
+  compiler->procedure_index = procedure_index;
+  compiler->code_size = 0;
+  compiler->locals_count = 0;
+  compiler->registers_count = 0;
+
+  /* the arguments, then the results, are the first registers */
+  uint parameter_index = 0;
+  for (statement *parameter = node->structure.declarations; parameter; parameter = parameter->next, ++parameter_index)
+  {
+    declaration_node *declaration = &parameter->expression.data->declaration;
+    uint parameter_register = allocate_register(&parameter->expression, compiler);
+    declare_local(declaration, parameter_register, compiler);
+    if (parameter_index >= node->arguments_count) emit_load(compiler, parameter_register, (value){0});
+  }
+  compiler->first_result = node->arguments_count;
+
+  for (statement *statement = node->statements; statement; statement = statement->next)
+    compile_statement(&statement->expression, compiler);
+  emit(compiler, operation_return, compiler->first_result, get_compiled_procedure(compiler)->results_count, 0);
+  finish_procedure(compiler);
+}
+
+void compile_bytecode(program *program, bytecode *bytecode)
+{
+  zero(bytecode, sizeof(*bytecode));
+  compiler compiler =
+  {
+    .program  = program,
+    .bytecode = bytecode,
+    .procedures_capacity = 16,
+  };
+  bytecode->procedures = allocate(compiler.procedures_capacity * sizeof(bytecode_procedure));
+  bytecode->procedures_count = 1;
+  zero(&bytecode->procedures[0], sizeof(bytecode_procedure));
+
+  /* every global procedure is compiled, and every other value is a global */
+  for (statement *global = program->global_scope.declarations; global; global = global->next)
+  {
+    declaration_node *declaration = &global->expression.data->declaration;
+    if (is_compile_time_declaration(declaration)) continue;
+    if (is_procedure_declaration(declaration)) get_procedure(declaration, &compiler);
+    else declaration->slot = ++bytecode->globals_count;
+  }
+  bytecode->globals = push_type(value, bytecode->globals_count, context.allocator);
+  zero(bytecode->globals, bytecode->globals_count * sizeof(value));
+  bytecode->global_types = push_type(type_id, bytecode->globals_count, context.allocator);
+  for (statement *global = program->global_scope.declarations; global; global = global->next)
+  {
+    declaration_node *declaration = &global->expression.data->declaration;
+    if (declaration->slot && !is_compile_time_declaration(declaration) && !is_procedure_declaration(declaration))
+      bytecode->global_types[declaration->slot - 1] = declaration->type;
+  }
+
+  /* the globals are initialized in the order they're declared */
+  compiler.procedure_index = 0;
+  for (statement *global = program->global_scope.declarations; global; global = global->next)
+  {
+    declaration_node *declaration = &global->expression.data->declaration;
+    if (is_compile_time_declaration(declaration) || is_procedure_declaration(declaration) || !declaration->assignment) continue;
+    compiler.registers_count = 0;
+    uint assigned = compile_converted(declaration->assignment, declaration->type, &compiler);
+    if (assigned == no_register) continue;
+    emit(&compiler, operation_set_global, assigned, 0, 0);
+    emit_immediate(&compiler, declaration->slot - 1);
+  }
+  emit(&compiler, operation_return, 0, 0, 0);
+  finish_procedure(&compiler);
+
+  /* the invoked procedures are appended as they're compiled */
+  for (uint i = 1; i < bytecode->procedures_count; ++i) compile_procedure(i, &compiler);
+
+  if (compiler.code) deallocate(compiler.code, compiler.code_capacity * sizeof(instruction));
+  if (compiler.locals) deallocate(compiler.locals, compiler.locals_capacity * sizeof(declaration_node *));
+}
+
+sintl find_bytecode_procedure(const utf8 *name, bytecode *bytecode)
+{
+  uint name_size = get_string_size(name);
+  for (uint i = 1; i < bytecode->procedures_count; ++i)
+  {
+    identifier_node *identifier = &bytecode->procedures[i].declaration->identifier;
+    if (identifier->runes_count == name_size && !compare_sized_string(identifier->runes, name, name_size)) return i;
+  }
+  return -1;
+}
+
+/*****************************************************************************/
+
+#define bytecode_stack_size  ((uint)1 << 20) /* in values */
+#define bytecode_frames_size ((uint)1 << 16)
+
+typedef struct
+{
+  const instruction *resumption;
+  value             *registers;
+} bytecode_frame;
+
+static sint64 convert_float_to_signed(float64 value)
+{
+  if (value != value) return 0;
+  if (value <= -9223372036854775808.0) return INT64_MIN;
+  if (value >=  9223372036854775808.0) return INT64_MAX;
+  return (sint64)value;
+}
+
+static uint64 convert_float_to_unsigned(float64 value)
+{
+  if (value != value || value <= 0) return 0;
+  if (value >= 18446744073709551616.0) return UINT64_MAX;
+  return (uint64)value;
+}
+
+bit run_bytecode(uint procedure_index, const value *arguments, value *results, bytecode *bytecode)
+{
+  bytecode_procedure *procedures = bytecode->procedures;
+  value *globals = bytecode->globals;
+
+  value          *stack  = allocate(bytecode_stack_size * sizeof(value));
+  bytecode_frame *frames = allocate(bytecode_frames_size * sizeof(bytecode_frame));
+  uint frames_count = 0;
+  bit  succeeded = 1;
+
+  value *registers = stack;
+  copy_typed(value, registers, arguments, procedures[procedure_index].arguments_count);
+  const instruction *ip = procedures[procedure_index].code;
+  instruction current;
+
+#define A registers[current.a]
+#define B registers[current.b]
+#define C registers[current.c]
+
+  /* each operation dispatches the next itself, which predicts better than
+     a shared `switch` */
+#if defined(__GNUC__)
+  static const void *const dispatch_table[operations_count] =
+  {
+  #define XPASTE(identifier) [operation_##identifier] = &&on_##identifier,
+    #include "proglosa_operations.inc"
+  #undef XPASTE
+  };
+  #define CASE(identifier) on_##identifier:
+  #define DISPATCH() do { current = *ip++; goto *dispatch_table[current.operation]; } while (0)
+  DISPATCH();
+#else
+  #define CASE(identifier) case operation_##identifier:
+  #define DISPATCH() continue
+  for (;;)
+  {
+    current = *ip++;
+    switch (current.operation)
+    {
+#endif
+
+  CASE(move) A = B; DISPATCH();
+  CASE(load)
+    A.unsigned_integer = (uint64)ip[0].immediate | (uint64)ip[1].immediate << 32;
+    ip += 2;
+    DISPATCH();
+  CASE(get_global) A = globals[(ip++)->immediate]; DISPATCH();
+  CASE(set_global) globals[(ip++)->immediate] = A; DISPATCH();
+
+  CASE(add)          A.unsigned_integer = B.unsigned_integer + C.unsigned_integer; DISPATCH();
+  CASE(subtract)     A.unsigned_integer = B.unsigned_integer - C.unsigned_integer; DISPATCH();
+  CASE(multiply)     A.unsigned_integer = B.unsigned_integer * C.unsigned_integer; DISPATCH();
+  CASE(divide_signed)
+    if (!C.signed_integer) goto divided_by_zero;
+    A.signed_integer = C.signed_integer == -1 ? (sint64)(0 - B.unsigned_integer) : B.signed_integer / C.signed_integer;
+    DISPATCH();
+  CASE(divide_unsigned)
+    if (!C.unsigned_integer) goto divided_by_zero;
+    A.unsigned_integer = B.unsigned_integer / C.unsigned_integer;
+    DISPATCH();
+  CASE(modulo_signed)
+    if (!C.signed_integer) goto divided_by_zero;
+    A.signed_integer = C.signed_integer == -1 ? 0 : B.signed_integer % C.signed_integer;
+    DISPATCH();
+  CASE(modulo_unsigned)
+    if (!C.unsigned_integer) goto divided_by_zero;
+    A.unsigned_integer = B.unsigned_integer % C.unsigned_integer;
+    DISPATCH();
+  CASE(and)          A.unsigned_integer = B.unsigned_integer & C.unsigned_integer; DISPATCH();
+  CASE(or)           A.unsigned_integer = B.unsigned_integer | C.unsigned_integer; DISPATCH();
+  CASE(exclusive_or) A.unsigned_integer = B.unsigned_integer ^ C.unsigned_integer; DISPATCH();
+  CASE(left_shift)
+    A.unsigned_integer = C.unsigned_integer < 64 ? B.unsigned_integer << C.unsigned_integer : 0;
+    DISPATCH();
+  CASE(right_shift_signed)
+    A.signed_integer = B.signed_integer >> (C.unsigned_integer < 64 ? C.unsigned_integer : 63);
+    DISPATCH();
+  CASE(right_shift_unsigned)
+    A.unsigned_integer = C.unsigned_integer < 64 ? B.unsigned_integer >> C.unsigned_integer : 0;
+    DISPATCH();
+
+  CASE(add_float)      A.decimal = B.decimal + C.decimal; DISPATCH();
+  CASE(subtract_float) A.decimal = B.decimal - C.decimal; DISPATCH();
+  CASE(multiply_float) A.decimal = B.decimal * C.decimal; DISPATCH();
+  CASE(divide_float)   A.decimal = B.decimal / C.decimal; DISPATCH();
+
+  CASE(equal)                     A.unsigned_integer = B.unsigned_integer == C.unsigned_integer; DISPATCH();
+  CASE(unequal)                   A.unsigned_integer = B.unsigned_integer != C.unsigned_integer; DISPATCH();
+  CASE(lesser_signed)             A.unsigned_integer = B.signed_integer   <  C.signed_integer;   DISPATCH();
+  CASE(lesser_unsigned)           A.unsigned_integer = B.unsigned_integer <  C.unsigned_integer; DISPATCH();
+  CASE(inclusive_lesser_signed)   A.unsigned_integer = B.signed_integer   <= C.signed_integer;   DISPATCH();
+  CASE(inclusive_lesser_unsigned) A.unsigned_integer = B.unsigned_integer <= C.unsigned_integer; DISPATCH();
+  CASE(equal_float)               A.unsigned_integer = B.decimal == C.decimal;                   DISPATCH();
+  CASE(unequal_float)             A.unsigned_integer = B.decimal != C.decimal;                   DISPATCH();
+  CASE(lesser_float)              A.unsigned_integer = B.decimal <  C.decimal;                   DISPATCH();
+  CASE(inclusive_lesser_float)    A.unsigned_integer = B.decimal <= C.decimal;                   DISPATCH();
+
+  CASE(negate)       A.unsigned_integer = 0 - B.unsigned_integer; DISPATCH();
+  CASE(negate_float) A.decimal = -B.decimal;                      DISPATCH();
+  CASE(not)          A.unsigned_integer = ~B.unsigned_integer;    DISPATCH();
+  CASE(test)         A.unsigned_integer = B.unsigned_integer != 0; DISPATCH();
+  CASE(test_float)   A.unsigned_integer = B.decimal != 0;          DISPATCH();
+  CASE(logical_not)  A.unsigned_integer = B.unsigned_integer == 0; DISPATCH();
+
+  CASE(truncate_signed)
+    A.signed_integer = (sint64)(B.unsigned_integer << (64 - current.c)) >> (64 - current.c);
+    DISPATCH();
+  CASE(truncate_unsigned)
+    A.unsigned_integer = B.unsigned_integer & (((uint64)1 << current.c) - 1);
+    DISPATCH();
+  CASE(round_float32)             A.decimal = (float32)B.decimal;                            DISPATCH();
+  CASE(convert_signed_to_float)   A.decimal = (float64)B.signed_integer;                     DISPATCH();
+  CASE(convert_unsigned_to_float) A.decimal = (float64)B.unsigned_integer;                   DISPATCH();
+  CASE(convert_float_to_signed)   A.signed_integer = convert_float_to_signed(B.decimal);     DISPATCH();
+  CASE(convert_float_to_unsigned) A.unsigned_integer = convert_float_to_unsigned(B.decimal); DISPATCH();
+
+  CASE(jump)
+    ip += (sint32)ip->immediate + 1;
+    DISPATCH();
+  CASE(jump_if_zero)
+    ip += A.unsigned_integer ? 1 : (sint32)ip->immediate + 1;
+    DISPATCH();
+
+  CASE(call)
+    {
+      bytecode_procedure *callee = &procedures[(ip++)->immediate];
+      value *callee_registers = registers + current.a;
+      if (frames_count == bytecode_frames_size || callee_registers + callee->registers_count > stack + bytecode_stack_size)
+      {
+        print_failure("The stack overflowed.\n");
+        succeeded = 0;
+        goto finished;
+      }
+      frames[frames_count++] = (bytecode_frame){ ip, registers };
+      registers = callee_registers;
+      ip = callee->code;
+      DISPATCH();
+    }
+  CASE(return)
+    for (uint i = 0; i < current.b; ++i) registers[i] = registers[current.a + i];
+    if (!frames_count)
+    {
+      copy_typed(value, results, registers, current.b);
+      goto finished;
+    }
+    frames_count -= 1;
+    ip = frames[frames_count].resumption;
+    registers = frames[frames_count].registers;
+    DISPATCH();
+
+#if !defined(__GNUC__)
+    }
+  }
+#endif
+
+#undef DISPATCH
+#undef CASE
+#undef C
+#undef B
+#undef A
+
+divided_by_zero:
+  print_failure("Divided by zero.\n");
+  succeeded = 0;
+finished:
+  deallocate(frames, bytecode_frames_size * sizeof(bytecode_frame));
+  deallocate(stack, bytecode_stack_size * sizeof(value));
+  return succeeded;
+}
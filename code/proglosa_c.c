@@ -0,0 +1,1491 @@
+#include "proglosa.h"
+
+/*****************************************************************************/
+
+/* the translation keeps the semantics of `run_bytecode`, which C leaves
+   undefined: integers wrap, shifts are clamped, divisions are checked, and
+   conversions of floats saturate */
+static const utf8 c_prelude[] =
+  "#include <stdint.h>\n"
+  "\n"
+  "int printf(const char *, ...);\n"
+  "void exit(int);\n"
+  "unsigned long long strtoull(const char *, char **, int);\n"
+  "double strtod(const char *, char **);\n"
+  "\n"
+  "static _Noreturn void proglosa_divided_by_zero(void)\n"
+  "{\n"
+  "  printf(\"[failure] Divided by zero.\\n\");\n"
+  "  exit(1);\n"
+  "}\n"
+  "\n"
+  "static inline int64_t proglosa_divide_signed(int64_t a, int64_t b)\n"
+  "{\n"
+  "  if (!b) proglosa_divided_by_zero();\n"
+  "  return b == -1 ? (int64_t)(0 - (uint64_t)a) : a / b;\n"
+  "}\n"
+  "\n"
+  "static inline uint64_t proglosa_divide_unsigned(uint64_t a, uint64_t b)\n"
+  "{\n"
+  "  if (!b) proglosa_divided_by_zero();\n"
+  "  return a / b;\n"
+  "}\n"
+  "\n"
+  "static inline int64_t proglosa_modulo_signed(int64_t a, int64_t b)\n"
+  "{\n"
+  "  if (!b) proglosa_divided_by_zero();\n"
+  "  return b == -1 ? 0 : a % b;\n"
+  "}\n"
+  "\n"
+  "static inline uint64_t proglosa_modulo_unsigned(uint64_t a, uint64_t b)\n"
+  "{\n"
+  "  if (!b) proglosa_divided_by_zero();\n"
+  "  return a % b;\n"
+  "}\n"
+  "\n"
+  "static inline uint64_t proglosa_shift_left(uint64_t a, uint64_t b)\n"
+  "{\n"
+  "  return b < 64 ? a << b : 0;\n"
+  "}\n"
+  "\n"
+  "static inline int64_t proglosa_shift_right_signed(int64_t a, uint64_t b)\n"
+  "{\n"
+  "  return a >> (b < 64 ? b : 63);\n"
+  "}\n"
+  "\n"
+  "static inline uint64_t proglosa_shift_right_unsigned(uint64_t a, uint64_t b)\n"
+  "{\n"
+  "  return b < 64 ? a >> b : 0;\n"
+  "}\n"
+  "\n"
+  "static inline int64_t proglosa_float_to_signed(double a)\n"
+  "{\n"
+  "  if (a != a) return 0;\n"
+  "  if (a <= -9223372036854775808.0) return INT64_MIN;\n"
+  "  if (a >=  9223372036854775808.0) return INT64_MAX;\n"
+  "  return (int64_t)a;\n"
+  "}\n"
+  "\n"
+  "static inline uint64_t proglosa_float_to_unsigned(double a)\n"
+  "{\n"
+  "  if (a != a || a <= 0) return 0;\n"
+  "  if (a >= 18446744073709551616.0) return UINT64_MAX;\n"
+  "  return (uint64_t)a;\n"
+  "}\n";
+
+/* identifiers that are renamed, since they're reserved by C or the prelude */
+static const utf8 *c_reserved_identifiers[] =
+{
+  "auto", "break", "case", "char", "const", "continue", "default", "do",
+  "double", "else", "enum", "extern", "float", "for", "goto", "if", "inline",
+  "int", "long", "register", "restrict", "return", "short", "signed",
+  "sizeof", "static", "struct", "switch", "typedef", "union", "unsigned",
+  "void", "volatile", "while", "bool", "true", "false",
+  "int8_t", "int16_t", "int32_t", "int64_t",
+  "uint8_t", "uint16_t", "uint32_t", "uint64_t",
+  "main", "printf", "exit", "strtoull", "strtod",
+};
+
+typedef enum
+{
+  c_structure_state_undefined,
+  c_structure_state_defining,
+  c_structure_state_defined,
+} c_structure_state;
+
+typedef struct
+{
+  expression       *procedure;
+  declaration_node *declaration; /* that names the procedure, if any */
+  bit               is_global : 1;
+} c_procedure;
+
+typedef struct
+{
+  program *program;
+  c_unit  *text; /* that's written */
+
+  /* sections, which are joined once every procedure is translated */
+  c_unit prototypes;
+  c_unit initializer;
+  c_unit definitions;
+
+  c_procedure *procedures; /* in the order they're first referred to */
+  uint         procedures_count;
+  uint         procedures_capacity;
+
+  uint8 *structure_states; /* of each type */
+
+  /* of the translated procedure */
+  expression        *procedure;
+  declaration_node **locals;
+  uint               locals_count;
+  uint               locals_capacity;
+  declaration_node  *results[maximum_parameters_count]; /* or 0 if unnamed */
+  uint               indentation;
+
+  uint temporaries_count; /* that hold the bases and values of selections */
+} translator;
+
+static void write_c(c_unit *text, const utf8 *format, ...)
+{
+  vargs vargs;
+  get_vargs(vargs, format);
+  int size = vsnprintf(0, 0, format, vargs);
+  end_vargs(vargs);
+  if (size <= 0) return;
+
+  if (text->size + (uint)size + 1 > text->capacity)
+  {
+    uint capacity = text->capacity ? text->capacity * 2 : 4096;
+    while (capacity < text->size + (uint)size + 1) capacity *= 2;
+    text->text = reallocate(capacity, text->text, text->capacity);
+    text->capacity = capacity;
+  }
+  get_vargs(vargs, format);
+  vsnprintf(text->text + text->size, (uint)size + 1, format, vargs);
+  end_vargs(vargs);
+  text->size += (uint)size;
+}
+
+static void append_c(c_unit *text, c_unit *appended)
+{
+  if (appended->size) write_c(text, "%.*s", (int)appended->size, appended->text);
+  release_c(appended);
+}
+
+static void write_c_indentation(translator *translator)
+{
+  write_c(translator->text, "%*s", (int)(translator->indentation * 2), "");
+}
+
+static void report_untranslatable(expression *expression, translator *translator)
+{
+  report_expression_failure(translator->program, expression, "Translating %s to C isn't supported.", node_tag_representations[expression->tag]);
+}
+
+static void write_c_identifier(const utf8 *runes, translator *translator)
+{
+  write_c(translator->text, "%s", runes);
+  for (uint i = 0; i < countof(c_reserved_identifiers); ++i)
+  {
+    if (compare_string(runes, c_reserved_identifiers[i])) continue;
+    write_c(translator->text, "_");
+    break;
+  }
+}
+
+static bit is_global_declaration(declaration_node *declaration, program *program)
+{
+  for (statement *global = program->global_scope.declarations; global; global = global->next)
+    if (&global->expression.data->declaration == declaration) return 1;
+  return 0;
+}
+
+static bit is_c_local(declaration_node *declaration, translator *translator)
+{
+  for (uint i = translator->locals_count; i--;)
+    if (translator->locals[i] == declaration) return 1;
+  return 0;
+}
+
+static void declare_c_local(declaration_node *declaration, translator *translator)
+{
+  if (translator->locals_count == translator->locals_capacity)
+  {
+    uint capacity = translator->locals_capacity ? translator->locals_capacity * 2 : 64;
+    translator->locals = reallocate(capacity * sizeof(declaration_node *), translator->locals, translator->locals_capacity * sizeof(declaration_node *));
+    translator->locals_capacity = capacity;
+  }
+  translator->locals[translator->locals_count++] = declaration;
+}
+
+/* procedures are translated in the order they're first referred to */
+static uint get_c_procedure(expression *procedure, declaration_node *declaration, translator *translator)
+{
+  for (uint i = 0; i < translator->procedures_count; ++i)
+    if (translator->procedures[i].procedure == procedure) return i;
+
+  if (translator->procedures_count == translator->procedures_capacity)
+  {
+    uint capacity = translator->procedures_capacity ? translator->procedures_capacity * 2 : 16;
+    translator->procedures = reallocate(capacity * sizeof(c_procedure), translator->procedures, translator->procedures_capacity * sizeof(c_procedure));
+    translator->procedures_capacity = capacity;
+  }
+  uint index = translator->procedures_count++;
+  translator->procedures[index] = (c_procedure)
+  {
+    .procedure   = procedure,
+    .declaration = declaration,
+    .is_global   = declaration && is_global_declaration(declaration, translator->program),
+  };
+  return index;
+}
+
+/* global procedures keep their names, and the others are numbered */
+static void write_c_procedure_name(uint index, translator *translator)
+{
+  c_procedure *procedure = &translator->procedures[index];
+  if (procedure->is_global) write_c_identifier(procedure->declaration->identifier.runes, translator);
+  else if (procedure->declaration) write_c(translator->text, "%s_%u", procedure->declaration->identifier.runes, index);
+  else write_c(translator->text, "literal_%u", index);
+}
+
+/*****************************************************************************/
+
+static bit is_c_type(type_id id)
+{
+  type_kind kind = get_type(id)->kind;
+  return kind != type_kind_none && kind != type_kind_type;
+}
+
+static void write_c_type(type_id id, translator *translator)
+{
+  type *type = get_type(id);
+  switch (type->kind)
+  {
+  case type_kind_none:     write_c(translator->text, "void");                                     break;
+  case type_kind_integer:  write_c(translator->text, "int64_t");                                  break;
+  case type_kind_decimal:  write_c(translator->text, "double");                                   break;
+  case type_kind_signed:   write_c(translator->text, "int%u_t", type->size * 8);                  break;
+  case type_kind_unsigned: write_c(translator->text, "uint%u_t", type->size * 8);                 break;
+  case type_kind_float:    write_c(translator->text, type->size == sizeof(float32) ? "float" : "double"); break;
+  case type_kind_bit:      write_c(translator->text, "uint8_t");                                  break;
+  case type_kind_procedure: write_c(translator->text, "procedure_%u", id);                        break;
+  case type_kind_pointer:
+    write_c_type(type->pointee, translator);
+    write_c(translator->text, " *");
+    break;
+  case type_kind_structure:
+    if (!type->declaration) write_c(translator->text, "structure_%u", id);
+    else if (is_global_declaration(type->declaration, translator->program)) write_c_identifier(type->declaration->identifier.runes, translator);
+    else write_c(translator->text, "%s_%u", type->declaration->identifier.runes, id);
+    break;
+  case type_kind_type:
+    UNREACHABLE();
+  }
+}
+
+/* writes `type name`, where pointers are written as `type *name` */
+static void write_c_typed(type_id id, translator *translator)
+{
+  write_c_type(id, translator);
+  if (translator->text->text[translator->text->size - 1] != '*') write_c(translator->text, " ");
+}
+
+static uint get_results_count(type_id procedure_type)
+{
+  type *type = get_type(procedure_type);
+  return type->components_count - type->arguments_count;
+}
+
+/* procedures of several results return them in a structure */
+static void write_c_result_type(type_id procedure_type, translator *translator)
+{
+  uint results_count = get_results_count(procedure_type);
+  if (results_count == 1) write_c_type(get_type(procedure_type)->components[get_type(procedure_type)->arguments_count], translator);
+  else if (results_count) write_c(translator->text, "results_%u", procedure_type);
+  else write_c(translator->text, "void");
+}
+
+static bit is_c_field(declaration_node *field, type_id type)
+{
+  return !field->is_constant && is_c_type(type);
+}
+
+/* structures are defined after those they contain */
+static void define_c_structure(type_id id, translator *translator)
+{
+  if (translator->structure_states[id] != c_structure_state_undefined) return;
+  translator->structure_states[id] = c_structure_state_defining;
+
+  type *type = get_type(id);
+  uint results_offset = type->kind == type_kind_procedure ? type->arguments_count : 0;
+  for (uint i = results_offset; i < type->components_count; ++i)
+    if (get_type(type->components[i])->kind == type_kind_structure) define_c_structure(type->components[i], translator);
+
+  type = get_type(id);
+  if (type->kind == type_kind_procedure)
+  {
+    write_c(translator->text, "struct results_%u\n{\n", id);
+    for (uint i = type->arguments_count; i < type->components_count; ++i)
+    {
+      write_c(translator->text, "  ");
+      write_c_typed(type->components[i], translator);
+      write_c(translator->text, "r%u;\n", i - type->arguments_count);
+    }
+  }
+  else
+  {
+    /* the fields are defined in the order of their offsets, so C lays them
+       out like `lay_out_types` */
+    write_c(translator->text, "struct ");
+    write_c_type(id, translator);
+    write_c(translator->text, "\n{\n");
+    uint fields_count = 0;
+    for (uint prior_offset = 0;; ++fields_count)
+    {
+      statement *next_field = 0;
+      uint next_index = 0, i = 0;
+      for (statement *field = type->structure->declarations; field && i < type->components_count; field = field->next, ++i)
+      {
+        uint offset = type->offsets[i];
+        if (offset == no_offset || !is_c_field(&field->expression.data->declaration, type->components[i])) continue;
+        if ((fields_count && offset <= prior_offset) || (next_field && offset >= type->offsets[next_index])) continue;
+        next_field = field;
+        next_index = i;
+      }
+      if (!next_field) break;
+      prior_offset = type->offsets[next_index];
+      write_c(translator->text, "  ");
+      write_c_typed(type->components[next_index], translator);
+      write_c_identifier(next_field->expression.data->declaration.identifier.runes, translator);
+      write_c(translator->text, ";\n");
+    }
+    if (!fields_count) write_c(translator->text, "  char unused;\n");
+  }
+  write_c(translator->text, "};\n\n");
+  translator->structure_states[id] = c_structure_state_defined;
+}
+
+static uint get_lanes_count(type_id id)
+{
+  uint lanes_count = 1;
+  while (lanes_count < get_type(id)->components_count) lanes_count *= 2;
+  return lanes_count;
+}
+
+/* integers are operated upon in unsigned lanes, so they wrap */
+static void write_c_lane_type(type_id element, translator *translator)
+{
+  if (is_floating(element)) write_c_type(element, translator);
+  else write_c(translator->text, "uint%u_t", get_type(element)->size * 8);
+}
+
+/* structures of one numeric type are operated upon as vectors of their
+   fields, which C compilers lower to SIMD instructions; the lanes beyond the
+   fields are zero */
+static void define_c_vector(type_id id, translator *translator)
+{
+  type *type = get_type(id);
+  type_id element = get_element_type(id);
+  write_c(translator->text, "typedef ");
+  write_c_lane_type(element, translator);
+  write_c(translator->text, " vector_%u __attribute__((vector_size(%u)));\n", id, get_lanes_count(id) * get_type(element)->size);
+
+  write_c(translator->text, "static inline vector_%u to_vector_%u(", id, id);
+  write_c_typed(id, translator);
+  write_c(translator->text, "s) { return (vector_%u){ ", id);
+  for (statement *field = type->structure->declarations; field; field = field->next)
+  {
+    write_c(translator->text, field == type->structure->declarations ? "s." : ", s.");
+    write_c_identifier(field->expression.data->declaration.identifier.runes, translator);
+  }
+  write_c(translator->text, " }; }\n");
+
+  write_c(translator->text, "static inline ");
+  write_c_typed(id, translator);
+  write_c(translator->text, "from_vector_%u(vector_%u v) { return (", id, id);
+  write_c_type(id, translator);
+  write_c(translator->text, "){ ");
+  uint i = 0;
+  for (statement *field = type->structure->declarations; field; field = field->next, ++i)
+  {
+    write_c(translator->text, i ? ", ." : ".");
+    write_c_identifier(field->expression.data->declaration.identifier.runes, translator);
+    write_c(translator->text, " = ");
+    if (!is_floating(element))
+    {
+      write_c(translator->text, "(");
+      write_c_type(element, translator);
+      write_c(translator->text, ")");
+    }
+    write_c(translator->text, "v[%u]", i);
+  }
+  write_c(translator->text, " }; }\n\n");
+}
+
+/*****************************************************************************/
+
+static void translate_expression(expression *expression, translator *translator);
+
+static void write_c_literal(expression *literal, type_id to, translator *translator)
+{
+  type *type = get_type(to);
+  if (type->kind == type_kind_float || type->kind == type_kind_decimal)
+  {
+    bit is_single = type->kind == type_kind_float && type->size == sizeof(float32);
+    float64 value = get_literal_decimal(literal);
+    if (is_single) value = (float32)value;
+    if (value != value)
+    {
+      write_c(translator->text, is_single ? "__builtin_nanf(\"\")" : "__builtin_nan(\"\")");
+      return;
+    }
+    if (value - value != 0)
+    {
+      write_c(translator->text, "(%s__builtin_inf%s())", value < 0 ? "-" : "", is_single ? "f" : "");
+      return;
+    }
+
+    /* the shortest representations that are read back exactly */
+    utf8 string[64];
+    snprintf(string, sizeof(string), is_single ? "%.9g" : "%.17g", value);
+    bit is_integral = !strpbrk(string, ".e");
+    write_c(translator->text, value < 0 ? "(%s%s%s)" : "%s%s%s", string, is_integral ? ".0" : "", is_single ? "f" : "");
+    return;
+  }
+
+  uint64 value = normalize_integer(get_literal_integer(literal), to);
+  switch (type->kind)
+  {
+  case type_kind_pointer:
+    write_c(translator->text, "((");
+    write_c_type(to, translator);
+    write_c(translator->text, ")%lluull)", (unsigned long long)value);
+    break;
+  case type_kind_integer:
+  case type_kind_signed:
+    if ((sint64)value == INT64_MIN) write_c(translator->text, "(-9223372036854775807 - 1)");
+    else write_c(translator->text, (sint64)value < 0 ? "(%lld)" : "%lld", (long long)value);
+    break;
+  default:
+    write_c(translator->text, value > UINT32_MAX ? "%lluull" : "%lluu", (unsigned long long)value);
+    break;
+  }
+}
+
+static void write_c_zero(type_id id, translator *translator)
+{
+  write_c(translator->text, get_type(id)->kind == type_kind_structure ? "{0}" : "0");
+}
+
+/* integers are computed in 64 bits, and wrapped to their type */
+static void open_c_normalization(type_id id, translator *translator)
+{
+  if (get_type(id)->kind == type_kind_bit)
+  {
+    write_c(translator->text, "(uint8_t)((");
+    return;
+  }
+  write_c(translator->text, "((");
+  write_c_type(id, translator);
+  write_c(translator->text, ")(");
+}
+
+static void close_c_normalization(type_id id, translator *translator)
+{
+  write_c(translator->text, get_type(id)->kind == type_kind_bit ? ") != 0)" : "))");
+}
+
+/* writes the expression's value converted to the type */
+static void translate_converted(expression *expression, type_id to, translator *translator)
+{
+  if (is_literal(expression) && to != none_type && is_scalar(to))
+  {
+    write_c_literal(expression, to, translator);
+    return;
+  }
+
+  type_id from = expression->type;
+  if (from == to || from == none_type || to == none_type || !is_scalar(from) || !is_scalar(to))
+  {
+    translate_expression(expression, translator);
+    return;
+  }
+
+  if (get_type(to)->kind == type_kind_bit)
+  {
+    write_c(translator->text, "(");
+    translate_expression(expression, translator);
+    write_c(translator->text, " != 0)");
+    return;
+  }
+  if (is_floating(from) && !is_floating(to))
+  {
+    open_c_normalization(to, translator);
+    write_c(translator->text, is_signed(to) ? "proglosa_float_to_signed(" : "proglosa_float_to_unsigned(");
+    translate_expression(expression, translator);
+    write_c(translator->text, ")");
+    close_c_normalization(to, translator);
+    return;
+  }
+
+  /* integers are converted to 32-bit floats through 64-bit ones */
+  write_c(translator->text, "((");
+  write_c_type(to, translator);
+  write_c(translator->text, ")");
+  if (!is_floating(from) && get_type(to)->kind == type_kind_float && get_type(to)->size == sizeof(float32))
+    write_c(translator->text, "(double)");
+  write_c(translator->text, "(");
+  translate_expression(expression, translator);
+  write_c(translator->text, "))");
+}
+
+static const utf8 *get_c_operator(node_tag tag)
+{
+  switch (tag)
+  {
+  case node_tag_addition:                      return "+";
+  case node_tag_subtraction:                   return "-";
+  case node_tag_multiplication:                return "*";
+  case node_tag_division:                      return "/";
+  case node_tag_bitwise_conjunction:           return "&";
+  case node_tag_bitwise_disjunction:           return "|";
+  case node_tag_bitwise_exclusive_disjunction: return "^";
+  case node_tag_equality:                      return "==";
+  case node_tag_inequality:                    return "!=";
+  case node_tag_greater:                       return ">";
+  case node_tag_lesser:                        return "<";
+  case node_tag_inclusive_greater:             return ">=";
+  case node_tag_inclusive_lesser:              return "<=";
+  case node_tag_conjunction:                   return "&&";
+  case node_tag_disjunction:                   return "||";
+  default: UNREACHABLE();
+  }
+}
+
+/* places are assigned and referred to */
+static bit is_c_place(expression *expression, bit must_be_pure)
+{
+  switch (expression->tag)
+  {
+  case node_tag_identifier:
+    return 1;
+  case node_tag_resolution:
+    {
+      struct expression *left = expression->data->resolution.left;
+      if (get_type(left->type)->kind != type_kind_pointer) return is_c_place(left, must_be_pure);
+      return !must_be_pure || is_c_place(left, 1);
+    }
+  default:
+    return 0;
+  }
+}
+
+static bit is_selection(expression *expression)
+{
+  return expression->tag == node_tag_resolution && expression->data->resolution.right->tag == node_tag_structure;
+}
+
+/* writes the fields selected from a base, which is written by
+   `translate_expression` unless it's held by a temporary, as the
+   initializers of a structure or of the lanes of a vector */
+static void write_c_selected(expression *selection, uint base_temporary, bit is_designated, translator *translator)
+{
+  struct expression *base = selection->data->resolution.left;
+  bit is_pointer = get_type(base->type)->kind == type_kind_pointer;
+  structure_node *fields = &selection->data->resolution.right->data->structure;
+  for (statement *selected = fields->declarations; selected; selected = selected->next)
+  {
+    declaration_node *field = selected->expression.data->declaration.identifier.declaration;
+    if (selected != fields->declarations) write_c(translator->text, ", ");
+    if (is_designated)
+    {
+      write_c(translator->text, ".");
+      write_c_identifier(selected->expression.data->declaration.identifier.runes, translator);
+      write_c(translator->text, " = ");
+    }
+    if (field->is_constant)
+    {
+      if (field->assignment) translate_converted(field->assignment, field->type, translator);
+      else report_untranslatable(selection, translator);
+      continue;
+    }
+    if (base_temporary) write_c(translator->text, "proglosa_%u", base_temporary);
+    else translate_expression(base, translator);
+    write_c(translator->text, is_pointer ? "->" : ".");
+    write_c_identifier(field->identifier.runes, translator);
+  }
+}
+
+/* a selection is a structure of the selected fields; a base that's written
+   more than once is held by a temporary */
+static void translate_selection(expression *selection, translator *translator)
+{
+  struct expression *base = selection->data->resolution.left;
+  if (is_c_place(base, 1))
+  {
+    write_c(translator->text, "((");
+    write_c_type(selection->type, translator);
+    write_c(translator->text, "){ ");
+    write_c_selected(selection, 0, 1, translator);
+    write_c(translator->text, " })");
+    return;
+  }
+  uint base_temporary = ++translator->temporaries_count;
+  write_c(translator->text, "({ ");
+  write_c_typed(base->type, translator);
+  write_c(translator->text, "proglosa_%u = ", base_temporary);
+  translate_expression(base, translator);
+  write_c(translator->text, "; (");
+  write_c_type(selection->type, translator);
+  write_c(translator->text, "){ ");
+  write_c_selected(selection, base_temporary, 1, translator);
+  write_c(translator->text, " }; })");
+}
+
+/* writes the expression as a vector of the elements of the structure, where
+   scalars are broadcast to every lane */
+static void translate_lanes(expression *expression, type_id type, translator *translator)
+{
+  type_id element = get_element_type(type);
+  if (expression->type != type)
+  {
+    write_c(translator->text, "((");
+    write_c_lane_type(element, translator);
+    write_c(translator->text, ")");
+    translate_converted(expression, element, translator);
+    write_c(translator->text, ")");
+    return;
+  }
+
+  switch (expression->tag)
+  {
+  case node_tag_addition:
+  case node_tag_subtraction:
+  case node_tag_multiplication:
+  case node_tag_division:
+  case node_tag_bitwise_conjunction:
+  case node_tag_bitwise_disjunction:
+  case node_tag_bitwise_exclusive_disjunction:
+    write_c(translator->text, "(");
+    translate_lanes(expression->data->binary.left, type, translator);
+    write_c(translator->text, " %s ", get_c_operator(expression->tag));
+    translate_lanes(expression->data->binary.right, type, translator);
+    write_c(translator->text, ")");
+    return;
+  case node_tag_positive:
+    translate_lanes(expression->data->unary.expression, type, translator);
+    return;
+  case node_tag_negative:
+  case node_tag_bitwise_negation:
+    write_c(translator->text, expression->tag == node_tag_negative ? "(-" : "(~");
+    translate_lanes(expression->data->unary.expression, type, translator);
+    write_c(translator->text, ")");
+    return;
+  case node_tag_resolution:
+    /* the selected fields are gathered into the vector directly */
+    if (!is_selection(expression) || !is_c_place(expression->data->resolution.left, 1)) break;
+    write_c(translator->text, "((vector_%u){ ", type);
+    write_c_selected(expression, 0, 0, translator);
+    write_c(translator->text, " })");
+    return;
+  default:
+    break;
+  }
+  write_c(translator->text, "to_vector_%u(", type);
+  translate_expression(expression, translator);
+  write_c(translator->text, ")");
+}
+
+static void translate_arithmetic(node_tag tag, type_id type, expression *left, expression *right, expression *expression, translator *translator)
+{
+  if (get_element_type(type) != none_type)
+  {
+    write_c(translator->text, "from_vector_%u(", type);
+    translate_lanes(left, type, translator);
+    write_c(translator->text, " %s ", get_c_operator(tag));
+    translate_lanes(right, type, translator);
+    write_c(translator->text, ")");
+    return;
+  }
+
+  if (!is_numeric(type))
+  {
+    report_untranslatable(expression, translator);
+    return;
+  }
+
+  if (is_floating(type))
+  {
+    write_c(translator->text, "(");
+    translate_converted(left, type, translator);
+    write_c(translator->text, " %s ", get_c_operator(tag));
+    translate_converted(right, type, translator);
+    write_c(translator->text, ")");
+    return;
+  }
+
+  open_c_normalization(type, translator);
+  switch (tag)
+  {
+  case node_tag_division:
+  case node_tag_modulo:
+  case node_tag_bitwise_left_shift:
+  case node_tag_bitwise_right_shift:
+    {
+      bit is_signed_type = is_signed(type);
+      const utf8 *helper;
+      switch (tag)
+      {
+      case node_tag_division:           helper = is_signed_type ? "divide_signed"      : "divide_unsigned";      break;
+      case node_tag_modulo:             helper = is_signed_type ? "modulo_signed"      : "modulo_unsigned";      break;
+      case node_tag_bitwise_left_shift: helper = "shift_left";                                                   break;
+      default:                          helper = is_signed_type ? "shift_right_signed" : "shift_right_unsigned"; break;
+      }
+      bit is_shift = tag == node_tag_bitwise_left_shift || tag == node_tag_bitwise_right_shift;
+      write_c(translator->text, "proglosa_%s(", helper);
+      translate_converted(left, type, translator);
+      write_c(translator->text, ", ");
+      translate_converted(right, is_shift ? right->type : type, translator);
+      write_c(translator->text, ")");
+      break;
+    }
+  default:
+    write_c(translator->text, "(uint64_t)");
+    translate_converted(left, type, translator);
+    write_c(translator->text, " %s (uint64_t)", get_c_operator(tag));
+    translate_converted(right, type, translator);
+    break;
+  }
+  close_c_normalization(type, translator);
+}
+
+static void translate_comparison(expression *expression, translator *translator)
+{
+  struct expression *left = expression->data->binary.left, *right = expression->data->binary.right;
+  type_id type = is_untyped(left->type) ? right->type : left->type;
+  if (!is_scalar(type))
+  {
+    report_untranslatable(expression, translator);
+    return;
+  }
+  write_c(translator->text, "(");
+  translate_converted(left, type, translator);
+  write_c(translator->text, " %s ", get_c_operator(expression->tag));
+  translate_converted(right, type, translator);
+  write_c(translator->text, ")");
+}
+
+/* the value is held by a temporary, and assigned to each selected field of
+   the base, whose address is held by another */
+static void translate_selection_assignment(expression *expression, bit is_statement, translator *translator)
+{
+  struct expression *left = expression->data->binary.left, *right = expression->data->binary.right;
+  struct expression *base = left->data->resolution.left;
+  node_tag operation = get_assigned_operation(expression->tag);
+  uint value_temporary = ++translator->temporaries_count;
+  uint base_temporary = ++translator->temporaries_count;
+
+  write_c(translator->text, is_statement ? "{ " : "({ ");
+  write_c_typed(left->type, translator);
+  write_c(translator->text, "proglosa_%u = ", value_temporary);
+  if (operation == node_tag_assignment) translate_converted(right, left->type, translator);
+  else translate_arithmetic(operation, left->type, left, right, expression, translator);
+  write_c(translator->text, "; ");
+
+  bit is_pointer = get_type(base->type)->kind == type_kind_pointer;
+  write_c_typed(is_pointer ? get_type(base->type)->pointee : base->type, translator);
+  write_c(translator->text, "*proglosa_%u = %s", base_temporary, is_pointer ? "" : "&");
+  translate_expression(base, translator);
+  write_c(translator->text, "; ");
+
+  for (statement *selected = left->data->resolution.right->data->structure.declarations; selected; selected = selected->next)
+  {
+    const utf8 *runes = selected->expression.data->declaration.identifier.runes;
+    write_c(translator->text, "proglosa_%u->", base_temporary);
+    write_c_identifier(runes, translator);
+    write_c(translator->text, " = proglosa_%u.", value_temporary);
+    write_c_identifier(runes, translator);
+    write_c(translator->text, "; ");
+  }
+  if (is_statement) write_c(translator->text, "}");
+  else write_c(translator->text, "proglosa_%u; })", value_temporary);
+}
+
+static void translate_assignment(expression *expression, bit is_statement, translator *translator)
+{
+  struct expression *left = expression->data->binary.left, *right = expression->data->binary.right;
+  node_tag operation = get_assigned_operation(expression->tag);
+
+  /* the place of a compound assignment is written twice */
+  if (!is_c_place(left, operation != node_tag_assignment))
+  {
+    report_untranslatable(expression, translator);
+    return;
+  }
+
+  if (is_selection(left))
+  {
+    translate_selection_assignment(expression, is_statement, translator);
+    return;
+  }
+
+  if (!is_statement) write_c(translator->text, "(");
+  translate_expression(left, translator);
+  write_c(translator->text, " = ");
+  if (operation == node_tag_assignment) translate_converted(right, left->type, translator);
+  else translate_arithmetic(operation, left->type, left, right, expression, translator);
+  if (!is_statement) write_c(translator->text, ")");
+}
+
+static void translate_invocation(expression *expression, translator *translator)
+{
+  struct expression *callee = expression->data->invocation.left;
+  declaration_node *declaration = callee->tag == node_tag_identifier ? callee->data->identifier.declaration : 0;
+  if (declaration == &builtin_declarations[builtin_return])
+  {
+    report_expression_failure(translator->program, expression, "Translating a return within a value to C isn't supported.");
+    return;
+  }
+
+  type_id callee_type = callee->type;
+  if (get_type(callee_type)->kind == type_kind_pointer)
+  {
+    callee_type = get_type(callee_type)->pointee;
+    write_c(translator->text, "(*");
+    translate_expression(callee, translator);
+    write_c(translator->text, ")");
+  }
+  else translate_expression(callee, translator);
+
+  struct expression *arguments[maximum_parameters_count];
+  uint arguments_count = 0;
+  flatten_list(arguments, &arguments_count, maximum_parameters_count, expression->data->invocation.right);
+  write_c(translator->text, "(");
+  for (uint i = 0; i < arguments_count; ++i)
+  {
+    if (i) write_c(translator->text, ", ");
+    translate_converted(arguments[i], get_type(callee_type)->components[i], translator);
+  }
+  write_c(translator->text, ")");
+}
+
+static void translate_identifier(expression *expression, translator *translator)
+{
+  declaration_node *declaration = expression->data->identifier.declaration;
+  if (declaration == &builtin_declarations[builtin_return])
+  {
+    report_expression_failure(translator->program, expression, "Translating a return within a value to C isn't supported.");
+    return;
+  }
+  if (get_builtin(declaration) >= 0 || is_type_declaration(declaration))
+  {
+    report_expression_failure(translator->program, expression, "Translating a type to a C value isn't supported.");
+    return;
+  }
+  if (is_procedure_declaration(declaration))
+  {
+    write_c_procedure_name(get_c_procedure(declaration->assignment, declaration, translator), translator);
+    return;
+  }
+  if (!is_c_local(declaration, translator) && !is_global_declaration(declaration, translator->program))
+  {
+    report_expression_failure(translator->program, expression, "Translating %s, which is a variable of another procedure, to C isn't supported.", declaration->identifier.runes);
+    return;
+  }
+  write_c_identifier(declaration->identifier.runes, translator);
+}
+
+/* writes a C expression, which is parenthesized unless it's primary or
+   postfix */
+void translate_expression(expression *expression, translator *translator)
+{
+  switch (expression->tag)
+  {
+  case node_tag_digital:
+  case node_tag_decimal:
+    write_c_literal(expression, expression->type, translator);
+    return;
+  case node_tag_rune:
+    write_c(translator->text, "%uu", expression->data->rune.value);
+    return;
+  case node_tag_string:
+    {
+      /* the runes are quoted and escaped like C's, except for new lines */
+      write_c(translator->text, "((uint8_t *)");
+      string_node *string = &expression->data->string;
+      for (uint i = 0; i < string->runes_count; ++i)
+      {
+        if (string->runes[i] == '\n') write_c(translator->text, "\\n");
+        else if (string->runes[i] != '\r') write_c(translator->text, "%c", string->runes[i]);
+      }
+      write_c(translator->text, ")");
+      return;
+    }
+  case node_tag_identifier:
+    translate_identifier(expression, translator);
+    return;
+  case node_tag_procedure:
+    write_c_procedure_name(get_c_procedure(expression, 0, translator), translator);
+    return;
+
+  case node_tag_positive:
+    translate_expression(expression->data->unary.expression, translator);
+    return;
+  case node_tag_negative:
+  case node_tag_bitwise_negation:
+    {
+      struct expression *operand = expression->data->unary.expression;
+      if (get_element_type(expression->type) != none_type)
+      {
+        write_c(translator->text, "from_vector_%u(", expression->type);
+        translate_lanes(expression, expression->type, translator);
+        write_c(translator->text, ")");
+        return;
+      }
+      if (!is_numeric(expression->type) && expression->type != types.bit_type) break;
+      if (is_floating(expression->type))
+      {
+        write_c(translator->text, "(-");
+        translate_converted(operand, expression->type, translator);
+        write_c(translator->text, ")");
+        return;
+      }
+      open_c_normalization(expression->type, translator);
+      write_c(translator->text, expression->tag == node_tag_negative ? "0 - (uint64_t)" : "~(uint64_t)");
+      translate_converted(operand, expression->type, translator);
+      close_c_normalization(expression->type, translator);
+      return;
+    }
+  case node_tag_negation:
+    write_c(translator->text, "(!");
+    translate_expression(expression->data->unary.expression, translator);
+    write_c(translator->text, ")");
+    return;
+  case node_tag_reference:
+    if (expression->type == types.type_type || !is_c_place(expression->data->reference.expression, 0)) break;
+    write_c(translator->text, "(&");
+    translate_expression(expression->data->reference.expression, translator);
+    write_c(translator->text, ")");
+    return;
+
+  case node_tag_addition:
+  case node_tag_subtraction:
+  case node_tag_multiplication:
+  case node_tag_division:
+  case node_tag_modulo:
+  case node_tag_bitwise_conjunction:
+  case node_tag_bitwise_disjunction:
+  case node_tag_bitwise_exclusive_disjunction:
+  case node_tag_bitwise_left_shift:
+  case node_tag_bitwise_right_shift:
+    translate_arithmetic(expression->tag, expression->type, expression->data->binary.left, expression->data->binary.right, expression, translator);
+    return;
+
+  case node_tag_equality:
+  case node_tag_inequality:
+  case node_tag_greater:
+  case node_tag_lesser:
+  case node_tag_inclusive_greater:
+  case node_tag_inclusive_lesser:
+    translate_comparison(expression, translator);
+    return;
+
+  case node_tag_conjunction:
+  case node_tag_disjunction:
+    write_c(translator->text, "(");
+    translate_expression(expression->data->binary.left, translator);
+    write_c(translator->text, " %s ", get_c_operator(expression->tag));
+    translate_expression(expression->data->binary.right, translator);
+    write_c(translator->text, ")");
+    return;
+
+  case node_tag_assignment:
+  case node_tag_addition_assignment:
+  case node_tag_subtraction_assignment:
+  case node_tag_multiplication_assignment:
+  case node_tag_division_assignment:
+  case node_tag_modulo_assignment:
+  case node_tag_bitwise_conjunction_assignment:
+  case node_tag_bitwise_disjunction_assignment:
+  case node_tag_bitwise_exclusive_disjunction_assignment:
+  case node_tag_bitwise_left_shift_assignment:
+  case node_tag_bitwise_right_shift_assignment:
+    translate_assignment(expression, 0, translator);
+    return;
+
+  case node_tag_resolution:
+    {
+      if (is_selection(expression))
+      {
+        translate_selection(expression, translator);
+        return;
+      }
+      struct expression *left = expression->data->resolution.left;
+      declaration_node *field = expression->data->resolution.right->data->identifier.declaration;
+      if (field->is_constant)
+      {
+        if (!field->assignment) break;
+        translate_converted(field->assignment, expression->type, translator);
+        return;
+      }
+      translate_expression(left, translator);
+      write_c(translator->text, get_type(left->type)->kind == type_kind_pointer ? "->" : ".");
+      write_c_identifier(field->identifier.runes, translator);
+      return;
+    }
+  case node_tag_cast:
+    translate_converted(expression->data->cast.left, expression->type, translator);
+    return;
+  case node_tag_invocation:
+    translate_invocation(expression, translator);
+    return;
+
+  case node_tag_condition:
+  case node_tag_ternary:
+    {
+      struct expression *other = expression->data->condition.other;
+      bit has_value = expression->type != none_type;
+      write_c(translator->text, "(");
+      translate_expression(expression->data->condition.left, translator);
+      write_c(translator->text, has_value ? " ? " : " ? (void)");
+      translate_converted(expression->data->condition.right, expression->type, translator);
+      write_c(translator->text, has_value ? " : " : " : (void)");
+      if (other) translate_converted(other, expression->type, translator);
+      else write_c(translator->text, "0");
+      write_c(translator->text, ")");
+      return;
+    }
+
+  default:
+    break;
+  }
+  report_untranslatable(expression, translator);
+}
+
+/*****************************************************************************/
+
+static void write_c_result_name(uint index, translator *translator)
+{
+  if (translator->results[index]) write_c_identifier(translator->results[index]->identifier.runes, translator);
+  else write_c(translator->text, "result_%u", index);
+}
+
+static void translate_return(expression *results, translator *translator)
+{
+  type_id procedure_type = translator->procedure->type;
+  type *type = get_type(procedure_type);
+  uint results_count = get_results_count(procedure_type);
+  expression *items[maximum_parameters_count];
+  uint items_count = 0;
+  flatten_list(items, &items_count, maximum_parameters_count, results);
+
+  /* a bare `return` returns the named results */
+  write_c_indentation(translator);
+  write_c(translator->text, results_count ? "return " : "return");
+  if (results_count > 1) write_c(translator->text, "(results_%u){ ", procedure_type);
+  for (uint i = 0; i < results_count; ++i)
+  {
+    if (i) write_c(translator->text, ", ");
+    if (items_count) translate_converted(items[i], type->components[type->arguments_count + i], translator);
+    else write_c_result_name(i, translator);
+  }
+  if (results_count > 1) write_c(translator->text, " }");
+  write_c(translator->text, ";\n");
+}
+
+static void translate_local_declaration(declaration_node *declaration, translator *translator)
+{
+  if (is_compile_time_declaration(declaration)) return;
+  if (is_procedure_declaration(declaration))
+  {
+    get_c_procedure(declaration->assignment, declaration, translator);
+    return;
+  }
+
+  write_c_indentation(translator);
+  if (declaration->is_constant && declaration->assignment && is_literal(declaration->assignment)) write_c(translator->text, "const ");
+  write_c_typed(declaration->type, translator);
+  write_c_identifier(declaration->identifier.runes, translator);
+  write_c(translator->text, " = ");
+  if (declaration->assignment) translate_converted(declaration->assignment, declaration->type, translator);
+  else write_c_zero(declaration->type, translator);
+  write_c(translator->text, ";\n");
+  declare_c_local(declaration, translator);
+}
+
+/* leaves are statements without effects */
+static bit has_c_effects(expression *expression)
+{
+  switch (node_families[expression->tag])
+  {
+  case node_family_leaf:
+    return expression->tag == node_tag_identifier && expression->data->identifier.declaration == &builtin_declarations[builtin_return];
+  default:
+    return 1;
+  }
+}
+
+static void translate_statement(expression *expression, translator *translator);
+
+/* whether the statement always returns, so nothing after it is reached */
+static bit is_c_return(expression *expression)
+{
+  switch (expression->tag)
+  {
+  case node_tag_identifier:
+    return expression->data->identifier.declaration == &builtin_declarations[builtin_return];
+  case node_tag_invocation:
+    {
+      struct expression *callee = expression->data->invocation.left;
+      return callee->tag == node_tag_identifier && callee->data->identifier.declaration == &builtin_declarations[builtin_return];
+    }
+  case node_tag_list:
+    return is_c_return(expression->data->list.right);
+  default:
+    return 0;
+  }
+}
+
+static void translate_arm(expression *arm, translator *translator)
+{
+  write_c_indentation(translator);
+  write_c(translator->text, "{\n");
+  ++translator->indentation;
+  translate_statement(arm, translator);
+  --translator->indentation;
+  write_c_indentation(translator);
+  write_c(translator->text, "}\n");
+}
+
+/* conditions of statements may return, so they're translated to `if`s */
+static void translate_condition_statement(expression *expression, bit is_chained, translator *translator)
+{
+  if (!is_chained) write_c_indentation(translator);
+  write_c(translator->text, "if (");
+  translate_expression(expression->data->condition.left, translator);
+  write_c(translator->text, ")\n");
+  translate_arm(expression->data->condition.right, translator);
+
+  struct expression *other = expression->data->condition.other;
+  if (!other || !has_c_effects(other)) return;
+  write_c_indentation(translator);
+  if (other->tag == node_tag_condition || other->tag == node_tag_ternary)
+  {
+    write_c(translator->text, "else ");
+    translate_condition_statement(other, 1, translator);
+    return;
+  }
+  write_c(translator->text, "else\n");
+  translate_arm(other, translator);
+}
+
+void translate_statement(expression *expression, translator *translator)
+{
+  if (!has_c_effects(expression)) return;
+  switch (expression->tag)
+  {
+  case node_tag_declaration:
+    translate_local_declaration(&expression->data->declaration, translator);
+    return;
+  case node_tag_identifier:
+    translate_return(0, translator);
+    return;
+  case node_tag_invocation:
+    {
+      struct expression *callee = expression->data->invocation.left;
+      if (callee->tag != node_tag_identifier || callee->data->identifier.declaration != &builtin_declarations[builtin_return]) break;
+      translate_return(expression->data->invocation.right, translator);
+      return;
+    }
+  case node_tag_condition:
+  case node_tag_ternary:
+    translate_condition_statement(expression, 0, translator);
+    return;
+  case node_tag_list:
+    translate_statement(expression->data->list.left, translator);
+    translate_statement(expression->data->list.right, translator);
+    return;
+  case node_tag_assignment:
+  case node_tag_addition_assignment:
+  case node_tag_subtraction_assignment:
+  case node_tag_multiplication_assignment:
+  case node_tag_division_assignment:
+  case node_tag_modulo_assignment:
+  case node_tag_bitwise_conjunction_assignment:
+  case node_tag_bitwise_disjunction_assignment:
+  case node_tag_bitwise_exclusive_disjunction_assignment:
+  case node_tag_bitwise_left_shift_assignment:
+  case node_tag_bitwise_right_shift_assignment:
+    write_c_indentation(translator);
+    translate_assignment(expression, 1, translator);
+    write_c(translator->text, ";\n");
+    return;
+  default:
+    break;
+  }
+  write_c_indentation(translator);
+  if (expression->tag != node_tag_invocation) write_c(translator->text, "(void)");
+  translate_expression(expression, translator);
+  write_c(translator->text, ";\n");
+}
+
+/*****************************************************************************/
+
+/* the declarations of the arguments, then the results, which are 0 if
+   they're unnamed */
+static void get_c_parameters(procedure_node *procedure, declaration_node **parameters)
+{
+  uint parameters_count = 0;
+  statement *named = procedure->structure.declarations;
+  for (uint i = 0; i < 2; ++i)
+  {
+    expression *items[maximum_parameters_count];
+    uint items_count = 0;
+    flatten_list(items, &items_count, maximum_parameters_count, i ? procedure->results : procedure->arguments);
+    for (uint j = 0; j < items_count && j < maximum_parameters_count; ++j)
+    {
+      bit is_named = items[j]->tag == node_tag_cast && items[j]->data->cast.left->tag == node_tag_identifier && named;
+      parameters[parameters_count++] = is_named ? &named->expression.data->declaration : 0;
+      if (is_named) named = named->next;
+    }
+  }
+}
+
+static void write_c_signature(uint index, translator *translator)
+{
+  c_procedure *procedure = &translator->procedures[index];
+  type_id procedure_type = procedure->procedure->type;
+  declaration_node *parameters[maximum_parameters_count * 2];
+  get_c_parameters(&procedure->procedure->data->procedure, parameters);
+
+  if (!procedure->is_global) write_c(translator->text, "static ");
+  write_c_result_type(procedure_type, translator);
+  write_c(translator->text, " ");
+  write_c_procedure_name(index, translator);
+  write_c(translator->text, "(");
+  type *type = get_type(procedure_type);
+  for (uint i = 0; i < type->arguments_count; ++i)
+  {
+    if (i) write_c(translator->text, ", ");
+    write_c_typed(type->components[i], translator);
+    if (parameters[i]) write_c_identifier(parameters[i]->identifier.runes, translator);
+    else write_c(translator->text, "argument_%u", i);
+  }
+  write_c(translator->text, type->arguments_count ? ")" : "void)");
+}
+
+static void translate_procedure(uint index, translator *translator)
+{
+  translator->text = &translator->prototypes;
+  write_c_signature(index, translator);
+  write_c(translator->text, ";\n");
+  translator->text = &translator->definitions;
+  write_c_signature(index, translator);
+  write_c(translator->text, "\n{\n");
+
+  expression *expression = translator->procedures[index].procedure;
+  procedure_node *node = &expression->data->procedure;
+  type *type = get_type(expression->type);
+  declaration_node *parameters[maximum_parameters_count * 2];
+  get_c_parameters(node, parameters);
+
+  translator->procedure = expression;
+  translator->locals_count = 0;
+  translator->indentation = 1;
+  for (uint i = 0; i < type->arguments_count; ++i)
+    if (parameters[i]) declare_c_local(parameters[i], translator);
+
+  /* the results are variables, which are returned by a bare `return` */
+  uint results_count = get_results_count(expression->type);
+  for (uint i = 0; i < results_count; ++i)
+  {
+    translator->results[i] = parameters[type->arguments_count + i];
+    if (translator->results[i]) declare_c_local(translator->results[i], translator);
+    write_c(translator->text, "  ");
+    write_c_typed(type->components[type->arguments_count + i], translator);
+    write_c_result_name(i, translator);
+    write_c(translator->text, " = ");
+    write_c_zero(type->components[type->arguments_count + i], translator);
+    write_c(translator->text, ";\n");
+  }
+
+  statement *last_statement = 0;
+  for (statement *statement = node->statements; statement; statement = statement->next)
+  {
+    translate_statement(&statement->expression, translator);
+    last_statement = statement;
+  }
+  /* the results are returned by a body that doesn't end returning them */
+  if (results_count && !(last_statement && is_c_return(&last_statement->expression))) translate_return(0, translator);
+  write_c(translator->text, "}\n\n");
+  translator->procedure = 0;
+}
+
+/* runs `main` like `proglosa run`, if its arguments and results are numbers */
+static void write_c_entry(uint index, translator *translator)
+{
+  type_id procedure_type = translator->procedures[index].procedure->type;
+  type *type = get_type(procedure_type);
+  for (uint i = 0; i < type->components_count; ++i)
+    if (!is_scalar(type->components[i]) || get_type(type->components[i])->kind == type_kind_pointer) return;
+
+  c_unit *text = translator->text;
+  uint arguments_count = type->arguments_count, results_count = get_results_count(procedure_type);
+  write_c(text, "int main(int arguments_count, char **arguments)\n{\n");
+  write_c(text, "  if (arguments_count != %u)\n  {\n", arguments_count + 1);
+  write_c(text, "    printf(\"[failure] main takes %u argument%s, but %%d were given.\\n\", arguments_count - 1);\n", arguments_count, arguments_count == 1 ? "" : "s");
+  write_c(text, "    return -1;\n  }\n");
+  if (arguments_count) write_c(text, "  char *ending;\n");
+  for (uint i = 0; i < arguments_count; ++i)
+  {
+    type_id argument_type = type->components[i];
+    write_c(text, "  ");
+    write_c_typed(argument_type, translator);
+    switch (get_type(argument_type)->kind)
+    {
+    case type_kind_float: write_c(text, "argument_%u = strtod(arguments[%u], &ending);\n", i, i + 1); break;
+    case type_kind_bit:   write_c(text, "argument_%u = strtoull(arguments[%u], &ending, 0) != 0;\n", i, i + 1); break;
+    default:
+      write_c(text, "argument_%u = (", i);
+      write_c_type(argument_type, translator);
+      write_c(text, ")strtoull(arguments[%u], &ending, 0);\n", i + 1);
+      break;
+    }
+    write_c(text, "  if (*ending)\n  {\n");
+    write_c(text, "    printf(\"[failure] The argument %u of main isn't a number: %%s\\n\", arguments[%u]);\n", i + 1, i + 1);
+    write_c(text, "    return -1;\n  }\n");
+  }
+
+  write_c(text, "  ");
+  if (results_count)
+  {
+    write_c_result_type(procedure_type, translator);
+    write_c(text, results_count == 1 ? " result = " : " results = ");
+  }
+  write_c_procedure_name(index, translator);
+  write_c(text, "(");
+  for (uint i = 0; i < arguments_count; ++i) write_c(text, i ? ", argument_%u" : "argument_%u", i);
+  write_c(text, ");\n");
+  for (uint i = 0; i < results_count; ++i)
+  {
+    const utf8 *format, *conversion;
+    switch (get_type(type->components[arguments_count + i])->kind)
+    {
+    case type_kind_float:  format = "%g";   conversion = "double";             break;
+    case type_kind_signed: format = "%lld"; conversion = "long long";          break;
+    default:               format = "%llu"; conversion = "unsigned long long"; break;
+    }
+    write_c(text, "  printf(\"%s\\n\", (%s)", format, conversion);
+    if (results_count == 1) write_c(text, "result);\n");
+    else write_c(text, "results.r%u);\n", i);
+  }
+  write_c(text, "  return 0;\n}\n");
+}
+
+/* anonymous structures are interned once before their fields are known */
+static bit is_c_declared_type(type_id id)
+{
+  type *type = get_type(id);
+  if (type->kind == type_kind_procedure) return get_results_count(id) > 1;
+  if (type->kind != type_kind_structure) return 0;
+  return type->declaration || type->components_count == type->structure->declarations_count;
+}
+
+void translate_to_c(program *program, c_unit *unit)
+{
+  zero(unit, sizeof(*unit));
+  translator translator =
+  {
+    .program = program,
+    .text    = unit,
+  };
+
+  write_c(unit, "/* translated by proglosa from %s */\n\n%s\n", program->source_path, c_prelude);
+
+  /* every type is declared before any is defined */
+  translator.structure_states = allocate(types.types_count);
+  zero(translator.structure_states, types.types_count);
+  for (type_id id = 1; id < types.types_count; ++id)
+  {
+    if (!is_c_declared_type(id)) continue;
+    if (get_type(id)->kind == type_kind_procedure) write_c(unit, "typedef struct results_%u results_%u;\n", id, id);
+    else
+    {
+      write_c(unit, "typedef struct ");
+      write_c_type(id, &translator);
+      write_c(unit, " ");
+      write_c_type(id, &translator);
+      write_c(unit, ";\n");
+    }
+  }
+  for (type_id id = 1; id < types.types_count; ++id)
+  {
+    type *type = get_type(id);
+    if (type->kind != type_kind_procedure) continue;
+    write_c(unit, "typedef ");
+    write_c_result_type(id, &translator);
+    write_c(unit, " (*procedure_%u)(", id);
+    for (uint i = 0; i < type->arguments_count; ++i)
+    {
+      if (i) write_c(unit, ", ");
+      write_c_type(type->components[i], &translator);
+    }
+    write_c(unit, type->arguments_count ? ");\n" : "void);\n");
+  }
+  write_c(unit, "\n");
+  for (type_id id = 1; id < types.types_count; ++id)
+    if (is_c_declared_type(id)) define_c_structure(id, &translator);
+  for (type_id id = 1; id < types.types_count; ++id)
+    if (is_c_declared_type(id) && get_element_type(id) != none_type) define_c_vector(id, &translator);
+
+  /* globals are initialized by constants, or else before `main` */
+  for (statement *global = program->global_scope.declarations; global; global = global->next)
+  {
+    declaration_node *declaration = &global->expression.data->declaration;
+    if (is_compile_time_declaration(declaration)) continue;
+    if (is_procedure_declaration(declaration))
+    {
+      get_c_procedure(declaration->assignment, declaration, &translator);
+      continue;
+    }
+
+    expression *assignment = declaration->assignment;
+    bit is_constant = assignment && (is_literal(assignment) || assignment->tag == node_tag_string);
+    translator.text = unit;
+    if (declaration->is_constant && is_constant) write_c(unit, "const ");
+    write_c_typed(declaration->type, &translator);
+    write_c_identifier(declaration->identifier.runes, &translator);
+    if (is_constant)
+    {
+      write_c(unit, " = ");
+      translate_converted(assignment, declaration->type, &translator);
+    }
+    write_c(unit, ";\n");
+    if (!assignment || is_constant) continue;
+
+    translator.text = &translator.initializer;
+    write_c(translator.text, "  ");
+    write_c_identifier(declaration->identifier.runes, &translator);
+    write_c(translator.text, " = ");
+    translate_converted(assignment, declaration->type, &translator);
+    write_c(translator.text, ";\n");
+  }
+
+  for (uint i = 0; i < translator.procedures_count; ++i) translate_procedure(i, &translator);
+
+  translator.text = unit;
+  write_c(unit, "\n");
+  append_c(unit, &translator.prototypes);
+  write_c(unit, "\n");
+  if (translator.initializer.size)
+  {
+    write_c(unit, "__attribute__((constructor)) static void proglosa_initialize_globals(void)\n{\n");
+    append_c(unit, &translator.initializer);
+    write_c(unit, "}\n\n");
+  }
+  append_c(unit, &translator.definitions);
+  for (uint i = 0; i < translator.procedures_count; ++i)
+  {
+    c_procedure *procedure = &translator.procedures[i];
+    if (procedure->is_global && !compare_string(procedure->declaration->identifier.runes, "main")) write_c_entry(i, &translator);
+  }
+
+  release_c(&translator.initializer);
+  deallocate(translator.structure_states, types.types_count);
+  deallocate(translator.procedures, translator.procedures_capacity * sizeof(c_procedure));
+  deallocate(translator.locals, translator.locals_capacity * sizeof(declaration_node *));
+}
+
+void print_c(c_unit *unit)
+{
+  fwrite(unit->text, 1, unit->size, stdout);
+}
+
+void release_c(c_unit *unit)
+{
+  if (unit->text) deallocate(unit->text, unit->capacity);
+  zero(unit, sizeof(*unit));
+}
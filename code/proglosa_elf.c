@@ -0,0 +1,441 @@
+#include "proglosa.h"
+
+/*****************************************************************************/
+
+#if defined(ON_ARCHITECTURE_X64)
+
+typedef struct
+{
+  uint8  identification[16];
+  uint16 type;
+  uint16 machine;
+  uint32 version;
+  uint64 entry;
+  uint64 program_headers_offset;
+  uint64 section_headers_offset;
+  uint32 flags;
+  uint16 header_size;
+  uint16 program_header_size;
+  uint16 program_headers_count;
+  uint16 section_header_size;
+  uint16 section_headers_count;
+  uint16 section_names_index;
+} elf_header;
+
+typedef struct
+{
+  uint32 name;
+  uint32 type;
+  uint64 flags;
+  uint64 address;
+  uint64 offset;
+  uint64 size;
+  uint32 link;
+  uint32 info;
+  uint64 alignment;
+  uint64 entry_size;
+} elf_section_header;
+
+typedef struct
+{
+  uint32 name;
+  uint8  info;
+  uint8  other;
+  uint16 section_index;
+  uint64 value;
+  uint64 size;
+} elf_symbol;
+
+typedef struct
+{
+  uint64 offset;
+  uint64 info;
+  sint64 addend;
+} elf_relocation;
+
+static_assert(sizeof(elf_header) == 64, "");
+static_assert(sizeof(elf_section_header) == 64, "");
+static_assert(sizeof(elf_symbol) == 24, "");
+static_assert(sizeof(elf_relocation) == 24, "");
+
+enum
+{
+  elf_section_type_program_bits = 1,
+  elf_section_type_symbols      = 2,
+  elf_section_type_strings      = 3,
+  elf_section_type_relocations  = 4,
+};
+
+enum
+{
+  elf_section_flag_write       = 0x1,
+  elf_section_flag_allocate    = 0x2,
+  elf_section_flag_execute     = 0x4,
+  elf_section_flag_information = 0x40,
+};
+
+enum
+{
+  elf_binding_local  = 0,
+  elf_binding_global = 1,
+};
+
+enum
+{
+  elf_symbol_type_object   = 1,
+  elf_symbol_type_function = 2,
+  elf_symbol_type_section  = 3,
+  elf_symbol_type_file     = 4,
+};
+
+enum
+{
+  elf_relocation_pc_32  = 2,  /* S + A - P */
+  elf_relocation_plt_32 = 4,  /* L + A - P */
+};
+
+#define elf_absolute_section ((uint16)0xFFF1)
+
+/* the sections of the object, in order */
+enum
+{
+  elf_section_none,
+  elf_section_text,
+  elf_section_data,
+  elf_section_relocations,
+  elf_section_symbols,
+  elf_section_strings,
+  elf_section_names,
+  elf_section_stack_note,
+  elf_sections_count,
+};
+
+/* the fixed symbols, which precede those of the procedures */
+enum
+{
+  elf_symbol_none,
+  elf_symbol_file,
+  elf_symbol_text,
+  elf_symbol_data,
+  elf_symbol_divided_by_zero,
+  elf_fixed_symbols_count,
+};
+
+typedef struct
+{
+  byte *bytes;
+  uint  size;
+  uint  capacity;
+} elf_buffer;
+
+static uint append_elf(elf_buffer *buffer, const void *bytes, uint size)
+{
+  if (buffer->size + size > buffer->capacity)
+  {
+    uint capacity = buffer->capacity ? buffer->capacity * 2 : 4096;
+    while (capacity < buffer->size + size) capacity *= 2;
+    buffer->bytes = reallocate(capacity, buffer->bytes, buffer->capacity);
+    buffer->capacity = capacity;
+  }
+  uint offset = buffer->size;
+  if (bytes) copy(buffer->bytes + offset, bytes, size);
+  else zero(buffer->bytes + offset, size);
+  buffer->size += size;
+  return offset;
+}
+
+static uint append_elf_string(elf_buffer *strings, const utf8 *string)
+{
+  return append_elf(strings, string, get_string_size(string) + 1);
+}
+
+static void align_elf(elf_buffer *buffer, uint alignment)
+{
+  append_elf(buffer, 0, (uint)align_forwards(buffer->size, alignment) - buffer->size);
+}
+
+static void release_elf(elf_buffer *buffer)
+{
+  if (buffer->bytes) deallocate(buffer->bytes, buffer->capacity);
+}
+
+/* writes the failure to the standard output and exits, like `run_bytecode`,
+   by system calls alone, so the object doesn't need a C library */
+static void emit_divided_by_zero_routine(jitter *jitter)
+{
+  static const utf8 message[] = "[failure] Divided by zero.\n";
+  EMIT_RAW(jitter, 0xB8, 0x01, 0x00, 0x00, 0x00);       /* mov eax, 1 (write) */
+  EMIT_RAW(jitter, 0xBF, 0x01, 0x00, 0x00, 0x00);       /* mov edi, 1 */
+  EMIT_RAW(jitter, 0x48, 0x8D, 0x35);                   /* lea rsi, [rip + rel32] */
+  emit_uint32(jitter, 0);
+  uint message_offset_position = jitter->code_size - 4;
+  EMIT_RAW(jitter, 0xBA);                               /* mov edx, imm32 */
+  emit_uint32(jitter, sizeof(message) - 1);
+  EMIT_RAW(jitter, 0x0F, 0x05);                         /* syscall */
+  EMIT_RAW(jitter, 0xB8, 0xE7, 0x00, 0x00, 0x00);       /* mov eax, 231 (exit_group) */
+  EMIT_RAW(jitter, 0xBF, 0x01, 0x00, 0x00, 0x00);       /* mov edi, 1 */
+  EMIT_RAW(jitter, 0x0F, 0x05);                         /* syscall */
+  patch_uint32(jitter, message_offset_position, jitter->code_size - (message_offset_position + 4));
+  emit_bytes(jitter, (const uint8 *)message, sizeof(message) - 1);
+}
+
+static void add_elf_symbol(elf_buffer *symbols, elf_buffer *strings, const utf8 *name, uint binding, uint type, uint16 section_index, uint64 value, uint64 size)
+{
+  elf_symbol symbol =
+  {
+    .name          = name ? append_elf_string(strings, name) : 0,
+    .info          = (uint8)(binding << 4 | type),
+    .section_index = section_index,
+    .value         = value,
+    .size          = size,
+  };
+  append_elf(symbols, &symbol, sizeof(symbol));
+}
+
+/* the global narrowed to its type as it's laid out, like C's; the globals
+   the compiler can't initialize, like structures, are zeroed */
+static void append_global(elf_buffer *data, value global, type_id type_id)
+{
+  type *type = get_type(type_id);
+  align_elf(data, type->alignment ? type->alignment : 1);
+  switch (type->kind)
+  {
+  case type_kind_float:
+    if (type->size == sizeof(float32))
+    {
+      float32 narrowed = (float32)global.decimal;
+      append_elf(data, &narrowed, sizeof(narrowed));
+      return;
+    }
+    /* fall through */
+  case type_kind_signed:
+  case type_kind_unsigned:
+  case type_kind_bit:
+  case type_kind_pointer:
+    /* the low bytes, since the target is little-endian */
+    append_elf(data, &global, get_minimum(type->size, (uint)sizeof(global)));
+    return;
+  default:
+    append_elf(data, 0, type->size);
+    return;
+  }
+}
+
+bit write_object(program *program, bytecode *bytecode, const utf8 *path)
+{
+  /* the globals are initialized by the compiler, and their values are the
+     object's data */
+  if (!run_bytecode(0, 0, 0, bytecode)) return 0;
+
+  uint procedures_count = bytecode->procedures_count;
+  bit *is_jittable = find_jittable_procedures(bytecode);
+  uint *entries = allocate(procedures_count * sizeof(uint));
+  uint *endings = allocate(procedures_count * sizeof(uint));
+  uint *symbols_of_procedures = allocate(procedures_count * sizeof(uint));
+
+  jitter jitter =
+  {
+    .bytecode       = bytecode,
+    .is_relocatable = 1,
+  };
+  for (uint i = 1; i < procedures_count; ++i)
+  {
+    if (!is_jittable[i])
+    {
+      if (bytecode->procedures[i].declaration && reporting.minimum_type <= reporting_type_comment)
+        print_comment("%s isn't compiled to machine code, so it isn't written.\n", bytecode->procedures[i].declaration->identifier.runes);
+      continue;
+    }
+    entries[i] = jitter.code_size;
+    compile_jitted_procedure(i, &jitter);
+    endings[i] = jitter.code_size;
+  }
+  uint divided_by_zero_entry = jitter.code_size;
+  emit_divided_by_zero_routine(&jitter);
+
+  /* the globals are laid out like C's, each at its alignment */
+  elf_buffer data = {0};
+  uint *global_offsets = allocate(get_maximum(bytecode->globals_count, 1) * sizeof(uint));
+  uint data_alignment = 8;
+  for (uint i = 0; i < bytecode->globals_count; ++i)
+  {
+    type *type = get_type(bytecode->global_types[i]);
+    append_global(&data, bytecode->globals[i], bytecode->global_types[i]);
+    global_offsets[i] = data.size - type->size;
+    data_alignment = get_maximum(data_alignment, type->alignment);
+  }
+
+  /* the local symbols precede the global ones */
+  elf_buffer strings = {0}, symbols = {0}, relocations = {0};
+  append_elf(&strings, "", 1);
+  append_elf(&symbols, 0, sizeof(elf_symbol));
+  add_elf_symbol(&symbols, &strings, program->source_path, elf_binding_local, elf_symbol_type_file, elf_absolute_section, 0, 0);
+  add_elf_symbol(&symbols, &strings, 0, elf_binding_local, elf_symbol_type_section, elf_section_text, 0, 0);
+  add_elf_symbol(&symbols, &strings, 0, elf_binding_local, elf_symbol_type_section, elf_section_data, 0, 0);
+  add_elf_symbol(&symbols, &strings, "proglosa_divided_by_zero", elf_binding_local, elf_symbol_type_function, elf_section_text,
+                 divided_by_zero_entry, jitter.code_size - divided_by_zero_entry);
+  for (uint binding = elf_binding_local; binding <= elf_binding_global; ++binding)
+  {
+    for (uint i = 1; i < procedures_count; ++i)
+    {
+      declaration_node *declaration = bytecode->procedures[i].declaration;
+      if (!is_jittable[i] || is_global_declaration(declaration, program) != (binding == elf_binding_global)) continue;
+      symbols_of_procedures[i] = symbols.size / sizeof(elf_symbol);
+      add_elf_symbol(&symbols, &strings, declaration->identifier.runes, binding, elf_symbol_type_function, elf_section_text,
+                     entries[i], endings[i] - entries[i]);
+    }
+  }
+  uint first_global_symbol = elf_fixed_symbols_count;
+  for (uint i = 1; i < procedures_count; ++i)
+    if (is_jittable[i] && !is_global_declaration(bytecode->procedures[i].declaration, program)) ++first_global_symbol;
+  for (statement *global = program->global_scope.declarations; global; global = global->next)
+  {
+    declaration_node *declaration = &global->expression.data->declaration;
+    if (is_compile_time_declaration(declaration) || is_procedure_declaration(declaration) || !declaration->slot) continue;
+    add_elf_symbol(&symbols, &strings, declaration->identifier.runes, elf_binding_global, elf_symbol_type_object, elf_section_data,
+                   global_offsets[declaration->slot - 1], get_type(declaration->type)->size);
+  }
+
+  for (uint i = 0; i < jitter.calls_count; ++i)
+  {
+    fixup *call = &jitter.calls[i];
+    uint symbol = call->target == procedures_count ? elf_symbol_divided_by_zero : symbols_of_procedures[call->target];
+    elf_relocation relocation = { call->position, (uint64)symbol << 32 | elf_relocation_plt_32, -4 };
+    append_elf(&relocations, &relocation, sizeof(relocation));
+  }
+  for (uint i = 0; i < jitter.addresses_count; ++i)
+  {
+    fixup *address = &jitter.addresses[i];
+    elf_relocation relocation = { address->position, (uint64)elf_symbol_data << 32 | elf_relocation_pc_32, (sint64)global_offsets[address->target] - 4 };
+    append_elf(&relocations, &relocation, sizeof(relocation));
+  }
+
+  /* the sections follow the header, and precede their headers */
+  elf_buffer image = {0}, names = {0};
+  append_elf(&image, 0, sizeof(elf_header));
+  append_elf(&names, "", 1);
+  elf_section_header headers[elf_sections_count] = {0};
+
+  align_elf(&image, 16);
+  headers[elf_section_text] = (elf_section_header)
+  {
+    .name      = append_elf_string(&names, ".text"),
+    .type      = elf_section_type_program_bits,
+    .flags     = elf_section_flag_allocate | elf_section_flag_execute,
+    .offset    = append_elf(&image, jitter.code, jitter.code_size),
+    .size      = jitter.code_size,
+    .alignment = 16,
+  };
+  align_elf(&image, data_alignment);
+  headers[elf_section_data] = (elf_section_header)
+  {
+    .name      = append_elf_string(&names, ".data"),
+    .type      = elf_section_type_program_bits,
+    .flags     = elf_section_flag_write | elf_section_flag_allocate,
+    .offset    = append_elf(&image, data.bytes, data.size),
+    .size      = data.size,
+    .alignment = data_alignment,
+  };
+  align_elf(&image, 8);
+  headers[elf_section_relocations] = (elf_section_header)
+  {
+    .name       = append_elf_string(&names, ".rela.text"),
+    .type       = elf_section_type_relocations,
+    .flags      = elf_section_flag_information,
+    .offset     = append_elf(&image, relocations.bytes, relocations.size),
+    .size       = relocations.size,
+    .link       = elf_section_symbols,
+    .info       = elf_section_text,
+    .alignment  = 8,
+    .entry_size = sizeof(elf_relocation),
+  };
+  align_elf(&image, 8);
+  headers[elf_section_symbols] = (elf_section_header)
+  {
+    .name       = append_elf_string(&names, ".symtab"),
+    .type       = elf_section_type_symbols,
+    .offset     = append_elf(&image, symbols.bytes, symbols.size),
+    .size       = symbols.size,
+    .link       = elf_section_strings,
+    .info       = first_global_symbol,
+    .alignment  = 8,
+    .entry_size = sizeof(elf_symbol),
+  };
+  headers[elf_section_strings] = (elf_section_header)
+  {
+    .name      = append_elf_string(&names, ".strtab"),
+    .type      = elf_section_type_strings,
+    .offset    = append_elf(&image, strings.bytes, strings.size),
+    .size      = strings.size,
+    .alignment = 1,
+  };
+
+  /* the stack isn't executable */
+  headers[elf_section_stack_note] = (elf_section_header)
+  {
+    .name      = append_elf_string(&names, ".note.GNU-stack"),
+    .type      = elf_section_type_program_bits,
+    .offset    = image.size,
+    .alignment = 1,
+  };
+  headers[elf_section_names] = (elf_section_header)
+  {
+    .name      = append_elf_string(&names, ".shstrtab"),
+    .type      = elf_section_type_strings,
+    .alignment = 1,
+  };
+  headers[elf_section_names].offset = append_elf(&image, names.bytes, names.size);
+  headers[elf_section_names].size = names.size;
+
+  align_elf(&image, 8);
+  uint section_headers_offset = append_elf(&image, headers, sizeof(headers));
+  elf_header header =
+  {
+    .identification         = { 0x7F, 'E', 'L', 'F', 2 /* 64 bits */, 1 /* little endian */, 1 /* version */ },
+    .type                   = 1, /* relocatable */
+    .machine                = 62, /* x86-64 */
+    .version                = 1,
+    .section_headers_offset = section_headers_offset,
+    .header_size            = sizeof(elf_header),
+    .section_header_size    = sizeof(elf_section_header),
+    .section_headers_count  = elf_sections_count,
+    .section_names_index    = elf_section_names,
+  };
+  copy(image.bytes, &header, sizeof(header));
+
+  handle object_handle = create_file(path);
+  bit is_written = write_to_file(image.bytes, image.size, object_handle) == image.size;
+  close_file(object_handle);
+  if (!is_written) print_failure("Failed to write %s.\n", path);
+
+  release_elf(&image);
+  release_elf(&names);
+  release_elf(&strings);
+  release_elf(&symbols);
+  release_elf(&relocations);
+  release_elf(&data);
+  deallocate(global_offsets, get_maximum(bytecode->globals_count, 1) * sizeof(uint));
+  deallocate(symbols_of_procedures, procedures_count * sizeof(uint));
+  deallocate(endings, procedures_count * sizeof(uint));
+  deallocate(entries, procedures_count * sizeof(uint));
+  deallocate(is_jittable, procedures_count);
+  if (jitter.code)      deallocate(jitter.code, jitter.code_capacity);
+  if (jitter.positions) deallocate(jitter.positions, jitter.positions_capacity * sizeof(uint));
+  if (jitter.jumps)     deallocate(jitter.jumps, jitter.jumps_capacity * sizeof(fixup));
+  if (jitter.calls)     deallocate(jitter.calls, jitter.calls_capacity * sizeof(fixup));
+  if (jitter.addresses) deallocate(jitter.addresses, jitter.addresses_capacity * sizeof(fixup));
+  return is_written;
+}
+
+#else
+
+bit write_object(program *program, bytecode *bytecode, const utf8 *path)
+{
+  (void)program;
+  (void)bytecode;
+  (void)path;
+  print_failure("Writing objects isn't supported on this architecture.\n");
+  return 0;
+}
+
+#endif
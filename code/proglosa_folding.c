@@ -0,0 +1,402 @@
+#include "proglosa.h"
+
+/*****************************************************************************/
+
+typedef struct
+{
+  program *program;
+} folder;
+
+static bit is_literal(expression *expression)
+{
+  return expression->tag == node_tag_digital || expression->tag == node_tag_decimal;
+}
+
+static bit is_signed(type_id id)
+{
+  type_kind kind = get_type(id)->kind;
+  return kind == type_kind_signed || kind == type_kind_integer;
+}
+
+static bit is_floating(type_id id)
+{
+  type_kind kind = get_type(id)->kind;
+  return kind == type_kind_float || kind == type_kind_decimal;
+}
+
+static float64 get_literal_decimal(expression *literal)
+{
+  if (literal->tag == node_tag_decimal) return literal->data->decimal.value;
+  uint64 value = literal->data->digital.value;
+  return is_signed(literal->type) ? (float64)(sint64)value : (float64)value;
+}
+
+static uint64 get_literal_integer(expression *literal)
+{
+  if (literal->tag == node_tag_digital) return literal->data->digital.value;
+  float64 value = literal->data->decimal.value;
+  return value < 0 ? (uint64)(sint64)value : (uint64)value;
+}
+
+static bit is_literal_true(expression *literal)
+{
+  return literal->tag == node_tag_decimal ? literal->data->decimal.value != 0 : literal->data->digital.value != 0;
+}
+
+/* wraps an integer to the size of its type, and extends its sign */
+static uint64 normalize_integer(uint64 value, type_id id)
+{
+  type *type = get_type(id);
+  if (type->kind == type_kind_bit) return value != 0;
+  if (!type->size || type->size >= sizeof(uint64)) return value;
+  uint bits_count = type->size * 8;
+  value &= ((uint64)1 << bits_count) - 1;
+  if (type->kind == type_kind_signed && value >> (bits_count - 1)) value |= ~(uint64)0 << bits_count;
+  return value;
+}
+
+/* replaces an expression with a literal of its type; every node that may be
+   folded is at least as large as a literal */
+static void set_integer(expression *expression, uint64 value)
+{
+  expression->tag = node_tag_digital;
+  expression->data->digital.value = normalize_integer(value, expression->type);
+}
+
+static void set_decimal(expression *expression, float64 value)
+{
+  if (get_type(expression->type)->size == sizeof(float32)) value = (float32)value;
+  expression->tag = node_tag_decimal;
+  expression->data->decimal.value = value;
+}
+
+/* the conversions of `check_conversion` and casts, of literals */
+static void convert_literal(expression *literal, type_id to, folder *folder)
+{
+  if (!is_literal(literal) || to == none_type || literal->type == to) return;
+  switch (get_type(to)->kind)
+  {
+  case type_kind_float:
+  case type_kind_decimal:
+    {
+      float64 value = get_literal_decimal(literal);
+      literal->type = to;
+      set_decimal(literal, value);
+      break;
+    }
+  case type_kind_integer:
+  case type_kind_unsigned:
+  case type_kind_signed:
+  case type_kind_bit:
+    {
+      uint64 value = get_literal_integer(literal);
+      bit is_exact = literal->tag == node_tag_digital;
+      literal->type = to;
+      set_integer(literal, value);
+      if (is_exact && literal->data->digital.value != value && get_type(to)->kind != type_kind_bit)
+      {
+        utf8 representation[type_representation_size];
+        report_expression_caution(folder->program, literal, "The constant overflows %s.", represent_type(representation, type_representation_size, to));
+      }
+      break;
+    }
+  default:
+    break;
+  }
+}
+
+/* a literal operand of a folded node is referred to by nothing else, so a
+   pooled one is given back; at least its literal's slots were taken */
+static void forget_operand(expression *operand, folder *folder)
+{
+  slot_pool *nodes = &folder->program->nodes;
+  if (!has_slots(operand, nodes)) return;
+  give_slots(operand, sizeof(struct expression) + node_sizes[operand->tag], nodes);
+}
+
+static void fold_unary(expression *expression, folder *folder)
+{
+  struct expression *operand = expression->data->unary.expression;
+  if (!is_literal(operand)) return;
+  switch (expression->tag)
+  {
+  case node_tag_negation:
+    set_integer(expression, !is_literal_true(operand));
+    break;
+  case node_tag_positive:
+    if (is_floating(expression->type)) set_decimal(expression, get_literal_decimal(operand));
+    else set_integer(expression, get_literal_integer(operand));
+    break;
+  case node_tag_negative:
+    if (is_floating(expression->type)) set_decimal(expression, -get_literal_decimal(operand));
+    else set_integer(expression, -get_literal_integer(operand));
+    break;
+  case node_tag_bitwise_negation:
+    set_integer(expression, ~get_literal_integer(operand));
+    break;
+  default:
+    break;
+  }
+  (void)folder;
+}
+
+static void fold_comparison(expression *expression)
+{
+  struct expression *left = expression->data->binary.left, *right = expression->data->binary.right;
+  sint ordering;
+  if (left->tag == node_tag_decimal || right->tag == node_tag_decimal)
+  {
+    float64 left_value = get_literal_decimal(left), right_value = get_literal_decimal(right);
+    ordering = (left_value > right_value) - (left_value < right_value);
+  }
+  else if (is_signed(left->type) && is_signed(right->type))
+  {
+    sint64 left_value = (sint64)left->data->digital.value, right_value = (sint64)right->data->digital.value;
+    ordering = (left_value > right_value) - (left_value < right_value);
+  }
+  else
+  {
+    uint64 left_value = left->data->digital.value, right_value = right->data->digital.value;
+    ordering = (left_value > right_value) - (left_value < right_value);
+  }
+
+  bit result = 0;
+  switch (expression->tag)
+  {
+  case node_tag_equality:          result = ordering == 0; break;
+  case node_tag_inequality:        result = ordering != 0; break;
+  case node_tag_greater:           result = ordering >  0; break;
+  case node_tag_lesser:            result = ordering <  0; break;
+  case node_tag_inclusive_greater: result = ordering >= 0; break;
+  case node_tag_inclusive_lesser:  result = ordering <= 0; break;
+  default: UNREACHABLE();
+  }
+  set_integer(expression, result);
+}
+
+static void fold_binary(expression *expression, folder *folder)
+{
+  struct expression *left = expression->data->binary.left, *right = expression->data->binary.right;
+  if (!is_literal(left) || !is_literal(right)) return;
+  switch (expression->tag)
+  {
+  case node_tag_equality:
+  case node_tag_inequality:
+  case node_tag_greater:
+  case node_tag_lesser:
+  case node_tag_inclusive_greater:
+  case node_tag_inclusive_lesser:
+    fold_comparison(expression);
+    return;
+  case node_tag_conjunction:
+    set_integer(expression, is_literal_true(left) && is_literal_true(right));
+    return;
+  case node_tag_disjunction:
+    set_integer(expression, is_literal_true(left) || is_literal_true(right));
+    return;
+  default:
+    break;
+  }
+
+  if (is_floating(expression->type))
+  {
+    float64 left_value = get_literal_decimal(left), right_value = get_literal_decimal(right);
+    switch (expression->tag)
+    {
+    case node_tag_addition:       set_decimal(expression, left_value + right_value); break;
+    case node_tag_subtraction:    set_decimal(expression, left_value - right_value); break;
+    case node_tag_multiplication: set_decimal(expression, left_value * right_value); break;
+    case node_tag_division:       set_decimal(expression, left_value / right_value); break;
+    default: break;
+    }
+    return;
+  }
+
+  uint64 left_value = get_literal_integer(left), right_value = get_literal_integer(right);
+  bit is_signed_operation = is_signed(expression->type);
+  switch (expression->tag)
+  {
+  case node_tag_addition:       set_integer(expression, left_value + right_value); break;
+  case node_tag_subtraction:    set_integer(expression, left_value - right_value); break;
+  case node_tag_multiplication: set_integer(expression, left_value * right_value); break;
+  case node_tag_division:
+  case node_tag_modulo:
+    {
+      if (!right_value)
+      {
+        report_expression_failure(folder->program, expression, "Divided by zero.");
+        break;
+      }
+      /* the quotient of the least number by -1 overflows */
+      if (is_signed_operation && right_value == ~(uint64)0)
+      {
+        set_integer(expression, expression->tag == node_tag_division ? -left_value : 0);
+        break;
+      }
+      uint64 result;
+      if (is_signed_operation)
+        result = expression->tag == node_tag_division ? (uint64)((sint64)left_value / (sint64)right_value) : (uint64)((sint64)left_value % (sint64)right_value);
+      else result = expression->tag == node_tag_division ? left_value / right_value : left_value % right_value;
+      set_integer(expression, result);
+      break;
+    }
+  case node_tag_bitwise_conjunction:           set_integer(expression, left_value & right_value); break;
+  case node_tag_bitwise_disjunction:           set_integer(expression, left_value | right_value); break;
+  case node_tag_bitwise_exclusive_disjunction: set_integer(expression, left_value ^ right_value); break;
+  case node_tag_bitwise_left_shift:
+    set_integer(expression, right_value < 64 ? left_value << right_value : 0);
+    break;
+  case node_tag_bitwise_right_shift:
+    if (right_value > 63) right_value = 63 + !is_signed_operation;
+    if (right_value == 64) set_integer(expression, 0);
+    else set_integer(expression, is_signed_operation ? (uint64)((sint64)left_value >> right_value) : left_value >> right_value);
+    break;
+  default:
+    break;
+  }
+}
+
+static void fold_declaration(declaration_node *declaration, folder *folder);
+
+static void fold_expression(expression *expression, folder *folder)
+{
+  if (!expression) return;
+  switch (node_families[expression->tag])
+  {
+  case node_family_leaf:
+    {
+      if (expression->tag != node_tag_identifier) break;
+      declaration_node *declaration = expression->data->identifier.declaration;
+      if (!declaration || !declaration->is_constant || get_builtin(declaration) >= 0) break;
+      fold_declaration(declaration, folder);
+      struct expression *assignment = declaration->assignment;
+      if (!assignment || !is_literal(assignment)) break;
+      expression->tag = assignment->tag;
+      copy(expression->data, assignment->data, node_sizes[assignment->tag]);
+      break;
+    }
+  case node_family_unary:
+    {
+      if (expression->tag == node_tag_reference) break; /* of a variable or a type */
+      /* the operand is read first, since the literal is written over it */
+      struct expression *operand = expression->data->unary.expression;
+      fold_expression(operand, folder);
+      fold_unary(expression, folder);
+      if (is_literal(expression)) forget_operand(operand, folder);
+      break;
+    }
+  case node_family_binary:
+    switch (expression->tag)
+    {
+    case node_tag_assignment:
+    case node_tag_addition_assignment:
+    case node_tag_subtraction_assignment:
+    case node_tag_multiplication_assignment:
+    case node_tag_division_assignment:
+    case node_tag_modulo_assignment:
+    case node_tag_bitwise_conjunction_assignment:
+    case node_tag_bitwise_disjunction_assignment:
+    case node_tag_bitwise_exclusive_disjunction_assignment:
+    case node_tag_bitwise_left_shift_assignment:
+    case node_tag_bitwise_right_shift_assignment:
+      fold_expression(expression->data->binary.right, folder);
+      convert_literal(expression->data->binary.right, expression->data->binary.left->type, folder);
+      break;
+    case node_tag_resolution:
+      fold_expression(expression->data->resolution.left, folder);
+      break;
+    case node_tag_cast:
+      {
+        struct expression *value = expression->data->cast.left;
+        fold_expression(value, folder);
+        if (!is_literal(value)) break;
+        type_id to = expression->type;
+        expression->tag = value->tag;
+        expression->type = value->type;
+        copy(expression->data, value->data, node_sizes[value->tag]);
+        convert_literal(expression, to, folder);
+        forget_operand(value, folder);
+        break;
+      }
+    case node_tag_invocation:
+      fold_expression(expression->data->invocation.right, folder);
+      break;
+    default:
+      fold_expression(expression->data->binary.left, folder);
+      fold_expression(expression->data->binary.right, folder);
+      {
+        struct expression *left = expression->data->binary.left, *right = expression->data->binary.right;
+        fold_binary(expression, folder);
+        if (!is_literal(expression)) break;
+        forget_operand(left, folder);
+        forget_operand(right, folder);
+      }
+      break;
+    }
+    break;
+  case node_family_ternary:
+    {
+      struct expression *condition = expression->data->condition.left;
+      struct expression *consequent = expression->data->condition.right;
+      struct expression *alternative = expression->data->condition.other;
+      fold_expression(condition, folder);
+      fold_expression(consequent, folder);
+      fold_expression(alternative, folder);
+      if (!alternative || !is_literal(condition)) break;
+      struct expression *chosen = is_literal_true(condition) ? consequent : alternative;
+      if (!is_literal(chosen)) break;
+      type_id type = expression->type;
+      expression->tag = chosen->tag;
+      expression->type = chosen->type;
+      copy(expression->data, chosen->data, node_sizes[chosen->tag]);
+      convert_literal(expression, type, folder);
+      break;
+    }
+  case node_family_scoped:
+    switch (expression->tag)
+    {
+    case node_tag_declaration:
+      fold_declaration(&expression->data->declaration, folder);
+      break;
+    case node_tag_structure:
+      for (statement *declaration = expression->data->structure.declarations; declaration; declaration = declaration->next)
+        fold_declaration(&declaration->expression.data->declaration, folder);
+      break;
+    case node_tag_procedure:
+      {
+        procedure_node *procedure = &expression->data->procedure;
+        for (statement *parameter = procedure->structure.declarations; parameter; parameter = parameter->next)
+          fold_declaration(&parameter->expression.data->declaration, folder);
+        for (statement *statement = procedure->statements; statement; statement = statement->next)
+          fold_expression(&statement->expression, folder);
+        break;
+      }
+    default:
+      break;
+    }
+    break;
+  }
+}
+
+void fold_declaration(declaration_node *declaration, folder *folder)
+{
+  /* marked beforehand, since procedures may refer to themselves */
+  if (declaration->is_folded) return;
+  declaration->is_folded = 1;
+
+  if (declaration->type_definition && declaration->type_definition->tag == node_tag_structure)
+    fold_expression(declaration->type_definition, folder);
+  if (!declaration->assignment || declaration->denoted_type != none_type || is_generic_declaration(declaration)) return;
+  fold_expression(declaration->assignment, folder);
+  convert_literal(declaration->assignment, declaration->type, folder);
+}
+
+void fold_constants(program *program)
+{
+  folder folder =
+  {
+    .program = program,
+  };
+  for (statement *declaration = program->global_scope.declarations; declaration; declaration = declaration->next)
+    fold_declaration(&declaration->expression.data->declaration, &folder);
+}
@@ -0,0 +1,1581 @@
+#include "proglosa.h"
+
+/*****************************************************************************/
+
+#define no_ir_value ((uint)0)
+#define no_ir_block ((uint)0)
+
+/* procedures of at most this many values, and no calls, are inlined */
+#define ir_inlining_threshold ((uint)32)
+
+#define ir_optimization_rounds_count ((uint)4)
+
+static uint add_ir_operands(ir_procedure *procedure, uint count)
+{
+  if (procedure->operands_count + count > procedure->operands_capacity)
+  {
+    uint capacity = procedure->operands_capacity ? procedure->operands_capacity * 2 : 256;
+    while (capacity < procedure->operands_count + count) capacity *= 2;
+    procedure->operands = reallocate(capacity * sizeof(uint), procedure->operands, procedure->operands_capacity * sizeof(uint));
+    procedure->operands_capacity = capacity;
+  }
+  uint offset = procedure->operands_count;
+  procedure->operands_count += count;
+  return offset;
+}
+
+static uint add_ir_block(ir_procedure *procedure)
+{
+  if (procedure->blocks_count == procedure->blocks_capacity)
+  {
+    uint capacity = procedure->blocks_capacity ? procedure->blocks_capacity * 2 : 16;
+    procedure->blocks = reallocate(capacity * sizeof(ir_block), procedure->blocks, procedure->blocks_capacity * sizeof(ir_block));
+    procedure->blocks_capacity = capacity;
+  }
+  uint index = procedure->blocks_count++;
+  zero(&procedure->blocks[index], sizeof(ir_block));
+  return index;
+}
+
+/* appends a value to a block */
+static uint add_ir_value(ir_procedure *procedure, uint block, ir_kind kind, type_id type, uint operands_count)
+{
+  if (procedure->values_count == procedure->values_capacity)
+  {
+    uint capacity = procedure->values_capacity ? procedure->values_capacity * 2 : 64;
+    procedure->values = reallocate(capacity * sizeof(ir_value), procedure->values, procedure->values_capacity * sizeof(ir_value));
+    procedure->values_capacity = capacity;
+  }
+  uint index = procedure->values_count++;
+  procedure->values[index] = (ir_value)
+  {
+    .kind           = (uint8)kind,
+    .type           = type,
+    .block          = block,
+    .operands       = add_ir_operands(procedure, operands_count),
+    .operands_count = operands_count,
+  };
+
+  ir_block *appended = &procedure->blocks[block];
+  if (appended->last_value) procedure->values[appended->last_value].next = index;
+  else appended->first_value = index;
+  appended->last_value = index;
+  return index;
+}
+
+static void initialize_ir_procedure(ir_procedure *procedure)
+{
+  /* the null value and block */
+  add_ir_block(procedure);
+  procedure->values = reallocate(64 * sizeof(ir_value), 0, 0);
+  procedure->values_capacity = 64;
+  procedure->values_count = 1;
+  zero(&procedure->values[0], sizeof(ir_value));
+  procedure->values[0].is_dead = 1;
+  procedure->blocks[0].is_dead = 1;
+}
+
+/* returns the value that replaced a value, if any */
+static uint resolve_ir_value(ir_procedure *procedure, uint index)
+{
+  uint resolved = index;
+  while (procedure->values[resolved].replacement) resolved = procedure->values[resolved].replacement;
+  while (procedure->values[index].replacement)
+  {
+    uint next = procedure->values[index].replacement;
+    if (next != resolved) procedure->values[index].replacement = resolved;
+    index = next;
+  }
+  return resolved;
+}
+
+static uint get_ir_operand(ir_procedure *procedure, uint value_index, uint operand_index)
+{
+  uint *operand = &procedure->operands[procedure->values[value_index].operands + operand_index];
+  *operand = resolve_ir_value(procedure, *operand);
+  return *operand;
+}
+
+static void replace_ir_value(ir_procedure *procedure, uint replaced, uint replacement)
+{
+  procedure->values[replaced].replacement = replacement;
+  procedure->values[replaced].is_dead = 1;
+}
+
+/*****************************************************************************/
+
+typedef struct
+{
+  program *program;
+  ir      *ir;
+
+  /* of the lowered procedure */
+  uint               procedure_index;
+  uint               block;           /* being appended to */
+  uint               last_block;      /* in the layout */
+  declaration_node **locals;
+  uint              *variables;       /* the current value of every local */
+  uint               locals_count;
+  uint               locals_capacity;
+  uint               first_result;
+} builder;
+
+/* procedures move as more are referred to */
+static ir_procedure *get_built_procedure(builder *builder)
+{
+  return &builder->ir->procedures[builder->procedure_index];
+}
+
+static void report_unlowerable(expression *expression, builder *builder)
+{
+  report_expression_failure(builder->program, expression, "Lowering %s isn't supported.", node_tag_representations[expression->tag]);
+}
+
+static sint find_ir_local(declaration_node *declaration, builder *builder)
+{
+  for (uint i = builder->locals_count; i--;)
+    if (builder->locals[i] == declaration) return (sint)i;
+  return -1;
+}
+
+static void declare_ir_local(declaration_node *declaration, uint value, builder *builder)
+{
+  if (builder->locals_count == builder->locals_capacity)
+  {
+    uint capacity = builder->locals_capacity ? builder->locals_capacity * 2 : 64;
+    builder->locals = reallocate(capacity * sizeof(declaration_node *), builder->locals, builder->locals_capacity * sizeof(declaration_node *));
+    builder->variables = reallocate(capacity * sizeof(uint), builder->variables, builder->locals_capacity * sizeof(uint));
+    builder->locals_capacity = capacity;
+  }
+  builder->locals[builder->locals_count] = declaration;
+  builder->variables[builder->locals_count] = value;
+  builder->locals_count += 1;
+}
+
+/* procedures are lowered in the order they're first referred to */
+static uint get_ir_procedure(declaration_node *declaration, builder *builder)
+{
+  ir *ir = builder->ir;
+  for (uint i = 1; i < ir->procedures_count; ++i)
+    if (ir->procedures[i].declaration == declaration) return i;
+
+  if (ir->procedures_count == ir->procedures_capacity)
+  {
+    uint capacity = ir->procedures_capacity * 2;
+    ir->procedures = reallocate(capacity * sizeof(ir_procedure), ir->procedures, ir->procedures_capacity * sizeof(ir_procedure));
+    ir->procedures_capacity = capacity;
+  }
+  uint index = ir->procedures_count++;
+  type *type = get_type(declaration->type);
+  ir->procedures[index] = (ir_procedure)
+  {
+    .declaration     = declaration,
+    .type            = declaration->type,
+    .arguments_count = type->arguments_count,
+    .results_count   = type->components_count - type->arguments_count,
+  };
+  return index;
+}
+
+/* starts a block following those of the predecessors that are reachable;
+   it's unreachable if none are */
+static uint start_ir_block(const uint *predecessors, uint predecessors_count, builder *builder)
+{
+  ir_procedure *procedure = get_built_procedure(builder);
+  uint block = add_ir_block(procedure);
+  if (builder->last_block) procedure->blocks[builder->last_block].next = block;
+  builder->last_block = block;
+  builder->block = block;
+
+  uint reachable_count = 0;
+  for (uint i = 0; i < predecessors_count; ++i) reachable_count += !procedure->blocks[predecessors[i]].is_dead;
+  uint offset = add_ir_operands(procedure, reachable_count);
+  for (uint i = 0, j = 0; i < predecessors_count; ++i)
+    if (!procedure->blocks[predecessors[i]].is_dead) procedure->operands[offset + j++] = predecessors[i];
+
+  ir_block *started = &procedure->blocks[block];
+  started->predecessors = offset;
+  started->predecessors_count = reachable_count;
+  started->is_dead = !reachable_count && block != ir_entry_block;
+  return block;
+}
+
+static void end_ir_block(uint block, ir_ending ending, uint condition, uint first_successor, uint second_successor, builder *builder)
+{
+  ir_block *ended = &get_built_procedure(builder)->blocks[block];
+  ended->ending = (uint8)ending;
+  ended->condition = condition;
+  ended->successors[0] = first_successor;
+  ended->successors[1] = second_successor;
+}
+
+static uint add_ir_constant(type_id type, value constant, builder *builder)
+{
+  ir_procedure *procedure = get_built_procedure(builder);
+  uint result = add_ir_value(procedure, builder->block, ir_kind_constant, type, 0);
+  procedure->values[result].constant = constant;
+  return result;
+}
+
+static uint add_ir_operation(operation operation, type_id type, uint b, uint c, uint bits, builder *builder)
+{
+  ir_procedure *procedure = get_built_procedure(builder);
+  uint result = add_ir_value(procedure, builder->block, ir_kind_operation, type, c ? 2 : 1);
+  ir_value *added = &procedure->values[result];
+  added->operation = (uint8)operation;
+  added->bits = (uint8)bits;
+  procedure->operands[added->operands] = b;
+  if (c) procedure->operands[added->operands + 1] = c;
+  return result;
+}
+
+/*****************************************************************************/
+
+/* keeps a value in the domain of its type, like `emit_normalization` */
+static uint build_normalization(uint value, type_id id, builder *builder)
+{
+  type *type = get_type(id);
+  switch (type->kind)
+  {
+  case type_kind_signed:
+    if (type->size < sizeof(uint64)) return add_ir_operation(operation_truncate_signed, id, value, no_ir_value, type->size * 8, builder);
+    break;
+  case type_kind_unsigned:
+    if (type->size < sizeof(uint64)) return add_ir_operation(operation_truncate_unsigned, id, value, no_ir_value, type->size * 8, builder);
+    break;
+  case type_kind_bit:
+    return add_ir_operation(operation_test, id, value, no_ir_value, 0, builder);
+  case type_kind_float:
+    if (type->size == sizeof(float32)) return add_ir_operation(operation_round_float32, id, value, no_ir_value, 0, builder);
+    break;
+  default:
+    break;
+  }
+  return value;
+}
+
+static uint build_conversion(uint value, type_id from, type_id to, builder *builder)
+{
+  operand_class from_class = classify_operand(from), to_class = classify_operand(to);
+  if (is_float_class(from_class) && !is_float_class(to_class))
+  {
+    if (get_type(to)->kind == type_kind_bit) return add_ir_operation(operation_test_float, to, value, no_ir_value, 0, builder);
+    value = add_ir_operation(to_class == operand_class_signed ? operation_convert_float_to_signed : operation_convert_float_to_unsigned, to, value, no_ir_value, 0, builder);
+  }
+  else if (!is_float_class(from_class) && is_float_class(to_class))
+    value = add_ir_operation(from_class == operand_class_signed ? operation_convert_signed_to_float : operation_convert_unsigned_to_float, to, value, no_ir_value, 0, builder);
+  return build_normalization(value, to, builder);
+}
+
+static uint build_expression(expression *expression, builder *builder);
+
+/* returns the expression's value converted to the type */
+static uint build_converted(expression *expression, type_id to, builder *builder)
+{
+  if (expression->tag == node_tag_digital || expression->tag == node_tag_decimal)
+  {
+    value constant;
+    if (is_float_class(classify_operand(to)))
+    {
+      constant.decimal = get_literal_decimal(expression);
+      if (classify_operand(to) == operand_class_float32) constant.decimal = (float32)constant.decimal;
+    }
+    else constant.unsigned_integer = normalize_integer(get_literal_integer(expression), to);
+    return add_ir_constant(to, constant, builder);
+  }
+
+  uint result = build_expression(expression, builder);
+  if (result == no_ir_value || expression->type == to || to == none_type) return result;
+  if (classify_operand(expression->type) == operand_class_unsupported || classify_operand(to) == operand_class_unsupported)
+  {
+    report_unlowerable(expression, builder);
+    return result;
+  }
+  return build_conversion(result, expression->type, to, builder);
+}
+
+/* returns a value of 0 or 1 */
+static uint build_truth(expression *expression, builder *builder)
+{
+  uint result = build_expression(expression, builder);
+  if (result == no_ir_value) return add_ir_constant(types.bit_type, (value){0}, builder);
+  if (get_type(expression->type)->kind == type_kind_bit) return result;
+  operation operation = is_float_class(classify_operand(expression->type)) ? operation_test_float : operation_test;
+  return add_ir_operation(operation, types.bit_type, result, no_ir_value, 0, builder);
+}
+
+static uint build_arithmetic(node_tag tag, type_id type, expression *left, expression *right, expression *expression, builder *builder)
+{
+  operand_class class = classify_operand(type);
+  if (class == operand_class_unsupported)
+  {
+    report_unlowerable(expression, builder);
+    return no_ir_value;
+  }
+  bit is_shift = tag == node_tag_bitwise_left_shift || tag == node_tag_bitwise_right_shift;
+  uint b = build_converted(left, type, builder);
+  uint c = build_converted(right, is_shift ? right->type : type, builder);
+  if (b == no_ir_value || c == no_ir_value) return no_ir_value;
+  uint result = add_ir_operation(get_arithmetic_operation(tag, class), type, b, c, 0, builder);
+  return build_normalization(result, type, builder);
+}
+
+static uint build_comparison(expression *expression, builder *builder)
+{
+  struct expression *left = expression->data->binary.left, *right = expression->data->binary.right;
+  type_id type = get_type(left->type)->kind == type_kind_integer || get_type(left->type)->kind == type_kind_decimal ? right->type : left->type;
+  operand_class class = classify_operand(type);
+  if (class == operand_class_unsupported)
+  {
+    report_unlowerable(expression, builder);
+    return no_ir_value;
+  }
+  uint b = build_converted(left, type, builder);
+  uint c = build_converted(right, type, builder);
+  if (b == no_ir_value || c == no_ir_value) return no_ir_value;
+
+  /* greater comparisons are lesser ones of swapped operands */
+  bit is_float = is_float_class(class), is_signed = class == operand_class_signed;
+  operation operation;
+  switch (expression->tag)
+  {
+  case node_tag_equality:   operation = is_float ? operation_equal_float   : operation_equal;   break;
+  case node_tag_inequality: operation = is_float ? operation_unequal_float : operation_unequal; break;
+  case node_tag_greater:
+    { uint swapped = b; b = c; c = swapped; }
+    /* fallthrough */
+  case node_tag_lesser:
+    operation = is_float ? operation_lesser_float : is_signed ? operation_lesser_signed : operation_lesser_unsigned;
+    break;
+  case node_tag_inclusive_greater:
+    { uint swapped = b; b = c; c = swapped; }
+    /* fallthrough */
+  case node_tag_inclusive_lesser:
+    operation = is_float ? operation_inclusive_lesser_float : is_signed ? operation_inclusive_lesser_signed : operation_inclusive_lesser_unsigned;
+    break;
+  default: UNREACHABLE();
+  }
+  return add_ir_operation(operation, types.bit_type, b, c, 0, builder);
+}
+
+static uint *save_variables(scratch *scratch, builder *builder)
+{
+  uint *saved = push_type(uint, builder->locals_count + 1, scratch->allocator);
+  copy_typed(uint, saved, builder->variables, builder->locals_count);
+  return saved;
+}
+
+/* joins two arms at a new block, where the locals they assign differently,
+   and their values, are chosen by `phi`s */
+static uint merge_arms(const uint ends[2], uint *const arm_variables[2], const uint arm_values[2], type_id type, builder *builder)
+{
+  uint locals_count = builder->locals_count;
+  uint merge = start_ir_block(ends, 2, builder);
+  ir_procedure *procedure = get_built_procedure(builder);
+  for (uint i = 0; i < 2; ++i)
+    if (!procedure->blocks[ends[i]].is_dead) end_ir_block(ends[i], ir_ending_jump, no_ir_value, merge, no_ir_block, builder);
+
+  bit is_reachable[2] = { !procedure->blocks[ends[0]].is_dead, !procedure->blocks[ends[1]].is_dead };
+  if (!is_reachable[0] || !is_reachable[1])
+  {
+    uint arm = is_reachable[0] ? 0 : 1;
+    copy_typed(uint, builder->variables, arm_variables[arm], locals_count);
+    return arm_values[arm];
+  }
+
+  for (uint i = 0; i < locals_count; ++i)
+  {
+    uint first = arm_variables[0][i], second = arm_variables[1][i];
+    if (first == second)
+    {
+      builder->variables[i] = first;
+      continue;
+    }
+    uint phi = add_ir_value(procedure, merge, ir_kind_phi, procedure->values[first].type, 2);
+    procedure = get_built_procedure(builder);
+    procedure->operands[procedure->values[phi].operands]     = first;
+    procedure->operands[procedure->values[phi].operands + 1] = second;
+    builder->variables[i] = phi;
+  }
+
+  if (type == none_type || !arm_values[0] || !arm_values[1]) return arm_values[0] ? arm_values[0] : arm_values[1];
+  if (arm_values[0] == arm_values[1]) return arm_values[0];
+  uint phi = add_ir_value(procedure, merge, ir_kind_phi, type, 2);
+  procedure = get_built_procedure(builder);
+  procedure->operands[procedure->values[phi].operands]     = arm_values[0];
+  procedure->operands[procedure->values[phi].operands + 1] = arm_values[1];
+  return phi;
+}
+
+/* `a && b` and `a || b` evaluate `b` only if needed, so `a` is the value
+   if it isn't */
+static uint build_logical(expression *expression, builder *builder)
+{
+  scratch scratch;
+  get_scratch(&scratch, context.allocator);
+
+  uint left = build_truth(expression->data->binary.left, builder);
+  uint origin = builder->block;
+  uint locals_count = builder->locals_count;
+  uint *origin_variables = save_variables(&scratch, builder);
+
+  uint right_block = start_ir_block(&origin, 1, builder);
+  uint right = build_truth(expression->data->binary.right, builder);
+  builder->locals_count = locals_count;
+  uint ends[2] = { origin, builder->block };
+  uint *arm_variables[2] = { origin_variables, save_variables(&scratch, builder) };
+  uint arm_values[2] = { left, right };
+
+  uint result = merge_arms(ends, arm_variables, arm_values, types.bit_type, builder);
+  uint merge = builder->block;
+  if (expression->tag == node_tag_conjunction) end_ir_block(origin, ir_ending_branch, left, right_block, merge, builder);
+  else end_ir_block(origin, ir_ending_branch, left, merge, right_block, builder);
+  end_scratch(&scratch);
+  return result;
+}
+
+static uint build_arm(expression *expression, type_id type, builder *builder)
+{
+  if (!expression) return no_ir_value;
+  return type != none_type ? build_converted(expression, type, builder) : build_expression(expression, builder);
+}
+
+static uint build_condition(expression *expression, builder *builder)
+{
+  scratch scratch;
+  get_scratch(&scratch, context.allocator);
+
+  type_id type = expression->type;
+  uint condition = build_truth(expression->data->condition.left, builder);
+  uint origin = builder->block;
+  uint locals_count = builder->locals_count;
+  uint *origin_variables = save_variables(&scratch, builder);
+
+  uint consequent = start_ir_block(&origin, 1, builder);
+  uint consequent_value = build_arm(expression->data->condition.right, type, builder);
+  uint consequent_end = builder->block;
+  builder->locals_count = locals_count;
+  uint *consequent_variables = save_variables(&scratch, builder);
+
+  /* without an alternative, the origin branches to the merge */
+  copy_typed(uint, builder->variables, origin_variables, locals_count);
+  uint alternative = no_ir_block;
+  uint alternative_value = no_ir_value;
+  uint alternative_end = origin;
+  if (expression->data->condition.other)
+  {
+    alternative = start_ir_block(&origin, 1, builder);
+    alternative_value = build_arm(expression->data->condition.other, type, builder);
+    alternative_end = builder->block;
+    builder->locals_count = locals_count;
+  }
+  uint ends[2] = { consequent_end, alternative_end };
+  uint *arm_variables[2] = { consequent_variables, save_variables(&scratch, builder) };
+  uint arm_values[2] = { consequent_value, alternative_value };
+
+  uint result = merge_arms(ends, arm_variables, arm_values, type, builder);
+  end_ir_block(origin, ir_ending_branch, condition, consequent, alternative ? alternative : builder->block, builder);
+  end_scratch(&scratch);
+  return result;
+}
+
+/* ends the block, and continues in an unreachable one */
+static void build_return(struct expression *results, builder *builder)
+{
+  ir_procedure *procedure = get_built_procedure(builder);
+  uint results_count = procedure->results_count;
+  uint returned[maximum_parameters_count];
+
+  struct expression *items[maximum_parameters_count];
+  uint items_count = 0;
+  flatten_list(items, &items_count, maximum_parameters_count, results);
+
+  /* a bare `return` returns the named results */
+  if (!items_count)
+    for (uint i = 0; i < results_count; ++i) returned[i] = builder->variables[builder->first_result + i];
+  else
+  {
+    if (items_count > results_count) items_count = results_count;
+    for (uint i = 0; i < items_count; ++i)
+    {
+      type_id result_type = get_type(procedure->type)->components[procedure->arguments_count + i];
+      returned[i] = build_converted(items[i], result_type, builder);
+      if (returned[i] == no_ir_value) returned[i] = add_ir_constant(result_type, (value){0}, builder);
+    }
+    results_count = items_count;
+  }
+
+  procedure = get_built_procedure(builder);
+  uint offset = add_ir_operands(procedure, results_count);
+  copy_typed(uint, &procedure->operands[offset], returned, results_count);
+  ir_block *ended = &procedure->blocks[builder->block];
+  ended->ending = ir_ending_return;
+  ended->results = offset;
+  ended->results_count = results_count;
+  start_ir_block(0, 0, builder);
+}
+
+static uint build_invocation(expression *expression, builder *builder)
+{
+  struct expression *callee = expression->data->invocation.left;
+  if (callee->tag == node_tag_identifier && callee->data->identifier.declaration == &builtin_declarations[builtin_return])
+  {
+    build_return(expression->data->invocation.right, builder);
+    return no_ir_value;
+  }
+
+  declaration_node *declaration = callee->tag == node_tag_identifier ? callee->data->identifier.declaration : 0;
+  if (!declaration || !is_procedure_declaration(declaration))
+  {
+    report_unlowerable(callee, builder);
+    return no_ir_value;
+  }
+  uint procedure_index = get_ir_procedure(declaration, builder);
+  type *procedure_type = get_type(declaration->type);
+
+  struct expression *items[maximum_parameters_count];
+  uint items_count = 0;
+  flatten_list(items, &items_count, maximum_parameters_count, expression->data->invocation.right);
+  uint arguments[maximum_parameters_count];
+  for (uint i = 0; i < items_count; ++i)
+  {
+    arguments[i] = build_converted(items[i], procedure_type->components[i], builder);
+    if (arguments[i] == no_ir_value) return no_ir_value;
+  }
+
+  bit has_value = procedure_type->components_count - procedure_type->arguments_count == 1;
+  type_id result_type = has_value ? procedure_type->components[procedure_type->arguments_count] : none_type;
+  ir_procedure *procedure = get_built_procedure(builder);
+  uint call = add_ir_value(procedure, builder->block, ir_kind_call, result_type, items_count);
+  procedure->values[call].index = procedure_index;
+  copy_typed(uint, &procedure->operands[procedure->values[call].operands], arguments, items_count);
+  return has_value ? call : no_ir_value;
+}
+
+static uint build_assignment(expression *expression, builder *builder)
+{
+  struct expression *left = expression->data->binary.left, *right = expression->data->binary.right;
+  if (left->tag != node_tag_identifier)
+  {
+    report_unlowerable(left, builder);
+    return no_ir_value;
+  }
+  declaration_node *declaration = left->data->identifier.declaration;
+
+  uint assigned;
+  node_tag operation = get_assigned_operation(expression->tag);
+  if (operation == node_tag_assignment) assigned = build_converted(right, left->type, builder);
+  else assigned = build_arithmetic(operation, left->type, left, right, expression, builder);
+  if (assigned == no_ir_value) return no_ir_value;
+
+  sint local = find_ir_local(declaration, builder);
+  if (local >= 0)
+  {
+    builder->variables[local] = assigned;
+    return assigned;
+  }
+  ir_procedure *procedure = get_built_procedure(builder);
+  uint set = add_ir_value(procedure, builder->block, ir_kind_set_global, none_type, 1);
+  procedure->values[set].declaration = declaration;
+  procedure->operands[procedure->values[set].operands] = assigned;
+  return assigned;
+}
+
+uint build_expression(expression *expression, builder *builder)
+{
+  switch (expression->tag)
+  {
+  case node_tag_digital:
+  case node_tag_decimal:
+    return build_converted(expression, expression->type, builder);
+
+  case node_tag_identifier:
+    {
+      declaration_node *declaration = expression->data->identifier.declaration;
+      if (declaration == &builtin_declarations[builtin_return])
+      {
+        build_return(0, builder);
+        return no_ir_value;
+      }
+      sint local = find_ir_local(declaration, builder);
+      if (local >= 0) return builder->variables[local];
+      if (is_procedure_declaration(declaration) || is_type_declaration(declaration) || get_builtin(declaration) >= 0) break;
+      ir_procedure *procedure = get_built_procedure(builder);
+      uint result = add_ir_value(procedure, builder->block, ir_kind_get_global, declaration->type, 0);
+      procedure->values[result].declaration = declaration;
+      return result;
+    }
+
+  case node_tag_positive:
+    return build_expression(expression->data->unary.expression, builder);
+  case node_tag_negative:
+  case node_tag_bitwise_negation:
+    {
+      operand_class class = classify_operand(expression->type);
+      if (class == operand_class_unsupported) break;
+      uint b = build_converted(expression->data->unary.expression, expression->type, builder);
+      if (b == no_ir_value) return no_ir_value;
+      operation operation = expression->tag == node_tag_bitwise_negation ? operation_not
+                          : is_float_class(class) ? operation_negate_float : operation_negate;
+      return build_normalization(add_ir_operation(operation, expression->type, b, no_ir_value, 0, builder), expression->type, builder);
+    }
+  case node_tag_negation:
+    {
+      uint b = build_truth(expression->data->unary.expression, builder);
+      return add_ir_operation(operation_logical_not, types.bit_type, b, no_ir_value, 0, builder);
+    }
+
+  case node_tag_addition:
+  case node_tag_subtraction:
+  case node_tag_multiplication:
+  case node_tag_division:
+  case node_tag_modulo:
+  case node_tag_bitwise_conjunction:
+  case node_tag_bitwise_disjunction:
+  case node_tag_bitwise_exclusive_disjunction:
+  case node_tag_bitwise_left_shift:
+  case node_tag_bitwise_right_shift:
+    return build_arithmetic(expression->tag, expression->type, expression->data->binary.left, expression->data->binary.right, expression, builder);
+
+  case node_tag_equality:
+  case node_tag_inequality:
+  case node_tag_greater:
+  case node_tag_lesser:
+  case node_tag_inclusive_greater:
+  case node_tag_inclusive_lesser:
+    return build_comparison(expression, builder);
+
+  case node_tag_conjunction:
+  case node_tag_disjunction:
+    return build_logical(expression, builder);
+
+  case node_tag_assignment:
+  case node_tag_addition_assignment:
+  case node_tag_subtraction_assignment:
+  case node_tag_multiplication_assignment:
+  case node_tag_division_assignment:
+  case node_tag_modulo_assignment:
+  case node_tag_bitwise_conjunction_assignment:
+  case node_tag_bitwise_disjunction_assignment:
+  case node_tag_bitwise_exclusive_disjunction_assignment:
+  case node_tag_bitwise_left_shift_assignment:
+  case node_tag_bitwise_right_shift_assignment:
+    return build_assignment(expression, builder);
+
+  case node_tag_cast:
+    return build_converted(expression->data->cast.left, expression->type, builder);
+  case node_tag_invocation:
+    return build_invocation(expression, builder);
+  case node_tag_condition:
+  case node_tag_ternary:
+    return build_condition(expression, builder);
+
+  default:
+    break;
+  }
+  report_unlowerable(expression, builder);
+  return no_ir_value;
+}
+
+static void build_statement(expression *expression, builder *builder)
+{
+  if (expression->tag != node_tag_declaration)
+  {
+    build_expression(expression, builder);
+    return;
+  }
+
+  declaration_node *declaration = &expression->data->declaration;
+  if (is_compile_time_declaration(declaration)) return;
+  if (is_procedure_declaration(declaration))
+  {
+    get_ir_procedure(declaration, builder);
+    return;
+  }
+  uint assigned = declaration->assignment ? build_converted(declaration->assignment, declaration->type, builder) : no_ir_value;
+  if (assigned == no_ir_value) assigned = add_ir_constant(declaration->type, (value){0}, builder);
+  declare_ir_local(declaration, assigned, builder);
+}
+
+static void start_building(uint procedure_index, builder *builder)
+{
+  builder->procedure_index = procedure_index;
+  builder->locals_count = 0;
+  builder->last_block = no_ir_block;
+  initialize_ir_procedure(get_built_procedure(builder));
+  start_ir_block(0, 0, builder);
+}
+
+static void build_procedure(uint procedure_index, builder *builder)
+{
+  start_building(procedure_index, builder);
+  ir_procedure *procedure = get_built_procedure(builder);
+  procedure_node *node = &procedure->declaration->assignment->data->procedure;
+
+  /* the arguments, then the results, are the first locals */
+  uint parameter_index = 0;
+  for (statement *parameter = node->structure.declarations; parameter; parameter = parameter->next, ++parameter_index)
+  {
+    declaration_node *declaration = &parameter->expression.data->declaration;
+    uint parameter_value;
+    if (parameter_index < node->arguments_count)
+    {
+      procedure = get_built_procedure(builder);
+      parameter_value = add_ir_value(procedure, builder->block, ir_kind_argument, declaration->type, 0);
+      procedure->values[parameter_value].index = parameter_index;
+    }
+    else parameter_value = add_ir_constant(declaration->type, (value){0}, builder);
+    declare_ir_local(declaration, parameter_value, builder);
+  }
+  builder->first_result = node->arguments_count;
+
+  for (statement *statement = node->statements; statement; statement = statement->next)
+    build_statement(&statement->expression, builder);
+  if (!get_built_procedure(builder)->blocks[builder->block].is_dead) build_return(0, builder);
+}
+
+void compile_ir(program *program, ir *ir)
+{
+  zero(ir, sizeof(*ir));
+  builder builder =
+  {
+    .program = program,
+    .ir      = ir,
+  };
+  ir->procedures_capacity = 16;
+  ir->procedures = reallocate(ir->procedures_capacity * sizeof(ir_procedure), 0, 0);
+  ir->procedures_count = 1;
+  zero(&ir->procedures[0], sizeof(ir_procedure));
+
+  for (statement *global = program->global_scope.declarations; global; global = global->next)
+  {
+    declaration_node *declaration = &global->expression.data->declaration;
+    if (is_procedure_declaration(declaration)) get_ir_procedure(declaration, &builder);
+  }
+
+  /* the globals are initialized in the order they're declared */
+  start_building(0, &builder);
+  for (statement *global = program->global_scope.declarations; global; global = global->next)
+  {
+    declaration_node *declaration = &global->expression.data->declaration;
+    if (is_compile_time_declaration(declaration) || is_procedure_declaration(declaration) || !declaration->assignment) continue;
+    uint assigned = build_converted(declaration->assignment, declaration->type, &builder);
+    if (assigned == no_ir_value) continue;
+    ir_procedure *procedure = get_built_procedure(&builder);
+    uint set = add_ir_value(procedure, builder.block, ir_kind_set_global, none_type, 1);
+    procedure->values[set].declaration = declaration;
+    procedure->operands[procedure->values[set].operands] = assigned;
+  }
+  build_return(0, &builder);
+
+  /* the invoked procedures are appended as they're lowered */
+  for (uint i = 1; i < ir->procedures_count; ++i) build_procedure(i, &builder);
+
+  if (builder.locals)
+  {
+    deallocate(builder.locals, builder.locals_capacity * sizeof(declaration_node *));
+    deallocate(builder.variables, builder.locals_capacity * sizeof(uint));
+  }
+}
+
+void release_ir(ir *ir)
+{
+  for (uint i = 0; i < ir->procedures_count; ++i)
+  {
+    ir_procedure *procedure = &ir->procedures[i];
+    if (procedure->values)   deallocate(procedure->values, procedure->values_capacity * sizeof(ir_value));
+    if (procedure->blocks)   deallocate(procedure->blocks, procedure->blocks_capacity * sizeof(ir_block));
+    if (procedure->operands) deallocate(procedure->operands, procedure->operands_capacity * sizeof(uint));
+  }
+  if (ir->procedures) deallocate(ir->procedures, ir->procedures_capacity * sizeof(ir_procedure));
+  zero(ir, sizeof(*ir));
+}
+
+/*****************************************************************************/
+
+static bit is_ir_constant(ir_procedure *procedure, uint index)
+{
+  return procedure->values[index].kind == ir_kind_constant;
+}
+
+static bit are_ir_constants_equal(ir_procedure *procedure, uint first, uint second)
+{
+  ir_value *a = &procedure->values[first], *b = &procedure->values[second];
+  return a->kind == ir_kind_constant && b->kind == ir_kind_constant && a->type == b->type && a->constant.unsigned_integer == b->constant.unsigned_integer;
+}
+
+/* evaluates an operation of constants like `run_bytecode`, unless it
+   fails */
+static bit evaluate_ir_operation(operation operation, uint bits, value b, value c, value *result)
+{
+  switch (operation)
+  {
+  case operation_add:      result->unsigned_integer = b.unsigned_integer + c.unsigned_integer; break;
+  case operation_subtract: result->unsigned_integer = b.unsigned_integer - c.unsigned_integer; break;
+  case operation_multiply: result->unsigned_integer = b.unsigned_integer * c.unsigned_integer; break;
+  case operation_divide_signed:
+    if (!c.signed_integer) return 0;
+    result->signed_integer = c.signed_integer == -1 ? (sint64)(0 - b.unsigned_integer) : b.signed_integer / c.signed_integer;
+    break;
+  case operation_divide_unsigned:
+    if (!c.unsigned_integer) return 0;
+    result->unsigned_integer = b.unsigned_integer / c.unsigned_integer;
+    break;
+  case operation_modulo_signed:
+    if (!c.signed_integer) return 0;
+    result->signed_integer = c.signed_integer == -1 ? 0 : b.signed_integer % c.signed_integer;
+    break;
+  case operation_modulo_unsigned:
+    if (!c.unsigned_integer) return 0;
+    result->unsigned_integer = b.unsigned_integer % c.unsigned_integer;
+    break;
+  case operation_and:          result->unsigned_integer = b.unsigned_integer & c.unsigned_integer; break;
+  case operation_or:           result->unsigned_integer = b.unsigned_integer | c.unsigned_integer; break;
+  case operation_exclusive_or: result->unsigned_integer = b.unsigned_integer ^ c.unsigned_integer; break;
+  case operation_left_shift:           result->unsigned_integer = c.unsigned_integer < 64 ? b.unsigned_integer << c.unsigned_integer : 0; break;
+  case operation_right_shift_signed:   result->signed_integer = b.signed_integer >> (c.unsigned_integer < 64 ? c.unsigned_integer : 63); break;
+  case operation_right_shift_unsigned: result->unsigned_integer = c.unsigned_integer < 64 ? b.unsigned_integer >> c.unsigned_integer : 0; break;
+
+  case operation_add_float:      result->decimal = b.decimal + c.decimal; break;
+  case operation_subtract_float: result->decimal = b.decimal - c.decimal; break;
+  case operation_multiply_float: result->decimal = b.decimal * c.decimal; break;
+  case operation_divide_float:   result->decimal = b.decimal / c.decimal; break;
+
+  case operation_equal:                     result->unsigned_integer = b.unsigned_integer == c.unsigned_integer; break;
+  case operation_unequal:                   result->unsigned_integer = b.unsigned_integer != c.unsigned_integer; break;
+  case operation_lesser_signed:             result->unsigned_integer = b.signed_integer   <  c.signed_integer;   break;
+  case operation_lesser_unsigned:           result->unsigned_integer = b.unsigned_integer <  c.unsigned_integer; break;
+  case operation_inclusive_lesser_signed:   result->unsigned_integer = b.signed_integer   <= c.signed_integer;   break;
+  case operation_inclusive_lesser_unsigned: result->unsigned_integer = b.unsigned_integer <= c.unsigned_integer; break;
+  case operation_equal_float:               result->unsigned_integer = b.decimal == c.decimal;                   break;
+  case operation_unequal_float:             result->unsigned_integer = b.decimal != c.decimal;                   break;
+  case operation_lesser_float:              result->unsigned_integer = b.decimal <  c.decimal;                   break;
+  case operation_inclusive_lesser_float:    result->unsigned_integer = b.decimal <= c.decimal;                   break;
+
+  case operation_negate:       result->unsigned_integer = 0 - b.unsigned_integer;  break;
+  case operation_negate_float: result->decimal = -b.decimal;                       break;
+  case operation_not:          result->unsigned_integer = ~b.unsigned_integer;     break;
+  case operation_test:         result->unsigned_integer = b.unsigned_integer != 0; break;
+  case operation_test_float:   result->unsigned_integer = b.decimal != 0;          break;
+  case operation_logical_not:  result->unsigned_integer = b.unsigned_integer == 0; break;
+
+  case operation_truncate_signed:           result->signed_integer = (sint64)(b.unsigned_integer << (64 - bits)) >> (64 - bits); break;
+  case operation_truncate_unsigned:         result->unsigned_integer = b.unsigned_integer & (((uint64)1 << bits) - 1);           break;
+  case operation_round_float32:             result->decimal = (float32)b.decimal;                                                break;
+  case operation_convert_signed_to_float:   result->decimal = (float64)b.signed_integer;                                         break;
+  case operation_convert_unsigned_to_float: result->decimal = (float64)b.unsigned_integer;                                       break;
+  case operation_convert_float_to_signed:   result->signed_integer = convert_float_to_signed(b.decimal);                         break;
+  case operation_convert_float_to_unsigned: result->unsigned_integer = convert_float_to_unsigned(b.decimal);                     break;
+
+  default: return 0;
+  }
+  return 1;
+}
+
+/* removes the edge from a predecessor, and the operands the block's `phi`s
+   have for it */
+static void remove_ir_predecessor(ir_procedure *procedure, uint block, uint predecessor)
+{
+  ir_block *removed_from = &procedure->blocks[block];
+  uint *predecessors = &procedure->operands[removed_from->predecessors];
+  uint position = 0;
+  while (position < removed_from->predecessors_count && predecessors[position] != predecessor) ++position;
+  if (position == removed_from->predecessors_count) return;
+  removed_from->predecessors_count -= 1;
+  move(&predecessors[position], &predecessors[position + 1], (removed_from->predecessors_count - position) * sizeof(uint));
+
+  for (uint value = removed_from->first_value; value; value = procedure->values[value].next)
+  {
+    ir_value *phi = &procedure->values[value];
+    if (phi->kind != ir_kind_phi) continue;
+    uint *operands = &procedure->operands[phi->operands];
+    phi->operands_count -= 1;
+    move(&operands[position], &operands[position + 1], (phi->operands_count - position) * sizeof(uint));
+  }
+}
+
+static void kill_ir_block(ir_procedure *procedure, uint block)
+{
+  ir_block *killed = &procedure->blocks[block];
+  killed->is_dead = 1;
+  for (uint value = killed->first_value; value; value = procedure->values[value].next) procedure->values[value].is_dead = 1;
+  if (killed->ending == ir_ending_jump) remove_ir_predecessor(procedure, killed->successors[0], block);
+  else if (killed->ending == ir_ending_branch)
+  {
+    remove_ir_predecessor(procedure, killed->successors[0], block);
+    remove_ir_predecessor(procedure, killed->successors[1], block);
+  }
+}
+
+/* folds the operations of constants, the `phi`s choosing one value, and
+   the branches on constants, whose untaken blocks may become unreachable.
+   blocks follow their predecessors, so one pass reaches a fixpoint. */
+static bit propagate_ir_constants(ir_procedure *procedure)
+{
+  bit has_changed = 0;
+  for (uint block = ir_entry_block; block; block = procedure->blocks[block].next)
+  {
+    ir_block *current = &procedure->blocks[block];
+    if (current->is_dead) continue;
+    if (block != ir_entry_block && !current->predecessors_count)
+    {
+      kill_ir_block(procedure, block);
+      has_changed = 1;
+      continue;
+    }
+
+    for (uint index = current->first_value; index; index = procedure->values[index].next)
+    {
+      ir_value *folded = &procedure->values[index];
+      if (folded->is_dead) continue;
+      if (folded->kind == ir_kind_phi)
+      {
+        uint first = get_ir_operand(procedure, index, 0);
+        bit is_uniform = 1;
+        for (uint i = 1; i < folded->operands_count && is_uniform; ++i)
+        {
+          uint operand = get_ir_operand(procedure, index, i);
+          is_uniform = operand == first || are_ir_constants_equal(procedure, operand, first);
+        }
+        if (!is_uniform) continue;
+        replace_ir_value(procedure, index, first);
+        has_changed = 1;
+      }
+      else if (folded->kind == ir_kind_operation)
+      {
+        uint b = get_ir_operand(procedure, index, 0);
+        uint c = folded->operands_count > 1 ? get_ir_operand(procedure, index, 1) : b;
+        if (!is_ir_constant(procedure, b) || !is_ir_constant(procedure, c)) continue;
+        value result;
+        if (!evaluate_ir_operation(folded->operation, folded->bits, procedure->values[b].constant, procedure->values[c].constant, &result)) continue;
+        folded->kind = ir_kind_constant;
+        folded->constant = result;
+        folded->operands_count = 0;
+        has_changed = 1;
+      }
+      else for (uint i = 0; i < folded->operands_count; ++i) get_ir_operand(procedure, index, i);
+    }
+
+    if (current->ending == ir_ending_branch)
+    {
+      current->condition = resolve_ir_value(procedure, current->condition);
+      if (!is_ir_constant(procedure, current->condition)) continue;
+      bit is_taken = procedure->values[current->condition].constant.unsigned_integer != 0;
+      uint untaken = current->successors[is_taken];
+      current->ending = ir_ending_jump;
+      current->successors[0] = current->successors[!is_taken];
+      current->successors[1] = no_ir_block;
+      current->condition = no_ir_value;
+      remove_ir_predecessor(procedure, untaken, block);
+      has_changed = 1;
+    }
+    else if (current->ending == ir_ending_return)
+      for (uint i = 0; i < current->results_count; ++i)
+      {
+        uint *result = &procedure->operands[current->results + i];
+        *result = resolve_ir_value(procedure, *result);
+      }
+  }
+  return has_changed;
+}
+
+/*****************************************************************************/
+
+/* blocks follow their predecessors, so the dominators of a block's
+   predecessors are found before it's */
+static void find_ir_dominators(ir_procedure *procedure, uint *orders)
+{
+  uint order = 0;
+  for (uint block = ir_entry_block; block; block = procedure->blocks[block].next) orders[block] = order++;
+
+  for (uint block = ir_entry_block; block; block = procedure->blocks[block].next)
+  {
+    ir_block *current = &procedure->blocks[block];
+    if (current->is_dead) continue;
+    uint dominator = no_ir_block;
+    for (uint i = 0; i < current->predecessors_count; ++i)
+    {
+      uint predecessor = procedure->operands[current->predecessors + i];
+      if (!dominator)
+      {
+        dominator = predecessor;
+        continue;
+      }
+      while (dominator != predecessor)
+      {
+        while (orders[dominator] > orders[predecessor]) dominator = procedure->blocks[dominator].dominator;
+        while (orders[predecessor] > orders[dominator]) predecessor = procedure->blocks[predecessor].dominator;
+      }
+    }
+    current->dominator = dominator;
+  }
+}
+
+static bit does_ir_block_dominate(ir_procedure *procedure, uint dominator, uint block)
+{
+  while (block && block != dominator) block = procedure->blocks[block].dominator;
+  return block == dominator;
+}
+
+/* `phi`s are only equivalent in the same block */
+static bit is_pure_ir_value(ir_value *value)
+{
+  return value->kind == ir_kind_constant || value->kind == ir_kind_operation || value->kind == ir_kind_phi;
+}
+
+static uint hash_ir_value(ir_procedure *procedure, uint index)
+{
+  ir_value *hashed = &procedure->values[index];
+  uint hash = 2166136261u;
+  hash = (hash ^ hashed->kind) * 16777619u;
+  hash = (hash ^ hashed->operation) * 16777619u;
+  hash = (hash ^ hashed->bits) * 16777619u;
+  hash = (hash ^ hashed->type) * 16777619u;
+  hash = (hash ^ (uint)hashed->constant.unsigned_integer) * 16777619u;
+  hash = (hash ^ (uint)(hashed->constant.unsigned_integer >> 32)) * 16777619u;
+  if (hashed->kind == ir_kind_phi) hash = (hash ^ hashed->block) * 16777619u;
+  for (uint i = 0; i < hashed->operands_count; ++i) hash = (hash ^ procedure->operands[hashed->operands + i]) * 16777619u;
+  return hash;
+}
+
+static bit are_ir_values_equivalent(ir_procedure *procedure, uint first, uint second)
+{
+  ir_value *a = &procedure->values[first], *b = &procedure->values[second];
+  if (a->kind != b->kind || a->operation != b->operation || a->bits != b->bits || a->type != b->type || a->operands_count != b->operands_count) return 0;
+  if (a->kind == ir_kind_constant) return a->constant.unsigned_integer == b->constant.unsigned_integer;
+  if (a->kind == ir_kind_phi && a->block != b->block) return 0;
+  for (uint i = 0; i < a->operands_count; ++i)
+    if (procedure->operands[a->operands + i] != procedure->operands[b->operands + i]) return 0;
+  return 1;
+}
+
+/* replaces the pure values computed before by a dominating block. the
+   table keeps the latest of equivalent values, since blocks are laid out so
+   the ones a value's block doesn't dominate are never revisited. */
+static bit eliminate_ir_subexpressions(ir_procedure *procedure)
+{
+  scratch scratch;
+  get_scratch(&scratch, context.allocator);
+  uint *orders = push_type(uint, procedure->blocks_count, scratch.allocator);
+  find_ir_dominators(procedure, orders);
+
+  uint slots_count = 16;
+  while (slots_count < procedure->values_count * 2) slots_count *= 2;
+  uint *slots = push_type(uint, slots_count, scratch.allocator);
+  zero(slots, slots_count * sizeof(uint));
+
+  bit has_changed = 0;
+  for (uint block = ir_entry_block; block; block = procedure->blocks[block].next)
+  {
+    if (procedure->blocks[block].is_dead) continue;
+    for (uint value = procedure->blocks[block].first_value; value; value = procedure->values[value].next)
+    {
+      ir_value *current = &procedure->values[value];
+      if (current->is_dead || !is_pure_ir_value(current)) continue;
+      for (uint i = 0; i < current->operands_count; ++i) get_ir_operand(procedure, value, i);
+
+      uint slot = hash_ir_value(procedure, value) & (slots_count - 1);
+      while (slots[slot] && !are_ir_values_equivalent(procedure, slots[slot], value)) slot = (slot + 1) & (slots_count - 1);
+      if (slots[slot] && does_ir_block_dominate(procedure, procedure->values[slots[slot]].block, block))
+      {
+        replace_ir_value(procedure, value, slots[slot]);
+        has_changed = 1;
+      }
+      else slots[slot] = value;
+    }
+  }
+  end_scratch(&scratch);
+  return has_changed;
+}
+
+/*****************************************************************************/
+
+/* divisions are kept for their failures */
+static bit has_ir_effects(ir_procedure *procedure, uint index)
+{
+  ir_value *value = &procedure->values[index];
+  switch (value->kind)
+  {
+  case ir_kind_set_global:
+  case ir_kind_call:
+    return 1;
+  case ir_kind_operation:
+    switch (value->operation)
+    {
+    case operation_divide_signed:
+    case operation_divide_unsigned:
+    case operation_modulo_signed:
+    case operation_modulo_unsigned:
+      {
+        uint divisor = get_ir_operand(procedure, index, 1);
+        return !is_ir_constant(procedure, divisor) || !procedure->values[divisor].constant.unsigned_integer;
+      }
+    default:
+      return 0;
+    }
+  default:
+    return 0;
+  }
+}
+
+/* keeps the values with effects and those they use, transitively, and
+   unlinks the rest from their blocks */
+static bit eliminate_dead_ir_code(ir_procedure *procedure)
+{
+  scratch scratch;
+  get_scratch(&scratch, context.allocator);
+  bit  *is_live = push_type(bit, procedure->values_count, scratch.allocator);
+  uint *pending = push_type(uint, procedure->values_count, scratch.allocator);
+  uint  pending_count = 0;
+  zero(is_live, procedure->values_count);
+
+#define KEEP(index) do { uint kept = (index); if (!is_live[kept]) { is_live[kept] = 1; pending[pending_count++] = kept; } } while (0)
+  for (uint block = ir_entry_block; block; block = procedure->blocks[block].next)
+  {
+    ir_block *current = &procedure->blocks[block];
+    if (current->is_dead) continue;
+    for (uint value = current->first_value; value; value = procedure->values[value].next)
+      if (!procedure->values[value].is_dead && has_ir_effects(procedure, value)) KEEP(value);
+    if (current->ending == ir_ending_branch)
+    {
+      current->condition = resolve_ir_value(procedure, current->condition);
+      KEEP(current->condition);
+    }
+    else if (current->ending == ir_ending_return)
+      for (uint i = 0; i < current->results_count; ++i)
+      {
+        uint *result = &procedure->operands[current->results + i];
+        *result = resolve_ir_value(procedure, *result);
+        KEEP(*result);
+      }
+  }
+  while (pending_count)
+  {
+    uint value = pending[--pending_count];
+    for (uint i = 0; i < procedure->values[value].operands_count; ++i) KEEP(get_ir_operand(procedure, value, i));
+  }
+#undef KEEP
+
+  bit has_changed = 0;
+  for (uint block = ir_entry_block; block; block = procedure->blocks[block].next)
+  {
+    ir_block *current = &procedure->blocks[block];
+    uint prior = no_ir_value;
+    for (uint value = current->first_value; value; value = procedure->values[value].next)
+    {
+      ir_value *swept = &procedure->values[value];
+      if (is_live[value] && !current->is_dead)
+      {
+        if (prior) procedure->values[prior].next = value;
+        else current->first_value = value;
+        prior = value;
+        continue;
+      }
+      has_changed |= !swept->is_dead;
+      swept->is_dead = 1;
+    }
+    if (prior) procedure->values[prior].next = no_ir_value;
+    else current->first_value = no_ir_value;
+    current->last_value = prior;
+  }
+  end_scratch(&scratch);
+  return has_changed;
+}
+
+static void replace_ir_predecessor(ir_procedure *procedure, uint block, uint replaced, uint replacement)
+{
+  ir_block *replaced_in = &procedure->blocks[block];
+  for (uint i = 0; i < replaced_in->predecessors_count; ++i)
+    if (procedure->operands[replaced_in->predecessors + i] == replaced) procedure->operands[replaced_in->predecessors + i] = replacement;
+}
+
+static bit has_ir_values(ir_procedure *procedure, uint block, bit of_phis)
+{
+  for (uint value = procedure->blocks[block].first_value; value; value = procedure->values[value].next)
+    if (!procedure->values[value].is_dead && (!of_phis || procedure->values[value].kind == ir_kind_phi)) return 1;
+  return 0;
+}
+
+/* skips the empty blocks that only jump to one without `phi`s, and appends
+   the blocks that are only jumped to by one block to it */
+static bit merge_ir_blocks(ir_procedure *procedure)
+{
+  bit has_changed = 0;
+  for (uint block = ir_entry_block; block; block = procedure->blocks[block].next)
+  {
+    if (procedure->blocks[block].is_dead) continue;
+
+    ir_block *current = &procedure->blocks[block];
+    uint successors_count = current->ending == ir_ending_branch ? 2 : current->ending == ir_ending_jump ? 1 : 0;
+    for (uint i = 0; i < successors_count; ++i)
+    {
+      uint successor = current->successors[i];
+      ir_block *skipped = &procedure->blocks[successor];
+      if (successor == block || skipped->predecessors_count != 1 || skipped->ending != ir_ending_jump || has_ir_values(procedure, successor, 0)) continue;
+      uint target = skipped->successors[0];
+      if (target == successor || has_ir_values(procedure, target, 1)) continue;
+      current->successors[i] = target;
+      replace_ir_predecessor(procedure, target, successor, block);
+      skipped->is_dead = 1;
+      skipped->predecessors_count = 0;
+      has_changed = 1;
+    }
+    if (current->ending == ir_ending_branch && current->successors[0] == current->successors[1])
+    {
+      current->ending = ir_ending_jump;
+      current->condition = no_ir_value;
+      remove_ir_predecessor(procedure, current->successors[0], block);
+    }
+
+    while (procedure->blocks[block].ending == ir_ending_jump)
+    {
+      ir_block *current = &procedure->blocks[block];
+      uint successor = current->successors[0];
+      ir_block *merged = &procedure->blocks[successor];
+      if (successor == block || merged->predecessors_count != 1) break;
+
+      /* whose `phi`s choose from one value */
+      for (uint value = merged->first_value; value; value = procedure->values[value].next)
+      {
+        procedure->values[value].block = block;
+        if (procedure->values[value].kind == ir_kind_phi && !procedure->values[value].is_dead) replace_ir_value(procedure, value, get_ir_operand(procedure, value, 0));
+      }
+      if (merged->first_value)
+      {
+        if (current->last_value) procedure->values[current->last_value].next = merged->first_value;
+        else current->first_value = merged->first_value;
+        current->last_value = merged->last_value;
+      }
+
+      current->ending        = merged->ending;
+      current->condition     = merged->condition;
+      current->successors[0] = merged->successors[0];
+      current->successors[1] = merged->successors[1];
+      current->results       = merged->results;
+      current->results_count = merged->results_count;
+      if (current->ending == ir_ending_jump) replace_ir_predecessor(procedure, current->successors[0], successor, block);
+      else if (current->ending == ir_ending_branch)
+      {
+        replace_ir_predecessor(procedure, current->successors[0], successor, block);
+        replace_ir_predecessor(procedure, current->successors[1], successor, block);
+      }
+      merged->is_dead = 1;
+      merged->first_value = merged->last_value = no_ir_value;
+      merged->predecessors_count = 0;
+      has_changed = 1;
+    }
+  }
+  return has_changed;
+}
+
+static void optimize_ir_procedure(ir_procedure *procedure)
+{
+  if (!procedure->blocks_count) return;
+  for (uint i = 0; i < ir_optimization_rounds_count; ++i)
+  {
+    bit has_changed = propagate_ir_constants(procedure);
+    has_changed |= eliminate_ir_subexpressions(procedure);
+    has_changed |= eliminate_dead_ir_code(procedure);
+    has_changed |= merge_ir_blocks(procedure);
+    if (!has_changed) break;
+  }
+}
+
+/*****************************************************************************/
+
+static bit is_inlinable(ir_procedure *procedure)
+{
+  if (!procedure->declaration || !procedure->blocks_count) return 0;
+  uint values_count = 0;
+  for (uint block = ir_entry_block; block; block = procedure->blocks[block].next)
+  {
+    if (procedure->blocks[block].is_dead) continue;
+    for (uint value = procedure->blocks[block].first_value; value; value = procedure->values[value].next)
+    {
+      if (procedure->values[value].kind == ir_kind_call) return 0;
+      values_count += 1;
+    }
+  }
+  return values_count <= ir_inlining_threshold;
+}
+
+/* splits the call's block after it, and copies the callee's blocks in
+   between, whose returns jump to the rest */
+static void inline_ir_call(ir_procedure *caller, uint call, ir_procedure *callee)
+{
+  scratch scratch;
+  get_scratch(&scratch, context.allocator);
+  uint *mapped_values = push_type(uint, callee->values_count, scratch.allocator);
+  uint *mapped_blocks = push_type(uint, callee->blocks_count, scratch.allocator);
+
+  uint returns_count = 0;
+  for (uint block = ir_entry_block; block; block = callee->blocks[block].next)
+    returns_count += !callee->blocks[block].is_dead && callee->blocks[block].ending == ir_ending_return;
+
+  uint split = caller->values[call].block;
+  type_id result_type = caller->values[call].type;
+  uint continuation = add_ir_block(caller);
+  uint result = no_ir_value;
+  if (result_type != none_type && returns_count > 1) result = add_ir_value(caller, continuation, ir_kind_phi, result_type, returns_count);
+
+  /* the values after the call continue the block */
+  uint prior = no_ir_value;
+  for (uint value = caller->blocks[split].first_value; value != call; value = caller->values[value].next) prior = value;
+  uint rest = caller->values[call].next;
+  if (rest)
+  {
+    if (result) caller->values[result].next = rest;
+    else caller->blocks[continuation].first_value = rest;
+    caller->blocks[continuation].last_value = caller->blocks[split].last_value;
+    for (uint value = rest; value; value = caller->values[value].next) caller->values[value].block = continuation;
+  }
+  if (prior) caller->values[prior].next = no_ir_value;
+  else caller->blocks[split].first_value = no_ir_value;
+  caller->blocks[split].last_value = prior;
+  caller->values[call].next = no_ir_value;
+
+  ir_block *continued = &caller->blocks[continuation], *splitted = &caller->blocks[split];
+  continued->ending        = splitted->ending;
+  continued->condition     = splitted->condition;
+  continued->successors[0] = splitted->successors[0];
+  continued->successors[1] = splitted->successors[1];
+  continued->results       = splitted->results;
+  continued->results_count = splitted->results_count;
+  if (continued->ending == ir_ending_jump) replace_ir_predecessor(caller, continued->successors[0], split, continuation);
+  else if (continued->ending == ir_ending_branch)
+  {
+    replace_ir_predecessor(caller, continued->successors[0], split, continuation);
+    replace_ir_predecessor(caller, continued->successors[1], split, continuation);
+  }
+
+  /* the callee's blocks are laid out between */
+  uint last = split, following = caller->blocks[split].next;
+  for (uint block = ir_entry_block; block; block = callee->blocks[block].next)
+  {
+    if (callee->blocks[block].is_dead) continue;
+    mapped_blocks[block] = add_ir_block(caller);
+    caller->blocks[last].next = mapped_blocks[block];
+    last = mapped_blocks[block];
+  }
+  caller->blocks[last].next = continuation;
+  caller->blocks[continuation].next = following;
+  caller->blocks[split].ending = ir_ending_jump;
+  caller->blocks[split].successors[0] = mapped_blocks[ir_entry_block];
+
+  uint continuation_predecessors = add_ir_operands(caller, returns_count);
+  uint returned = 0;
+  for (uint block = ir_entry_block; block; block = callee->blocks[block].next)
+  {
+    ir_block *copied = &callee->blocks[block];
+    if (copied->is_dead) continue;
+    uint mapped = mapped_blocks[block];
+
+    uint predecessors = add_ir_operands(caller, block == ir_entry_block ? 1 : copied->predecessors_count);
+    if (block == ir_entry_block) caller->operands[predecessors] = split;
+    else for (uint i = 0; i < copied->predecessors_count; ++i) caller->operands[predecessors + i] = mapped_blocks[callee->operands[copied->predecessors + i]];
+    caller->blocks[mapped].predecessors = predecessors;
+    caller->blocks[mapped].predecessors_count = block == ir_entry_block ? 1 : copied->predecessors_count;
+
+    for (uint value = copied->first_value; value; value = callee->values[value].next)
+    {
+      ir_value *original = &callee->values[value];
+      if (original->is_dead) continue;
+      if (original->kind == ir_kind_argument)
+      {
+        mapped_values[value] = get_ir_operand(caller, call, original->index);
+        continue;
+      }
+      uint copy = add_ir_value(caller, mapped, original->kind, original->type, original->operands_count);
+      ir_value *copied_value = &caller->values[copy];
+      copied_value->operation   = original->operation;
+      copied_value->bits        = original->bits;
+      copied_value->index       = original->index;
+      copied_value->declaration = original->declaration;
+      copied_value->constant    = original->constant;
+      for (uint i = 0; i < original->operands_count; ++i)
+        caller->operands[copied_value->operands + i] = mapped_values[get_ir_operand(callee, value, i)];
+      mapped_values[value] = copy;
+    }
+
+    ir_block *target = &caller->blocks[mapped];
+    switch (copied->ending)
+    {
+    case ir_ending_branch:
+      target->condition = mapped_values[resolve_ir_value(callee, copied->condition)];
+      target->successors[1] = mapped_blocks[copied->successors[1]];
+      /* fallthrough */
+    case ir_ending_jump:
+      target->ending = copied->ending;
+      target->successors[0] = mapped_blocks[copied->successors[0]];
+      break;
+    case ir_ending_return:
+      target->ending = ir_ending_jump;
+      target->successors[0] = continuation;
+      caller->operands[continuation_predecessors + returned] = mapped;
+      if (result_type != none_type)
+      {
+        uint returned_value = mapped_values[resolve_ir_value(callee, callee->operands[copied->results])];
+        if (result) caller->operands[caller->values[result].operands + returned] = returned_value;
+        else result = returned_value;
+      }
+      returned += 1;
+      break;
+    }
+  }
+  caller->blocks[continuation].predecessors = continuation_predecessors;
+  caller->blocks[continuation].predecessors_count = returns_count;
+
+  if (result) replace_ir_value(caller, call, result);
+  else caller->values[call].is_dead = 1;
+  end_scratch(&scratch);
+}
+
+/* returns whether any call was inlined */
+static bit inline_ir_calls(ir *ir)
+{
+  scratch scratch;
+  get_scratch(&scratch, context.allocator);
+  bit *is_callee_inlinable = push_type(bit, ir->procedures_count, scratch.allocator);
+  for (uint i = 0; i < ir->procedures_count; ++i) is_callee_inlinable[i] = is_inlinable(&ir->procedures[i]);
+
+  bit has_changed = 0;
+  for (uint i = 0; i < ir->procedures_count; ++i)
+  {
+    ir_procedure *caller = &ir->procedures[i];
+    if (!caller->blocks_count || is_callee_inlinable[i]) continue;
+
+    /* the calls are gathered first, since inlining moves them */
+    uint *calls = push_type(uint, caller->values_count + 1, scratch.allocator);
+    uint calls_count = 0;
+    for (uint block = ir_entry_block; block; block = caller->blocks[block].next)
+    {
+      if (caller->blocks[block].is_dead) continue;
+      for (uint value = caller->blocks[block].first_value; value; value = caller->values[value].next)
+        if (caller->values[value].kind == ir_kind_call && is_callee_inlinable[caller->values[value].index]) calls[calls_count++] = value;
+    }
+    for (uint j = 0; j < calls_count; ++j) inline_ir_call(caller, calls[j], &ir->procedures[caller->values[calls[j]].index]);
+    has_changed |= calls_count != 0;
+  }
+  end_scratch(&scratch);
+  return has_changed;
+}
+
+void optimize_ir(ir *ir)
+{
+  for (uint round = 0;; ++round)
+  {
+    for (uint i = 0; i < ir->procedures_count; ++i) optimize_ir_procedure(&ir->procedures[i]);
+    if (round == ir_optimization_rounds_count || !inline_ir_calls(ir)) break;
+  }
+}
+
+/*****************************************************************************/
+
+static void print_ir_type(type_id type)
+{
+  utf8 representation[type_representation_size];
+  printf("%s", represent_type(representation, sizeof(representation), type));
+}
+
+static void print_ir_name(declaration_node *declaration)
+{
+  printf("%.*s", (int)declaration->identifier.runes_count, declaration->identifier.runes);
+}
+
+static void print_ir_value(ir_procedure *procedure, uint index, ir *ir)
+{
+  ir_value *printed = &procedure->values[index];
+  printf("  ");
+  if (printed->type != none_type)
+  {
+    printf("%%%u: ", index);
+    print_ir_type(printed->type);
+    printf(" = ");
+  }
+
+  switch (printed->kind)
+  {
+  case ir_kind_constant:
+    printf("constant ");
+    switch (get_type(printed->type)->kind)
+    {
+    case type_kind_float:  printf("%g", printed->constant.decimal); break;
+    case type_kind_signed: printf("%lld", (long long)printed->constant.signed_integer); break;
+    default:               printf("%llu", (unsigned long long)printed->constant.unsigned_integer); break;
+    }
+    break;
+  case ir_kind_argument:
+    printf("argument %u", printed->index);
+    break;
+  case ir_kind_phi:
+    printf("phi");
+    for (uint i = 0; i < printed->operands_count; ++i)
+      printf("%s [%%%u, b%u]", i ? "," : "", get_ir_operand(procedure, index, i), procedure->operands[procedure->blocks[printed->block].predecessors + i]);
+    break;
+  case ir_kind_operation:
+    printf("%s %%%u", operation_representations[printed->operation], get_ir_operand(procedure, index, 0));
+    if (printed->operands_count > 1) printf(", %%%u", get_ir_operand(procedure, index, 1));
+    if (printed->operation == operation_truncate_signed || printed->operation == operation_truncate_unsigned) printf(", %u", printed->bits);
+    break;
+  case ir_kind_get_global:
+    printf("get_global ");
+    print_ir_name(printed->declaration);
+    break;
+  case ir_kind_set_global:
+    printf("set_global ");
+    print_ir_name(printed->declaration);
+    printf(", %%%u", get_ir_operand(procedure, index, 0));
+    break;
+  case ir_kind_call:
+    printf("call ");
+    print_ir_name(ir->procedures[printed->index].declaration);
+    for (uint i = 0; i < printed->operands_count; ++i) printf("%s%%%u", i ? ", " : " ", get_ir_operand(procedure, index, i));
+    break;
+  }
+  printf("\n");
+}
+
+void print_ir(ir *ir)
+{
+  for (uint i = 0; i < ir->procedures_count; ++i)
+  {
+    ir_procedure *procedure = &ir->procedures[i];
+    if (!procedure->blocks_count) continue;
+    if (!procedure->declaration) printf("globals\n");
+    else
+    {
+      print_ir_name(procedure->declaration);
+      printf(" :: ");
+      print_ir_type(procedure->type);
+      printf("\n");
+    }
+
+    for (uint block = ir_entry_block; block; block = procedure->blocks[block].next)
+    {
+      ir_block *printed = &procedure->blocks[block];
+      if (printed->is_dead) continue;
+      printf("b%u:", block);
+      for (uint j = 0; j < printed->predecessors_count; ++j) printf("%s b%u", j ? "," : " /* from", procedure->operands[printed->predecessors + j]);
+      printf("%s\n", printed->predecessors_count ? " */" : "");
+
+      for (uint value = printed->first_value; value; value = procedure->values[value].next)
+        if (!procedure->values[value].is_dead) print_ir_value(procedure, value, ir);
+
+      switch (printed->ending)
+      {
+      case ir_ending_jump:
+        printf("  jump b%u\n", printed->successors[0]);
+        break;
+      case ir_ending_branch:
+        printf("  branch %%%u, b%u, b%u\n", resolve_ir_value(procedure, printed->condition), printed->successors[0], printed->successors[1]);
+        break;
+      case ir_ending_return:
+        printf("  return");
+        for (uint j = 0; j < printed->results_count; ++j) printf("%s%%%u", j ? ", " : " ", resolve_ir_value(procedure, procedure->operands[printed->results + j]));
+        printf("\n");
+        break;
+      }
+    }
+    printf("\n");
+  }
+}
@@ -0,0 +1,1433 @@
+#include "proglosa.h"
+
+/*****************************************************************************/
+
+#if defined(ON_ARCHITECTURE_X64)
+
+/* the encodings of the general registers */
+typedef enum
+{
+  register_rax, register_rcx, register_rdx, register_rbx,
+  register_rsp, register_rbp, register_rsi, register_rdi,
+  register_r8,  register_r9,  register_r10, register_r11,
+  register_r12, register_r13, register_r14, register_r15,
+} general_register;
+
+/* `rax`, `rcx`, `rdx`, `r11`, `xmm0` and `xmm1` are never allocated, and
+   are the scratch registers of every lowered operation */
+static const uint8 volatile_general_registers[] = { register_rsi, register_rdi, register_r8, register_r9, register_r10 };
+static const uint8 preserved_general_registers[] = { register_rbx, register_r12, register_r13, register_r14, register_r15 };
+static const uint8 argument_general_registers[] = { register_rdi, register_rsi, register_rdx, register_rcx, register_r8, register_r9 };
+
+#define first_allocated_vector_register ((uint)2)
+#define vector_registers_count          ((uint)16)
+#define argument_vector_registers_count ((uint)8)
+
+typedef enum
+{
+  location_kind_general,
+  location_kind_vector,
+  location_kind_memory, /* at `offset` from the general register */
+} location_kind;
+
+typedef struct
+{
+  location_kind kind;
+  uint8         index;
+  sint32        offset;
+} location;
+
+static location general(uint index)
+{
+  return (location){ .kind = location_kind_general, .index = (uint8)index };
+}
+
+static location vector(uint index)
+{
+  return (location){ .kind = location_kind_vector, .index = (uint8)index };
+}
+
+static location memory(uint base, sint32 offset)
+{
+  return (location){ .kind = location_kind_memory, .index = (uint8)base, .offset = offset };
+}
+
+static bit are_locations_equal(location left, location right)
+{
+  return left.kind == right.kind && left.index == right.index && left.offset == right.offset;
+}
+
+/*****************************************************************************/
+
+/* the live interval of a bytecode register, between its first and last
+   occurrences. bytecode only jumps forward, so this covers every path. */
+typedef struct
+{
+  sint     beginning;
+  sint     ending;
+  uint     register_index;
+  sint     float_votes;   /* the uses as floats less the uses as integers */
+  bit      is_crossing;   /* a call happens within */
+  location location;
+} interval;
+
+typedef struct
+{
+  uint position; /* of the `rel32` */
+  uint target;   /* the bytecode position, or the procedure */
+} fixup;
+
+typedef struct
+{
+  bytecode *bytecode;
+  jit      *jit;
+
+  byte *code;
+  uint  code_size;
+  uint  code_capacity;
+
+  /* of the compiled procedure */
+  bytecode_procedure *procedure;
+  interval            intervals[maximum_registers_count];
+  uint                preserved_count;
+  uint8               preserved[countof(preserved_general_registers)];
+  uint                spills_count;
+  uint                frame_size;
+  uint               *positions;          /* of each bytecode instruction */
+  uint                positions_capacity;
+  fixup              *jumps;
+  uint                jumps_count;
+  uint                jumps_capacity;
+
+  /* of every procedure */
+  fixup *calls;
+  uint   calls_count;
+  uint   calls_capacity;
+
+  /* relocatable code refers to the globals by `addresses`, which are
+     `rel32`s, and calls the failure routine by a call whose target is
+     `procedures_count`; both are relocated by `write_object` */
+  bit    is_relocatable;
+  fixup *addresses;
+  uint   addresses_count;
+  uint   addresses_capacity;
+} jitter;
+
+static void emit_byte(jitter *jitter, uint8 value)
+{
+  if (jitter->code_size == jitter->code_capacity)
+  {
+    uint capacity = jitter->code_capacity ? jitter->code_capacity * 2 : 16 * kibibyte;
+    jitter->code = reallocate(capacity, jitter->code, jitter->code_capacity);
+    jitter->code_capacity = capacity;
+  }
+  jitter->code[jitter->code_size++] = value;
+}
+
+static void emit_bytes(jitter *jitter, const uint8 *bytes, uint count)
+{
+  for (uint i = 0; i < count; ++i) emit_byte(jitter, bytes[i]);
+}
+
+static void emit_uint32(jitter *jitter, uint32 value)
+{
+  for (uint i = 0; i < 4; ++i) emit_byte(jitter, (uint8)(value >> (i * 8)));
+}
+
+static void emit_uint64(jitter *jitter, uint64 value)
+{
+  for (uint i = 0; i < 8; ++i) emit_byte(jitter, (uint8)(value >> (i * 8)));
+}
+
+static void patch_uint32(jitter *jitter, uint position, uint32 value)
+{
+  for (uint i = 0; i < 4; ++i) jitter->code[position + i] = (uint8)(value >> (i * 8));
+}
+
+/* emits `[prefix] [REX] opcode ModRM [displacement]`, whose ModRM's `reg`
+   is a register and whose `r/m` is a register or memory */
+static void emit_instruction(jitter *jitter, uint8 prefix, bit is_wide, const uint8 *opcode, uint opcode_size, uint reg, location rm)
+{
+  if (prefix) emit_byte(jitter, prefix);
+  uint8 rex = 0x40 | (is_wide << 3) | (((reg >> 3) & 1) << 2) | ((rm.index >> 3) & 1);
+  if (rex != 0x40) emit_byte(jitter, rex);
+  emit_bytes(jitter, opcode, opcode_size);
+  if (rm.kind == location_kind_memory)
+  {
+    ASSERT((rm.index & 7) != register_rsp); /* which would need a SIB */
+    emit_byte(jitter, 0x80 | ((reg & 7) << 3) | (rm.index & 7));
+    emit_uint32(jitter, (uint32)rm.offset);
+  }
+  else emit_byte(jitter, 0xC0 | ((reg & 7) << 3) | (rm.index & 7));
+}
+
+#define EMIT(jitter, prefix, is_wide, reg, rm, ...) \
+  do { static const uint8 opcode[] = { __VA_ARGS__ }; emit_instruction(jitter, prefix, is_wide, opcode, sizeof(opcode), reg, rm); } while (0)
+
+static void emit_raw(jitter *jitter, uint count, const uint8 *bytes)
+{
+  emit_bytes(jitter, bytes, count);
+}
+
+#define EMIT_RAW(jitter, ...) \
+  do { static const uint8 bytes[] = { __VA_ARGS__ }; emit_raw(jitter, sizeof(bytes), bytes); } while (0)
+
+static void emit_move_immediate(jitter *jitter, uint destination, uint64 value)
+{
+  emit_byte(jitter, 0x48 | ((destination >> 3) & 1));
+  emit_byte(jitter, 0xB8 | (destination & 7));
+  emit_uint64(jitter, value);
+}
+
+static void emit_push(jitter *jitter, uint source)
+{
+  if (source >= 8) emit_byte(jitter, 0x41);
+  emit_byte(jitter, 0x50 | (source & 7));
+}
+
+static void emit_pop(jitter *jitter, uint destination)
+{
+  if (destination >= 8) emit_byte(jitter, 0x41);
+  emit_byte(jitter, 0x58 | (destination & 7));
+}
+
+/* returns the position of the `rel32`, to be patched by `patch_forward` */
+static uint emit_forward_jump(jitter *jitter, sint condition)
+{
+  if (condition < 0) emit_byte(jitter, 0xE9);
+  else
+  {
+    emit_byte(jitter, 0x0F);
+    emit_byte(jitter, 0x80 | (uint8)condition);
+  }
+  emit_uint32(jitter, 0);
+  return jitter->code_size - 4;
+}
+
+static void patch_forward(jitter *jitter, uint position)
+{
+  patch_uint32(jitter, position, jitter->code_size - (position + 4));
+}
+
+typedef enum
+{
+  condition_always = -1,
+  condition_below = 0x2, condition_above_or_equal = 0x3, condition_equal = 0x4, condition_unequal = 0x5,
+  condition_below_or_equal = 0x6, condition_above = 0x7, condition_sign = 0x8, condition_not_sign = 0x9, condition_parity = 0xA,
+  condition_not_parity = 0xB, condition_less = 0xC, condition_greater_or_equal = 0xD,
+  condition_less_or_equal = 0xE, condition_greater = 0xF,
+} condition;
+
+/* `setcc reg8` */
+static void emit_set(jitter *jitter, condition condition, uint destination)
+{
+  emit_byte(jitter, 0x0F);
+  emit_byte(jitter, 0x90 | (uint8)condition);
+  emit_byte(jitter, 0xC0 | destination);
+}
+
+/* `movzx eax, al` */
+static void emit_extend_al(jitter *jitter)
+{
+  EMIT_RAW(jitter, 0x0F, 0xB6, 0xC0);
+}
+
+static void emit_call_address(jitter *jitter, const void *target)
+{
+  emit_move_immediate(jitter, register_rax, (uint64)(address)target);
+  EMIT_RAW(jitter, 0xFF, 0xD0); /* call rax */
+}
+
+/*****************************************************************************/
+
+static void load_general(jitter *jitter, uint destination, location source)
+{
+  switch (source.kind)
+  {
+  case location_kind_general:
+    if (source.index != destination) EMIT(jitter, 0, 1, destination, source, 0x8B);
+    break;
+  case location_kind_vector:
+    EMIT(jitter, 0x66, 1, source.index, general(destination), 0x0F, 0x7E); /* movq r64, xmm */
+    break;
+  case location_kind_memory:
+    EMIT(jitter, 0, 1, destination, source, 0x8B);
+    break;
+  }
+}
+
+static void store_general(jitter *jitter, location destination, uint source)
+{
+  switch (destination.kind)
+  {
+  case location_kind_general:
+    if (destination.index != source) EMIT(jitter, 0, 1, destination.index, general(source), 0x8B);
+    break;
+  case location_kind_vector:
+    EMIT(jitter, 0x66, 1, destination.index, general(source), 0x0F, 0x6E); /* movq xmm, r64 */
+    break;
+  case location_kind_memory:
+    EMIT(jitter, 0, 1, source, destination, 0x89);
+    break;
+  }
+}
+
+static void load_vector(jitter *jitter, uint destination, location source)
+{
+  switch (source.kind)
+  {
+  case location_kind_general:
+    EMIT(jitter, 0x66, 1, destination, source, 0x0F, 0x6E); /* movq xmm, r64 */
+    break;
+  case location_kind_vector:
+    if (source.index != destination) EMIT(jitter, 0xF2, 0, destination, source, 0x0F, 0x10);
+    break;
+  case location_kind_memory:
+    EMIT(jitter, 0xF2, 0, destination, source, 0x0F, 0x10); /* movsd */
+    break;
+  }
+}
+
+static void store_vector(jitter *jitter, location destination, uint source)
+{
+  switch (destination.kind)
+  {
+  case location_kind_general:
+    EMIT(jitter, 0x66, 1, source, destination, 0x0F, 0x7E); /* movq r64, xmm */
+    break;
+  case location_kind_vector:
+    if (destination.index != source) EMIT(jitter, 0xF2, 0, destination.index, vector(source), 0x0F, 0x10);
+    break;
+  case location_kind_memory:
+    EMIT(jitter, 0xF2, 0, source, destination, 0x0F, 0x11);
+    break;
+  }
+}
+
+static void move_location(jitter *jitter, location destination, location source)
+{
+  if (are_locations_equal(destination, source)) return;
+  switch (destination.kind)
+  {
+  case location_kind_general: load_general(jitter, destination.index, source); break;
+  case location_kind_vector:  load_vector(jitter, destination.index, source);  break;
+  case location_kind_memory:
+    if (source.kind == location_kind_general) store_general(jitter, destination, source.index);
+    else if (source.kind == location_kind_vector) store_vector(jitter, destination, source.index);
+    else
+    {
+      load_general(jitter, register_rax, source);
+      store_general(jitter, destination, register_rax);
+    }
+    break;
+  }
+}
+
+/* a register operand of `op r64, r/m64`, whose memory can't be a vector */
+static location general_operand(jitter *jitter, location source, uint scratch)
+{
+  if (source.kind != location_kind_vector) return source;
+  load_general(jitter, scratch, source);
+  return general(scratch);
+}
+
+static location vector_operand(jitter *jitter, location source, uint scratch)
+{
+  if (source.kind != location_kind_general) return source;
+  load_vector(jitter, scratch, source);
+  return vector(scratch);
+}
+
+/*****************************************************************************/
+
+static bit is_jittable_type(type_id id)
+{
+  switch (get_type(id)->kind)
+  {
+  case type_kind_signed:
+  case type_kind_unsigned:
+  case type_kind_bit:
+  case type_kind_float:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+static bit is_float_type(type_id id)
+{
+  return get_type(id)->kind == type_kind_float;
+}
+
+static bit is_float32_type(type_id id)
+{
+  return get_type(id)->kind == type_kind_float && get_type(id)->size == sizeof(float32);
+}
+
+/* the arguments and result must fit in registers */
+static bit has_jittable_signature(bytecode_procedure *procedure)
+{
+  if (!procedure->declaration || procedure->results_count > 1) return 0;
+  type *type = get_type(procedure->type);
+  uint generals_count = 0, vectors_count = 0;
+  for (uint i = 0; i < type->components_count; ++i)
+  {
+    type_id component = get_type(procedure->type)->components[i];
+    if (!is_jittable_type(component)) return 0;
+    if (i < type->arguments_count) *(is_float_type(component) ? &vectors_count : &generals_count) += 1;
+  }
+  return generals_count <= countof(argument_general_registers) && vectors_count <= argument_vector_registers_count;
+}
+
+/* the length of an instruction with its immediates */
+static uint get_instruction_size(const instruction *instruction)
+{
+  switch (instruction->operation)
+  {
+  case operation_load:       return 3;
+  case operation_get_global:
+  case operation_set_global:
+  case operation_jump:
+  case operation_jump_if_zero:
+  case operation_call:       return 2;
+  default:                   return 1;
+  }
+}
+
+/* whether the procedure calls anything compiled by `run_bytecode` alone */
+static bit calls_unjittable(bytecode_procedure *procedure, const bit *is_jittable)
+{
+  for (uint i = 0; i < procedure->code_size; i += get_instruction_size(&procedure->code[i]))
+    if (procedure->code[i].operation == operation_call && !is_jittable[procedure->code[i + 1].immediate]) return 1;
+  return 0;
+}
+
+/*****************************************************************************/
+
+static void note_occurrence(jitter *jitter, uint register_index, sint position, sint float_vote)
+{
+  interval *interval = &jitter->intervals[register_index];
+  if (interval->beginning > position) interval->beginning = position;
+  if (interval->ending < position) interval->ending = position;
+  interval->float_votes += float_vote;
+}
+
+static void analyze_intervals(jitter *jitter, sint *calls_positions, uint *calls_count)
+{
+  bytecode_procedure *procedure = jitter->procedure;
+  for (uint i = 0; i < maximum_registers_count; ++i)
+    jitter->intervals[i] = (interval){ .beginning = INT32_MAX, .ending = -1, .register_index = i };
+
+  /* the arguments are defined upon entry */
+  type *procedure_type = get_type(procedure->type);
+  for (uint i = 0; i < procedure->arguments_count; ++i)
+    note_occurrence(jitter, i, -1, is_float_type(procedure_type->components[i]) ? 1 : -1);
+
+  *calls_count = 0;
+  for (uint i = 0; i < procedure->code_size; i += get_instruction_size(&procedure->code[i]))
+  {
+    instruction current = procedure->code[i];
+    sint position = (sint)i;
+    switch (current.operation)
+    {
+    case operation_move:
+      note_occurrence(jitter, current.a, position, 0);
+      note_occurrence(jitter, current.b, position, 0);
+      break;
+    case operation_load:
+    case operation_get_global:
+    case operation_set_global:
+    case operation_jump_if_zero:
+      note_occurrence(jitter, current.a, position, 0);
+      break;
+    case operation_add_float:
+    case operation_subtract_float:
+    case operation_multiply_float:
+    case operation_divide_float:
+      note_occurrence(jitter, current.a, position, 1);
+      /* fallthrough */
+    case operation_equal_float:
+    case operation_unequal_float:
+    case operation_lesser_float:
+    case operation_inclusive_lesser_float:
+      note_occurrence(jitter, current.b, position, 1);
+      note_occurrence(jitter, current.c, position, 1);
+      if (current.operation >= operation_equal_float) note_occurrence(jitter, current.a, position, -1);
+      break;
+    case operation_negate_float:
+    case operation_round_float32:
+      note_occurrence(jitter, current.a, position, 1);
+      note_occurrence(jitter, current.b, position, 1);
+      break;
+    case operation_test_float:
+      note_occurrence(jitter, current.a, position, -1);
+      note_occurrence(jitter, current.b, position, 1);
+      break;
+    case operation_convert_signed_to_float:
+    case operation_convert_unsigned_to_float:
+      note_occurrence(jitter, current.a, position, 1);
+      note_occurrence(jitter, current.b, position, -1);
+      break;
+    case operation_convert_float_to_signed:
+    case operation_convert_float_to_unsigned:
+      note_occurrence(jitter, current.a, position, -1);
+      note_occurrence(jitter, current.b, position, 1);
+      break;
+    case operation_negate:
+    case operation_not:
+    case operation_test:
+    case operation_logical_not:
+    case operation_truncate_signed:
+    case operation_truncate_unsigned:
+      note_occurrence(jitter, current.a, position, -1);
+      note_occurrence(jitter, current.b, position, -1);
+      break;
+    case operation_jump:
+      break;
+    case operation_call:
+      {
+        bytecode_procedure *callee = &jitter->bytecode->procedures[procedure->code[i + 1].immediate];
+        type *callee_type = get_type(callee->type);
+        calls_positions[(*calls_count)++] = position;
+        for (uint j = 0; j < current.b; ++j)
+          note_occurrence(jitter, current.a + j, position, is_float_type(get_type(callee->type)->components[j]) ? 1 : -1);
+        if (callee->results_count)
+          note_occurrence(jitter, current.a, position, is_float_type(callee_type->components[callee_type->arguments_count]) ? 1 : -1);
+        break;
+      }
+    case operation_return:
+      for (uint j = 0; j < current.b; ++j)
+        note_occurrence(jitter, current.a + j, position, is_float_type(procedure_type->components[procedure->arguments_count + j]) ? 1 : -1);
+      break;
+    default:
+      /* the integer operations of three registers */
+      note_occurrence(jitter, current.a, position, -1);
+      note_occurrence(jitter, current.b, position, -1);
+      note_occurrence(jitter, current.c, position, -1);
+      break;
+    }
+  }
+
+  for (uint i = 0; i < maximum_registers_count; ++i)
+  {
+    interval *interval = &jitter->intervals[i];
+    for (uint j = 0; j < *calls_count && !interval->is_crossing; ++j)
+      interval->is_crossing = interval->beginning < calls_positions[j] && calls_positions[j] < interval->ending;
+  }
+}
+
+/* linear scan: intervals are visited by their beginnings, and upon running
+   out of registers, the interval ending last is spilled */
+static void allocate_locations(jitter *jitter)
+{
+  interval *sorted[maximum_registers_count];
+  uint sorted_count = 0;
+  for (uint i = 0; i < maximum_registers_count; ++i)
+  {
+    interval *interval = &jitter->intervals[i];
+    if (interval->ending < 0) continue;
+    uint j = sorted_count++;
+    while (j && sorted[j - 1]->beginning > interval->beginning)
+    {
+      sorted[j] = sorted[j - 1];
+      --j;
+    }
+    sorted[j] = interval;
+  }
+
+  interval *active[maximum_registers_count];
+  uint active_count = 0;
+  bit is_general_used[16] = {0};
+  bit is_vector_used[vector_registers_count] = {0};
+  bit is_preserved_used[countof(preserved_general_registers)] = {0};
+
+  jitter->spills_count = 0;
+  for (uint i = 0; i < sorted_count; ++i)
+  {
+    interval *current = sorted[i];
+
+    /* expire the intervals that ended */
+    uint kept_count = 0;
+    for (uint j = 0; j < active_count; ++j)
+    {
+      interval *other = active[j];
+      if (other->ending >= current->beginning)
+      {
+        active[kept_count++] = other;
+        continue;
+      }
+      if (other->location.kind == location_kind_general) is_general_used[other->location.index] = 0;
+      if (other->location.kind == location_kind_vector) is_vector_used[other->location.index] = 0;
+    }
+    active_count = kept_count;
+
+    bit is_float = current->float_votes > 0;
+    sint chosen = -1;
+    if (is_float && !current->is_crossing)
+    {
+      for (uint j = first_allocated_vector_register; j < vector_registers_count && chosen < 0; ++j)
+        if (!is_vector_used[j]) chosen = j;
+      if (chosen >= 0)
+      {
+        is_vector_used[chosen] = 1;
+        current->location = vector(chosen);
+      }
+    }
+    else if (!is_float)
+    {
+      if (!current->is_crossing)
+        for (uint j = 0; j < countof(volatile_general_registers) && chosen < 0; ++j)
+          if (!is_general_used[volatile_general_registers[j]]) chosen = volatile_general_registers[j];
+      for (uint j = 0; j < countof(preserved_general_registers) && chosen < 0; ++j)
+        if (!is_general_used[preserved_general_registers[j]])
+        {
+          chosen = preserved_general_registers[j];
+          is_preserved_used[j] = 1;
+        }
+      if (chosen >= 0)
+      {
+        is_general_used[chosen] = 1;
+        current->location = general(chosen);
+      }
+    }
+
+    if (chosen < 0)
+    {
+      /* floats that live across calls are always spilled, since no vector
+         register is preserved by calls */
+      interval *spilled = current;
+      if (!(is_float && current->is_crossing))
+      {
+        for (uint j = 0; j < active_count; ++j)
+        {
+          interval *other = active[j];
+          bit is_compatible = is_float ? other->location.kind == location_kind_vector
+                                       : other->location.kind == location_kind_general
+                                         && (!current->is_crossing || other->is_crossing || other->location.index == register_rbx || other->location.index >= register_r12);
+          if (is_compatible && other->ending > spilled->ending) spilled = other;
+        }
+      }
+      if (spilled != current)
+      {
+        current->location = spilled->location;
+        for (uint j = 0; j < active_count; ++j)
+          if (active[j] == spilled) active[j] = current;
+      }
+      /* the slots are numbered until the frame is laid out */
+      spilled->location = memory(register_rbp, (sint32)jitter->spills_count++);
+      continue;
+    }
+    active[active_count++] = current;
+  }
+
+  jitter->preserved_count = 0;
+  for (uint i = 0; i < countof(preserved_general_registers); ++i)
+    if (is_preserved_used[i]) jitter->preserved[jitter->preserved_count++] = preserved_general_registers[i];
+}
+
+/*****************************************************************************/
+
+static location at(jitter *jitter, uint register_index)
+{
+  return jitter->intervals[register_index].location;
+}
+
+/* the frame is the preserved registers, the spills, then the arguments of
+   calls, below `rbp` */
+static void lay_out_frame(jitter *jitter, uint outgoing_count)
+{
+  for (uint i = 0; i < maximum_registers_count; ++i)
+  {
+    location *location = &jitter->intervals[i].location;
+    if (location->kind == location_kind_memory && jitter->intervals[i].ending >= 0)
+      location->offset = -8 * (sint32)(jitter->preserved_count + location->offset + 1);
+  }
+  uint slots_count = jitter->spills_count + outgoing_count;
+  jitter->frame_size = slots_count * 8;
+
+  /* calls need `rsp` aligned to 16 bytes */
+  if ((jitter->preserved_count * 8 + jitter->frame_size) % 16) jitter->frame_size += 8;
+}
+
+static location get_outgoing(jitter *jitter, uint index)
+{
+  return memory(register_rbp, -8 * (sint32)(jitter->preserved_count + jitter->spills_count + index + 1));
+}
+
+static void emit_shift_immediate(jitter *jitter, uint extension, uint destination, uint8 count)
+{
+  EMIT(jitter, 0, 1, extension, general(destination), 0xC1);
+  emit_byte(jitter, count);
+}
+
+static void emit_truncation(jitter *jitter, uint destination, bit is_signed, uint bits_count)
+{
+  emit_shift_immediate(jitter, 4, destination, (uint8)(64 - bits_count));              /* shl */
+  emit_shift_immediate(jitter, is_signed ? 7 : 5, destination, (uint8)(64 - bits_count)); /* sar or shr */
+}
+
+/* `movzx eax, al` after a `setcc`, into a register */
+static void store_condition(jitter *jitter, location destination)
+{
+  emit_extend_al(jitter);
+  store_general(jitter, destination, register_rax);
+}
+
+static void divide_by_zero_in_machine_code(void)
+{
+  print_failure("Divided by zero.\n");
+  jump(*context.failure_jump_point, 1);
+}
+
+static void add_fixup(fixup **fixups, uint *count, uint *capacity, uint position, uint target)
+{
+  if (*count == *capacity)
+  {
+    uint new_capacity = *capacity ? *capacity * 2 : 64;
+    *fixups = reallocate(new_capacity * sizeof(fixup), *fixups, *capacity * sizeof(fixup));
+    *capacity = new_capacity;
+  }
+  (*fixups)[(*count)++] = (fixup){ position, target };
+}
+
+static void emit_global_address(jitter *jitter, uint global_index)
+{
+  if (!jitter->is_relocatable)
+  {
+    emit_move_immediate(jitter, register_rax, (uint64)(address)&jitter->bytecode->globals[global_index]);
+    return;
+  }
+  EMIT_RAW(jitter, 0x48, 0x8D, 0x05); /* lea rax, [rip + rel32] */
+  emit_uint32(jitter, 0);
+  add_fixup(&jitter->addresses, &jitter->addresses_count, &jitter->addresses_capacity, jitter->code_size - 4, global_index);
+}
+
+/* the globals of the virtual machine are values, but those of an object are
+   stored as they're declared, so they're narrowed and widened like C's */
+static void load_global(jitter *jitter, uint destination, uint global_index)
+{
+  emit_global_address(jitter, global_index);
+  type *type = get_type(jitter->bytecode->global_types[global_index]);
+  location source = memory(register_rax, 0);
+  if (!jitter->is_relocatable || type->size == sizeof(uint64)) load_general(jitter, destination, source);
+  else if (type->kind == type_kind_float)
+  {
+    EMIT(jitter, 0xF3, 0, 0, source, 0x0F, 0x10);    /* movss */
+    EMIT(jitter, 0xF3, 0, 0, vector(0), 0x0F, 0x5A); /* cvtss2sd */
+    load_general(jitter, destination, vector(0));
+  }
+  else if (type->kind == type_kind_signed)
+  {
+    if (type->size == sizeof(uint32))      EMIT(jitter, 0, 1, destination, source, 0x63);       /* movsxd */
+    else if (type->size == sizeof(uint16)) EMIT(jitter, 0, 1, destination, source, 0x0F, 0xBF); /* movsx */
+    else                                   EMIT(jitter, 0, 1, destination, source, 0x0F, 0xBE); /* movsx */
+  }
+  else
+  {
+    if (type->size == sizeof(uint32))      EMIT(jitter, 0, 0, destination, source, 0x8B);       /* mov, which zeroes the upper half */
+    else if (type->size == sizeof(uint16)) EMIT(jitter, 0, 0, destination, source, 0x0F, 0xB7); /* movzx */
+    else                                   EMIT(jitter, 0, 0, destination, source, 0x0F, 0xB6); /* movzx */
+  }
+}
+
+/* the source mustn't be `rax`, which holds the address */
+static void store_global(jitter *jitter, uint global_index, uint source)
+{
+  emit_global_address(jitter, global_index);
+  type *type = get_type(jitter->bytecode->global_types[global_index]);
+  location destination = memory(register_rax, 0);
+  if (!jitter->is_relocatable || type->size == sizeof(uint64)) store_general(jitter, destination, source);
+  else if (type->kind == type_kind_float)
+  {
+    store_general(jitter, vector(0), source);
+    EMIT(jitter, 0xF2, 0, 0, vector(0), 0x0F, 0x5A);   /* cvtsd2ss */
+    EMIT(jitter, 0xF3, 0, 0, destination, 0x0F, 0x11); /* movss */
+  }
+  else if (type->size == sizeof(uint32)) EMIT(jitter, 0,    0, source, destination, 0x89);
+  else if (type->size == sizeof(uint16)) EMIT(jitter, 0x66, 0, source, destination, 0x89);
+  else                                   EMIT(jitter, 0,    0, source, destination, 0x88);
+}
+
+static void emit_divided_by_zero(jitter *jitter)
+{
+  if (!jitter->is_relocatable)
+  {
+    emit_call_address(jitter, divide_by_zero_in_machine_code);
+    return;
+  }
+  emit_byte(jitter, 0xE8); /* call rel32 */
+  emit_uint32(jitter, 0);
+  add_fixup(&jitter->calls, &jitter->calls_count, &jitter->calls_capacity, jitter->code_size - 4, jitter->bytecode->procedures_count);
+}
+
+/* the saturating conversions of `run_bytecode`, from `xmm0` into `rax`.
+   `cvttsd2si` gives 1 << 63 for NaN and numbers out of range, which are then
+   told apart by their bits in `rcx`. */
+static void emit_float_to_signed(jitter *jitter)
+{
+  EMIT(jitter, 0xF2, 1, register_rax, vector(0), 0x0F, 0x2C);  /* cvttsd2si rax, xmm0 */
+  emit_move_immediate(jitter, register_rcx, (uint64)1 << 63);
+  EMIT(jitter, 0, 1, register_rax, general(register_rcx), 0x3B); /* cmp rax, rcx */
+  uint in_range = emit_forward_jump(jitter, condition_unequal);
+  EMIT(jitter, 0x66, 0, 0, vector(0), 0x0F, 0x2E);              /* ucomisd xmm0, xmm0 */
+  uint not_number = emit_forward_jump(jitter, condition_parity);
+  EMIT(jitter, 0x66, 1, 0, general(register_rcx), 0x0F, 0x7E);  /* movq rcx, xmm0 */
+  EMIT(jitter, 0, 1, register_rcx, general(register_rcx), 0x85); /* test rcx, rcx */
+  uint negative = emit_forward_jump(jitter, condition_sign);
+  EMIT(jitter, 0, 1, 1, general(register_rax), 0xFF);            /* dec rax, the greatest */
+  uint positive = emit_forward_jump(jitter, condition_always);
+  patch_forward(jitter, not_number);
+  EMIT(jitter, 0, 0, register_rax, general(register_rax), 0x33); /* xor eax, eax */
+  patch_forward(jitter, in_range);
+  patch_forward(jitter, negative);
+  patch_forward(jitter, positive);
+}
+
+static void emit_float_to_unsigned(jitter *jitter)
+{
+  /* what's negative, even zero or NaN, is 0 */
+  EMIT(jitter, 0x66, 1, 0, general(register_rcx), 0x0F, 0x7E);  /* movq rcx, xmm0 */
+  EMIT(jitter, 0, 0, register_rax, general(register_rax), 0x33); /* xor eax, eax */
+  EMIT(jitter, 0, 1, register_rcx, general(register_rcx), 0x85); /* test rcx, rcx */
+  uint negative = emit_forward_jump(jitter, condition_sign);
+  emit_move_immediate(jitter, register_rax, 0x43F0000000000000);  /* 2^64 */
+  EMIT(jitter, 0, 1, register_rcx, general(register_rax), 0x3B); /* cmp rcx, rax */
+  uint above = emit_forward_jump(jitter, condition_above_or_equal);
+  EMIT(jitter, 0xF2, 1, register_rax, vector(0), 0x0F, 0x2C);  /* cvttsd2si rax, xmm0 */
+  EMIT(jitter, 0, 1, register_rax, general(register_rax), 0x85); /* test rax, rax */
+  uint below_half = emit_forward_jump(jitter, condition_not_sign);
+
+  /* those from 2^63 have its exponent, so they're their mantissas shifted
+     under the highest bit */
+  EMIT(jitter, 0, 1, register_rax, general(register_rcx), 0x8B); /* mov rax, rcx */
+  emit_shift_immediate(jitter, 4, register_rax, 11);             /* shl rax, 11 */
+  EMIT(jitter, 0, 1, 5, general(register_rax), 0x0F, 0xBA);      /* bts rax, 63 */
+  emit_byte(jitter, 63);
+  uint above_half = emit_forward_jump(jitter, condition_always);
+
+  /* those from 2^64 are the greatest, and NaN, whose bits are above those of
+     infinity, is 0; `mov` keeps the flags */
+  patch_forward(jitter, above);
+  emit_move_immediate(jitter, register_rax, 0x7FF0000000000000);  /* infinity */
+  EMIT(jitter, 0, 1, register_rcx, general(register_rax), 0x3B); /* cmp rcx, rax */
+  emit_move_immediate(jitter, register_rax, UINT64_MAX);
+  uint greatest = emit_forward_jump(jitter, condition_below_or_equal);
+  EMIT(jitter, 0, 0, register_rax, general(register_rax), 0x33); /* xor eax, eax */
+
+  patch_forward(jitter, negative);
+  patch_forward(jitter, below_half);
+  patch_forward(jitter, above_half);
+  patch_forward(jitter, greatest);
+}
+
+static void emit_epilogue(jitter *jitter)
+{
+  EMIT_RAW(jitter, 0x48, 0x81, 0xC4); /* add rsp, imm32 */
+  emit_uint32(jitter, jitter->frame_size);
+  for (uint i = jitter->preserved_count; i--;) emit_pop(jitter, jitter->preserved[i]);
+  emit_pop(jitter, register_rbp);
+  emit_byte(jitter, 0xC3); /* ret */
+}
+
+static void lower_division(jitter *jitter, instruction current)
+{
+  bit is_signed = current.operation == operation_divide_signed || current.operation == operation_modulo_signed;
+  bit is_modulo = current.operation == operation_modulo_signed || current.operation == operation_modulo_unsigned;
+  load_general(jitter, register_rcx, at(jitter, current.c));
+  load_general(jitter, register_rax, at(jitter, current.b));
+
+  EMIT(jitter, 0, 1, register_rcx, general(register_rcx), 0x85); /* test rcx, rcx */
+  uint nonzero = emit_forward_jump(jitter, condition_unequal);
+  emit_divided_by_zero(jitter);
+  patch_forward(jitter, nonzero);
+
+  if (is_signed)
+  {
+    /* the quotient of the least number by -1 overflows, and traps */
+    EMIT_RAW(jitter, 0x48, 0x83, 0xF9, 0xFF); /* cmp rcx, -1 */
+    uint ordinary = emit_forward_jump(jitter, condition_unequal);
+    if (is_modulo) EMIT_RAW(jitter, 0x31, 0xC0);                         /* xor eax, eax */
+    else EMIT(jitter, 0, 1, 3, general(register_rax), 0xF7);              /* neg rax */
+    uint done = emit_forward_jump(jitter, condition_always);
+    patch_forward(jitter, ordinary);
+    EMIT_RAW(jitter, 0x48, 0x99);                                         /* cqo */
+    EMIT(jitter, 0, 1, 7, general(register_rcx), 0xF7);                   /* idiv rcx */
+    if (is_modulo) EMIT(jitter, 0, 1, register_rax, general(register_rdx), 0x8B);
+    patch_forward(jitter, done);
+  }
+  else
+  {
+    EMIT_RAW(jitter, 0x31, 0xD2);                                         /* xor edx, edx */
+    EMIT(jitter, 0, 1, 6, general(register_rcx), 0xF7);                   /* div rcx */
+    if (is_modulo) EMIT(jitter, 0, 1, register_rax, general(register_rdx), 0x8B);
+  }
+  store_general(jitter, at(jitter, current.a), register_rax);
+}
+
+static void lower_shift(jitter *jitter, instruction current)
+{
+  load_general(jitter, register_rcx, at(jitter, current.c));
+  load_general(jitter, register_rax, at(jitter, current.b));
+
+  /* shifts by 64 bits or more clear, or fill with the sign */
+  EMIT_RAW(jitter, 0x48, 0x83, 0xF9, 0x3F); /* cmp rcx, 63 */
+  uint in_range = emit_forward_jump(jitter, condition_below_or_equal);
+  uint done = 0;
+  if (current.operation == operation_right_shift_signed) EMIT_RAW(jitter, 0xB9, 0x3F, 0x00, 0x00, 0x00); /* mov ecx, 63 */
+  else
+  {
+    EMIT_RAW(jitter, 0x31, 0xC0); /* xor eax, eax */
+    done = emit_forward_jump(jitter, condition_always);
+  }
+  patch_forward(jitter, in_range);
+  uint extension = current.operation == operation_left_shift ? 4 : current.operation == operation_right_shift_signed ? 7 : 5;
+  EMIT(jitter, 0, 1, extension, general(register_rax), 0xD3);
+  if (done) patch_forward(jitter, done);
+  store_general(jitter, at(jitter, current.a), register_rax);
+}
+
+static void lower_call(jitter *jitter, instruction current, uint callee_index)
+{
+  bytecode_procedure *callee = &jitter->bytecode->procedures[callee_index];
+  type_id callee_type = callee->type;
+
+  /* the arguments pass through the frame, since their registers may be
+     arguments themselves */
+  for (uint i = 0; i < current.b; ++i) move_location(jitter, get_outgoing(jitter, i), at(jitter, current.a + i));
+  uint generals_count = 0, vectors_count = 0;
+  for (uint i = 0; i < current.b; ++i)
+  {
+    type_id argument_type = get_type(callee_type)->components[i];
+    if (!is_float_type(argument_type))
+    {
+      load_general(jitter, argument_general_registers[generals_count++], get_outgoing(jitter, i));
+      continue;
+    }
+    uint argument_register = vectors_count++;
+    load_vector(jitter, argument_register, get_outgoing(jitter, i));
+    if (is_float32_type(argument_type)) EMIT(jitter, 0xF2, 0, argument_register, vector(argument_register), 0x0F, 0x5A); /* cvtsd2ss */
+  }
+
+  emit_byte(jitter, 0xE8); /* call rel32 */
+  emit_uint32(jitter, 0);
+  add_fixup(&jitter->calls, &jitter->calls_count, &jitter->calls_capacity, jitter->code_size - 4, callee_index);
+
+  if (!callee->results_count) return;
+  type_id result_type = get_type(callee_type)->components[get_type(callee_type)->arguments_count];
+  if (!is_float_type(result_type))
+  {
+    store_general(jitter, at(jitter, current.a), register_rax);
+    return;
+  }
+  if (is_float32_type(result_type)) EMIT(jitter, 0xF3, 0, 0, vector(0), 0x0F, 0x5A); /* cvtss2sd */
+  store_vector(jitter, at(jitter, current.a), 0);
+}
+
+static void lower_return(jitter *jitter, instruction current)
+{
+  bytecode_procedure *procedure = jitter->procedure;
+  if (current.b)
+  {
+    type_id result_type = get_type(procedure->type)->components[procedure->arguments_count];
+    if (!is_float_type(result_type)) load_general(jitter, register_rax, at(jitter, current.a));
+    else
+    {
+      load_vector(jitter, 0, at(jitter, current.a));
+      if (is_float32_type(result_type)) EMIT(jitter, 0xF2, 0, 0, vector(0), 0x0F, 0x5A); /* cvtsd2ss */
+    }
+  }
+  emit_epilogue(jitter);
+}
+
+static void lower_instruction(jitter *jitter, uint position)
+{
+  const instruction *code = jitter->procedure->code;
+  instruction current = code[position];
+  switch ((operation)current.operation)
+  {
+  case operation_move:
+    move_location(jitter, at(jitter, current.a), at(jitter, current.b));
+    break;
+  case operation_load:
+    {
+      uint64 value = (uint64)code[position + 1].immediate | (uint64)code[position + 2].immediate << 32;
+      location destination = at(jitter, current.a);
+      if (destination.kind == location_kind_general) emit_move_immediate(jitter, destination.index, value);
+      else
+      {
+        emit_move_immediate(jitter, register_rax, value);
+        store_general(jitter, destination, register_rax);
+      }
+      break;
+    }
+  case operation_get_global:
+    load_global(jitter, register_rax, code[position + 1].immediate);
+    store_general(jitter, at(jitter, current.a), register_rax);
+    break;
+  case operation_set_global:
+    load_general(jitter, register_rcx, at(jitter, current.a));
+    store_global(jitter, code[position + 1].immediate, register_rcx);
+    break;
+
+  case operation_add:
+  case operation_subtract:
+  case operation_multiply:
+  case operation_and:
+  case operation_or:
+  case operation_exclusive_or:
+    {
+      load_general(jitter, register_rax, at(jitter, current.b));
+      location operand = general_operand(jitter, at(jitter, current.c), register_rcx);
+      switch (current.operation)
+      {
+      case operation_add:          EMIT(jitter, 0, 1, register_rax, operand, 0x03);       break;
+      case operation_subtract:     EMIT(jitter, 0, 1, register_rax, operand, 0x2B);       break;
+      case operation_multiply:     EMIT(jitter, 0, 1, register_rax, operand, 0x0F, 0xAF); break;
+      case operation_and:          EMIT(jitter, 0, 1, register_rax, operand, 0x23);       break;
+      case operation_or:           EMIT(jitter, 0, 1, register_rax, operand, 0x0B);       break;
+      case operation_exclusive_or: EMIT(jitter, 0, 1, register_rax, operand, 0x33);       break;
+      }
+      store_general(jitter, at(jitter, current.a), register_rax);
+      break;
+    }
+  case operation_divide_signed:
+  case operation_divide_unsigned:
+  case operation_modulo_signed:
+  case operation_modulo_unsigned:
+    lower_division(jitter, current);
+    break;
+  case operation_left_shift:
+  case operation_right_shift_signed:
+  case operation_right_shift_unsigned:
+    lower_shift(jitter, current);
+    break;
+
+  case operation_add_float:
+  case operation_subtract_float:
+  case operation_multiply_float:
+  case operation_divide_float:
+    {
+      load_vector(jitter, 0, at(jitter, current.b));
+      location operand = vector_operand(jitter, at(jitter, current.c), 1);
+      switch (current.operation)
+      {
+      case operation_add_float:      EMIT(jitter, 0xF2, 0, 0, operand, 0x0F, 0x58); break;
+      case operation_subtract_float: EMIT(jitter, 0xF2, 0, 0, operand, 0x0F, 0x5C); break;
+      case operation_multiply_float: EMIT(jitter, 0xF2, 0, 0, operand, 0x0F, 0x59); break;
+      case operation_divide_float:   EMIT(jitter, 0xF2, 0, 0, operand, 0x0F, 0x5E); break;
+      }
+      store_vector(jitter, at(jitter, current.a), 0);
+      break;
+    }
+
+  case operation_equal:
+  case operation_unequal:
+  case operation_lesser_signed:
+  case operation_lesser_unsigned:
+  case operation_inclusive_lesser_signed:
+  case operation_inclusive_lesser_unsigned:
+    {
+      load_general(jitter, register_rax, at(jitter, current.b));
+      EMIT(jitter, 0, 1, register_rax, general_operand(jitter, at(jitter, current.c), register_rcx), 0x3B); /* cmp */
+      condition condition = current.operation == operation_equal                   ? condition_equal
+                          : current.operation == operation_unequal                 ? condition_unequal
+                          : current.operation == operation_lesser_signed           ? condition_less
+                          : current.operation == operation_lesser_unsigned         ? condition_below
+                          : current.operation == operation_inclusive_lesser_signed ? condition_less_or_equal
+                          :                                                          condition_below_or_equal;
+      emit_set(jitter, condition, register_rax);
+      store_condition(jitter, at(jitter, current.a));
+      break;
+    }
+  case operation_equal_float:
+  case operation_unequal_float:
+    load_vector(jitter, 0, at(jitter, current.b));
+    load_vector(jitter, 1, at(jitter, current.c));
+    EMIT(jitter, 0x66, 0, 0, vector(1), 0x0F, 0x2E); /* ucomisd xmm0, xmm1 */
+    /* unordered comparisons set the parity */
+    if (current.operation == operation_equal_float)
+    {
+      emit_set(jitter, condition_equal, register_rax);
+      emit_set(jitter, condition_not_parity, register_rcx);
+      EMIT_RAW(jitter, 0x20, 0xC8); /* and al, cl */
+    }
+    else
+    {
+      emit_set(jitter, condition_unequal, register_rax);
+      emit_set(jitter, condition_parity, register_rcx);
+      EMIT_RAW(jitter, 0x08, 0xC8); /* or al, cl */
+    }
+    store_condition(jitter, at(jitter, current.a));
+    break;
+  case operation_lesser_float:
+  case operation_inclusive_lesser_float:
+    /* `b < c` is `c > b`, which is false when unordered */
+    load_vector(jitter, 0, at(jitter, current.b));
+    load_vector(jitter, 1, at(jitter, current.c));
+    EMIT(jitter, 0x66, 0, 1, vector(0), 0x0F, 0x2E); /* ucomisd xmm1, xmm0 */
+    emit_set(jitter, current.operation == operation_lesser_float ? condition_above : condition_above_or_equal, register_rax);
+    store_condition(jitter, at(jitter, current.a));
+    break;
+
+  case operation_negate:
+  case operation_not:
+    load_general(jitter, register_rax, at(jitter, current.b));
+    EMIT(jitter, 0, 1, current.operation == operation_negate ? 3 : 2, general(register_rax), 0xF7);
+    store_general(jitter, at(jitter, current.a), register_rax);
+    break;
+  case operation_negate_float:
+    load_general(jitter, register_rax, at(jitter, current.b));
+    emit_move_immediate(jitter, register_rcx, (uint64)1 << 63);
+    EMIT(jitter, 0, 1, register_rax, general(register_rcx), 0x33); /* xor rax, rcx */
+    store_general(jitter, at(jitter, current.a), register_rax);
+    break;
+  case operation_test:
+  case operation_logical_not:
+    load_general(jitter, register_rax, at(jitter, current.b));
+    EMIT(jitter, 0, 1, register_rax, general(register_rax), 0x85); /* test rax, rax */
+    emit_set(jitter, current.operation == operation_test ? condition_unequal : condition_equal, register_rax);
+    store_condition(jitter, at(jitter, current.a));
+    break;
+  case operation_test_float:
+    load_vector(jitter, 0, at(jitter, current.b));
+    EMIT(jitter, 0x66, 0, 1, vector(1), 0x0F, 0x57); /* xorpd xmm1, xmm1 */
+    EMIT(jitter, 0x66, 0, 0, vector(1), 0x0F, 0x2E); /* ucomisd xmm0, xmm1 */
+    emit_set(jitter, condition_unequal, register_rax);
+    emit_set(jitter, condition_parity, register_rcx);
+    EMIT_RAW(jitter, 0x08, 0xC8); /* or al, cl */
+    store_condition(jitter, at(jitter, current.a));
+    break;
+
+  case operation_truncate_signed:
+  case operation_truncate_unsigned:
+    load_general(jitter, register_rax, at(jitter, current.b));
+    emit_truncation(jitter, register_rax, current.operation == operation_truncate_signed, current.c);
+    store_general(jitter, at(jitter, current.a), register_rax);
+    break;
+  case operation_round_float32:
+    load_vector(jitter, 0, at(jitter, current.b));
+    EMIT(jitter, 0xF2, 0, 0, vector(0), 0x0F, 0x5A); /* cvtsd2ss */
+    EMIT(jitter, 0xF3, 0, 0, vector(0), 0x0F, 0x5A); /* cvtss2sd */
+    store_vector(jitter, at(jitter, current.a), 0);
+    break;
+  case operation_convert_signed_to_float:
+    load_general(jitter, register_rax, at(jitter, current.b));
+    EMIT(jitter, 0xF2, 1, 0, general(register_rax), 0x0F, 0x2A); /* cvtsi2sd xmm0, rax */
+    store_vector(jitter, at(jitter, current.a), 0);
+    break;
+  case operation_convert_unsigned_to_float:
+    {
+      /* numbers of the highest bit are halved, keeping the lowest bit for
+         rounding, and doubled */
+      load_general(jitter, register_rax, at(jitter, current.b));
+      EMIT(jitter, 0, 1, register_rax, general(register_rax), 0x85); /* test rax, rax */
+      uint large = emit_forward_jump(jitter, condition_sign);
+      EMIT(jitter, 0xF2, 1, 0, general(register_rax), 0x0F, 0x2A);  /* cvtsi2sd xmm0, rax */
+      uint done = emit_forward_jump(jitter, condition_always);
+      patch_forward(jitter, large);
+      EMIT(jitter, 0, 1, register_rcx, general(register_rax), 0x8B); /* mov rcx, rax */
+      EMIT(jitter, 0, 1, 5, general(register_rcx), 0xD1);            /* shr rcx, 1 */
+      EMIT_RAW(jitter, 0x83, 0xE0, 0x01);                             /* and eax, 1 */
+      EMIT(jitter, 0, 1, register_rcx, general(register_rax), 0x0B); /* or rcx, rax */
+      EMIT(jitter, 0xF2, 1, 0, general(register_rcx), 0x0F, 0x2A);  /* cvtsi2sd xmm0, rcx */
+      EMIT(jitter, 0xF2, 0, 0, vector(0), 0x0F, 0x58);               /* addsd xmm0, xmm0 */
+      patch_forward(jitter, done);
+      store_vector(jitter, at(jitter, current.a), 0);
+      break;
+    }
+  case operation_convert_float_to_signed:
+  case operation_convert_float_to_unsigned:
+    load_vector(jitter, 0, at(jitter, current.b));
+    if (current.operation == operation_convert_float_to_signed) emit_float_to_signed(jitter);
+    else emit_float_to_unsigned(jitter);
+    store_general(jitter, at(jitter, current.a), register_rax);
+    break;
+
+  case operation_jump:
+    emit_forward_jump(jitter, condition_always);
+    add_fixup(&jitter->jumps, &jitter->jumps_count, &jitter->jumps_capacity, jitter->code_size - 4, position + 2 + code[position + 1].immediate);
+    break;
+  case operation_jump_if_zero:
+    load_general(jitter, register_rax, at(jitter, current.a));
+    EMIT(jitter, 0, 1, register_rax, general(register_rax), 0x85); /* test rax, rax */
+    emit_forward_jump(jitter, condition_equal);
+    add_fixup(&jitter->jumps, &jitter->jumps_count, &jitter->jumps_capacity, jitter->code_size - 4, position + 2 + code[position + 1].immediate);
+    break;
+  case operation_call:
+    lower_call(jitter, current, code[position + 1].immediate);
+    break;
+  case operation_return:
+    lower_return(jitter, current);
+    break;
+
+  case operations_count:
+    UNREACHABLE();
+  }
+}
+
+static void compile_jitted_procedure(uint procedure_index, jitter *jitter)
+{
+  bytecode_procedure *procedure = &jitter->bytecode->procedures[procedure_index];
+  jitter->procedure = procedure;
+
+  sint *positions_of_calls = allocate(procedure->code_size * sizeof(sint) + sizeof(sint));
+  uint calls_count;
+  analyze_intervals(jitter, positions_of_calls, &calls_count);
+  deallocate(positions_of_calls, procedure->code_size * sizeof(sint) + sizeof(sint));
+  allocate_locations(jitter);
+
+  uint outgoing_count = procedure->arguments_count;
+  for (uint i = 0; i < procedure->code_size; i += get_instruction_size(&procedure->code[i]))
+    if (procedure->code[i].operation == operation_call && procedure->code[i].b > outgoing_count) outgoing_count = procedure->code[i].b;
+  lay_out_frame(jitter, outgoing_count);
+
+  /* the prologue */
+  emit_push(jitter, register_rbp);
+  EMIT_RAW(jitter, 0x48, 0x89, 0xE5); /* mov rbp, rsp */
+  for (uint i = 0; i < jitter->preserved_count; ++i) emit_push(jitter, jitter->preserved[i]);
+  EMIT_RAW(jitter, 0x48, 0x81, 0xEC); /* sub rsp, imm32 */
+  emit_uint32(jitter, jitter->frame_size);
+
+  /* the arguments pass through the frame to their registers, converted to
+     their representations in registers */
+  type_id procedure_type = procedure->type;
+  uint generals_count = 0, vectors_count = 0;
+  for (uint i = 0; i < procedure->arguments_count; ++i)
+  {
+    type_id argument_type = get_type(procedure_type)->components[i];
+    if (!is_float_type(argument_type))
+    {
+      store_general(jitter, get_outgoing(jitter, i), argument_general_registers[generals_count++]);
+      continue;
+    }
+    uint argument_register = vectors_count++;
+    if (is_float32_type(argument_type)) EMIT(jitter, 0xF3, 0, argument_register, vector(argument_register), 0x0F, 0x5A); /* cvtss2sd */
+    store_vector(jitter, get_outgoing(jitter, i), argument_register);
+  }
+  for (uint i = 0; i < procedure->arguments_count; ++i)
+  {
+    type *argument_type = get_type(get_type(procedure_type)->components[i]);
+    if (argument_type->kind == type_kind_float || jitter->intervals[i].ending < 0)
+    {
+      move_location(jitter, at(jitter, i), get_outgoing(jitter, i));
+      continue;
+    }
+    load_general(jitter, register_rax, get_outgoing(jitter, i));
+    if (argument_type->kind == type_kind_bit)
+    {
+      EMIT(jitter, 0, 1, register_rax, general(register_rax), 0x85); /* test rax, rax */
+      emit_set(jitter, condition_unequal, register_rax);
+      emit_extend_al(jitter);
+    }
+    else if (argument_type->size < sizeof(uint64)) emit_truncation(jitter, register_rax, argument_type->kind == type_kind_signed, argument_type->size * 8);
+    store_general(jitter, at(jitter, i), register_rax);
+  }
+
+  if (jitter->positions_capacity < procedure->code_size + 1)
+  {
+    uint capacity = procedure->code_size + 1;
+    jitter->positions = reallocate(capacity * sizeof(uint), jitter->positions, jitter->positions_capacity * sizeof(uint));
+    jitter->positions_capacity = capacity;
+  }
+  jitter->jumps_count = 0;
+  for (uint i = 0; i < procedure->code_size; i += get_instruction_size(&procedure->code[i]))
+  {
+    jitter->positions[i] = jitter->code_size;
+    lower_instruction(jitter, i);
+  }
+  jitter->positions[procedure->code_size] = jitter->code_size;
+
+  for (uint i = 0; i < jitter->jumps_count; ++i)
+  {
+    fixup *jump = &jitter->jumps[i];
+    patch_uint32(jitter, jump->position, jitter->positions[jump->target] - (jump->position + 4));
+  }
+}
+
+/* `void thunk(const value *arguments, value *results)` */
+static void emit_thunk(uint procedure_index, jitter *jitter)
+{
+  bytecode_procedure *procedure = &jitter->bytecode->procedures[procedure_index];
+  type_id procedure_type = procedure->type;
+
+  emit_push(jitter, register_rbx);
+  EMIT(jitter, 0, 1, register_rbx, general(register_rsi), 0x8B); /* mov rbx, rsi */
+
+  /* `rdi` is loaded last, since it points to the arguments */
+  uint generals[countof(argument_general_registers)];
+  uint generals_count = 0, vectors_count = 0;
+  for (uint i = 0; i < procedure->arguments_count; ++i)
+  {
+    type_id argument_type = get_type(procedure_type)->components[i];
+    if (!is_float_type(argument_type))
+    {
+      generals[generals_count++] = i;
+      continue;
+    }
+    uint argument_register = vectors_count++;
+    load_vector(jitter, argument_register, memory(register_rdi, (sint32)(i * sizeof(value))));
+    if (is_float32_type(argument_type)) EMIT(jitter, 0xF2, 0, argument_register, vector(argument_register), 0x0F, 0x5A); /* cvtsd2ss */
+  }
+  for (uint i = generals_count; i--;)
+    load_general(jitter, argument_general_registers[i], memory(register_rdi, (sint32)(generals[i] * sizeof(value))));
+
+  emit_byte(jitter, 0xE8); /* call rel32 */
+  emit_uint32(jitter, 0);
+  add_fixup(&jitter->calls, &jitter->calls_count, &jitter->calls_capacity, jitter->code_size - 4, procedure_index);
+
+  if (procedure->results_count)
+  {
+    type_id result_type = get_type(procedure_type)->components[procedure->arguments_count];
+    if (!is_float_type(result_type)) store_general(jitter, memory(register_rbx, 0), register_rax);
+    else
+    {
+      if (is_float32_type(result_type)) EMIT(jitter, 0xF3, 0, 0, vector(0), 0x0F, 0x5A); /* cvtss2sd */
+      store_vector(jitter, memory(register_rbx, 0), 0);
+    }
+  }
+  emit_pop(jitter, register_rbx);
+  emit_byte(jitter, 0xC3); /* ret */
+}
+
+/* returns which procedures can be compiled, of `procedures_count` bits; the
+   procedures that invoke procedures which can't be compiled can't be either */
+static bit *find_jittable_procedures(bytecode *bytecode)
+{
+  uint procedures_count = bytecode->procedures_count;
+  bit *is_jittable = allocate(procedures_count);
+  is_jittable[0] = 0;
+  for (uint i = 1; i < procedures_count; ++i) is_jittable[i] = has_jittable_signature(&bytecode->procedures[i]);
+  for (bit has_changed = 1; has_changed;)
+  {
+    has_changed = 0;
+    for (uint i = 1; i < procedures_count; ++i)
+    {
+      if (!is_jittable[i] || !calls_unjittable(&bytecode->procedures[i], is_jittable)) continue;
+      is_jittable[i] = 0;
+      has_changed = 1;
+    }
+  }
+  return is_jittable;
+}
+
+uint compile_jit(bytecode *bytecode, jit *jit)
+{
+  zero(jit, sizeof(*jit));
+  jit->bytecode = bytecode;
+  uint procedures_count = bytecode->procedures_count;
+  jit->entries = push_type(uint, procedures_count, context.allocator);
+  jit->thunks  = push_type(uint, procedures_count, context.allocator);
+  bit *is_jittable = find_jittable_procedures(bytecode);
+
+  jitter jitter =
+  {
+    .bytecode = bytecode,
+    .jit      = jit,
+  };
+  uint compiled_count = 0;
+  for (uint i = 0; i < procedures_count; ++i)
+  {
+    jit->entries[i] = jit->thunks[i] = no_jit_entry;
+    if (!is_jittable[i]) continue;
+    jit->entries[i] = jitter.code_size;
+    compile_jitted_procedure(i, &jitter);
+    compiled_count += 1;
+  }
+  for (uint i = 0; i < procedures_count; ++i)
+  {
+    if (!is_jittable[i]) continue;
+    jit->thunks[i] = jitter.code_size;
+    emit_thunk(i, &jitter);
+  }
+  for (uint i = 0; i < jitter.calls_count; ++i)
+  {
+    fixup *call = &jitter.calls[i];
+    patch_uint32(&jitter, call->position, jit->entries[call->target] - (call->position + 4));
+  }
+
+  /* the code is copied to memory that's executable but not writable */
+  if (jitter.code_size)
+  {
+    jit->code_size = jitter.code_size;
+    jit->code = allocate(jit->code_size);
+    copy(jit->code, jitter.code, jit->code_size);
+    if (!protect_executable(jit->code, jit->code_size))
+    {
+      print_failure("Failed to make machine code executable.\n");
+      deallocate(jit->code, jit->code_size);
+      jit->code = 0;
+      jit->code_size = 0;
+      compiled_count = 0;
+      for (uint i = 0; i < procedures_count; ++i) jit->entries[i] = jit->thunks[i] = no_jit_entry;
+    }
+  }
+
+  deallocate(is_jittable, procedures_count);
+  if (jitter.code)      deallocate(jitter.code, jitter.code_capacity);
+  if (jitter.positions) deallocate(jitter.positions, jitter.positions_capacity * sizeof(uint));
+  if (jitter.jumps)     deallocate(jitter.jumps, jitter.jumps_capacity * sizeof(fixup));
+  if (jitter.calls)     deallocate(jitter.calls, jitter.calls_capacity * sizeof(fixup));
+  return compiled_count;
+}
+
+void release_jit(jit *jit)
+{
+  if (jit->code) deallocate(jit->code, jit->code_size);
+  jit->code = 0;
+  jit->code_size = 0;
+}
+
+void *find_jitted_procedure(const utf8 *name, jit *jit)
+{
+  sintl procedure_index = find_bytecode_procedure(name, jit->bytecode);
+  if (procedure_index < 0 || jit->entries[procedure_index] == no_jit_entry) return 0;
+  return jit->code + jit->entries[procedure_index];
+}
+
+bit run_jitted(uint procedure_index, const value *arguments, value *results, jit *jit)
+{
+  if (jit->thunks[procedure_index] == no_jit_entry) return 0;
+  void (*thunk)(const value *, value *) = (void (*)(const value *, value *))(address)(jit->code + jit->thunks[procedure_index]);
+
+  /* failures in machine code jump here */
+  jump_point failure_jump_point;
+  jump_point *prior_failure_jump_point = context.failure_jump_point;
+  context.failure_jump_point = &failure_jump_point;
+  bit succeeded = 1;
+  if (set_jump_point(failure_jump_point)) succeeded = 0;
+  else thunk(arguments, results);
+  context.failure_jump_point = prior_failure_jump_point;
+  return succeeded;
+}
+
+#else
+
+uint compile_jit(bytecode *bytecode, jit *jit)
+{
+  zero(jit, sizeof(*jit));
+  jit->bytecode = bytecode;
+  return 0;
+}
+
+void release_jit(jit *jit)
+{
+  (void)jit;
+}
+
+void *find_jitted_procedure(const utf8 *name, jit *jit)
+{
+  (void)name;
+  (void)jit;
+  return 0;
+}
+
+bit run_jitted(uint procedure_index, const value *arguments, value *results, jit *jit)
+{
+  (void)procedure_index;
+  (void)arguments;
+  (void)results;
+  (void)jit;
+  return 0;
+}
+
+#endif
@@ -0,0 +1,242 @@
+#include "proglosa.h"
+
+/*****************************************************************************/
+
+typedef enum
+{
+  layout_state_unlaid,
+  layout_state_laying,
+  layout_state_laid,
+} layout_state;
+
+typedef struct
+{
+  program              *program;
+  const layout_options *options;
+  uint8                *states; /* of each type */
+} layouter;
+
+static expression *get_structure_expression(structure_node *structure)
+{
+  return (expression *)((byte *)structure - offsetof(expression, data));
+}
+
+/* anonymous structures are interned once before their fields are known */
+static bit is_laid_structure(type_id id)
+{
+  type *type = get_type(id);
+  return type->kind == type_kind_structure && type->components_count == type->structure->declarations_count;
+}
+
+static bit is_stored_field(declaration_node *field, type_id id)
+{
+  type_kind kind = get_type(id)->kind;
+  return !field->is_constant && kind != type_kind_none && kind != type_kind_type;
+}
+
+/* the fields of a structure in the order they're laid out; when they're
+   reordered, fields of greater alignment precede the others, which leaves
+   padding only at the ending */
+static void order_fields(type_id id, declaration_node **fields, uint *order, bit is_reordering)
+{
+  type *type = get_type(id);
+  uint i = 0;
+  for (statement *field = type->structure->declarations; field; field = field->next, ++i)
+  {
+    fields[i] = &field->expression.data->declaration;
+    order[i] = i;
+  }
+  if (!is_reordering) return;
+  for (uint j = 1; j < type->components_count; ++j)
+  {
+    uint current = order[j], k = j;
+    for (; k && get_type(type->components[order[k - 1]])->alignment < get_type(type->components[current])->alignment; --k) order[k] = order[k - 1];
+    order[k] = current;
+  }
+}
+
+static void lay_out_type(type_id id, layouter *layouter);
+
+static void lay_out_structure(type_id id, layouter *layouter)
+{
+  type *structure = get_type(id);
+  for (uint i = 0; i < structure->components_count; ++i) lay_out_type(structure->components[i], layouter);
+
+  structure = get_type(id);
+  uint fields_count = structure->components_count;
+  declaration_node **fields = allocate(fields_count * sizeof(declaration_node *) + 1);
+  uint *order = allocate(fields_count * sizeof(uint) + 1);
+  order_fields(id, fields, order, layouter->options->is_reordering_fields);
+
+  structure->offsets = push_type(uint, fields_count + 1, &structure->program->allocator);
+  uint size = 0, alignment = 1, stored_size = 0;
+  for (uint i = 0; i < fields_count; ++i)
+  {
+    uint field = order[i];
+    type *field_type = get_type(structure->components[field]);
+    structure->offsets[field] = no_offset;
+    if (!is_stored_field(fields[field], structure->components[field])) continue;
+    size = (uint)align_forwards(size, field_type->alignment);
+    structure->offsets[field] = size;
+    size += field_type->size;
+    stored_size += field_type->size;
+    if (field_type->alignment > alignment) alignment = field_type->alignment;
+  }
+
+  /* a structure without stored fields still has an address */
+  structure->size = size ? (uint)align_forwards(size, alignment) : 1;
+  structure->alignment = alignment;
+  structure->padding_size = size ? structure->size - stored_size : 0;
+
+  deallocate(order, fields_count * sizeof(uint) + 1);
+  deallocate(fields, fields_count * sizeof(declaration_node *) + 1);
+
+  if (structure->padding_size)
+  {
+    utf8 representation[type_representation_size];
+    report_expression_comment(layouter->program, get_structure_expression(structure->structure), "%u of the %u bytes of %s are padding.",
+                              structure->padding_size, structure->size, represent_type(representation, type_representation_size, id));
+  }
+}
+
+void lay_out_type(type_id id, layouter *layouter)
+{
+  switch ((layout_state)layouter->states[id])
+  {
+  case layout_state_laid:
+    return;
+  case layout_state_laying:
+    {
+      /* only a structure can contain itself, which is infinite */
+      utf8 representation[type_representation_size];
+      report_expression_failure(layouter->program, get_structure_expression(get_type(id)->structure), "%s contains itself.",
+                                represent_type(representation, type_representation_size, id));
+      get_type(id)->alignment = 1;
+      return;
+    }
+  case layout_state_unlaid:
+    break;
+  }
+  layouter->states[id] = layout_state_laying;
+
+  type *type = get_type(id);
+  switch (type->kind)
+  {
+  case type_kind_none:
+  case type_kind_type:
+  case type_kind_integer:
+  case type_kind_decimal:
+    type->alignment = 1;
+    break;
+  case type_kind_unsigned:
+  case type_kind_signed:
+  case type_kind_float:
+  case type_kind_bit:
+  case type_kind_pointer:
+  case type_kind_procedure:
+    type->alignment = type->size;
+    break;
+  case type_kind_structure:
+    if (is_laid_structure(id)) lay_out_structure(id, layouter);
+    else type->alignment = 1;
+    break;
+  }
+  layouter->states[id] = layout_state_laid;
+}
+
+void lay_out_types(program *program, const layout_options *options)
+{
+  layouter layouter =
+  {
+    .program = program,
+    .options = options,
+    .states  = allocate(types.types_count),
+  };
+  /* the types are interned for every program of the process, and those
+     laid out for a prior one keep their layouts */
+  for (type_id id = 0; id < types.types_count; ++id)
+    layouter.states[id] = get_type(id)->alignment ? layout_state_laid : layout_state_unlaid;
+  for (type_id id = 1; id < types.types_count; ++id) lay_out_type(id, &layouter);
+  deallocate(layouter.states, types.types_count);
+
+  for (uint i = 0; i < options->struct_of_arrays_count; ++i)
+  {
+    const utf8 *name = options->struct_of_arrays[i];
+    bit is_found = 0;
+    for (type_id id = 1; id < types.types_count; ++id)
+    {
+      type *type = get_type(id);
+      if (type->kind != type_kind_structure || !type->declaration || compare_string(type->declaration->identifier.runes, name)) continue;
+      type->is_struct_of_arrays = 1;
+      is_found = 1;
+    }
+    if (!is_found)
+    {
+      print_failure("%s isn't a named structure.\n", name);
+      program->failures_count += 1;
+    }
+  }
+}
+
+/* the arrays are ordered by the alignments of their fields, so none is
+   padded when the count varies */
+uint lay_out_arrays(type_id id, uint count, uint *offsets)
+{
+  type *structure = get_type(id);
+  uint fields_count = structure->components_count;
+  declaration_node **fields = allocate(fields_count * sizeof(declaration_node *) + 1);
+  uint *order = allocate(fields_count * sizeof(uint) + 1);
+  order_fields(id, fields, order, 1);
+
+  uint size = 0;
+  for (uint i = 0; i < fields_count; ++i)
+  {
+    uint field = order[i];
+    type *field_type = get_type(structure->components[field]);
+    offsets[field] = no_offset;
+    if (!is_stored_field(fields[field], structure->components[field])) continue;
+    size = (uint)align_forwards(size, field_type->alignment);
+    offsets[field] = size;
+    size += field_type->size * count;
+  }
+
+  deallocate(order, fields_count * sizeof(uint) + 1);
+  deallocate(fields, fields_count * sizeof(declaration_node *) + 1);
+  return (uint)align_forwards(size, structure->alignment);
+}
+
+void print_layouts(void)
+{
+  for (type_id id = 1; id < types.types_count; ++id)
+  {
+    if (!is_laid_structure(id)) continue;
+    type *type = get_type(id);
+    utf8 representation[type_representation_size];
+    printf("%s: %u bytes, aligned to %u, of which %u are padding\n", represent_type(representation, type_representation_size, id),
+           type->size, type->alignment, type->padding_size);
+
+    uint i = 0;
+    for (statement *field = type->structure->declarations; field; field = field->next, ++i)
+    {
+      const utf8 *name = field->expression.data->declaration.identifier.runes;
+      if (type->offsets[i] == no_offset) continue;
+      printf("  %s: %s at %u\n", name, represent_type(representation, type_representation_size, type->components[i]), type->offsets[i]);
+    }
+    if (!type->is_struct_of_arrays) continue;
+
+    /* the offsets of the arrays of one structure are their coefficients */
+    uint *offsets = allocate(type->components_count * sizeof(uint) + 1);
+    lay_out_arrays(id, 1, offsets);
+    printf("  as arrays of n:");
+    i = 0;
+    bit is_first = 1;
+    for (statement *field = type->structure->declarations; field; field = field->next, ++i)
+    {
+      if (offsets[i] == no_offset) continue;
+      printf(offsets[i] ? "%s %s at %un" : "%s %s at 0", is_first ? "" : ",", field->expression.data->declaration.identifier.runes, offsets[i]);
+      is_first = 0;
+    }
+    printf("\n");
+    deallocate(offsets, type->components_count * sizeof(uint) + 1);
+  }
+}
@@ -0,0 +1,866 @@
+#include "proglosa.h"
+
+/*****************************************************************************/
+
+/* a value of a JSON message, whose strings are decoded */
+typedef enum
+{
+  json_kind_null,
+  json_kind_boolean,
+  json_kind_number,
+  json_kind_string,
+  json_kind_array,
+  json_kind_object,
+} json_kind;
+
+typedef struct json_value json_value;
+struct json_value
+{
+  json_kind   kind;
+  const utf8 *raw;         /* the text of the value, which ids are answered with */
+  uint        raw_size;
+  float64     number;      /* or the boolean */
+  utf8       *string;      /* terminated */
+  uint        string_size;
+  json_value *first;       /* of the elements or members */
+  json_value *next;        /* within the enclosing array or object */
+  utf8       *key;         /* of a member */
+};
+
+typedef struct
+{
+  const utf8 *cursor;
+  const utf8 *ending;
+  allocator  *allocator;
+  bit         has_failed : 1;
+} json_reader;
+
+static void skip_json_spaces(json_reader *reader)
+{
+  while (reader->cursor < reader->ending && (*reader->cursor == ' ' || *reader->cursor == '\t' || *reader->cursor == '\n' || *reader->cursor == '\r'))
+    ++reader->cursor;
+}
+
+static uint read_json_hexadecimal(json_reader *reader)
+{
+  uint result = 0;
+  for (uint i = 0; i < 4; ++i)
+  {
+    if (reader->cursor == reader->ending || !isxdigit((byte)*reader->cursor))
+    {
+      reader->has_failed = 1;
+      return 0;
+    }
+    utf8 digit = *reader->cursor++;
+    result = result * 16 + (uint)(digit <= '9' ? digit - '0' : (digit | 0x20) - 'a' + 10);
+  }
+  return result;
+}
+
+/* decodes a string, whose decoding is never longer than its text */
+static utf8 *read_json_string(uint *string_size, json_reader *reader)
+{
+  ++reader->cursor; /* skip `"` */
+  const utf8 *beginning = reader->cursor;
+  while (reader->cursor < reader->ending && *reader->cursor != '"') reader->cursor += *reader->cursor == '\\' ? 2 : 1;
+  if (reader->cursor >= reader->ending)
+  {
+    reader->has_failed = 1;
+    return 0;
+  }
+  const utf8 *ending = reader->cursor++;
+
+  utf8 *string = push_type(utf8, (uint)(ending - beginning) + 1, reader->allocator);
+  uint size = 0;
+  json_reader escapes = { .cursor = beginning, .ending = ending, .allocator = reader->allocator };
+  while (escapes.cursor < ending)
+  {
+    utf8 c = *escapes.cursor++;
+    if (c != '\\')
+    {
+      string[size++] = c;
+      continue;
+    }
+    switch (*escapes.cursor++)
+    {
+    case 'b': string[size++] = '\b'; break;
+    case 'f': string[size++] = '\f'; break;
+    case 'n': string[size++] = '\n'; break;
+    case 'r': string[size++] = '\r'; break;
+    case 't': string[size++] = '\t'; break;
+    case 'u':
+      {
+        utf32 rune = read_json_hexadecimal(&escapes);
+        /* a rune past the basic plane is escaped as a surrogate pair */
+        if (rune >= 0xd800 && rune < 0xdc00 && escapes.cursor + 6 <= ending && escapes.cursor[0] == '\\' && escapes.cursor[1] == 'u')
+        {
+          escapes.cursor += 2;
+          utf32 low = read_json_hexadecimal(&escapes);
+          rune = 0x10000 + ((rune - 0xd800) << 10) + (low - 0xdc00);
+        }
+        size += encode_utf8(string + size, rune);
+        break;
+      }
+    default:
+      string[size++] = escapes.cursor[-1];
+      break;
+    }
+  }
+  if (escapes.has_failed) reader->has_failed = 1;
+  string[size] = 0;
+  *string_size = size;
+  return string;
+}
+
+static json_value *read_json(json_reader *reader)
+{
+  skip_json_spaces(reader);
+  if (reader->cursor >= reader->ending)
+  {
+    reader->has_failed = 1;
+    return 0;
+  }
+
+  json_value *value = push_type(json_value, 1, reader->allocator);
+  value->raw = reader->cursor;
+  switch (*reader->cursor)
+  {
+  case '{':
+  case '[':
+    {
+      bit is_object = *reader->cursor++ == '{';
+      value->kind = is_object ? json_kind_object : json_kind_array;
+      skip_json_spaces(reader);
+      if (reader->cursor < reader->ending && *reader->cursor == (is_object ? '}' : ']'))
+      {
+        ++reader->cursor;
+        break;
+      }
+      for (json_value *prior = 0; !reader->has_failed;)
+      {
+        utf8 *key = 0;
+        if (is_object)
+        {
+          skip_json_spaces(reader);
+          uint key_size;
+          if (reader->cursor >= reader->ending || *reader->cursor != '"') goto failed;
+          key = read_json_string(&key_size, reader);
+          skip_json_spaces(reader);
+          if (reader->cursor >= reader->ending || *reader->cursor++ != ':') goto failed;
+        }
+        json_value *item = read_json(reader);
+        if (!item) goto failed;
+        item->key = key;
+        if (prior) prior->next = item;
+        else value->first = item;
+        prior = item;
+
+        skip_json_spaces(reader);
+        if (reader->cursor >= reader->ending) goto failed;
+        utf8 separator = *reader->cursor++;
+        if (separator == (is_object ? '}' : ']')) break;
+        if (separator != ',') goto failed;
+      }
+      break;
+    }
+  case '"':
+    value->kind = json_kind_string;
+    value->string = read_json_string(&value->string_size, reader);
+    break;
+  case 't':
+  case 'f':
+  case 'n':
+    {
+      static const utf8 *words[] = { "true", "false", "null" };
+      uint word = *reader->cursor == 't' ? 0 : *reader->cursor == 'f' ? 1 : 2;
+      uint word_size = get_string_size(words[word]);
+      if ((uint)(reader->ending - reader->cursor) < word_size || compare_sized_string(reader->cursor, words[word], word_size)) goto failed;
+      reader->cursor += word_size;
+      value->kind = word == 2 ? json_kind_null : json_kind_boolean;
+      value->number = word == 0;
+      break;
+    }
+  default:
+    {
+      /* the message is terminated, so the number ends before it */
+      utf8 *number_ending;
+      value->kind = json_kind_number;
+      value->number = strtod(reader->cursor, &number_ending);
+      if (number_ending == reader->cursor) goto failed;
+      reader->cursor = number_ending;
+      break;
+    }
+  }
+  value->raw_size = (uint)(reader->cursor - value->raw);
+  return value;
+
+failed:
+  reader->has_failed = 1;
+  return 0;
+}
+
+static json_value *get_json_member(json_value *object, const utf8 *key)
+{
+  if (!object || object->kind != json_kind_object) return 0;
+  for (json_value *member = object->first; member; member = member->next)
+    if (!compare_string(member->key, key)) return member;
+  return 0;
+}
+
+static const utf8 *get_json_string(json_value *value)
+{
+  return value && value->kind == json_kind_string ? value->string : 0;
+}
+
+static void write_json_string(report_capture *response, const utf8 *string, uint string_size)
+{
+  capture_reports("\"", 1, response);
+  for (uint i = 0; i < string_size; ++i)
+  {
+    byte c = (byte)string[i];
+    if (c == '"' || c == '\\') write_response(response, "\\%c", c);
+    else if (c == '\n') write_response(response, "\\n");
+    else if (c < 0x20) write_response(response, "\\u%04x", c);
+    else capture_reports(&string[i], 1, response);
+  }
+  capture_reports("\"", 1, response);
+}
+
+/*****************************************************************************/
+
+#if defined(ON_PLATFORM_LINUX)
+
+/* the span of a node of a document, within those of its ancestors */
+typedef struct
+{
+  uint        beginning;
+  uint        ending;
+  uint        order;  /* of the walk, so that nodes of equal spans are ordered by depth */
+  uint        parent; /* the index of the innermost span that contains this one, or `no_span` */
+  expression *expression;
+} lsp_span;
+
+#define no_span ((uint)-1)
+
+DECLARE_ARRAY(lsp_span_array, lsp_span)
+DEFINE_ARRAY(lsp_span_array, lsp_span)
+
+typedef struct
+{
+  utf8    *uri;
+  utf8    *path;           /* of the uri, which the reports refer to */
+  bit      is_resolved : 1; /* so that identifiers refer to their declarations */
+  program  program;
+
+  /* sorted by their beginnings, and then by their endings descending, so a
+     span's ancestors precede it */
+  lsp_span_array spans;
+} lsp_document;
+
+DECLARE_ARRAY(lsp_document_array, lsp_document *)
+DEFINE_ARRAY(lsp_document_array, lsp_document *)
+
+typedef struct
+{
+  int                output; /* the standard output, which nothing but messages is written to */
+  parser             parser; /* of every document */
+  lsp_document_array documents;
+  bit                is_shut_down : 1;
+} language_server;
+
+static void add_span(expression *expression, lsp_document *document)
+{
+  uint order = document->spans.count;
+  *add_to_lsp_span_array(1, &document->spans) = (lsp_span)
+  {
+    .beginning  = expression->beginning,
+    .ending     = expression->ending,
+    .order      = order,
+    .expression = expression,
+  };
+}
+
+static void add_statement_spans(statement *statements, lsp_document *document);
+
+static void add_spans(expression *expression, lsp_document *document)
+{
+  if (!expression) return;
+  if (expression->ending > expression->beginning) add_span(expression, document);
+  switch (node_families[expression->tag])
+  {
+  case node_family_leaf:
+    break;
+  case node_family_unary:
+    add_spans(expression->data->unary.expression, document);
+    break;
+  case node_family_binary:
+    add_spans(expression->data->binary.left, document);
+    add_spans(expression->data->binary.right, document);
+    break;
+  case node_family_ternary:
+    add_spans(expression->data->ternary.left, document);
+    add_spans(expression->data->ternary.right, document);
+    add_spans(expression->data->ternary.other, document);
+    break;
+  case node_family_scoped:
+    switch (expression->tag)
+    {
+    case node_tag_procedure_type:
+      add_spans(expression->data->procedure_type.arguments, document);
+      add_spans(expression->data->procedure_type.results, document);
+      break;
+    case node_tag_declaration:
+      add_spans(expression->data->declaration.type_definition, document);
+      add_spans(expression->data->declaration.assignment, document);
+      break;
+    case node_tag_structure:
+      add_statement_spans(expression->data->structure.declarations, document);
+      break;
+    case node_tag_procedure:
+      {
+        /* the parameters span the casts of the arguments and the results,
+           whose types they share, so their names refer to them */
+        procedure_node *procedure = &expression->data->procedure;
+        add_statement_spans(procedure->type_parameters, document);
+        add_statement_spans(procedure->structure.declarations, document);
+        add_statement_spans(procedure->statements, document);
+        break;
+      }
+    default:
+      break;
+    }
+    break;
+  }
+}
+
+void add_statement_spans(statement *statements, lsp_document *document)
+{
+  for (statement *statement = statements; statement; statement = statement->next)
+    add_spans(&statement->expression, document);
+}
+
+static int compare_spans(const void *left_pointer, const void *right_pointer)
+{
+  const lsp_span *left = left_pointer, *right = right_pointer;
+  if (left->beginning != right->beginning) return left->beginning < right->beginning ? -1 : 1;
+  if (left->ending != right->ending) return left->ending > right->ending ? -1 : 1;
+  return left->order < right->order ? -1 : 1;
+}
+
+/* sorts the spans of the nodes, and links each to its innermost ancestor */
+static void index_document(lsp_document *document)
+{
+  lsp_span_array *spans = &document->spans;
+  spans->count = 0;
+  add_statement_spans(document->program.global_scope.declarations, document);
+  if (!spans->count) return;
+  qsort(spans->elements, spans->count, sizeof(lsp_span), compare_spans);
+
+  /* the spans of the ancestors of the last one, innermost last */
+  uint *ancestors = allocate(spans->count * sizeof(uint));
+  uint ancestors_count = 0;
+  for (uint i = 0; i < spans->count; ++i)
+  {
+    lsp_span *span = &spans->elements[i];
+    while (ancestors_count && spans->elements[ancestors[ancestors_count - 1]].ending < span->ending) --ancestors_count;
+    span->parent = ancestors_count ? ancestors[ancestors_count - 1] : no_span;
+    ancestors[ancestors_count++] = i;
+  }
+  deallocate(ancestors, spans->count * sizeof(uint));
+}
+
+/* the innermost node whose span contains the offset, or 0; the span of the
+   last node beginning at or before the offset is within it, or beside it
+   within one of its ancestors */
+static expression *find_innermost_node(uint offset, lsp_document *document)
+{
+  lsp_span *spans = document->spans.elements;
+  uint low = 0, high = document->spans.count;
+  while (low < high)
+  {
+    uint middle = low + (high - low) / 2;
+    if (spans[middle].beginning <= offset) low = middle + 1;
+    else high = middle;
+  }
+  for (uint i = low ? low - 1 : no_span; i != no_span; i = spans[i].parent)
+    if (offset <= spans[i].ending) return spans[i].expression;
+  return 0;
+}
+
+/*****************************************************************************/
+
+/* positions count UTF-16 units within their lines */
+
+static uint get_lsp_offset(uint line, uint character, program *program)
+{
+  uint row, column;
+  locate_offset(&row, &column, 0, program); /* which indexes the lines */
+  if (line >= program->lines_count) return program->source_size;
+
+  uint offset = program->line_offsets[line];
+  for (uint units = 0; units < character && offset < program->source_size && program->source[offset] != '\n';)
+  {
+    utf32 rune;
+    offset += decode_utf8(&rune, program->source + offset);
+    units += rune >= 0x10000 ? 2 : 1;
+  }
+  return offset;
+}
+
+static void write_lsp_position(report_capture *response, uint offset, program *program)
+{
+  uint row, column;
+  locate_offset(&row, &column, offset, program);
+  uint units = 0;
+  for (uint i = program->line_offsets[row - 1]; i < offset;)
+  {
+    utf32 rune;
+    i += decode_utf8(&rune, program->source + i);
+    units += rune >= 0x10000 ? 2 : 1;
+  }
+  write_response(response, "{\"line\":%u,\"character\":%u}", row - 1, units);
+}
+
+static void write_lsp_range(report_capture *response, uint beginning, uint ending, program *program)
+{
+  write_response(response, "{\"start\":");
+  write_lsp_position(response, beginning, program);
+  write_response(response, ",\"end\":");
+  write_lsp_position(response, ending, program);
+  write_response(response, "}");
+}
+
+/* the span of a declaration's name, which begins it */
+static void write_lsp_name_range(report_capture *response, declaration_node *declaration, program *program)
+{
+  expression *expression = get_declaration_expression(declaration);
+  write_lsp_range(response, expression->beginning, expression->beginning + declaration->identifier.runes_count, program);
+}
+
+/*****************************************************************************/
+
+static void send_message(report_capture *message, language_server *server)
+{
+  utf8 header[64];
+  int header_size = snprintf(header, sizeof(header), "Content-Length: %u\r\n\r\n", message->size);
+  const utf8 *parts[2] = { header, message->text };
+  uint sizes[2] = { (uint)header_size, message->size };
+  for (uint i = 0; i < 2; ++i)
+  {
+    for (uint written_size = 0; written_size < sizes[i];)
+    {
+      ssize_t size = write(server->output, parts[i] + written_size, sizes[i] - written_size);
+      if (size <= 0) return;
+      written_size += (uint)size;
+    }
+  }
+}
+
+static void begin_result(report_capture *response, json_value *id)
+{
+  write_response(response, "{\"jsonrpc\":\"2.0\",\"id\":%.*s,\"result\":", id ? (int)id->raw_size : 4, id ? id->raw : "null");
+}
+
+static lsp_document *find_document(const utf8 *uri, language_server *server)
+{
+  if (!uri) return 0;
+  for (uint i = 0; i < server->documents.count; ++i)
+    if (!compare_string(server->documents.elements[i]->uri, uri)) return server->documents.elements[i];
+  return 0;
+}
+
+/* the path of a `file://` uri, whose escapes are decoded */
+static utf8 *get_uri_path(const utf8 *uri)
+{
+  const utf8 *path = uri;
+  if (!compare_sized_string(uri, "file://", 7)) path += 7;
+  uint path_size = get_string_size(path);
+  utf8 *result = push_type(utf8, path_size + 1, context.allocator);
+  uint size = 0;
+  for (uint i = 0; i < path_size; ++i)
+  {
+    if (path[i] == '%' && i + 2 < path_size && isxdigit((byte)path[i + 1]) && isxdigit((byte)path[i + 2]))
+    {
+      utf8 digits[3] = { path[i + 1], path[i + 2], 0 };
+      result[size++] = (utf8)strtoul(digits, 0, 16);
+      i += 2;
+    }
+    else result[size++] = path[i];
+  }
+  result[size] = 0;
+  return result;
+}
+
+/* reports are captured in the compact form, `path:row:column:beginning:
+   ending:type:message`, and published as diagnostics */
+static void publish_diagnostics(lsp_document *document, report_capture *reports, language_server *server)
+{
+  report_capture message = {0};
+  write_response(&message, "{\"jsonrpc\":\"2.0\",\"method\":\"textDocument/publishDiagnostics\",\"params\":{\"uri\":");
+  write_json_string(&message, document->uri, get_string_size(document->uri));
+  write_response(&message, ",\"diagnostics\":[");
+
+  uint path_size = get_string_size(document->path);
+  bit is_first = 1;
+  for (utf8 *line = reports->text, *ending = reports->text + reports->size; line && line < ending;)
+  {
+    utf8 *line_ending = memchr(line, '\n', (uint)(ending - line));
+    if (!line_ending) line_ending = ending;
+    uint row, column, beginning, span_ending;
+    int prefix_size = 0;
+    if ((uint)(line_ending - line) > path_size && !compare_sized_string(line, document->path, path_size)
+        && sscanf(line + path_size, ":%u:%u:%u:%u:%n", &row, &column, &beginning, &span_ending, &prefix_size) == 4 && prefix_size)
+    {
+      utf8 *type = line + path_size + prefix_size;
+      utf8 *message_text = memchr(type, ':', (uint)(line_ending - type));
+      if (message_text)
+      {
+        uint severity = 3;
+        if (!compare_sized_string(type, reporting_type_representation[reporting_type_failure], (uint)(message_text - type))) severity = 1;
+        else if (!compare_sized_string(type, reporting_type_representation[reporting_type_caution], (uint)(message_text - type))) severity = 2;
+        message_text += 1;
+
+        write_response(&message, is_first ? "{\"range\":" : ",{\"range\":");
+        uint source_size = document->program.source_size;
+        write_lsp_range(&message, beginning < source_size ? beginning : source_size, span_ending < source_size ? span_ending : source_size, &document->program);
+        write_response(&message, ",\"severity\":%u,\"source\":\"proglosa\",\"message\":", severity);
+        write_json_string(&message, message_text, (uint)(line_ending - message_text));
+        write_response(&message, "}");
+        is_first = 0;
+      }
+    }
+    line = line_ending + 1;
+  }
+  write_response(&message, "]}}");
+  send_message(&message, server);
+  release_response(&message);
+}
+
+/* parses, resolves and checks the text of a document, which is indexed
+   regardless of its failures */
+static void analyze_document(lsp_document *document, const utf8 *text, uint text_size, language_server *server)
+{
+  /* the arena of the prior version is reused */
+  program *program = &document->program;
+  reset_program(program);
+  document->is_resolved = 0;
+
+  report_capture reports = {0};
+  reporting_settings prior_reporting = reporting;
+  reporting.capture = &reports;
+  reporting.is_compact = 1;
+  parse_text(document->path, text, text_size, program, &server->parser);
+  if (!program->failures_count)
+  {
+    resolve(program);
+    document->is_resolved = !program->failures_count;
+  }
+  if (document->is_resolved) check_types(program);
+  flush_reports();
+  reporting = prior_reporting;
+
+  index_document(document);
+  publish_diagnostics(document, &reports, server);
+  release_response(&reports);
+}
+
+/*****************************************************************************/
+
+/* the declaration named at the offset, or 0 */
+static declaration_node *find_named_declaration(uint offset, lsp_document *document)
+{
+  if (!document->is_resolved) return 0;
+  expression *node = find_innermost_node(offset, document);
+  if (!node) return 0;
+  if (node->tag == node_tag_identifier) return node->data->identifier.declaration;
+  if (node->tag != node_tag_declaration) return 0;
+
+  /* the fields of a selection refer to the fields they're selected from */
+  declaration_node *declaration = &node->data->declaration;
+  if (offset > node->beginning + declaration->identifier.runes_count) return 0;
+  return declaration->identifier.declaration ? declaration->identifier.declaration : declaration;
+}
+
+static uint get_request_offset(json_value *parameters, lsp_document *document)
+{
+  json_value *position = get_json_member(parameters, "position");
+  json_value *line = get_json_member(position, "line");
+  json_value *character = get_json_member(position, "character");
+  return get_lsp_offset(line ? (uint)line->number : 0, character ? (uint)character->number : 0, &document->program);
+}
+
+static void answer_definition(json_value *id, json_value *parameters, lsp_document *document, language_server *server)
+{
+  report_capture response = {0};
+  begin_result(&response, id);
+  declaration_node *declaration = document ? find_named_declaration(get_request_offset(parameters, document), document) : 0;
+  if (!declaration || get_builtin(declaration) >= 0) write_response(&response, "null");
+  else
+  {
+    write_response(&response, "{\"uri\":");
+    write_json_string(&response, document->uri, get_string_size(document->uri));
+    write_response(&response, ",\"range\":");
+    write_lsp_name_range(&response, declaration, &document->program);
+    write_response(&response, "}");
+  }
+  write_response(&response, "}");
+  send_message(&response, server);
+  release_response(&response);
+}
+
+static void answer_hover(json_value *id, json_value *parameters, lsp_document *document, language_server *server)
+{
+  report_capture response = {0};
+  begin_result(&response, id);
+
+  utf8 text[type_representation_size * 2];
+  text[0] = 0;
+  uint offset = document ? get_request_offset(parameters, document) : 0;
+  declaration_node *declaration = document ? find_named_declaration(offset, document) : 0;
+  expression *node = document ? find_innermost_node(offset, document) : 0;
+  utf8 representation[type_representation_size];
+  if (declaration && get_builtin(declaration) >= 0)
+    snprintf(text, sizeof(text), "%s :: builtin", declaration->identifier.runes);
+  else if (declaration && is_generic_declaration(declaration))
+    snprintf(text, sizeof(text), "%s :: generic procedure", declaration->identifier.runes);
+  else if (declaration && declaration->denoted_type != none_type)
+    snprintf(text, sizeof(text), "%s :: %s", declaration->identifier.runes, represent_type(representation, type_representation_size, declaration->denoted_type));
+  else if (declaration && declaration->type == none_type && declaration->type_definition)
+  {
+    /* within a generic procedure, the types are only written */
+    expression *type_definition = declaration->type_definition;
+    snprintf(text, sizeof(text), "%s: %.*s", declaration->identifier.runes, (int)(type_definition->ending - type_definition->beginning),
+             document->program.source + type_definition->beginning);
+  }
+  else if (declaration && declaration->type != none_type)
+    snprintf(text, sizeof(text), "%s: %s", declaration->identifier.runes, represent_type(representation, type_representation_size, declaration->type));
+  else if (declaration)
+    snprintf(text, sizeof(text), "%s", declaration->identifier.runes);
+  else if (node && node->type != none_type && document->is_resolved)
+    snprintf(text, sizeof(text), "%s", represent_type(representation, type_representation_size, node->type));
+
+  if (!text[0] || !node) write_response(&response, "null");
+  else
+  {
+    write_response(&response, "{\"contents\":{\"kind\":\"plaintext\",\"value\":");
+    write_json_string(&response, text, get_string_size(text));
+    write_response(&response, "},\"range\":");
+    write_lsp_range(&response, node->beginning, node->ending, &document->program);
+    write_response(&response, "}");
+  }
+  write_response(&response, "}");
+  send_message(&response, server);
+  release_response(&response);
+}
+
+/* the kinds of the protocol's symbols */
+enum
+{
+  lsp_symbol_field    = 8,
+  lsp_symbol_function = 12,
+  lsp_symbol_variable = 13,
+  lsp_symbol_constant = 14,
+  lsp_symbol_struct   = 23,
+};
+
+static void write_document_symbols(report_capture *response, statement *declarations, bit is_field, lsp_document *document)
+{
+  write_response(response, "[");
+  for (statement *statement = declarations; statement; statement = statement->next)
+  {
+    declaration_node *declaration = &statement->expression.data->declaration;
+    if (!declaration->identifier.runes) continue;
+    expression *type_definition = declaration->type_definition;
+    bit is_structure = type_definition && type_definition->tag == node_tag_structure;
+    uint kind = is_field ? lsp_symbol_field : declaration->is_constant ? lsp_symbol_constant : lsp_symbol_variable;
+    if (is_structure) kind = lsp_symbol_struct;
+    else if (declaration->assignment && declaration->assignment->tag == node_tag_procedure) kind = lsp_symbol_function;
+
+    write_response(response, statement == declarations ? "{\"name\":" : ",{\"name\":");
+    write_json_string(response, declaration->identifier.runes, declaration->identifier.runes_count);
+    write_response(response, ",\"kind\":%u,\"range\":", kind);
+    write_lsp_range(response, statement->expression.beginning, statement->expression.ending, &document->program);
+    write_response(response, ",\"selectionRange\":");
+    write_lsp_name_range(response, declaration, &document->program);
+    if (is_structure)
+    {
+      write_response(response, ",\"children\":");
+      write_document_symbols(response, type_definition->data->structure.declarations, 1, document);
+    }
+    write_response(response, "}");
+  }
+  write_response(response, "]");
+}
+
+static void answer_document_symbols(json_value *id, lsp_document *document, language_server *server)
+{
+  report_capture response = {0};
+  begin_result(&response, id);
+  if (!document) write_response(&response, "null");
+  else write_document_symbols(&response, document->program.global_scope.declarations, 0, document);
+  write_response(&response, "}");
+  send_message(&response, server);
+  release_response(&response);
+}
+
+static void open_document(const utf8 *uri, const utf8 *text, uint text_size, language_server *server)
+{
+  lsp_document *document = find_document(uri, server);
+  if (!document)
+  {
+    document = push_type(lsp_document, 1, context.allocator);
+    uint uri_size = get_string_size(uri);
+    document->uri = push_type(utf8, uri_size + 1, context.allocator);
+    copy(document->uri, uri, uri_size + 1);
+    document->path = get_uri_path(uri);
+    *add_to_lsp_document_array(1, &server->documents) = document;
+  }
+  analyze_document(document, text, text_size, server);
+}
+
+static void close_document(const utf8 *uri, language_server *server)
+{
+  for (uint i = 0; i < server->documents.count; ++i)
+  {
+    lsp_document *document = server->documents.elements[i];
+    if (compare_string(document->uri, uri)) continue;
+
+    report_capture no_reports = {0};
+    document->program.source_size = 0;
+    document->spans.count = 0;
+    publish_diagnostics(document, &no_reports, server);
+    release_lsp_span_array(&document->spans);
+    release_program(&document->program);
+    server->documents.elements[i] = server->documents.elements[--server->documents.count];
+    return;
+  }
+}
+
+/* answers a message, and returns whether to keep serving */
+static bit answer_message(json_value *message, language_server *server)
+{
+  const utf8 *method = get_json_string(get_json_member(message, "method"));
+  json_value *id = get_json_member(message, "id");
+  json_value *parameters = get_json_member(message, "params");
+  json_value *text_document = get_json_member(parameters, "textDocument");
+  const utf8 *uri = get_json_string(get_json_member(text_document, "uri"));
+  if (!method) return 1;
+
+  if (!compare_string(method, "initialize"))
+  {
+    report_capture response = {0};
+    begin_result(&response, id);
+    write_response(&response, "{\"capabilities\":{\"textDocumentSync\":1,\"definitionProvider\":true,\"hoverProvider\":true,"
+                              "\"documentSymbolProvider\":true},\"serverInfo\":{\"name\":\"proglosa\"}}}");
+    send_message(&response, server);
+    release_response(&response);
+  }
+  else if (!compare_string(method, "shutdown"))
+  {
+    server->is_shut_down = 1;
+    report_capture response = {0};
+    begin_result(&response, id);
+    write_response(&response, "null}");
+    send_message(&response, server);
+    release_response(&response);
+  }
+  else if (!compare_string(method, "exit"))
+    return 0;
+  else if (!compare_string(method, "textDocument/didOpen"))
+  {
+    json_value *text = get_json_member(text_document, "text");
+    if (uri && text && text->kind == json_kind_string) open_document(uri, text->string, text->string_size, server);
+  }
+  else if (!compare_string(method, "textDocument/didChange"))
+  {
+    /* the whole text is synchronized, so the last change is all of it */
+    json_value *changes = get_json_member(parameters, "contentChanges");
+    json_value *change = changes && changes->kind == json_kind_array ? changes->first : 0;
+    while (change && change->next) change = change->next;
+    json_value *text = get_json_member(change, "text");
+    if (uri && text && text->kind == json_kind_string) open_document(uri, text->string, text->string_size, server);
+  }
+  else if (!compare_string(method, "textDocument/didClose"))
+  {
+    if (uri) close_document(uri, server);
+  }
+  else if (!compare_string(method, "textDocument/definition"))
+    answer_definition(id, parameters, find_document(uri, server), server);
+  else if (!compare_string(method, "textDocument/hover"))
+    answer_hover(id, parameters, find_document(uri, server), server);
+  else if (!compare_string(method, "textDocument/documentSymbol"))
+    answer_document_symbols(id, find_document(uri, server), server);
+  else if (id)
+  {
+    report_capture response = {0};
+    write_response(&response, "{\"jsonrpc\":\"2.0\",\"id\":%.*s,\"error\":{\"code\":-32601,\"message\":\"Unknown method.\"}}", (int)id->raw_size, id->raw);
+    send_message(&response, server);
+    release_response(&response);
+  }
+  return 1;
+}
+
+int serve_language(void)
+{
+  /* the messages are written to the standard output, and whatever's printed
+     otherwise to the standard error */
+  fflush(stdout);
+  language_server server = { .output = dup(STDOUT_FILENO) };
+  if (server.output < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0)
+  {
+    print_failure("Failed to serve the language.\n");
+    return -1;
+  }
+
+  allocator message_allocator = {0};
+  for (;;)
+  {
+    /* `Content-Length: size`, and other headers until an empty line */
+    uint content_size = 0;
+    bit has_header = 0;
+    utf8 header[256];
+    while (fgets(header, sizeof(header), stdin))
+    {
+      has_header = 1;
+      if (!compare_string(header, "\r\n") || !compare_string(header, "\n")) break;
+      if (!compare_sized_string(header, "Content-Length:", 15)) content_size = (uint)strtoul(header + 15, 0, 10);
+    }
+    if (!has_header || feof(stdin)) break;
+    if (!content_size) continue;
+
+    scratch message_scratch;
+    get_scratch(&message_scratch, &message_allocator);
+    utf8 *content = push_type(utf8, content_size + 1, &message_allocator);
+    if (fread(content, 1, content_size, stdin) != content_size) break;
+    content[content_size] = 0;
+
+    json_reader reader = { .cursor = content, .ending = content + content_size, .allocator = &message_allocator };
+    json_value *message = read_json(&reader);
+    bit is_serving = 1;
+    if (message && !reader.has_failed) is_serving = answer_message(message, &server);
+
+    end_scratch(&message_scratch);
+    if (!is_serving) break;
+  }
+
+  for (uint i = 0; i < server.documents.count; ++i)
+  {
+    release_lsp_span_array(&server.documents.elements[i]->spans);
+    release_program(&server.documents.elements[i]->program);
+  }
+  release_lsp_document_array(&server.documents);
+  release_parser(&server.parser);
+  release_allocator(&message_allocator);
+  close(server.output);
+  return server.is_shut_down ? 0 : 1;
+}
+
+#else
+
+int serve_language(void)
+{
+  print_failure("Serving the language isn't supported on this platform.\n");
+  return -1;
+}
+
+#endif
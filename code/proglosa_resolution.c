@@ -0,0 +1,264 @@
+#include "proglosa.h"
+
+/*****************************************************************************/
+
+typedef enum
+{
+#define XPASTE(identifier, representation) builtin_##identifier,
+  #include "proglosa_builtins.inc"
+#undef XPASTE
+  builtins_count,
+} builtin;
+
+static const utf8 builtin_representations[][8] =
+{
+#define XPASTE(identifier, representation) [builtin_##identifier] = representation,
+  #include "proglosa_builtins.inc"
+#undef XPASTE
+};
+
+/* the outermost scope, of the declarations every program begins with; these
+   are initialized upon the first `resolve` */
+static declaration_node builtin_declarations[builtins_count];
+static scope            builtin_scope;
+
+typedef struct
+{
+  program *program;
+  scope   *scope;
+} resolver;
+
+static bit is_declaration_of(const scope_slot *slot, const identifier_node *identifier)
+{
+  const identifier_node *declared = &slot->declaration->identifier;
+  return slot->hash == identifier->hash
+         && declared->runes_count == identifier->runes_count
+         && !compare_sized_string(declared->runes, identifier->runes, identifier->runes_count);
+}
+
+static uint get_slot_hash(const scope_slot *slot)
+{
+  return slot->hash;
+}
+
+DEFINE_MAP(scope_map, scope_slot, const identifier_node *, is_declaration_of, get_slot_hash)
+
+/* returns the prior declaration of the same identifier, if any */
+static declaration_node *declare(declaration_node *declaration, scope *scope)
+{
+  identifier_node *identifier = &declaration->identifier;
+  bit is_new;
+  scope_slot *slot = add_to_scope_map(identifier->hash, identifier, &is_new, &scope->slots);
+  if (!is_new) return slot->declaration;
+  slot->hash = identifier->hash;
+  slot->declaration = declaration;
+  return 0;
+}
+
+declaration_node *find_declaration(const utf8 *runes, uint runes_count, uint hash, scope *scope)
+{
+  identifier_node identifier = { .runes = (utf8 *)runes, .runes_count = runes_count, .hash = hash };
+  for (; scope; scope = scope->parent)
+  {
+    scope_slot *slot = find_in_scope_map(hash, &identifier, &scope->slots);
+    if (slot) return slot->declaration;
+  }
+  return 0;
+}
+
+/* the builtin scope is shared by every program, so its slots are allocated */
+static void initialize_builtin_scope(void)
+{
+  if (builtin_scope.slots.entries_count) return;
+  for (uint i = 0; i < builtins_count; ++i)
+  {
+    identifier_node *identifier = &builtin_declarations[i].identifier;
+    identifier->runes       = (utf8 *)builtin_representations[i];
+    identifier->runes_count = get_string_size(builtin_representations[i]);
+    identifier->hash        = hash_string(identifier->runes, identifier->runes_count);
+    builtin_declarations[i].is_constant = 1;
+    declare(&builtin_declarations[i], &builtin_scope);
+  }
+}
+
+static scope *enter_scope(uint declarations_count, resolver *resolver)
+{
+  scope *result = push_type(scope, 1, &resolver->program->allocator);
+  result->parent = resolver->scope;
+  result->slots.allocator = &resolver->program->allocator;
+  reserve_scope_map(declarations_count, &result->slots);
+  resolver->scope = result;
+  return result;
+}
+
+static void exit_scope(resolver *resolver)
+{
+  resolver->scope = resolver->scope->parent;
+}
+
+static void declare_statement(statement *statement, resolver *resolver)
+{
+  declaration_node *declaration = &statement->expression.data->declaration;
+  if (!declaration->identifier.runes) return;
+  if (declare(declaration, resolver->scope))
+    report_expression_failure(resolver->program, &statement->expression, "Redeclared %s.", declaration->identifier.runes);
+}
+
+static void resolve_expression(expression *expression, resolver *resolver);
+
+/* the names of parameters are declarations rather than uses */
+static void resolve_parameters(expression *parameters, resolver *resolver)
+{
+  if (!parameters) return;
+  switch (parameters->tag)
+  {
+  case node_tag_list:
+    resolve_parameters(parameters->data->list.left, resolver);
+    resolve_parameters(parameters->data->list.right, resolver);
+    break;
+  case node_tag_cast:
+    if (parameters->data->cast.left->tag == node_tag_identifier)
+    {
+      resolve_expression(parameters->data->cast.right, resolver);
+      break;
+    }
+    /* fallthrough */
+  default:
+    resolve_expression(parameters, resolver);
+    break;
+  }
+}
+
+static void resolve_declaration(declaration_node *declaration, resolver *resolver)
+{
+  resolve_expression(declaration->type_definition, resolver);
+  resolve_expression(declaration->assignment, resolver);
+}
+
+/* the declarations of a structure are visible throughout it, regardless of
+   their order */
+static void resolve_structure(structure_node *structure, resolver *resolver)
+{
+  structure->scope = enter_scope(structure->declarations_count, resolver);
+  for (statement *declaration = structure->declarations; declaration; declaration = declaration->next)
+    declare_statement(declaration, resolver);
+  for (statement *declaration = structure->declarations; declaration; declaration = declaration->next)
+    resolve_declaration(&declaration->expression.data->declaration, resolver);
+  exit_scope(resolver);
+}
+
+/* the parameters of a procedure are visible throughout it, and its local
+   declarations after them */
+static void resolve_procedure(procedure_node *procedure, resolver *resolver)
+{
+  /* the type parameters enclose the parameters, whose types refer to them */
+  if (procedure->type_parameters)
+  {
+    enter_scope(procedure->type_parameters_count, resolver);
+    for (statement *type_parameter = procedure->type_parameters; type_parameter; type_parameter = type_parameter->next)
+      declare_statement(type_parameter, resolver);
+  }
+
+  for (statement *parameter = procedure->structure.declarations; parameter; parameter = parameter->next)
+    resolve_expression(parameter->expression.data->declaration.type_definition, resolver);
+
+  uint locals_count = 0;
+  for (statement *statement = procedure->statements; statement; statement = statement->next)
+    locals_count += statement->expression.tag == node_tag_declaration;
+
+  procedure->structure.scope = enter_scope(procedure->structure.declarations_count + locals_count, resolver);
+  for (statement *parameter = procedure->structure.declarations; parameter; parameter = parameter->next)
+    declare_statement(parameter, resolver);
+
+  for (statement *statement = procedure->statements; statement; statement = statement->next)
+  {
+    if (statement->expression.tag == node_tag_declaration)
+    {
+      resolve_declaration(&statement->expression.data->declaration, resolver);
+      declare_statement(statement, resolver);
+    }
+    else resolve_expression(&statement->expression, resolver);
+  }
+  exit_scope(resolver);
+  if (procedure->type_parameters) exit_scope(resolver);
+}
+
+void resolve_expression(expression *expression, resolver *resolver)
+{
+  if (!expression) return;
+  switch (node_families[expression->tag])
+  {
+  case node_family_leaf:
+    if (expression->tag == node_tag_identifier)
+    {
+      identifier_node *identifier = &expression->data->identifier;
+      identifier->declaration = find_declaration(identifier->runes, identifier->runes_count, identifier->hash, resolver->scope);
+      if (!identifier->declaration)
+        report_expression_failure(resolver->program, expression, "Undeclared %s.", identifier->runes);
+    }
+    else if (expression->tag == node_tag_type_parameter)
+      report_expression_failure(resolver->program, expression, "%s is a type parameter outside the arguments of a procedure.", expression->data->type_parameter.identifier.runes);
+    break;
+  case node_family_unary:
+    resolve_expression(expression->data->unary.expression, resolver);
+    break;
+  case node_family_binary:
+    resolve_expression(expression->data->binary.left, resolver);
+    /* the right of a resolution is a field, which is found by its type, or
+       a selection of fields, which are declared in a scope of their own */
+    if (expression->tag != node_tag_resolution)
+      resolve_expression(expression->data->binary.right, resolver);
+    else if (expression->data->resolution.right->tag == node_tag_structure)
+      resolve_structure(&expression->data->resolution.right->data->structure, resolver);
+    break;
+  case node_family_ternary:
+    resolve_expression(expression->data->ternary.left, resolver);
+    resolve_expression(expression->data->ternary.right, resolver);
+    resolve_expression(expression->data->ternary.other, resolver);
+    break;
+  case node_family_scoped:
+    switch (expression->tag)
+    {
+    case node_tag_procedure_type:
+      resolve_parameters(expression->data->procedure_type.arguments, resolver);
+      resolve_parameters(expression->data->procedure_type.results, resolver);
+      break;
+    case node_tag_declaration:
+      resolve_declaration(&expression->data->declaration, resolver);
+      break;
+    case node_tag_structure:
+      resolve_structure(&expression->data->structure, resolver);
+      break;
+    case node_tag_procedure:
+      resolve_procedure(&expression->data->procedure, resolver);
+      break;
+    default:
+      UNREACHABLE();
+    }
+    break;
+  }
+}
+
+/* resolves the clone of a generic procedure within the scope that encloses
+   the generic one */
+static void resolve_instance(expression *instance, scope *scope, program *program)
+{
+  resolver resolver =
+  {
+    .program = program,
+    .scope   = scope,
+  };
+  resolve_expression(instance, &resolver);
+}
+
+void resolve(program *program)
+{
+  initialize_builtin_scope();
+
+  resolver resolver =
+  {
+    .program = program,
+    .scope   = &builtin_scope,
+  };
+  resolve_structure(&program->global_scope, &resolver);
+}
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+
+# generates `proglosa_runes.inc` from the Unicode database of the running
+# Python, whose `str.isidentifier` implements XID_Start and XID_Continue.
+#
+#   python3 code/proglosa_runes.py > code/proglosa_runes.inc
+
+import sys
+import unicodedata
+
+rune_class_space         = 1 << 0
+rune_class_letter        = 1 << 1
+rune_class_number        = 1 << 2
+rune_class_hexadecimal   = 1 << 3
+rune_class_continuation  = 1 << 4
+
+block_size = 256
+runes_count = 0x110000
+
+def is_start(rune):
+  return rune != ord('_') and chr(rune).isidentifier()
+
+def is_continuation(rune):
+  return ('a' + chr(rune)).isidentifier()
+
+# White_Space within Latin-1; the rest is checked by `on_space`
+def is_space(rune):
+  return 0x09 <= rune <= 0x0d or rune in (0x20, 0x85, 0xa0)
+
+def classify(rune):
+  c = 0
+  if is_space(rune): c |= rune_class_space
+  if is_start(rune) or rune == ord('_'): c |= rune_class_letter
+  if ord('0') <= rune <= ord('9'): c |= rune_class_number
+  if chr(rune) in '0123456789abcdefABCDEF': c |= rune_class_hexadecimal
+  if is_continuation(rune): c |= rune_class_continuation
+  return c
+
+out = sys.stdout
+out.write('/* generated by `proglosa_runes.py` from Unicode %s; do not edit */\n\n' % unicodedata.unidata_version)
+
+out.write('static const byte rune_classes[256] =\n{\n')
+for row in range(0, 256, 16):
+  out.write('  ' + ' '.join('0x%02x,' % classify(r) for r in range(row, row + 16)) + '\n')
+out.write('};\n\n')
+
+blocks = {}
+indices = []
+for b in range(runes_count // block_size):
+  starts = continuations = 0
+  for i in range(block_size):
+    rune = b * block_size + i
+    if is_start(rune):        starts        |= 1 << i
+    if is_continuation(rune): continuations |= 1 << i
+  key = (starts, continuations)
+  if key not in blocks: blocks[key] = len(blocks)
+  indices.append(blocks[key])
+
+assert len(blocks) <= 256
+
+out.write('static const byte xid_block_indices[%d] =\n{\n' % len(indices))
+for row in range(0, len(indices), 16):
+  out.write('  ' + ' '.join('%3d,' % i for i in indices[row:row + 16]) + '\n')
+out.write('};\n\n')
+
+def words(bits):
+  return ', '.join('0x%08x' % ((bits >> (32 * i)) & 0xffffffff) for i in range(block_size // 32))
+
+out.write('/* [block][0] is XID_Start, [block][1] is XID_Continue */\n')
+out.write('static const uint xid_blocks[%d][2][%d] =\n{\n' % (len(blocks), block_size // 32))
+for (starts, continuations), i in sorted(blocks.items(), key=lambda item: item[1]):
+  out.write('  {{%s},\n   {%s}},\n' % (words(starts), words(continuations)))
+out.write('};\n')
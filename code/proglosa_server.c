@@ -0,0 +1,443 @@
+#include "proglosa.h"
+
+#if defined(ON_PLATFORM_LINUX)
+  #include <errno.h>
+  #include <poll.h>
+  #include <sys/inotify.h>
+  #include <sys/socket.h>
+  #include <sys/un.h>
+#endif
+
+/*****************************************************************************/
+
+/* a request is a line of words, `check path`, `declarations path` or `stop`,
+   whose paths are absolute. the response begins with a line of the count of
+   failures, which is followed by the reports or the answer */
+
+#define maximum_request_size ((uint)4 * kibibyte)
+
+static void v_write_response(report_capture *response, const utf8 *format, vargs format_vargs)
+{
+  /* most responses are written in short pieces, which aren't allocated */
+  utf8 short_text[256];
+  vargs copied_vargs;
+  copy_vargs(copied_vargs, format_vargs);
+  int size = vsnprintf(short_text, sizeof(short_text), format, copied_vargs);
+  end_vargs(copied_vargs);
+  if (size <= 0) return;
+  if ((uint)size < sizeof(short_text))
+  {
+    capture_reports(short_text, (uint)size, response);
+    return;
+  }
+
+  utf8 *text = allocate((uint)size + 1);
+  vsnprintf(text, (uint)size + 1, format, format_vargs);
+  capture_reports(text, (uint)size, response);
+  deallocate(text, (uint)size + 1);
+}
+
+static void write_response(report_capture *response, const utf8 *format, ...)
+{
+  vargs vargs;
+  get_vargs(vargs, format);
+  v_write_response(response, format, vargs);
+  end_vargs(vargs);
+}
+
+static void release_response(report_capture *response)
+{
+  if (response->text) deallocate(response->text, response->capacity);
+  zero(response, sizeof(*response));
+}
+
+#if defined(ON_PLATFORM_LINUX)
+
+/* a program that's kept by the server, which is checked again only once its
+   source changes */
+typedef struct served_program served_program;
+struct served_program
+{
+  utf8           *path;
+  uint            path_size;
+  uint            hash;         /* of the path */
+  int             watch;        /* of the source, or -1 once it's gone */
+  served_program *next_watched; /* of the same watch, since links to one source share it */
+  bit             is_stale : 1; /* if the source changed since it was checked */
+  program         program;
+  report_capture  reports;      /* of the last check */
+};
+
+DECLARE_ARRAY(served_program_array, served_program *)
+DEFINE_ARRAY(served_program_array, served_program *)
+
+static bit is_served_program_of(served_program *const *entry, const served_program *key)
+{
+  return (*entry)->hash == key->hash && (*entry)->path_size == key->path_size && !compare_sized_string((*entry)->path, key->path, key->path_size);
+}
+
+static uint get_served_program_hash(served_program *const *entry)
+{
+  return (*entry)->hash;
+}
+
+DECLARE_MAP(served_program_map, served_program *, const served_program *)
+DEFINE_MAP(served_program_map, served_program *, const served_program *, is_served_program_of, get_served_program_hash)
+
+/* the programs whose sources an inotify watch is of. entries aren't removed,
+   so a watch that's gone keeps one without programs */
+typedef struct
+{
+  int             watch;
+  served_program *first_watched;
+} watched_source;
+
+static bit is_watched_source_of(const watched_source *entry, int watch)
+{
+  return entry->watch == watch;
+}
+
+static uint hash_watch(int watch)
+{
+  return hash_string((const utf8 *)&watch, sizeof(watch));
+}
+
+static uint get_watched_source_hash(const watched_source *entry)
+{
+  return hash_watch(entry->watch);
+}
+
+DECLARE_MAP(watched_source_map, watched_source, int)
+DEFINE_MAP(watched_source_map, watched_source, int, is_watched_source_of, get_watched_source_hash)
+
+typedef struct
+{
+  int                   listener;
+  int                   watcher; /* of the sources, by inotify */
+  const layout_options *layout_options;
+  parser                parser;  /* of every source */
+  served_program_array  programs;
+  served_program_map    programs_by_path;
+  watched_source_map    watched_sources; /* by their watches, so an event finds its programs at once */
+} server;
+
+static served_program *find_served_program(const utf8 *path, server *server)
+{
+  served_program key = { .path = (utf8 *)path, .path_size = get_string_size(path) };
+  key.hash = hash_string(path, key.path_size);
+  bit is_new;
+  served_program **entry = add_to_served_program_map(key.hash, &key, &is_new, &server->programs_by_path);
+  if (!is_new) return *entry;
+
+  /* the programs don't move, since their declarations are referred to by
+     the interned types */
+  served_program *served = push_type(served_program, 1, context.allocator);
+  served->path = push_type(utf8, key.path_size + 1, context.allocator);
+  copy(served->path, path, key.path_size + 1);
+  served->path_size = key.path_size;
+  served->hash      = key.hash;
+  served->watch     = -1;
+  served->is_stale  = 1;
+  *add_to_served_program_array(1, &server->programs) = served;
+  *entry = served;
+  return served;
+}
+
+static void check_served_program(served_program *served, server *server)
+{
+  if (!served->is_stale) return;
+  served->is_stale = 0;
+
+  /* the source is watched before it's read, so that a change while it's
+     parsed makes it stale again */
+  if (served->watch < 0)
+  {
+    served->watch = inotify_add_watch(server->watcher, served->path, IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_MOVE_SELF | IN_DELETE_SELF);
+    if (served->watch >= 0)
+    {
+      bit is_new;
+      watched_source *source = add_to_watched_source_map(hash_watch(served->watch), served->watch, &is_new, &server->watched_sources);
+      source->watch = served->watch;
+      served->next_watched = source->first_watched;
+      source->first_watched = served;
+    }
+  }
+
+  /* the arena of the prior program is reused */
+  program *program = &served->program;
+  reset_program(program);
+  served->reports.size = 0;
+  reporting.capture = &served->reports;
+  parse(served->path, program, &server->parser);
+  if (!program->failures_count) resolve(program);
+  if (!program->failures_count) check_types(program);
+  if (!program->failures_count) lay_out_types(program, server->layout_options);
+  if (!program->failures_count) fold_constants(program);
+  flush_reports();
+  reporting.capture = 0;
+
+  if (program->failures_count && !served->reports.size) write_response(&served->reports, "Failed to check %s.\n", served->path);
+
+  /* a source that can't be watched is checked upon every request */
+  if (served->watch < 0) served->is_stale = 1;
+}
+
+static void read_changes(server *server)
+{
+  alignas(struct inotify_event) byte events[16 * kibibyte];
+  for (;;)
+  {
+    ssize_t size = read(server->watcher, events, sizeof(events));
+    if (size <= 0) return;
+    for (byte *cursor = events; cursor < events + size;)
+    {
+      struct inotify_event *event = (struct inotify_event *)cursor;
+      cursor += sizeof(struct inotify_event) + event->len;
+      watched_source *source = find_in_watched_source_map(hash_watch(event->wd), event->wd, &server->watched_sources);
+      if (!source || !source->first_watched) continue;
+      for (served_program *served = source->first_watched; served; served = served->next_watched) served->is_stale = 1;
+
+      /* a source that's replaced, as editors save them, is watched anew
+         upon its next check */
+      if (event->mask & (IN_MOVE_SELF | IN_DELETE_SELF)) inotify_rm_watch(server->watcher, event->wd);
+      if (!(event->mask & (IN_MOVE_SELF | IN_DELETE_SELF | IN_IGNORED))) continue;
+      for (served_program *served = source->first_watched, *next; served; served = next)
+      {
+        next = served->next_watched;
+        served->watch = -1;
+        served->next_watched = 0;
+      }
+      source->first_watched = 0;
+    }
+  }
+}
+
+static void answer_declarations(served_program *served, report_capture *response)
+{
+  program *program = &served->program;
+  write_response(response, "0\n");
+  for (statement *global = program->global_scope.declarations; global; global = global->next)
+  {
+    declaration_node *declaration = &global->expression.data->declaration;
+    uint row, column;
+    locate_offset(&row, &column, global->expression.beginning, program);
+    /* `path:row:column:name:kind:type`, where a type is of the value, or
+       the one that's denoted */
+    const utf8 *kind = "value";
+    type_id id = declaration->type;
+    if (declaration->denoted_type != none_type) kind = "type", id = declaration->denoted_type;
+    else if (is_generic_declaration(declaration)) kind = "generic";
+    utf8 representation[type_representation_size];
+    represent_type(representation, type_representation_size, id);
+    write_response(response, "%s:%u:%u:%s:%s:%s\n", served->path, row, column, declaration->identifier.runes, kind, representation);
+  }
+}
+
+/* answers a client, and returns whether to keep serving */
+static bit answer(server *server)
+{
+  int client = accept4(server->listener, 0, 0, SOCK_CLOEXEC);
+  if (client < 0) return 1;
+
+  /* a client that doesn't finish its request is dropped */
+  struct timeval timeout = { .tv_sec = 1 };
+  setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  utf8 request[maximum_request_size + 1];
+  uint request_size = 0;
+  while (request_size < maximum_request_size && !memchr(request, '\n', request_size))
+  {
+    ssize_t read_size = read(client, request + request_size, maximum_request_size - request_size);
+    if (read_size <= 0) break;
+    request_size += (uint)read_size;
+  }
+  request[request_size] = 0;
+  utf8 *line_ending = memchr(request, '\n', request_size);
+  if (line_ending) *line_ending = 0;
+
+  utf8 *argument = strchr(request, ' ');
+  if (argument) *argument++ = 0;
+
+  report_capture response = {0};
+  bit is_serving = 1;
+  if (!compare_string(request, "stop"))
+  {
+    write_response(&response, "0\n");
+    is_serving = 0;
+  }
+  else if (argument && (!compare_string(request, "check") || !compare_string(request, "declarations")))
+  {
+    served_program *served = find_served_program(argument, server);
+    check_served_program(served, server);
+    if (served->program.failures_count || !compare_string(request, "check"))
+    {
+      write_response(&response, "%u\n", served->program.failures_count);
+      capture_reports(served->reports.text, served->reports.size, &response);
+    }
+    else answer_declarations(served, &response);
+  }
+  else write_response(&response, "1\nUnknown request: %s\n", request);
+
+  for (uint sent_size = 0; sent_size < response.size;)
+  {
+    ssize_t size = send(client, response.text + sent_size, response.size - sent_size, MSG_NOSIGNAL);
+    if (size <= 0) break;
+    sent_size += (uint)size;
+  }
+  close(client);
+  release_response(&response);
+  return is_serving;
+}
+
+static bit get_socket_address(struct sockaddr_un *address, const utf8 *socket_path)
+{
+  zero(address, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  uint path_size = get_string_size(socket_path);
+  if (path_size >= sizeof(address->sun_path))
+  {
+    print_failure("The socket path is too long: %s\n", socket_path);
+    return 0;
+  }
+  copy(address->sun_path, socket_path, path_size + 1);
+  return 1;
+}
+
+int serve(const utf8 *socket_path, const layout_options *layout_options, bit is_compacting_nodes, bit is_pooling_nodes)
+{
+  struct sockaddr_un address;
+  if (!get_socket_address(&address, socket_path)) return -1;
+
+  server server =
+  {
+    .listener       = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0),
+    .watcher        = inotify_init1(IN_NONBLOCK | IN_CLOEXEC),
+    .layout_options = layout_options,
+    .parser         = { .is_compacting = is_compacting_nodes, .is_pooling = is_pooling_nodes },
+  };
+  if (server.listener < 0 || server.watcher < 0) goto failed;
+
+  /* the socket of a prior server is replaced, but no other file */
+  struct stat status;
+  if (!stat(socket_path, &status) && S_ISSOCK(status.st_mode)) unlink(socket_path);
+  if (bind(server.listener, (struct sockaddr *)&address, sizeof(address)) || listen(server.listener, 16)) goto failed;
+  if (reporting.minimum_type <= reporting_type_comment) print_comment("Serving upon %s.\n", socket_path);
+
+  for (bit is_serving = 1; is_serving;)
+  {
+    struct pollfd polled[2] =
+    {
+      { .fd = server.listener, .events = POLLIN },
+      { .fd = server.watcher,  .events = POLLIN },
+    };
+    if (poll(polled, 2, -1) < 0)
+    {
+      if (errno == EINTR) continue;
+      break;
+    }
+    /* the changes are read first, so no request is answered from a stale
+       program */
+    if (polled[1].revents & POLLIN) read_changes(&server);
+    if (polled[0].revents & POLLIN) is_serving = answer(&server);
+  }
+
+  close(server.listener);
+  close(server.watcher);
+  unlink(socket_path);
+  for (uint i = 0; i < server.programs.count; ++i)
+  {
+    release_program(&server.programs.elements[i]->program);
+    release_response(&server.programs.elements[i]->reports);
+  }
+  release_served_program_array(&server.programs);
+  release_served_program_map(&server.programs_by_path);
+  release_watched_source_map(&server.watched_sources);
+  release_parser(&server.parser);
+  return 0;
+
+failed:
+  print_failure("Failed to serve upon %s: %s\n", socket_path, strerror(errno));
+  if (server.listener >= 0) close(server.listener);
+  if (server.watcher >= 0) close(server.watcher);
+  return -1;
+}
+
+int ask(const utf8 *socket_path, char *words[], uint words_count)
+{
+  struct sockaddr_un address;
+  if (!get_socket_address(&address, socket_path)) return -1;
+  if (!words_count)
+  {
+    print_failure("A request wasn't given.\n");
+    return -1;
+  }
+
+  /* the paths are relative to the client rather than the server */
+  report_capture request = {0};
+  for (uint i = 0; i < words_count; ++i)
+  {
+    utf8 *absolute_path = i == 1 ? realpath(words[i], 0) : 0;
+    write_response(&request, i ? " %s" : "%s", absolute_path ? absolute_path : words[i]);
+    free(absolute_path);
+  }
+  write_response(&request, "\n");
+
+  int server = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (server < 0 || connect(server, (struct sockaddr *)&address, sizeof(address)))
+  {
+    print_failure("Failed to connect to %s: %s\n", socket_path, strerror(errno));
+    if (server >= 0) close(server);
+    release_response(&request);
+    return -1;
+  }
+  for (uint sent_size = 0; sent_size < request.size;)
+  {
+    ssize_t size = send(server, request.text + sent_size, request.size - sent_size, MSG_NOSIGNAL);
+    if (size <= 0) break;
+    sent_size += (uint)size;
+  }
+  shutdown(server, SHUT_WR);
+
+  report_capture response = {0};
+  for (;;)
+  {
+    utf8 received[16 * kibibyte];
+    ssize_t size = read(server, received, sizeof(received));
+    if (size <= 0) break;
+    capture_reports(received, (uint)size, &response);
+  }
+  close(server);
+  release_response(&request);
+
+  utf8 *body = response.text ? memchr(response.text, '\n', response.size) : 0;
+  if (!body)
+  {
+    print_failure("The server didn't answer.\n");
+    release_response(&response);
+    return -1;
+  }
+  uint failures_count = (uint)strtoul(response.text, 0, 10);
+  body += 1;
+  fwrite(body, 1, (uint)(response.text + response.size - body), stdout);
+  if (failures_count) print_failure("%u failure%s.\n", failures_count, failures_count == 1 ? "" : "s");
+  release_response(&response);
+  return failures_count ? 1 : 0;
+}
+
+#else
+
+int serve(const utf8 *socket_path, const layout_options *layout_options, bit is_compacting_nodes, bit is_pooling_nodes)
+{
+  (void)socket_path, (void)layout_options, (void)is_compacting_nodes, (void)is_pooling_nodes;
+  print_failure("Serving isn't supported on this platform.\n");
+  return -1;
+}
+
+int ask(const utf8 *socket_path, char *words[], uint words_count)
+{
+  (void)socket_path, (void)words, (void)words_count;
+  print_failure("Serving isn't supported on this platform.\n");
+  return -1;
+}
+
+#endif
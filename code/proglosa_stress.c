@@ -0,0 +1,285 @@
+#include "proglosa.h"
+
+#if defined(ON_PLATFORM_LINUX)
+  #include <fcntl.h>
+  #include <sys/resource.h>
+  #include <sys/wait.h>
+#endif
+
+/*****************************************************************************/
+
+/* a size that grows faster than linearly is told from noise by the exponent
+   of the time over all the steps, since consecutive ones are too noisy */
+#define maximum_time_exponent  1.25
+#define minimum_judged_time    ((float64)2e6) /* in nanoseconds, of the steps the exponent is fitted to */
+#define maximum_memory_multiple 32            /* of the size of the source */
+#define memory_slack_size       ((uintl)16 * mebibyte)
+#define default_steps_count     6             /* which halve the size from the greatest */
+#define reparsed_declarations_count 20000   /* of the source that's reparsed */
+
+DECLARE_ARRAY(stress_text, utf8)
+DEFINE_ARRAY(stress_text, utf8)
+
+static void write_stress_text(stress_text *text, const utf8 *format, ...)
+{
+  utf8 short_text[64];
+  vargs vargs;
+  get_vargs(vargs, format);
+  int size = vsnprintf(short_text, sizeof(short_text), format, vargs);
+  end_vargs(vargs);
+  copy(add_to_stress_text((uint)size, text), short_text, (uint)size);
+}
+
+/* of `size` top-level declarations */
+static void generate_declarations(uint size, stress_text *text)
+{
+  for (uint i = 0; i < size; ++i) write_stress_text(text, "d%u: s64 = %u;\n", i, i);
+}
+
+/* of an expression nested `size` deep */
+static void generate_nesting(uint size, stress_text *text)
+{
+  write_stress_text(text, "n: s64 = ");
+  for (uint i = 0; i < size; ++i) write_stress_text(text, "(1 + ");
+  write_stress_text(text, "1");
+  fill(add_to_stress_text(size, text), size, ')');
+  write_stress_text(text, ";\n");
+}
+
+/* of a string of `size` bytes */
+static void generate_string(uint size, stress_text *text)
+{
+  write_stress_text(text, "s :: \"");
+  fill(add_to_stress_text(size, text), size, 'a');
+  write_stress_text(text, "\";\n");
+}
+
+/* of a procedure of `size` declarations, each of which names the prior one */
+static void generate_scope(uint size, stress_text *text)
+{
+  write_stress_text(text, "p :: () -> r: s64\n{\n  v0: s64 = 0;\n");
+  for (uint i = 1; i < size; ++i) write_stress_text(text, "  v%u: s64 = v%u;\n", i, i - 1);
+  write_stress_text(text, "  r = v%u;\n  return r;\n}\n", size - 1);
+}
+
+/* of `size` declarations of constant expressions, which are folded */
+static void generate_constants(uint size, stress_text *text)
+{
+  for (uint i = 0; i < size; ++i) write_stress_text(text, "c%u: s64 = (%u + 1) * 3 - -%u;\n", i, i, i);
+}
+
+/* of declarations after one that fails, which is reparsed rather than
+   grown; see `reparsing` */
+static void generate_failing(uint size, stress_text *text)
+{
+  write_stress_text(text, "f: s64 = (;\n");
+  generate_declarations(size, text);
+}
+
+typedef struct
+{
+  const utf8 *name;
+  uint        maximum_size;
+  void      (*generate)(uint size, stress_text *text);
+  bit         is_reparsing : 1; /* the size is of the times a failing source is reparsed into a reset program, whose memory is reused */
+  bit         is_folding   : 1; /* its types are checked and its constants folded too */
+  bit         is_pooling   : 1; /* its nodes are taken from a slot pool rather than pushed, which folding gives them back to */
+} stress_shape;
+
+static const stress_shape stress_shapes[] =
+{
+  { .name = "declarations", .maximum_size = 1000000,        .generate = generate_declarations },
+  { .name = "nesting",      .maximum_size = 10000,          .generate = generate_nesting      },
+  { .name = "string",       .maximum_size = 100 * mebibyte, .generate = generate_string       },
+  { .name = "scope",        .maximum_size = 1000000,        .generate = generate_scope        },
+  { .name = "reparsing",    .maximum_size = 256,            .generate = generate_failing,     .is_reparsing = 1 },
+  { .name = "constants",    .maximum_size = 1000000,        .generate = generate_constants,   .is_folding = 1 },
+  { .name = "pooled",       .maximum_size = 1000000,        .generate = generate_constants,   .is_folding = 1, .is_pooling = 1 },
+};
+
+#if defined(ON_PLATFORM_LINUX)
+
+typedef struct
+{
+  uintl   source_size;
+  float64 time;        /* of parsing and resolving, and checking and folding if the shape does, in nanoseconds */
+  uintl   memory_size; /* the peak, past that of the process before the source was generated */
+  bit     has_failed : 1;
+} stress_step;
+
+/* peak sizes are kept by the kernel for each process, so each step runs in
+   its own, which writes back what it measured */
+static stress_step run_stress_step(const stress_shape *shape, uint size)
+{
+  stress_step step = { .has_failed = 1 };
+  int pipe_ends[2];
+  if (pipe(pipe_ends)) return step;
+  fflush(stdout);
+
+  pid_t child = fork();
+  if (!child)
+  {
+    close(pipe_ends[0]);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    uintl beginning_memory_size = (uintl)usage.ru_maxrss * kibibyte;
+
+    stress_text text = {0};
+    shape->generate(shape->is_reparsing ? reparsed_declarations_count : size, &text);
+
+    program program = {0};
+    parser parser = { .is_pooling = shape->is_pooling };
+    uintl beginning_time = get_time();
+    if (shape->is_reparsing)
+    {
+      /* its failures are expected, and would only repeat themselves */
+      int null_file = open("/dev/null", O_WRONLY);
+      if (null_file >= 0) dup2(null_file, STDERR_FILENO);
+      step.has_failed = 0;
+      for (uint i = 0; i < size; ++i)
+      {
+        parse_text(shape->name, text.elements, text.count, &program, &parser);
+        flush_reports();
+        step.has_failed |= !program.failures_count;
+        reset_program(&program);
+      }
+    }
+    else
+    {
+      parse_text(shape->name, text.elements, text.count, &program, &parser);
+      if (!program.failures_count) resolve(&program);
+      if (!program.failures_count && shape->is_folding) check_types(&program);
+      if (!program.failures_count && shape->is_folding) fold_constants(&program);
+      step.has_failed = program.failures_count != 0;
+    }
+    step.time = (float64)(get_time() - beginning_time);
+    flush_reports();
+
+    getrusage(RUSAGE_SELF, &usage);
+    step.source_size = text.count;
+    step.memory_size = (uintl)usage.ru_maxrss * kibibyte - beginning_memory_size;
+    bit has_written = write(pipe_ends[1], &step, sizeof(step)) == sizeof(step);
+    _exit(has_written ? 0 : 1);
+  }
+  close(pipe_ends[1]);
+  if (child < 0)
+  {
+    close(pipe_ends[0]);
+    return step;
+  }
+
+  /* a step that crashes, like upon a recursion too deep, writes nothing */
+  stress_step written;
+  bit has_read = read(pipe_ends[0], &written, sizeof(written)) == sizeof(written);
+  close(pipe_ends[0]);
+  int status;
+  waitpid(child, &status, 0);
+  if (has_read && WIFEXITED(status) && !WEXITSTATUS(status)) step = written;
+  else if (WIFSIGNALED(status)) printf("  the step was killed by signal %d\n", WTERMSIG(status));
+  return step;
+}
+
+/* the integer part by halving, and the fraction bit by bit by squaring */
+static float64 get_log2(float64 x)
+{
+  float64 result = 0;
+  for (; x >= 2; x /= 2) result += 1;
+  for (; x < 1; x *= 2) result -= 1;
+  for (float64 fraction = 0.5; fraction > 1e-6; fraction /= 2)
+  {
+    x *= x;
+    if (x < 2) continue;
+    x /= 2;
+    result += fraction;
+  }
+  return result;
+}
+
+/* returns whether the shape scaled */
+static bit stress_shape_steps(const stress_shape *shape, uint maximum_size, uint steps_count)
+{
+  printf("%s, up to %u:\n", shape->name, maximum_size);
+  bit has_scaled = 1;
+  stress_step first_judged = {0}, last_judged = {0};
+  uint first_judged_size = 0, last_judged_size = 0;
+  for (uint i = steps_count; i--;)
+  {
+    uint size = maximum_size >> i;
+    if (!size) continue;
+    stress_step step = run_stress_step(shape, size);
+    if (step.has_failed)
+    {
+      print_failure("%s of %u failed to parse and resolve, or to check and fold.\n", shape->name, size);
+      return 0;
+    }
+
+    float64 multiple = (float64)step.memory_size / (float64)step.source_size;
+    printf("  %10u: %10llu bytes in %9.2f ms, peaking at %8.2f MB (%.1fx)\n", size, (unsigned long long)step.source_size,
+           step.time / 1e6, (float64)step.memory_size / mebibyte, multiple);
+    if (step.memory_size > step.source_size * maximum_memory_multiple + memory_slack_size)
+    {
+      print_failure("%s of %u peaked at over %u times its source.\n", shape->name, size, maximum_memory_multiple);
+      has_scaled = 0;
+    }
+
+    if (step.time < minimum_judged_time) continue;
+    if (!first_judged_size) first_judged = step, first_judged_size = size;
+    last_judged = step, last_judged_size = size;
+  }
+
+  if (first_judged_size == last_judged_size)
+  {
+    printf("  too fast to judge its growth\n");
+    return has_scaled;
+  }
+  float64 exponent = get_log2(last_judged.time / first_judged.time) / get_log2((float64)last_judged_size / first_judged_size);
+  printf("  time grows as size^%.2f\n", exponent);
+  if (exponent > maximum_time_exponent)
+  {
+    print_failure("%s grows faster than linearly, as size^%.2f.\n", shape->name, exponent);
+    has_scaled = 0;
+  }
+  return has_scaled;
+}
+
+int stress(char *words[], uint words_count)
+{
+  const stress_shape *chosen_shape = 0;
+  if (words_count)
+  {
+    for (uint i = 0; i < countof(stress_shapes); ++i)
+      if (!compare_string(words[0], stress_shapes[i].name)) chosen_shape = &stress_shapes[i];
+    if (!chosen_shape)
+    {
+      print_failure("%s isn't a shape; it's declarations, nesting, string, scope, reparsing, constants or pooled.\n", words[0]);
+      return 1;
+    }
+  }
+  uint maximum_size = words_count > 1 ? (uint)strtoul(words[1], 0, 10) : 0;
+  uint steps_count = words_count > 2 ? (uint)strtoul(words[2], 0, 10) : default_steps_count;
+
+  /* the reports of the generated programs would only repeat themselves */
+  reporting.minimum_type = reporting_type_failure;
+  uint failures_count = 0;
+  for (uint i = 0; i < countof(stress_shapes); ++i)
+  {
+    const stress_shape *shape = &stress_shapes[i];
+    if (chosen_shape && shape != chosen_shape) continue;
+    failures_count += !stress_shape_steps(shape, maximum_size ? maximum_size : shape->maximum_size, steps_count ? steps_count : 1);
+  }
+
+  if (!failures_count) return 0;
+  print_failure("%u shape%s didn't scale.\n", failures_count, failures_count == 1 ? "" : "s");
+  return 1;
+}
+
+#else
+
+int stress(char *words[], uint words_count)
+{
+  (void)words, (void)words_count;
+  print_failure("Stressing isn't supported on this platform.\n");
+  return -1;
+}
+
+#endif
@@ -0,0 +1,1310 @@
+#include "proglosa.h"
+
+/*****************************************************************************/
+
+/* the interned types of every program checked by the process; these are
+   initialized upon the first `check_types` */
+static struct
+{
+  type *types;
+  uint  types_count;
+  uint  types_capacity;
+
+  type_id *slots; /* an open-addressing set of ids, where 0 is free */
+  uint     slots_count;
+
+  type_id free_type; /* the first id forgotten with its program, whose `pointee` is the next */
+
+  type_id builtins[builtins_count];
+  type_id type_type;
+  type_id integer_type;
+  type_id decimal_type;
+  type_id bit_type;
+  type_id string_type;
+} types;
+
+typedef enum
+{
+  checking_state_unchecked,
+  checking_state_checking,
+  checking_state_checked,
+} checking_state;
+
+typedef struct
+{
+  program        *program;
+  procedure_node *procedure; /* that encloses the checked expressions */
+} checker;
+
+type *get_type(type_id id)
+{
+  ASSERT(id < types.types_count);
+  return &types.types[id];
+}
+
+static bit is_named_structure(const type *type)
+{
+  return type->kind == type_kind_structure && type->declaration;
+}
+
+static uint hash_type(const type *type)
+{
+  /* named structures are identified by their declarations alone, since their
+     fields are assigned after they're interned */
+  uint hash = hash_string((const utf8 *)&type->kind, sizeof(type->kind));
+  if (is_named_structure(type))
+    return hash ^ hash_string((const utf8 *)&type->declaration, sizeof(type->declaration));
+
+  /* the size of a structure follows from its fields, and it's assigned after
+     it's interned */
+  if (type->kind != type_kind_structure) hash = hash * 31 + type->size;
+  hash = hash * 31 + type->pointee;
+  hash = hash * 31 + type->arguments_count;
+  for (uint i = 0; i < type->components_count; ++i) hash = hash * 31 + type->components[i];
+  if (type->kind == type_kind_structure)
+  {
+    for (statement *field = type->structure->declarations; field; field = field->next)
+      hash = hash * 31 + field->expression.data->declaration.identifier.hash;
+  }
+  return hash;
+}
+
+static bit are_types_equal(const type *left, const type *right)
+{
+  if (left->kind != right->kind || left->hash != right->hash) return 0;
+  if (is_named_structure(left) || is_named_structure(right)) return left->declaration == right->declaration;
+  if ((left->kind != type_kind_structure && left->size != right->size)
+      || left->pointee != right->pointee
+      || left->arguments_count != right->arguments_count
+      || left->components_count != right->components_count)
+    return 0;
+  for (uint i = 0; i < left->components_count; ++i)
+    if (left->components[i] != right->components[i]) return 0;
+
+  /* equal structures have equally named fields, and they're distinct in
+     distinct programs, whose nodes they refer to */
+  if (left->kind == type_kind_structure && left->program != right->program) return 0;
+  if (left->kind == type_kind_structure && left->structure != right->structure)
+  {
+    statement *left_field = left->structure->declarations;
+    statement *right_field = right->structure->declarations;
+    for (; left_field && right_field; left_field = left_field->next, right_field = right_field->next)
+    {
+      identifier_node *left_name = &left_field->expression.data->declaration.identifier;
+      identifier_node *right_name = &right_field->expression.data->declaration.identifier;
+      if (left_name->runes_count != right_name->runes_count
+          || compare_sized_string(left_name->runes, right_name->runes, left_name->runes_count))
+        return 0;
+    }
+  }
+  return 1;
+}
+
+static void insert_type_slot(type_id id)
+{
+  uint mask = types.slots_count - 1;
+  uint i = types.types[id].hash & mask;
+  while (types.slots[i]) i = (i + 1) & mask;
+  types.slots[i] = id;
+}
+
+type_id intern_type(const type *candidate)
+{
+  if (candidate->kind == type_kind_none) return none_type;
+
+  type hashed = *candidate;
+  hashed.hash = hash_type(&hashed);
+
+  /* a type refers to the nodes of its components' program */
+  if (!hashed.program && hashed.pointee) hashed.program = get_type(hashed.pointee)->program;
+  for (uint i = 0; !hashed.program && i < hashed.components_count; ++i) hashed.program = get_type(hashed.components[i])->program;
+
+  uint mask = types.slots_count - 1;
+  for (uint i = hashed.hash & mask; types.slots[i]; i = (i + 1) & mask)
+    if (are_types_equal(&types.types[types.slots[i]], &hashed)) return types.slots[i];
+
+  if (types.types_count == types.types_capacity)
+  {
+    uint capacity = types.types_capacity * 2;
+    types.types = reallocate(capacity * sizeof(type), types.types, types.types_capacity * sizeof(type));
+    types.types_capacity = capacity;
+  }
+
+  /* the load of the set is kept at most half */
+  if ((types.types_count + 1) * 2 > types.slots_count)
+  {
+    uint old_slots_count = types.slots_count;
+    deallocate(types.slots, old_slots_count * sizeof(type_id));
+    types.slots_count *= 2;
+    types.slots = allocate(types.slots_count * sizeof(type_id));
+    zero(types.slots, types.slots_count * sizeof(type_id));
+    /* the ids freed by `forget_program` aren't types */
+    for (type_id id = 1; id < types.types_count; ++id)
+      if (types.types[id].kind != type_kind_none) insert_type_slot(id);
+  }
+
+  if (hashed.components_count)
+  {
+    hashed.components = push_type(type_id, hashed.components_count, hashed.program ? &hashed.program->allocator : context.allocator);
+    copy_typed(type_id, hashed.components, candidate->components, hashed.components_count);
+  }
+
+  type_id id = types.free_type;
+  if (id) types.free_type = types.types[id].pointee;
+  else id = types.types_count++;
+  types.types[id] = hashed;
+  insert_type_slot(id);
+  return id;
+}
+
+static type_id intern_primitive(type_kind kind, uint size)
+{
+  return intern_type(&(type){ .kind = kind, .size = size });
+}
+
+static type_id intern_pointer(type_id pointee)
+{
+  return intern_type(&(type){ .kind = type_kind_pointer, .size = sizeof(void *), .pointee = pointee });
+}
+
+static void initialize_types(void)
+{
+  if (types.types) return;
+
+  types.types_capacity = 256;
+  types.types = allocate(types.types_capacity * sizeof(type));
+  types.types_count = 1; /* `none_type` */
+  zero(&types.types[none_type], sizeof(type));
+
+  types.slots_count = 512;
+  types.slots = allocate(types.slots_count * sizeof(type_id));
+  zero(types.slots, types.slots_count * sizeof(type_id));
+
+  types.type_type    = intern_primitive(type_kind_type,    0);
+  types.integer_type = intern_primitive(type_kind_integer, 0);
+  types.decimal_type = intern_primitive(type_kind_decimal, 0);
+
+  types.builtins[builtin_u8]  = intern_primitive(type_kind_unsigned, 1);
+  types.builtins[builtin_u16] = intern_primitive(type_kind_unsigned, 2);
+  types.builtins[builtin_u32] = intern_primitive(type_kind_unsigned, 4);
+  types.builtins[builtin_u64] = intern_primitive(type_kind_unsigned, 8);
+  types.builtins[builtin_s8]  = intern_primitive(type_kind_signed,   1);
+  types.builtins[builtin_s16] = intern_primitive(type_kind_signed,   2);
+  types.builtins[builtin_s32] = intern_primitive(type_kind_signed,   4);
+  types.builtins[builtin_s64] = intern_primitive(type_kind_signed,   8);
+  types.builtins[builtin_f32] = intern_primitive(type_kind_float,    4);
+  types.builtins[builtin_f64] = intern_primitive(type_kind_float,    8);
+  types.builtins[builtin_bit] = intern_primitive(type_kind_bit,      1);
+
+  types.bit_type    = types.builtins[builtin_bit];
+  types.string_type = intern_pointer(types.builtins[builtin_u8]);
+}
+
+/*****************************************************************************/
+
+typedef struct
+{
+  utf8 *cursor;
+  utf8 *ending;
+} type_writer;
+
+static void write_type_string(type_writer *writer, const utf8 *format, ...)
+{
+  vargs vargs;
+  get_vargs(vargs, format);
+  uint available_size = (uint)(writer->ending - writer->cursor);
+  int written_size = vsnprintf(writer->cursor, available_size, format, vargs);
+  end_vargs(vargs);
+  if (written_size < 0) return;
+  writer->cursor += (uint)written_size < available_size ? (uint)written_size : available_size - 1;
+}
+
+static void write_type(type_writer *writer, type_id id)
+{
+  type *type = get_type(id);
+  switch (type->kind)
+  {
+  case type_kind_none:    write_type_string(writer, "none");             break;
+  case type_kind_type:    write_type_string(writer, "type");             break;
+  case type_kind_integer: write_type_string(writer, "integer constant"); break;
+  case type_kind_decimal: write_type_string(writer, "decimal constant"); break;
+  case type_kind_unsigned:
+  case type_kind_signed:
+  case type_kind_float:
+  case type_kind_bit:
+    for (uint i = 0; i < builtins_count; ++i)
+    {
+      if (types.builtins[i] != id) continue;
+      write_type_string(writer, "%s", builtin_representations[i]);
+      break;
+    }
+    break;
+  case type_kind_pointer:
+    write_type_string(writer, "@");
+    write_type(writer, type->pointee);
+    break;
+  case type_kind_procedure:
+    write_type_string(writer, "(");
+    for (uint i = 0; i < type->components_count; ++i)
+    {
+      if (i == type->arguments_count) write_type_string(writer, ") -> (");
+      else if (i) write_type_string(writer, ", ");
+      write_type(writer, get_type(id)->components[i]);
+    }
+    if (type->arguments_count == type->components_count) write_type_string(writer, ") -> (");
+    write_type_string(writer, ")");
+    break;
+  case type_kind_structure:
+    if (type->declaration)
+    {
+      write_type_string(writer, "%s", type->declaration->identifier.runes);
+      break;
+    }
+    write_type_string(writer, "{");
+    uint i = 0;
+    for (statement *field = type->structure->declarations; field; field = field->next, ++i)
+    {
+      write_type_string(writer, i ? "; %s: " : "%s: ", field->expression.data->declaration.identifier.runes);
+      write_type(writer, get_type(id)->components[i]);
+    }
+    write_type_string(writer, "}");
+    break;
+  }
+}
+
+const utf8 *represent_type(utf8 *string, uint string_size, type_id id)
+{
+  type_writer writer = { string, string + string_size };
+  string[0] = 0;
+  write_type(&writer, id);
+  return string;
+}
+
+/*****************************************************************************/
+
+static bit is_numeric(type_id id)
+{
+  switch (get_type(id)->kind)
+  {
+  case type_kind_integer:
+  case type_kind_decimal:
+  case type_kind_unsigned:
+  case type_kind_signed:
+  case type_kind_float:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+static bit is_integral(type_id id)
+{
+  switch (get_type(id)->kind)
+  {
+  case type_kind_integer:
+  case type_kind_unsigned:
+  case type_kind_signed:
+  case type_kind_bit:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+static bit is_scalar(type_id id)
+{
+  return is_numeric(id) || get_type(id)->kind == type_kind_bit || get_type(id)->kind == type_kind_pointer;
+}
+
+static bit is_untyped(type_id id)
+{
+  return id == types.integer_type || id == types.decimal_type;
+}
+
+static expression *get_declaration_expression(declaration_node *declaration)
+{
+  return (expression *)((byte *)declaration - offsetof(expression, data));
+}
+
+static sintl get_builtin(declaration_node *declaration)
+{
+  if (declaration < builtin_declarations || declaration >= builtin_declarations + builtins_count) return -1;
+  return declaration - builtin_declarations;
+}
+
+/* a procedure whose arguments declare type parameters, `$T`, is checked
+   once per instance rather than by itself */
+static bit is_generic_procedure(expression *expression)
+{
+  return expression && expression->tag == node_tag_procedure && expression->data->procedure.type_parameters && !expression->data->procedure.is_instance;
+}
+
+static bit is_generic_declaration(declaration_node *declaration)
+{
+  return declaration->is_constant && is_generic_procedure(declaration->assignment);
+}
+
+#define type_representation_size ((uint)128)
+
+static void report_mismatch(expression *expression, type_id expected, type_id given, checker *checker)
+{
+  utf8 expected_representation[type_representation_size], given_representation[type_representation_size];
+  report_expression_failure(checker->program, expression, "Expected %s, but got %s.",
+                            represent_type(expected_representation, type_representation_size, expected),
+                            represent_type(given_representation, type_representation_size, given));
+}
+
+/* checks that a value can be implicitly converted */
+static void check_conversion(expression *expression, type_id to, checker *checker)
+{
+  type_id from = expression->type;
+  if (from == to || from == none_type || to == none_type) return;
+
+  type_kind to_kind = get_type(to)->kind;
+  if (from == types.integer_type && (is_numeric(to) || to_kind == type_kind_bit)) return;
+  if (from == types.decimal_type && to_kind == type_kind_float) return;
+  if (from == types.decimal_type && is_integral(to))
+  {
+    report_expression_caution(checker->program, expression, "The decimal constant is truncated.");
+    return;
+  }
+  report_mismatch(expression, to, from, checker);
+}
+
+/* the type of an untyped constant that's stored in a variable */
+static type_id get_default_type(type_id id)
+{
+  if (id == types.integer_type) return types.builtins[builtin_s64];
+  if (id == types.decimal_type) return types.builtins[builtin_f64];
+  return id;
+}
+
+/* the type of every field of a structure whose fields are variables of one
+   numeric type, which is operated upon elementwise; or none */
+static type_id get_element_type(type_id id)
+{
+  type *type = get_type(id);
+  if (type->kind != type_kind_structure || !type->components_count || type->components_count != type->structure->declarations_count)
+    return none_type;
+  uint i = 0;
+  for (statement *field = type->structure->declarations; field; field = field->next, ++i)
+  {
+    if (field->expression.data->declaration.is_constant
+        || type->components[i] != type->components[0]
+        || !is_numeric(type->components[i])
+        || is_untyped(type->components[i]))
+      return none_type;
+  }
+  return type->components[0];
+}
+
+/* the common type of two operands */
+static type_id unify(expression *left, expression *right, checker *checker)
+{
+  type_id left_type = left->type, right_type = right->type;
+  if (left_type == none_type || right_type == none_type) return none_type;
+  if (left_type == right_type) return left_type;
+  if (is_untyped(left_type) && is_untyped(right_type)) return types.decimal_type;
+  if (is_untyped(left_type))
+  {
+    check_conversion(left, right_type, checker);
+    return right_type;
+  }
+  if (is_untyped(right_type))
+  {
+    check_conversion(right, left_type, checker);
+    return left_type;
+  }
+  report_mismatch(right, left_type, right_type, checker);
+  return none_type;
+}
+
+/* the arithmetic of compound assignments */
+static node_tag get_assigned_operation(node_tag tag)
+{
+  switch (tag)
+  {
+  case node_tag_addition_assignment:                      return node_tag_addition;
+  case node_tag_subtraction_assignment:                   return node_tag_subtraction;
+  case node_tag_multiplication_assignment:                return node_tag_multiplication;
+  case node_tag_division_assignment:                      return node_tag_division;
+  case node_tag_modulo_assignment:                        return node_tag_modulo;
+  case node_tag_bitwise_conjunction_assignment:           return node_tag_bitwise_conjunction;
+  case node_tag_bitwise_disjunction_assignment:           return node_tag_bitwise_disjunction;
+  case node_tag_bitwise_exclusive_disjunction_assignment: return node_tag_bitwise_exclusive_disjunction;
+  case node_tag_bitwise_left_shift_assignment:            return node_tag_bitwise_left_shift;
+  case node_tag_bitwise_right_shift_assignment:           return node_tag_bitwise_right_shift;
+  default:                                                return node_tag_assignment;
+  }
+}
+
+/* the common type of two arithmetic operands, of which a scalar is operated
+   upon with every field of a structure */
+static type_id unify_arithmetic(expression *left, expression *right, checker *checker)
+{
+  type_id left_element = get_element_type(left->type), right_element = get_element_type(right->type);
+  if (left->type == right->type || (left_element == none_type && right_element == none_type)) return unify(left, right, checker);
+  if (left_element != none_type && right_element == none_type && is_numeric(right->type))
+  {
+    check_conversion(right, left_element, checker);
+    return left->type;
+  }
+  if (right_element != none_type && left_element == none_type && is_numeric(left->type))
+  {
+    check_conversion(left, right_element, checker);
+    return right->type;
+  }
+  report_mismatch(right, left->type, right->type, checker);
+  return none_type;
+}
+
+/* checks that the arithmetic is defined for the type, or its elements */
+static bit check_arithmetic(expression *expression, node_tag tag, type_id id, checker *checker)
+{
+  type_id element = get_element_type(id);
+  type_id operand = element != none_type ? element : id;
+  bit is_bitwise = node_tag_bitwise_conjunction <= tag && tag <= node_tag_bitwise_exclusive_disjunction;
+  if (!is_numeric(operand)
+      || (is_bitwise && !is_integral(operand))
+      || (tag == node_tag_modulo && get_type(operand)->kind == type_kind_float)
+      || (element != none_type && is_integral(element) && (tag == node_tag_division || tag == node_tag_modulo))
+      || (element != none_type && (tag == node_tag_bitwise_left_shift || tag == node_tag_bitwise_right_shift)))
+  {
+    utf8 representation[type_representation_size];
+    report_expression_failure(checker->program, expression, "The operation isn't defined for %s.", represent_type(representation, type_representation_size, id));
+    return 0;
+  }
+  return 1;
+}
+
+static type_id check_expression(expression *expression, checker *checker);
+static void    check_declaration(declaration_node *declaration, checker *checker);
+
+static bit denotes_type(expression *expression, checker *checker)
+{
+  if (!expression) return 0;
+  switch (expression->tag)
+  {
+  case node_tag_identifier:
+    {
+      declaration_node *declaration = expression->data->identifier.declaration;
+      if (!declaration) return 0;
+      sintl builtin = get_builtin(declaration);
+      if (builtin >= 0) return builtin != builtin_return;
+      check_declaration(declaration, checker);
+      return declaration->denoted_type != none_type;
+    }
+  case node_tag_reference:
+    return denotes_type(expression->data->reference.expression, checker);
+  case node_tag_procedure_type:
+  case node_tag_structure:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+static void flatten_list(expression **items, uint *items_count, uint items_capacity, expression *list)
+{
+  if (!list) return;
+  if (list->tag == node_tag_list)
+  {
+    flatten_list(items, items_count, items_capacity, list->data->list.left);
+    flatten_list(items, items_count, items_capacity, list->data->list.right);
+    return;
+  }
+  if (*items_count < items_capacity) items[*items_count] = list;
+  *items_count += 1;
+}
+
+#define maximum_parameters_count ((uint)64)
+
+static type_id evaluate_type(expression *expression, checker *checker);
+
+/* the type of a procedure's parameter list, `(a: A, B)` */
+static void evaluate_parameters(type_id *components, uint *components_count, expression *parameters, checker *checker)
+{
+  expression *items[maximum_parameters_count];
+  uint items_count = 0;
+  flatten_list(items, &items_count, maximum_parameters_count, parameters);
+  if (items_count > maximum_parameters_count)
+  {
+    report_expression_failure(checker->program, parameters, "Too many parameters.");
+    items_count = maximum_parameters_count;
+  }
+  for (uint i = 0; i < items_count; ++i)
+  {
+    expression *item = items[i];
+    if (item->tag == node_tag_cast && item->data->cast.left->tag == node_tag_identifier) item = item->data->cast.right;
+    if (*components_count < maximum_parameters_count * 2)
+      components[(*components_count)++] = evaluate_type(item, checker);
+  }
+}
+
+static type_id evaluate_procedure_type(expression *arguments, expression *results, checker *checker)
+{
+  type_id components[maximum_parameters_count * 2];
+  uint components_count = 0;
+  evaluate_parameters(components, &components_count, arguments, checker);
+  uint arguments_count = components_count;
+  evaluate_parameters(components, &components_count, results, checker);
+  return intern_type(&(type)
+  {
+    .kind             = type_kind_procedure,
+    .size             = sizeof(void *),
+    .components       = components,
+    .components_count = components_count,
+    .arguments_count  = arguments_count,
+  });
+}
+
+static type_id evaluate_structure_type(structure_node *structure, declaration_node *declaration, checker *checker)
+{
+  type_id id = intern_type(&(type)
+  {
+    .kind        = type_kind_structure,
+    .structure   = structure,
+    .declaration = declaration,
+    .program     = checker->program,
+  });
+  if (declaration) declaration->denoted_type = id;
+
+  type_id *components = push_type(type_id, structure->declarations_count, &checker->program->allocator);
+  uint i = 0;
+  for (statement *field = structure->declarations; field; field = field->next, ++i)
+  {
+    check_declaration(&field->expression.data->declaration, checker);
+    components[i] = field->expression.data->declaration.type;
+  }
+
+  if (declaration)
+  {
+    /* a named structure is interned by its declaration, so the fields are
+       assigned in place */
+    type *type = get_type(id);
+    type->components = components;
+    type->components_count = structure->declarations_count;
+    return id;
+  }
+  return intern_type(&(type)
+  {
+    .kind             = type_kind_structure,
+    .structure        = structure,
+    .components       = components,
+    .components_count = structure->declarations_count,
+    .program          = checker->program,
+  });
+}
+
+type_id evaluate_type(expression *expression, checker *checker)
+{
+  if (!expression) return none_type;
+  expression->type = types.type_type;
+  switch (expression->tag)
+  {
+  case node_tag_identifier:
+    {
+      declaration_node *declaration = expression->data->identifier.declaration;
+      if (!declaration) return none_type;
+      sintl builtin = get_builtin(declaration);
+      if (builtin >= 0 && builtin != builtin_return) return types.builtins[builtin];
+      if (builtin < 0)
+      {
+        check_declaration(declaration, checker);
+        if (declaration->denoted_type != none_type) return declaration->denoted_type;
+      }
+      break;
+    }
+  case node_tag_reference:
+    {
+      type_id pointee = evaluate_type(expression->data->reference.expression, checker);
+      return pointee == none_type ? none_type : intern_pointer(pointee);
+    }
+  case node_tag_procedure_type:
+    return evaluate_procedure_type(expression->data->procedure_type.arguments, expression->data->procedure_type.results, checker);
+  case node_tag_structure:
+    return evaluate_structure_type(&expression->data->structure, 0, checker);
+  default:
+    break;
+  }
+  report_expression_failure(checker->program, expression, "Expected a type.");
+  return none_type;
+}
+
+static void check_procedure(expression *expression, checker *checker)
+{
+  procedure_node *procedure = &expression->data->procedure;
+  if (expression->type == none_type)
+    expression->type = evaluate_procedure_type(procedure->arguments, procedure->results, checker);
+
+  procedure_node *prior_procedure = checker->procedure;
+  checker->procedure = procedure;
+  for (statement *parameter = procedure->structure.declarations; parameter; parameter = parameter->next)
+    check_declaration(&parameter->expression.data->declaration, checker);
+  for (statement *statement = procedure->statements; statement; statement = statement->next)
+  {
+    if (statement->expression.tag == node_tag_declaration)
+      check_declaration(&statement->expression.data->declaration, checker);
+    else check_expression(&statement->expression, checker);
+  }
+  checker->procedure = prior_procedure;
+}
+
+void check_declaration(declaration_node *declaration, checker *checker)
+{
+  if (get_builtin(declaration) >= 0) return;
+  switch ((checking_state)declaration->checking_state)
+  {
+  case checking_state_checked:
+    return;
+  case checking_state_checking:
+    report_expression_failure(checker->program, get_declaration_expression(declaration), "%s depends on itself.", declaration->identifier.runes);
+    declaration->checking_state = checking_state_checked; /* to report once */
+    return;
+  case checking_state_unchecked:
+    break;
+  }
+  declaration->checking_state = checking_state_checking;
+
+  /* declarations are checked lazily upon their first use, which isn't
+     necessarily within the procedure that encloses the use */
+  procedure_node *prior_procedure = checker->procedure;
+  expression *type_definition = declaration->type_definition;
+  expression *assignment = declaration->assignment;
+
+  if (type_definition && type_definition->tag == node_tag_structure)
+  {
+    /* `Name: {fields}` names a structure, which may refer to itself */
+    declaration->type = types.type_type;
+    declaration->checking_state = checking_state_checked;
+    type_definition->type = types.type_type;
+    evaluate_structure_type(&type_definition->data->structure, declaration, checker);
+    if (assignment) check_expression(assignment, checker);
+  }
+  else if (is_generic_declaration(declaration))
+  {
+    /* the body is checked within each instance, where its types are known */
+    declaration->type = none_type;
+  }
+  else if (declaration->is_constant && assignment && assignment->tag == node_tag_procedure)
+  {
+    /* the type of a procedure is known before its body is checked, so that
+       it may invoke itself */
+    procedure_node *procedure = &assignment->data->procedure;
+    checker->procedure = 0;
+    assignment->type = evaluate_procedure_type(procedure->arguments, procedure->results, checker);
+    declaration->type = assignment->type;
+    if (type_definition) check_conversion(assignment, evaluate_type(type_definition, checker), checker);
+    declaration->checking_state = checking_state_checked;
+    check_procedure(assignment, checker);
+  }
+  else if (declaration->is_constant && denotes_type(assignment, checker))
+  {
+    declaration->type = types.type_type;
+    declaration->denoted_type = evaluate_type(assignment, checker);
+  }
+  else
+  {
+    type_id declared_type = type_definition ? evaluate_type(type_definition, checker) : none_type;
+    if (assignment)
+    {
+      check_expression(assignment, checker);
+      if (type_definition) check_conversion(assignment, declared_type, checker);
+    }
+    if (type_definition) declaration->type = declared_type;
+    else if (declaration->is_constant) declaration->type = assignment->type;
+    else declaration->type = get_default_type(assignment->type);
+  }
+
+  checker->procedure = prior_procedure;
+  declaration->checking_state = checking_state_checked;
+}
+
+static bit is_assignable(expression *expression)
+{
+  switch (expression->tag)
+  {
+  case node_tag_identifier:
+    {
+      declaration_node *declaration = expression->data->identifier.declaration;
+      return declaration && get_builtin(declaration) < 0 && !declaration->is_constant;
+    }
+  case node_tag_resolution:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+/* the instances of generic procedures, by their generic declarations and the
+   types bound to their type parameters; like the types, they're kept for
+   every program checked by the process, until it's reset */
+typedef struct
+{
+  uint              hash;
+  program          *program;  /* whose arena holds the instance */
+  declaration_node *generic;
+  type_id          *bindings; /* of each type parameter, in order */
+  declaration_node *instance; /* or none, if the slot is free */
+} instance_slot;
+
+static struct
+{
+  instance_slot *slots;
+  uint           slots_count;
+  uint           instances_count;
+} instances;
+
+static uint hash_instance(declaration_node *generic, const type_id *bindings, uint bindings_count)
+{
+  uint hash = hash_string((const utf8 *)&generic, sizeof(generic));
+  for (uint i = 0; i < bindings_count; ++i) hash = hash * 31 + bindings[i];
+  return hash;
+}
+
+/* the slot of an instance, or the free slot it'd be inserted into */
+static instance_slot *find_instance_slot(declaration_node *generic, const type_id *bindings, uint hash)
+{
+  uint bindings_count = generic->assignment->data->procedure.type_parameters_count;
+  uint mask = instances.slots_count - 1;
+  for (uint i = hash & mask;; i = (i + 1) & mask)
+  {
+    instance_slot *slot = &instances.slots[i];
+    if (!slot->instance) return slot;
+    if (slot->hash != hash || slot->generic != generic) continue;
+    uint j = 0;
+    while (j < bindings_count && slot->bindings[j] == bindings[j]) ++j;
+    if (j == bindings_count) return slot;
+  }
+}
+
+/* the load of the table is kept at most half */
+static void reserve_instance(void)
+{
+  if ((instances.instances_count + 1) * 2 <= instances.slots_count) return;
+  instance_slot *old_slots = instances.slots;
+  uint old_slots_count = instances.slots_count;
+  instances.slots_count = old_slots_count ? old_slots_count * 2 : 16;
+  instances.slots = allocate(instances.slots_count * sizeof(instance_slot));
+  zero(instances.slots, instances.slots_count * sizeof(instance_slot));
+  for (uint i = 0; i < old_slots_count; ++i)
+  {
+    instance_slot *old_slot = &old_slots[i];
+    if (old_slot->instance) *find_instance_slot(old_slot->generic, old_slot->bindings, old_slot->hash) = *old_slot;
+  }
+  if (old_slots) deallocate(old_slots, old_slots_count * sizeof(instance_slot));
+}
+
+/* forgets the types that refer to the program's nodes, whose ids are then
+   reused, and the instances of its generic procedures; no other program
+   refers to them, since even equal structures are distinct across programs */
+static void forget_program(program *program)
+{
+  bit is_forgetting = 0;
+  for (type_id id = 1; id < types.types_count; ++id)
+  {
+    if (types.types[id].program != program) continue;
+    zero(&types.types[id], sizeof(type));
+    types.types[id].pointee = types.free_type;
+    types.free_type = id;
+    is_forgetting = 1;
+  }
+  if (is_forgetting)
+  {
+    zero(types.slots, types.slots_count * sizeof(type_id));
+    for (type_id id = 1; id < types.types_count; ++id)
+      if (types.types[id].kind != type_kind_none) insert_type_slot(id);
+  }
+
+  if (!instances.instances_count) return;
+  instance_slot *old_slots = instances.slots;
+  instances.slots = allocate(instances.slots_count * sizeof(instance_slot));
+  zero(instances.slots, instances.slots_count * sizeof(instance_slot));
+  instances.instances_count = 0;
+  for (uint i = 0; i < instances.slots_count; ++i)
+  {
+    instance_slot *old_slot = &old_slots[i];
+    if (!old_slot->instance || old_slot->program == program) continue;
+    *find_instance_slot(old_slot->generic, old_slot->bindings, old_slot->hash) = *old_slot;
+    instances.instances_count += 1;
+  }
+  deallocate(old_slots, instances.slots_count * sizeof(instance_slot));
+}
+
+/* binds the type parameters within the type of a parameter to the parts of
+   the argument's type they correspond to */
+static void infer_bindings(type_id *bindings, procedure_node *generic, expression *pattern, type_id given)
+{
+  if (!pattern || given == none_type) return;
+  switch (pattern->tag)
+  {
+  case node_tag_identifier:
+    {
+      uint i = 0;
+      for (statement *type_parameter = generic->type_parameters; type_parameter; type_parameter = type_parameter->next, ++i)
+      {
+        if (pattern->data->identifier.declaration != &type_parameter->expression.data->declaration) continue;
+        if (bindings[i] == none_type) bindings[i] = given;
+        return;
+      }
+      break;
+    }
+  case node_tag_reference:
+    if (get_type(given)->kind == type_kind_pointer)
+      infer_bindings(bindings, generic, pattern->data->reference.expression, get_type(given)->pointee);
+    break;
+  default:
+    break;
+  }
+}
+
+static void report_instance_failures(expression *invocation, declaration_node *generic, const type_id *bindings, checker *checker)
+{
+  utf8 representation[type_representation_size];
+  type_writer writer = { representation, representation + type_representation_size };
+  representation[0] = 0;
+  uint i = 0;
+  for (statement *type_parameter = generic->assignment->data->procedure.type_parameters; type_parameter; type_parameter = type_parameter->next, ++i)
+  {
+    write_type_string(&writer, i ? ", %s = " : "%s = ", type_parameter->expression.data->declaration.identifier.runes);
+    write_type(&writer, bindings[i]);
+  }
+  report_expression_caution(checker->program, invocation, "The failures above are within %s where %s.", generic->identifier.runes, representation);
+}
+
+/* the instance of a generic procedure for the types of the arguments, which
+   is created upon its first invocation and reused by the others */
+static declaration_node *instantiate(declaration_node *generic, expression *invocation, expression **arguments, uint arguments_count, checker *checker)
+{
+  procedure_node *procedure = &generic->assignment->data->procedure;
+  if (arguments_count != procedure->arguments_count)
+  {
+    report_expression_failure(checker->program, invocation, "Expected %u arguments, but got %u.", procedure->arguments_count, arguments_count);
+    return 0;
+  }
+  if (procedure->type_parameters_count > maximum_parameters_count)
+  {
+    report_expression_failure(checker->program, generic->assignment, "Too many type parameters.");
+    return 0;
+  }
+
+  /* the typed arguments bind first, so that untyped constants are converted
+     to the types bound by them */
+  type_id bindings[maximum_parameters_count] = {0};
+  for (bit is_binding_untyped = 0; is_binding_untyped <= 1; ++is_binding_untyped)
+  {
+    statement *parameter = procedure->structure.declarations;
+    for (uint i = 0; i < arguments_count; ++i, parameter = parameter->next)
+    {
+      type_id given = arguments[i]->type;
+      if (is_untyped(given) != is_binding_untyped) continue;
+      infer_bindings(bindings, procedure, parameter->expression.data->declaration.type_definition, get_default_type(given));
+    }
+  }
+  bit is_bound = 1;
+  uint i = 0;
+  for (statement *type_parameter = procedure->type_parameters; type_parameter; type_parameter = type_parameter->next, ++i)
+  {
+    if (bindings[i] != none_type) continue;
+    report_expression_failure(checker->program, invocation, "%s isn't inferred from the arguments.", type_parameter->expression.data->declaration.identifier.runes);
+    is_bound = 0;
+  }
+  if (!is_bound) return 0;
+
+  uint hash = hash_instance(generic, bindings, procedure->type_parameters_count);
+  reserve_instance();
+  instance_slot *slot = find_instance_slot(generic, bindings, hash);
+  if (slot->instance) return slot->instance;
+
+  /* the instance is a clone that's resolved where the generic procedure is
+     declared, whose type parameters denote the bound types */
+  expression *generic_expression = get_declaration_expression(generic);
+  allocator *allocator = &checker->program->allocator;
+  statement *instance_statement = push_typed_train(statement, declaration_node, allocator);
+  zero(instance_statement, sizeof(statement) + sizeof(declaration_node));
+  instance_statement->expression.tag       = node_tag_declaration;
+  instance_statement->expression.beginning = generic_expression->beginning;
+  instance_statement->expression.ending    = generic_expression->ending;
+  declaration_node *instance = &instance_statement->expression.data->declaration;
+  instance->identifier             = generic->identifier;
+  instance->identifier.declaration = 0;
+  instance->is_constant            = 1;
+  instance->assignment             = clone_expression(generic->assignment, allocator);
+  instance->assignment->data->procedure.is_instance = 1;
+
+  scope *enclosing_scope = procedure->structure.scope->parent->parent; /* past the parameters and the type parameters */
+  resolve_instance(instance->assignment, enclosing_scope, checker->program);
+  i = 0;
+  for (statement *type_parameter = instance->assignment->data->procedure.type_parameters; type_parameter; type_parameter = type_parameter->next, ++i)
+  {
+    declaration_node *bound = &type_parameter->expression.data->declaration;
+    bound->type           = types.type_type;
+    bound->denoted_type   = bindings[i];
+    bound->checking_state = checking_state_checked;
+  }
+
+  /* cached before it's checked, since it may invoke itself */
+  slot->hash     = hash;
+  slot->program  = checker->program;
+  slot->generic  = generic;
+  slot->bindings = push_type(type_id, procedure->type_parameters_count, allocator);
+  copy_typed(type_id, slot->bindings, bindings, procedure->type_parameters_count);
+  slot->instance = instance;
+  instances.instances_count += 1;
+
+  uint failures_count = checker->program->failures_count;
+  check_declaration(instance, checker);
+  if (checker->program->failures_count != failures_count) report_instance_failures(invocation, generic, bindings, checker);
+  return instance;
+}
+
+static type_id check_invocation(expression *expression, checker *checker)
+{
+  struct expression *callee = expression->data->invocation.left;
+  struct expression *arguments[maximum_parameters_count];
+  uint arguments_count = 0;
+  flatten_list(arguments, &arguments_count, maximum_parameters_count, expression->data->invocation.right);
+  if (arguments_count > maximum_parameters_count)
+  {
+    report_expression_failure(checker->program, expression, "Too many arguments.");
+    return none_type;
+  }
+  for (uint i = 0; i < arguments_count; ++i) check_expression(arguments[i], checker);
+
+  /* `return results` */
+  if (callee->tag == node_tag_identifier && callee->data->identifier.declaration == &builtin_declarations[builtin_return])
+  {
+    callee->type = none_type;
+    if (!checker->procedure)
+    {
+      report_expression_failure(checker->program, expression, "Returned outside of a procedure.");
+      return none_type;
+    }
+    struct expression *procedure_expression = (struct expression *)((byte *)checker->procedure - offsetof(struct expression, data));
+    type *procedure_type = get_type(procedure_expression->type);
+    uint results_count = procedure_type->components_count - procedure_type->arguments_count;
+    if (arguments_count != results_count)
+    {
+      report_expression_failure(checker->program, expression, "Expected %u results, but got %u.", results_count, arguments_count);
+      return none_type;
+    }
+    for (uint i = 0; i < arguments_count; ++i)
+      check_conversion(arguments[i], get_type(procedure_expression->type)->components[procedure_type->arguments_count + i], checker);
+    return none_type;
+  }
+
+  /* a generic procedure is invoked through its instance */
+  if (callee->tag == node_tag_identifier && callee->data->identifier.declaration && is_generic_declaration(callee->data->identifier.declaration))
+  {
+    declaration_node *instance = instantiate(callee->data->identifier.declaration, expression, arguments, arguments_count, checker);
+    if (!instance) return none_type;
+    callee->data->identifier.declaration = instance;
+  }
+
+  type_id callee_type = check_expression(callee, checker);
+  if (callee_type == none_type) return none_type;
+  if (get_type(callee_type)->kind == type_kind_pointer) callee_type = get_type(callee_type)->pointee;
+  if (get_type(callee_type)->kind != type_kind_procedure)
+  {
+    utf8 representation[type_representation_size];
+    report_expression_failure(checker->program, callee, "Expected a procedure, but got %s.", represent_type(representation, type_representation_size, callee_type));
+    return none_type;
+  }
+
+  uint parameters_count = get_type(callee_type)->arguments_count;
+  if (arguments_count != parameters_count)
+  {
+    report_expression_failure(checker->program, expression, "Expected %u arguments, but got %u.", parameters_count, arguments_count);
+    return none_type;
+  }
+  for (uint i = 0; i < arguments_count; ++i)
+    check_conversion(arguments[i], get_type(callee_type)->components[i], checker);
+
+  type *procedure_type = get_type(callee_type);
+  uint results_count = procedure_type->components_count - procedure_type->arguments_count;
+  return results_count == 1 ? procedure_type->components[procedure_type->arguments_count] : none_type;
+}
+
+/* finds a field in the scope of the structure alone */
+static declaration_node *find_field(identifier_node *identifier, structure_node *structure, expression *expression, checker *checker)
+{
+  scope fields = *structure->scope;
+  fields.parent = 0;
+  declaration_node *field = find_declaration(identifier->runes, identifier->runes_count, identifier->hash, &fields);
+  if (!field)
+  {
+    report_expression_failure(checker->program, expression, "Undeclared field %s.", identifier->runes);
+    return 0;
+  }
+  check_declaration(field, checker);
+  return field;
+}
+
+static type_id check_resolution(expression *expression, checker *checker)
+{
+  type_id base_type = check_expression(expression->data->resolution.left, checker);
+  if (base_type == none_type) return none_type;
+  if (get_type(base_type)->kind == type_kind_pointer) base_type = get_type(base_type)->pointee;
+
+  struct expression *field = expression->data->resolution.right;
+  if (get_type(base_type)->kind != type_kind_structure)
+  {
+    utf8 representation[type_representation_size];
+    report_expression_failure(checker->program, expression, "%s has no fields.", represent_type(representation, type_representation_size, base_type));
+    return none_type;
+  }
+  structure_node *structure = get_type(base_type)->structure;
+
+  if (field->tag == node_tag_identifier)
+  {
+    identifier_node *identifier = &field->data->identifier;
+    identifier->declaration = find_field(identifier, structure, field, checker);
+    return field->type = identifier->declaration ? identifier->declaration->type : none_type;
+  }
+
+  /* a selection is a structure of the selected fields, each of which refers
+     to the field it's selected from by its identifier */
+  bit has_failed = 0;
+  for (statement *selected = field->data->structure.declarations; selected; selected = selected->next)
+  {
+    declaration_node *declaration = &selected->expression.data->declaration;
+    declaration->identifier.declaration = find_field(&declaration->identifier, structure, &selected->expression, checker);
+    declaration->checking_state = checking_state_checked;
+    if (!declaration->identifier.declaration)
+    {
+      has_failed = 1;
+      continue;
+    }
+    declaration->type = declaration->identifier.declaration->type;
+    selected->expression.type = declaration->type;
+  }
+  if (has_failed) return none_type;
+  return field->type = evaluate_structure_type(&field->data->structure, 0, checker);
+}
+
+type_id check_expression(expression *expression, checker *checker)
+{
+  if (!expression) return none_type;
+  type_id result = none_type;
+  switch (expression->tag)
+  {
+  case node_tag_undefined:
+  case node_tag_type_parameter: /* which is reported by `resolve` */
+    break;
+  case node_tag_identifier:
+    {
+      declaration_node *declaration = expression->data->identifier.declaration;
+      if (!declaration) break;
+      sintl builtin = get_builtin(declaration);
+      if (builtin >= 0)
+      {
+        result = builtin == builtin_return ? none_type : types.type_type;
+        break;
+      }
+      if (is_generic_declaration(declaration))
+      {
+        report_expression_failure(checker->program, expression, "%s is generic, so it's only invoked.", declaration->identifier.runes);
+        break;
+      }
+      check_declaration(declaration, checker);
+      result = declaration->denoted_type != none_type ? types.type_type : declaration->type;
+      break;
+    }
+  case node_tag_string:  result = types.string_type;              break;
+  case node_tag_rune:    result = types.builtins[builtin_u32];     break;
+  case node_tag_digital: result = types.integer_type;              break;
+  case node_tag_decimal: result = types.decimal_type;              break;
+
+  case node_tag_procedure_type:
+    evaluate_type(expression, checker);
+    result = types.type_type;
+    break;
+  case node_tag_declaration:
+    check_declaration(&expression->data->declaration, checker);
+    break;
+  case node_tag_structure:
+    for (statement *declaration = expression->data->structure.declarations; declaration; declaration = declaration->next)
+      check_declaration(&declaration->expression.data->declaration, checker);
+    break;
+  case node_tag_procedure:
+    if (is_generic_procedure(expression))
+    {
+      report_expression_failure(checker->program, expression, "A generic procedure is declared as a constant.");
+      break;
+    }
+    check_procedure(expression, checker);
+    result = expression->type;
+    break;
+
+  case node_tag_unary:
+  case node_tag_positive:
+  case node_tag_negative:
+    result = check_expression(expression->data->unary.expression, checker);
+    if (result != none_type && !is_numeric(result) && get_element_type(result) == none_type)
+    {
+      report_mismatch(expression->data->unary.expression, types.integer_type, result, checker);
+      result = none_type;
+    }
+    break;
+  case node_tag_bitwise_negation:
+    result = check_expression(expression->data->unary.expression, checker);
+    if (result != none_type && !is_integral(result) && !is_integral(get_element_type(result)))
+    {
+      report_mismatch(expression->data->unary.expression, types.integer_type, result, checker);
+      result = none_type;
+    }
+    break;
+  case node_tag_negation:
+    check_expression(expression->data->unary.expression, checker);
+    result = types.bit_type;
+    break;
+  case node_tag_reference:
+    if (denotes_type(expression->data->reference.expression, checker))
+    {
+      evaluate_type(expression, checker);
+      result = types.type_type;
+    }
+    else
+    {
+      type_id pointee = check_expression(expression->data->reference.expression, checker);
+      result = pointee == none_type ? none_type : intern_pointer(get_default_type(pointee));
+    }
+    break;
+
+  case node_tag_binary:
+  case node_tag_addition:
+  case node_tag_subtraction:
+  case node_tag_multiplication:
+  case node_tag_division:
+  case node_tag_modulo:
+  case node_tag_bitwise_conjunction:
+  case node_tag_bitwise_disjunction:
+  case node_tag_bitwise_exclusive_disjunction:
+    check_expression(expression->data->binary.left, checker);
+    check_expression(expression->data->binary.right, checker);
+    result = unify_arithmetic(expression->data->binary.left, expression->data->binary.right, checker);
+    if (result != none_type && !check_arithmetic(expression, expression->tag, result, checker)) result = none_type;
+    break;
+  case node_tag_bitwise_left_shift:
+  case node_tag_bitwise_right_shift:
+    result = check_expression(expression->data->binary.left, checker);
+    check_expression(expression->data->binary.right, checker);
+    if (result != none_type && !is_integral(result)) report_mismatch(expression->data->binary.left, types.integer_type, result, checker), result = none_type;
+    if (expression->data->binary.right->type != none_type && !is_integral(expression->data->binary.right->type))
+      report_mismatch(expression->data->binary.right, types.integer_type, expression->data->binary.right->type, checker);
+    break;
+  case node_tag_equality:
+  case node_tag_inequality:
+  case node_tag_greater:
+  case node_tag_lesser:
+  case node_tag_inclusive_greater:
+  case node_tag_inclusive_lesser:
+    check_expression(expression->data->binary.left, checker);
+    check_expression(expression->data->binary.right, checker);
+    unify(expression->data->binary.left, expression->data->binary.right, checker);
+    result = types.bit_type;
+    break;
+  case node_tag_conjunction:
+  case node_tag_disjunction:
+    for (uint i = 0; i < 2; ++i)
+    {
+      struct expression *operand = i ? expression->data->binary.right : expression->data->binary.left;
+      type_id operand_type = check_expression(operand, checker);
+      if (operand_type != none_type && !is_scalar(operand_type)) report_mismatch(operand, types.bit_type, operand_type, checker);
+    }
+    result = types.bit_type;
+    break;
+
+  case node_tag_assignment:
+  case node_tag_addition_assignment:
+  case node_tag_subtraction_assignment:
+  case node_tag_multiplication_assignment:
+  case node_tag_division_assignment:
+  case node_tag_modulo_assignment:
+  case node_tag_bitwise_conjunction_assignment:
+  case node_tag_bitwise_disjunction_assignment:
+  case node_tag_bitwise_exclusive_disjunction_assignment:
+  case node_tag_bitwise_left_shift_assignment:
+  case node_tag_bitwise_right_shift_assignment:
+    result = check_expression(expression->data->binary.left, checker);
+    check_expression(expression->data->binary.right, checker);
+    if (!is_assignable(expression->data->binary.left))
+      report_expression_failure(checker->program, expression->data->binary.left, "Expected a variable.");
+    if (expression->tag != node_tag_assignment && get_element_type(result) != none_type)
+    {
+      /* `a op= b` is checked like `a op b` */
+      struct expression *right = expression->data->binary.right;
+      check_conversion(right, is_numeric(right->type) ? get_element_type(result) : result, checker);
+      check_arithmetic(expression, get_assigned_operation(expression->tag), result, checker);
+      break;
+    }
+    check_conversion(expression->data->binary.right, result, checker);
+    if (expression->tag != node_tag_assignment && result != none_type && !is_numeric(result))
+    {
+      utf8 representation[type_representation_size];
+      report_expression_failure(checker->program, expression, "The operation isn't defined for %s.", represent_type(representation, type_representation_size, result));
+    }
+    break;
+
+  case node_tag_resolution:
+    result = check_resolution(expression, checker);
+    break;
+  case node_tag_cast:
+    {
+      /* unlike implicit conversions, casts convert between any numbers, and
+         between any pointers */
+      type_id from = check_expression(expression->data->cast.left, checker);
+      result = evaluate_type(expression->data->cast.right, checker);
+      if (from == none_type || result == none_type || from == result) break;
+      type_kind from_kind = get_type(from)->kind, to_kind = get_type(result)->kind;
+      bit is_valid = (is_scalar(from) && from_kind != type_kind_pointer && is_scalar(result) && to_kind != type_kind_pointer)
+                     || (from_kind == type_kind_pointer && to_kind == type_kind_pointer)
+                     || (from_kind == type_kind_pointer && is_integral(result) && get_type(result)->size == sizeof(void *))
+                     || (to_kind == type_kind_pointer && is_integral(from) && (from == types.integer_type || get_type(from)->size == sizeof(void *)));
+      if (!is_valid)
+      {
+        utf8 from_representation[type_representation_size], to_representation[type_representation_size];
+        report_expression_failure(checker->program, expression, "Cannot cast %s to %s.",
+                                  represent_type(from_representation, type_representation_size, from),
+                                  represent_type(to_representation, type_representation_size, result));
+      }
+      break;
+    }
+  case node_tag_invocation:
+    result = check_invocation(expression, checker);
+    break;
+  case node_tag_list:
+    check_expression(expression->data->list.left, checker);
+    check_expression(expression->data->list.right, checker);
+    break;
+
+  case node_tag_ternary:
+  case node_tag_condition:
+    {
+      type_id condition_type = check_expression(expression->data->condition.left, checker);
+      if (condition_type != none_type && !is_scalar(condition_type))
+        report_mismatch(expression->data->condition.left, types.bit_type, condition_type, checker);
+      check_expression(expression->data->condition.right, checker);
+      if (!expression->data->condition.other) break;
+      check_expression(expression->data->condition.other, checker);
+      result = unify(expression->data->condition.right, expression->data->condition.other, checker);
+      break;
+    }
+  }
+  return expression->type = result;
+}
+
+void check_types(program *program)
+{
+  initialize_types();
+
+  checker checker =
+  {
+    .program = program,
+  };
+  for (statement *declaration = program->global_scope.declarations; declaration; declaration = declaration->next)
+  {
+    check_declaration(&declaration->expression.data->declaration, &checker);
+    declaration->expression.type = declaration->expression.data->declaration.type;
+  }
+}
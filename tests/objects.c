@@ -0,0 +1,62 @@
+/* reads and writes the globals of tests/objects.p, which an object stores
+   as they're declared:
+
+     ./proglosa --emit-object objects.o tests/objects.p
+     cc -o objects tests/objects.c objects.o && ./objects */
+
+#include <stdint.h>
+#include <stdio.h>
+
+extern float    gf;
+extern double   gd;
+extern int8_t   gb;
+extern uint16_t gw;
+extern int32_t  gi;
+extern int64_t  gl;
+
+float    get_f(void);
+int64_t  set_f(float x);
+int8_t   get_b(void);
+int64_t  set_b(int8_t x);
+uint16_t get_w(void);
+int32_t  get_i(void);
+int64_t  bump(void);
+
+static int failures_count;
+
+#define CHECK(condition) do { if (!(condition)) { printf("failed: %s\n", #condition); ++failures_count; } } while (0)
+
+int main(void)
+{
+  /* as they're initialized */
+  CHECK(gf == 1.5f);
+  CHECK(gd == 2.25);
+  CHECK(gb == -3);
+  CHECK(gw == 65000);
+  CHECK(gi == -100000);
+  CHECK(gl == 1234567890123);
+  CHECK(get_f() == 1.5f);
+  CHECK(get_b() == -3);
+  CHECK(get_w() == 65000);
+  CHECK(get_i() == -100000);
+
+  /* as they're written by either side */
+  gf = 0.1f;
+  CHECK(get_f() == 0.1f);
+  set_f(3.75f);
+  CHECK(gf == 3.75f);
+  set_b(-128);
+  CHECK(gb == -128);
+  CHECK(get_b() == -128);
+
+  /* as they wrap */
+  gw = 65535;
+  gi = 7;
+  CHECK(bump() == 1234567890123 + 8);
+  CHECK(gw == 0);
+  CHECK(gi == 8);
+  CHECK(get_w() == 0);
+
+  printf(failures_count ? "failed\n" : "passed\n");
+  return failures_count != 0;
+}
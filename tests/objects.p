@@ -0,0 +1,14 @@
+gf: f32 = 1.5;
+gd: f64 = 2.25;
+gb: s8 = -3;
+gw: u16 = 65000;
+gi: s32 = -100000;
+gl: s64 = 1234567890123;
+
+get_f :: () -> r: f32 { r = gf; return r; }
+set_f :: (x: f32) -> r: s64 { gf = x; r = 0; return r; }
+get_b :: () -> r: s8 { r = gb; return r; }
+set_b :: (x: s8) -> r: s64 { gb = x; r = 0; return r; }
+get_w :: () -> r: u16 { r = gw; return r; }
+get_i :: () -> r: s32 { r = gi; return r; }
+bump :: () -> r: s64 { gi = gi + 1; gw = gw + 1; r = gl + (gi : s64); return r; }